@@ -0,0 +1,163 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routebatch.h"
+#include "geo/calculations.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+/*
+ * Calculates routes for a list of airport pairs and prints timing and statistics as CSV.
+ *
+ * Input file contains one departure and destination airport ident separated by space per line.
+ * Empty lines and lines starting with "#" are ignored.
+ *
+ * Example:
+ * routebenchmark --database little_navmap_navigraph.sqlite --mode jet --threads 4 pairs.txt > result.csv
+ */
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("routebenchmark");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Benchmark for the Little Navmap route finder.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("pairs", "File containing departure and destination airport idents.");
+
+  QCommandLineOption databaseOpt("database", "Navigation database file.", "file");
+  QCommandLineOption modeOpt("mode", "Network mode: radionav, victor, jet or both.", "mode", "jet");
+  QCommandLineOption threadsOpt("threads", "Number of worker threads.", "number",
+                                QString::number(QThread::idealThreadCount()));
+  QCommandLineOption altitudeOpt("altitude", "Use airways for altitude in feet.", "feet", "0");
+  QCommandLineOption repeatOpt("repeat", "Number of passes over all routes.", "number", "1");
+  QCommandLineOption preloadOpt("preload", "Preload the whole network into memory.");
+  QCommandLineOption landmarksOpt("landmarks", "Number of landmarks for the ALT heuristic. Needs preload.",
+                                  "number", "0");
+  QCommandLineOption bidirectionalOpt("bidirectional", "Use bidirectional search.");
+  parser.addOptions({databaseOpt, modeOpt, threadsOpt, altitudeOpt, repeatOpt, preloadOpt, landmarksOpt,
+                     bidirectionalOpt});
+  parser.process(app);
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  if(parser.positionalArguments().isEmpty() || !parser.isSet(databaseOpt))
+  {
+    err << "Database and pairs file are required." << endl;
+    parser.showHelp(1);
+  }
+
+  nw::Modes mode;
+  QString modeStr = parser.value(modeOpt).toLower();
+  if(modeStr == "radionav")
+    mode = nw::ROUTE_RADIONAV;
+  else if(modeStr == "victor")
+    mode = nw::ROUTE_VICTOR;
+  else if(modeStr == "jet")
+    mode = nw::ROUTE_JET;
+  else if(modeStr == "both")
+    mode = nw::ROUTE_VICTOR | nw::ROUTE_JET;
+  else
+  {
+    err << "Invalid mode " << modeStr << endl;
+    return 1;
+  }
+
+  // Read airport pairs ======================================================
+  QVector<rb::RouteBatchRequest> requests;
+  QFile pairsFile(parser.positionalArguments().first());
+  if(pairsFile.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    QTextStream in(&pairsFile);
+    while(!in.atEnd())
+    {
+      QString line = in.readLine().simplified();
+      if(line.isEmpty() || line.startsWith("#"))
+        continue;
+
+      QStringList idents = line.split(" ");
+      if(idents.size() >= 2)
+        requests.append({idents.at(0).toUpper(), idents.at(1).toUpper()});
+      else
+        err << "Ignoring line " << line << endl;
+    }
+    pairsFile.close();
+  }
+  else
+  {
+    err << "Cannot open " << pairsFile.fileName() << ": " << pairsFile.errorString() << endl;
+    return 1;
+  }
+
+  // Calculate ===============================================================
+  RouteBatch batch(parser.value(databaseOpt), mode);
+  batch.setNumThreads(parser.value(threadsOpt).toInt());
+  batch.setAltitude(parser.value(altitudeOpt).toInt());
+  batch.setPreloadGraph(parser.isSet(preloadOpt));
+  batch.setNumLandmarks(parser.value(landmarksOpt).toInt());
+  batch.setUseLandmarks(parser.value(landmarksOpt).toInt() > 0);
+  batch.setBidirectional(parser.isSet(bidirectionalOpt));
+
+  out << "pass;departure;destination;found;distance_nm;waypoints;time_ms;nodes_expanded;"
+         "cache_hits;cache_misses;error" << endl;
+
+  int passes = std::max(1, parser.value(repeatOpt).toInt());
+  for(int pass = 0; pass < passes; pass++)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    QVector<rb::RouteBatchResult> results = batch.calculate(requests);
+    qint64 elapsedMs = timer.elapsed();
+
+    int numFound = 0;
+    qint64 totalTimeUs = 0, totalExpanded = 0, totalHits = 0, totalMisses = 0;
+    for(const rb::RouteBatchResult& result : results)
+    {
+      out << pass << ";" << result.departureIdent << ";" << result.destinationIdent << ";"
+          << (result.found ? 1 : 0) << ";"
+          << QString::number(atools::geo::meterToNm(result.distanceMeter), 'f', 1) << ";"
+          << result.route.size() << ";"
+          << QString::number(result.timeMicroseconds / 1000., 'f', 3) << ";"
+          << result.nodesExpanded << ";" << result.cacheHits << ";" << result.cacheMisses << ";"
+          << result.error << endl;
+
+      if(result.found)
+        numFound++;
+      totalTimeUs += result.timeMicroseconds;
+      totalExpanded += result.nodesExpanded;
+      totalHits += result.cacheHits;
+      totalMisses += result.cacheMisses;
+    }
+
+    qint64 fetches = totalHits + totalMisses;
+    err << "Pass " << pass + 1 << ": " << results.size() << " routes, " << numFound << " found, "
+        << elapsedMs << " ms wall time, "
+        << QString::number(elapsedMs > 0 ? results.size() * 1000. / elapsedMs : 0., 'f', 1) << " routes/s, "
+        << QString::number(results.isEmpty() ? 0. : totalTimeUs / 1000. / results.size(), 'f', 2)
+        << " ms/route, "
+        << (results.isEmpty() ? 0 : totalExpanded / results.size()) << " nodes expanded/route, "
+        << QString::number(fetches > 0 ? totalHits * 100. / fetches : 0., 'f', 1) << "% cache hits" << endl;
+  }
+
+  return 0;
+}
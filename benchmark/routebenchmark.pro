@@ -0,0 +1,65 @@
+#-------------------------------------------------
+#
+# Command line benchmark for the route finder.
+# Uses the route calculation sources of littlenavmap.pro.
+#
+#-------------------------------------------------
+
+QT       += core gui sql
+
+QT       -= widgets
+
+TARGET = routebenchmark
+TEMPLATE = app
+
+CONFIG += console c++14
+CONFIG -= app_bundle
+
+CONFIG(debug, debug|release):CONF_TYPE=debug
+CONFIG(release, debug|release):CONF_TYPE=release
+
+DEFINES += QT_NO_CAST_FROM_BYTEARRAY
+DEFINES += QT_NO_CAST_TO_ASCII
+
+# =====================================================================
+# Dependencies
+# =====================================================================
+
+DEPENDPATH += $$PWD/../../atools/src
+INCLUDEPATH += $$PWD/../../atools/src $$PWD/../src
+
+win32 {
+  DEFINES += _USE_MATH_DEFINES
+  LIBS += -L $$PWD/../../build-atools-$${CONF_TYPE}/$${CONF_TYPE} -l atools
+  LIBS += -lz
+  PRE_TARGETDEPS += $$PWD/../../build-atools-$${CONF_TYPE}/$${CONF_TYPE}/libatools.a
+}
+
+unix {
+  LIBS += -L $$PWD/../../build-atools-$${CONF_TYPE} -l atools -lz
+  PRE_TARGETDEPS += $$PWD/../../build-atools-$${CONF_TYPE}/libatools.a
+}
+
+# =====================================================================
+# Files
+# =====================================================================
+
+SOURCES += routebenchmark.cpp \
+    $$PWD/../src/route/routebatch.cpp \
+    $$PWD/../src/route/routefinder.cpp \
+    $$PWD/../src/route/routelandmarks.cpp \
+    $$PWD/../src/route/routenetwork.cpp \
+    $$PWD/../src/route/routenetworkairway.cpp \
+    $$PWD/../src/route/routenetworkgraph.cpp \
+    $$PWD/../src/route/routenetworkradio.cpp \
+    $$PWD/../src/route/routenodegrid.cpp
+
+HEADERS += \
+    $$PWD/../src/route/routebatch.h \
+    $$PWD/../src/route/routefinder.h \
+    $$PWD/../src/route/routelandmarks.h \
+    $$PWD/../src/route/routenetwork.h \
+    $$PWD/../src/route/routenetworkairway.h \
+    $$PWD/../src/route/routenetworkgraph.h \
+    $$PWD/../src/route/routenetworkradio.h \
+    $$PWD/../src/route/routenodegrid.h
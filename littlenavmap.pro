@@ -118,10 +118,14 @@ SOURCES += src/main.cpp\
     src/search/sqlmodel.cpp \
     src/search/column.cpp \
     src/search/sqlproxymodel.cpp \
+    src/search/searchtextindex.cpp \
+    src/search/searchspatialindex.cpp \
+    src/search/sqlmodelpager.cpp \
     src/search/searchcontroller.cpp \
     src/search/airportsearch.cpp \
     src/search/navsearch.cpp \
     src/mapgui/mappaintlayer.cpp \
+    src/mapgui/mappaintprofiler.cpp \
     src/mapgui/maplayer.cpp \
     src/mapgui/maplayersettings.cpp \
     src/mapgui/mappainter.cpp \
@@ -141,6 +145,7 @@ SOURCES += src/main.cpp\
     src/common/formatter.cpp \
     src/common/coordinateconverter.cpp \
     src/common/maptypesfactory.cpp \
+    src/db/airspacegeometrylod.cpp \
     src/db/databasedialog.cpp \
     src/route/parkingdialog.cpp \
     src/route/routecommand.cpp \
@@ -149,9 +154,15 @@ SOURCES += src/main.cpp\
     src/route/routenetworkradio.cpp \
     src/route/routenetworkairway.cpp \
     src/route/routenetwork.cpp \
+    src/route/routenetworkgraph.cpp \
+    src/route/routelandmarks.cpp \
+    src/route/routebatch.cpp \
+    src/route/routenodegrid.cpp \
     src/common/weatherreporter.cpp \
     src/connect/connectdialog.cpp \
     src/connect/connectclient.cpp \
+    src/connect/connectnetworkreader.cpp \
+    src/connect/simconnectreplay.cpp \
     src/mapgui/mappainteraircraft.cpp \
     src/profile/profilewidget.cpp \
     src/common/aircrafttrack.cpp \
@@ -164,6 +175,7 @@ SOURCES += src/main.cpp\
     src/export/exporter.cpp \
     src/export/htmlexporter.cpp \
     src/common/htmlinfobuilder.cpp \
+    src/mapgui/mapscreengrid.cpp \
     src/mapgui/mapscreenindex.cpp \
     src/options/optionsdialog.cpp \
     src/options/optiondata.cpp \
@@ -173,6 +185,8 @@ SOURCES += src/main.cpp\
     src/print/printsupport.cpp \
     src/print/printdialog.cpp \
     src/route/routestring.cpp \
+    src/route/routestringcache.cpp \
+    src/route/routestringbatch.cpp \
     src/route/routestringdialog.cpp \
     src/route/flightplanentrybuilder.cpp \
     src/common/unit.cpp \
@@ -183,11 +197,13 @@ SOURCES += src/main.cpp\
     src/search/abstractsearch.cpp \
     src/search/proceduresearch.cpp \
     src/common/proctypes.cpp \
+    src/mapgui/mapairspacegeometrycache.cpp \
     src/mapgui/mappainterairspace.cpp \
     src/db/databaseerrordialog.cpp \
     src/gui/airspacetoolbarhandler.cpp \
     src/navapp.cpp \
     src/common/mapflags.cpp \
+    src/common/elevationcache.cpp \
     src/common/elevationprovider.cpp \
     src/mapgui/mappaintership.cpp \
     src/mapgui/mappaintervehicle.cpp \
@@ -196,6 +212,7 @@ SOURCES += src/main.cpp\
     src/query/airportquery.cpp \
     src/query/infoquery.cpp \
     src/query/mapquery.cpp \
+    src/query/mapqueryprefetch.cpp \
     src/query/procedurequery.cpp
 
 HEADERS  += src/gui/mainwindow.h \
@@ -203,10 +220,14 @@ HEADERS  += src/gui/mainwindow.h \
     src/search/sqlmodel.h \
     src/search/column.h \
     src/search/sqlproxymodel.h \
+    src/search/searchtextindex.h \
+    src/search/searchspatialindex.h \
+    src/search/sqlmodelpager.h \
     src/search/searchcontroller.h \
     src/search/airportsearch.h \
     src/search/navsearch.h \
     src/mapgui/mappaintlayer.h \
+    src/mapgui/mappaintprofiler.h \
     src/mapgui/maplayer.h \
     src/mapgui/maplayersettings.h \
     src/mapgui/mappainter.h \
@@ -226,6 +247,8 @@ HEADERS  += src/gui/mainwindow.h \
     src/common/formatter.h \
     src/common/coordinateconverter.h \
     src/common/maptypesfactory.h \
+    src/common/mapobjectlist.h \
+    src/db/airspacegeometrylod.h \
     src/db/databasedialog.h \
     src/route/parkingdialog.h \
     src/route/routecommand.h \
@@ -234,9 +257,15 @@ HEADERS  += src/gui/mainwindow.h \
     src/route/routenetworkradio.h \
     src/route/routenetworkairway.h \
     src/route/routenetwork.h \
+    src/route/routenetworkgraph.h \
+    src/route/routelandmarks.h \
+    src/route/routebatch.h \
+    src/route/routenodegrid.h \
     src/common/weatherreporter.h \
     src/connect/connectdialog.h \
     src/connect/connectclient.h \
+    src/connect/connectnetworkreader.h \
+    src/connect/simconnectreplay.h \
     src/mapgui/mappainteraircraft.h \
     src/profile/profilewidget.h \
     src/common/aircrafttrack.h \
@@ -249,6 +278,7 @@ HEADERS  += src/gui/mainwindow.h \
     src/export/exporter.h \
     src/export/htmlexporter.h \
     src/common/htmlinfobuilder.h \
+    src/mapgui/mapscreengrid.h \
     src/mapgui/mapscreenindex.h \
     src/options/optionsdialog.h \
     src/options/optiondata.h \
@@ -258,6 +288,8 @@ HEADERS  += src/gui/mainwindow.h \
     src/print/printsupport.h \
     src/print/printdialog.h \
     src/route/routestring.h \
+    src/route/routestringcache.h \
+    src/route/routestringbatch.h \
     src/route/routestringdialog.h \
     src/route/flightplanentrybuilder.h \
     src/common/unit.h \
@@ -268,11 +300,13 @@ HEADERS  += src/gui/mainwindow.h \
     src/search/abstractsearch.h \
     src/search/proceduresearch.h \
     src/common/proctypes.h \
+    src/mapgui/mapairspacegeometrycache.h \
     src/mapgui/mappainterairspace.h \
     src/db/databaseerrordialog.h \
     src/gui/airspacetoolbarhandler.h \
     src/navapp.h \
     src/common/mapflags.h \
+    src/common/elevationcache.h \
     src/common/elevationprovider.h \
     src/mapgui/mappaintership.h \
     src/mapgui/mappaintervehicle.h \
@@ -281,6 +315,8 @@ HEADERS  += src/gui/mainwindow.h \
     src/query/airportquery.h \
     src/query/infoquery.h \
     src/query/mapquery.h \
+    src/query/mapqueryprefetch.h \
+    src/query/maptilecache.h \
     src/query/procedurequery.h
 
 FORMS    += src/gui/mainwindow.ui \
@@ -25,15 +25,11 @@
 #include <QDateTime>
 #include <QFile>
 
-AircraftTrack::AircraftTrack()
-{
+using atools::settings::Settings;
 
-}
+static const QString SPILL_SUFFIX(".track_spill");
 
-AircraftTrack::~AircraftTrack()
-{
-
-}
+const float AircraftTrack::LEVEL_TOLERANCE_METER[NUM_LEVELS] = {0.f, 250.f, 1000.f, 4000.f, 16000.f};
 
 namespace at {
 
@@ -49,11 +45,84 @@ QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& tra
   return dataStream;
 }
 
+AircraftTrackRing::AircraftTrackRing(int capacityValue)
+  : capacity(std::max(capacityValue, 1))
+{
+
+}
+
+bool AircraftTrackRing::append(const AircraftTrackPos& trackPos, AircraftTrackPos *dropped)
+{
+  numAppended++;
+  if(entries.size() < capacity)
+  {
+    entries.append(trackPos);
+    return false;
+  }
+  else
+  {
+    // Full - replace oldest
+    if(dropped != nullptr)
+      *dropped = entries.at(start);
+    entries[start] = trackPos;
+    start = (start + 1) % entries.size();
+    return true;
+  }
+}
+
+void AircraftTrackRing::setCapacity(int value, QVector<AircraftTrackPos> *dropped)
+{
+  value = std::max(value, 1);
+  if(value == capacity)
+    return;
+
+  // Copy into linear order keeping the newest entries
+  QVector<AircraftTrackPos> linear;
+  linear.reserve(std::min(entries.size(), value));
+  int numRemove = std::max(entries.size() - value, 0);
+  for(int i = 0; i < entries.size(); i++)
+  {
+    if(i < numRemove)
+    {
+      if(dropped != nullptr)
+        dropped->append(at(i));
+    }
+    else
+      linear.append(at(i));
+  }
+
+  entries = linear;
+  start = 0;
+  capacity = value;
+  numAppended = 0;
+  generation++;
+}
+
+void AircraftTrackRing::clear()
+{
+  entries.clear();
+  start = 0;
+  numAppended = 0;
+  generation++;
+}
+
+}
+
+AircraftTrack::AircraftTrack()
+{
+
+}
+
+AircraftTrack::~AircraftTrack()
+{
+
 }
 
 void AircraftTrack::saveState()
 {
-  QFile trackFile(atools::settings::Settings::getConfigFilename(".track"));
+  flushSpill();
+
+  QFile trackFile(Settings::getConfigFilename(".track"));
 
   if(trackFile.open(QIODevice::WriteOnly))
   {
@@ -61,7 +130,10 @@ void AircraftTrack::saveState()
     out.setVersion(QDataStream::Qt_5_5);
     out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-    out << FILE_MAGIC_NUMBER << FILE_VERSION << *this;
+    // Same layout as a serialized QList
+    out << FILE_MAGIC_NUMBER << FILE_VERSION << static_cast<quint32>(size());
+    for(int i = 0; i < size(); i++)
+      out << at(i);
     trackFile.close();
   }
   else
@@ -70,9 +142,18 @@ void AircraftTrack::saveState()
 
 void AircraftTrack::restoreState()
 {
-  clear();
+  for(at::AircraftTrackRing& level : levels)
+    level.clear();
+  spillBuffer.clear();
+  maxAltitude = 0.f;
+
+  // Fill decimated levels with the positions dropped in previous sessions
+  QVector<at::AircraftTrackPos> spilled;
+  readSpill(spilled);
+  for(const at::AircraftTrackPos& trackPos : spilled)
+    appendDecimated(trackPos);
 
-  QFile trackFile(atools::settings::Settings::getConfigFilename(".track"));
+  QFile trackFile(Settings::getConfigFilename(".track"));
   if(trackFile.exists())
   {
     if(trackFile.open(QIODevice::ReadOnly))
@@ -88,7 +169,16 @@ void AircraftTrack::restoreState()
       {
         in >> version;
         if(version == FILE_VERSION)
-          in >> *this;
+        {
+          quint32 num;
+          in >> num;
+          for(quint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+          {
+            at::AircraftTrackPos trackPos;
+            in >> trackPos;
+            appendInternal(trackPos);
+          }
+        }
         else
           qWarning() << "Cannot read track" << trackFile.fileName() << ". Invalid version number:" << version;
       }
@@ -100,6 +190,27 @@ void AircraftTrack::restoreState()
     else
       qWarning() << "Cannot read track" << trackFile.fileName() << ":" << trackFile.errorString();
   }
+  numDropped = 0;
+}
+
+void AircraftTrack::clearTrack()
+{
+  for(at::AircraftTrackRing& level : levels)
+    level.clear();
+  spillBuffer.clear();
+  numDropped = 0;
+  maxAltitude = 0.f;
+  QFile::remove(Settings::getConfigFilename(SPILL_SUFFIX));
+}
+
+void AircraftTrack::setMaxTrackEntries(int value)
+{
+  QVector<at::AircraftTrackPos> dropped;
+  levels[0].setCapacity(value, &dropped);
+  spillBuffer.append(dropped);
+
+  for(int i = 1; i < NUM_LEVELS; i++)
+    levels[i].setCapacity(value);
 }
 
 bool AircraftTrack::appendTrackPos(const atools::geo::Pos& pos, const QDateTime& timestamp, bool onGround)
@@ -110,7 +221,7 @@ bool AircraftTrack::appendTrackPos(const atools::geo::Pos& pos, const QDateTime&
   long timeDiff = onGround ? MIN_POSITION_TIME_DIFF_GROUND_MS : MIN_POSITION_TIME_DIFF_MS;
 
   if(isEmpty())
-    append({pos, timestamp.toTime_t(), onGround});
+    appendInternal({pos, timestamp.toTime_t(), onGround});
   else
   {
     long time = timestamp.toMSecsSinceEpoch();
@@ -120,28 +231,125 @@ bool AircraftTrack::appendTrackPos(const atools::geo::Pos& pos, const QDateTime&
     {
       if(pos.distanceMeterTo(last().pos) > atools::geo::nmToMeter(MAX_POINT_DISTANCE_NM))
       {
-        clear();
+        clearTrack();
         pruned = true;
       }
-      else
+
+      appendInternal({pos, timestamp.toTime_t(), onGround});
+
+      if(numDropped >= PRUNE_TRACK_ENTRIES)
       {
-        if(size() > maxTrackEntries)
-        {
-          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++)
-            removeFirst();
-          pruned = true;
-        }
+        flushSpill();
+        numDropped = 0;
+        pruned = true;
       }
-      append({pos, timestamp.toTime_t(), onGround});
     }
   }
   return pruned;
 }
 
-float AircraftTrack::getMaxAltitude() const
+void AircraftTrack::appendInternal(const at::AircraftTrackPos& trackPos)
+{
+  at::AircraftTrackPos dropped;
+  if(levels[0].append(trackPos, &dropped))
+  {
+    spillBuffer.append(dropped);
+    numDropped++;
+  }
+  appendDecimated(trackPos);
+}
+
+void AircraftTrack::appendDecimated(const at::AircraftTrackPos& trackPos)
+{
+  maxAltitude = std::max(maxAltitude, trackPos.pos.getAltitude());
+
+  for(int i = 1; i < NUM_LEVELS; i++)
+  {
+    at::AircraftTrackRing& level = levels[i];
+    if(level.isEmpty() || level.last().onGround != trackPos.onGround ||
+       level.last().pos.distanceMeterTo(trackPos.pos) > LEVEL_TOLERANCE_METER[i])
+      level.append(trackPos);
+  }
+}
+
+const at::AircraftTrackRing& AircraftTrack::getTrack(float toleranceMeter) const
+{
+  int i = NUM_LEVELS - 1;
+  while(i > 0 && LEVEL_TOLERANCE_METER[i] > toleranceMeter)
+    i--;
+
+  // Use finer level if the coarse one is too sparse to draw a line
+  while(i > 0 && levels[i].size() < 2)
+    i--;
+  return levels[i];
+}
+
+void AircraftTrack::getFullTrack(QVector<at::AircraftTrackPos>& track) const
+{
+  readSpill(track);
+  track.append(spillBuffer);
+  for(int i = 0; i < size(); i++)
+    track.append(at(i));
+}
+
+void AircraftTrack::flushSpill()
 {
-  float maxAlt = 0.f;
-  for(const at::AircraftTrackPos& trackPos : *this)
-    maxAlt = std::max(maxAlt, trackPos.pos.getAltitude());
-  return maxAlt;
+  if(spillBuffer.isEmpty())
+    return;
+
+  QFile spillFile(Settings::getConfigFilename(SPILL_SUFFIX));
+  if(spillFile.open(QIODevice::Append))
+  {
+    QDataStream out(&spillFile);
+    out.setVersion(QDataStream::Qt_5_5);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    if(spillFile.size() == 0)
+      out << SPILL_MAGIC_NUMBER << SPILL_VERSION;
+
+    for(const at::AircraftTrackPos& trackPos : spillBuffer)
+      out << trackPos;
+    spillFile.close();
+  }
+  else
+    qWarning() << "Cannot write track" << spillFile.fileName() << ":" << spillFile.errorString();
+
+  spillBuffer.clear();
+}
+
+bool AircraftTrack::readSpill(QVector<at::AircraftTrackPos>& track) const
+{
+  QFile spillFile(Settings::getConfigFilename(SPILL_SUFFIX));
+  if(!spillFile.exists())
+    return false;
+
+  if(spillFile.open(QIODevice::ReadOnly))
+  {
+    quint32 magic;
+    quint16 version;
+    QDataStream in(&spillFile);
+    in.setVersion(QDataStream::Qt_5_5);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    in >> magic >> version;
+
+    bool ok = magic == SPILL_MAGIC_NUMBER && version == SPILL_VERSION;
+    if(ok)
+    {
+      while(!in.atEnd() && in.status() == QDataStream::Ok)
+      {
+        at::AircraftTrackPos trackPos;
+        in >> trackPos;
+        if(in.status() == QDataStream::Ok)
+          track.append(trackPos);
+      }
+    }
+    else
+      qWarning() << "Cannot read track" << spillFile.fileName() << ". Invalid magic or version:" << magic << version;
+
+    spillFile.close();
+    return ok;
+  }
+  else
+    qWarning() << "Cannot read track" << spillFile.fileName() << ":" << spillFile.errorString();
+  return false;
 }
@@ -20,6 +20,8 @@
 
 #include "geo/pos.h"
 
+#include <QVector>
+
 namespace at {
 /* Track position. Can be converted to QVariant and thus be saved to settings */
 struct AircraftTrackPos
@@ -37,11 +39,87 @@ QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& obj
 Q_DECLARE_TYPEINFO(at::AircraftTrackPos, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(at::AircraftTrackPos);
 
+namespace at {
+
 /*
- * Stores the track of the flight simulator aircraft
+ * Fixed capacity ring buffer of track positions. Appending to a full buffer replaces the oldest entry.
+ * Index 0 is the oldest entry. Memory grows on demand up to the capacity.
  */
-class AircraftTrack :
-  private QList<at::AircraftTrackPos>
+class AircraftTrackRing
+{
+public:
+  AircraftTrackRing(int capacityValue = 20000);
+
+  /* Append position. Returns true and copies the replaced oldest entry into dropped if the buffer was full. */
+  bool append(const AircraftTrackPos& trackPos, AircraftTrackPos *dropped = nullptr);
+
+  /* Change capacity keeping the newest entries. Removed entries are appended to dropped if not null. */
+  void setCapacity(int value, QVector<AircraftTrackPos> *dropped = nullptr);
+
+  void clear();
+
+  int getCapacity() const
+  {
+    return capacity;
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+  bool isEmpty() const
+  {
+    return entries.isEmpty();
+  }
+
+  const AircraftTrackPos& at(int i) const
+  {
+    return entries.at((start + i) % entries.size());
+  }
+
+  const AircraftTrackPos& first() const
+  {
+    return at(0);
+  }
+
+  const AircraftTrackPos& last() const
+  {
+    return at(entries.size() - 1);
+  }
+
+  /* Number of positions appended since last clear or capacity change */
+  quint32 getNumAppended() const
+  {
+    return numAppended;
+  }
+
+  /* Changes on clear or capacity change. Allows users to detect if they can keep data derived from the buffer. */
+  quint32 getGeneration() const
+  {
+    return generation;
+  }
+
+private:
+  QVector<AircraftTrackPos> entries;
+  int start = 0, capacity;
+  quint32 numAppended = 0, generation = 0;
+};
+
+}
+
+/*
+ * Stores the track of the flight simulator aircraft.
+ *
+ * Full resolution positions are kept in a ring buffer of fixed capacity. Positions dropped from the ring are
+ * appended to a spill file (little_navmap.track_spill) so the whole flight is still available for export.
+ *
+ * Additionally a number of decimated levels are updated incrementally on each append. A level keeps a position
+ * only if it is farther than the level tolerance from the last kept one. The levels have the same capacity as
+ * the full resolution ring and therefore cover a longer history. Use getTrack() to get the level matching the
+ * current display scale.
+ */
+class AircraftTrack
 {
 public:
   AircraftTrack();
@@ -51,10 +129,8 @@ public:
   void saveState();
   void restoreState();
 
-  void clearTrack()
-  {
-    clear();
-  }
+  /* Clear all levels and remove the spill file */
+  void clearTrack();
 
   /*
    * Add a track position. Accurracy depends on the ground flag which will cause more
@@ -63,26 +139,77 @@ public:
    */
   bool appendTrackPos(const atools::geo::Pos& pos, const QDateTime& timestamp, bool onGround);
 
-  float getMaxAltitude() const;
+  /* Maximum altitude of all positions including the ones dropped from memory */
+  float getMaxAltitude() const
+  {
+    return maxAltitude;
+  }
+
+  /* Get the coarsest level which has a tolerance not larger than toleranceMeter. Level 0 is full resolution. */
+  const at::AircraftTrackRing& getTrack(float toleranceMeter) const;
+
+  /* Get the complete track in full resolution including positions from the spill file. Slow. */
+  void getFullTrack(QVector<at::AircraftTrackPos>& track) const;
+
+  /* Access to full resolution positions in memory */
+  bool isEmpty() const
+  {
+    return levels[0].isEmpty();
+  }
+
+  int size() const
+  {
+    return levels[0].size();
+  }
+
+  const at::AircraftTrackPos& at(int i) const
+  {
+    return levels[0].at(i);
+  }
 
-  /* Pull only needed methods into public space */
-  using QList::isEmpty;
-  using QList::first;
-  using QList::last;
-  using QList::size;
-  using QList::at;
-  using QList::begin;
-  using QList::end;
+  const at::AircraftTrackPos& first() const
+  {
+    return levels[0].first();
+  }
 
-  void setMaxTrackEntries(int value)
+  const at::AircraftTrackPos& last() const
   {
-    maxTrackEntries = value;
+    return levels[0].last();
   }
 
+  /* Capacity for full resolution and each decimated level */
+  void setMaxTrackEntries(int value);
+
 private:
-  /* Maximum number of track points. If exceeded entries will be removed from beginning of the list */
-  int maxTrackEntries = 20000;
-  /* Number of entries to remove at once */
+  /* Add position to all levels and spill dropped full resolution positions */
+  void appendInternal(const at::AircraftTrackPos& trackPos);
+
+  /* Add position to decimated levels only */
+  void appendDecimated(const at::AircraftTrackPos& trackPos);
+
+  /* Append buffered dropped positions to the spill file */
+  void flushSpill();
+
+  /* Read all positions from the spill file */
+  bool readSpill(QVector<at::AircraftTrackPos>& track) const;
+
+  /* Number of levels including full resolution */
+  static Q_DECL_CONSTEXPR int NUM_LEVELS = 5;
+
+  /* Minimum distance between positions for each level */
+  static const float LEVEL_TOLERANCE_METER[NUM_LEVELS];
+
+  at::AircraftTrackRing levels[NUM_LEVELS];
+
+  /* Positions dropped from full resolution level not yet written to the spill file */
+  QVector<at::AircraftTrackPos> spillBuffer;
+
+  /* Number of positions dropped since last pruned notification */
+  int numDropped = 0;
+
+  float maxAltitude = 0.f;
+
+  /* Notify about pruning and write the spill file every number of dropped entries */
   static Q_DECL_CONSTEXPR int PRUNE_TRACK_ENTRIES = 200;
 
   /* Minimum time difference between recordings */
@@ -96,6 +223,9 @@ private:
 
   /* Version 2 to adds timstamp and single floating point precision */
   static Q_DECL_CONSTEXPR quint16 FILE_VERSION = 2;
+
+  static Q_DECL_CONSTEXPR quint32 SPILL_MAGIC_NUMBER = 0x5B6C1A2C;
+  static Q_DECL_CONSTEXPR quint16 SPILL_VERSION = 1;
 };
 
 #endif // LITTLENAVMAP_AIRCRAFTTRACK_H
@@ -143,6 +143,10 @@ const QLatin1Literal SEARCHTAB_NAV_VIEW_DIST_WIDGET("SearchPaneNav/WidgetDistVie
 const QLatin1Literal SETTINGS_INFOQUERY("Settings/InfoQuery");
 const QLatin1Literal SETTINGS_MAPQUERY("Settings/MapQuery");
 const QLatin1Literal SETTINGS_DATABASE("Settings/Database");
+const QLatin1Literal SETTINGS_ROUTE_NETWORK("Settings/RouteNetwork");
+const QLatin1Literal SETTINGS_MAP_PROFILE("Settings/MapProfile");
+const QLatin1Literal SETTINGS_CONNECT_REPLAY("Settings/ConnectReplay");
+const QLatin1Literal SETTINGS_SEARCH("Settings/Search");
 
 const QLatin1Literal APPROACHTREE_WIDGET("ApproachTree/Widget");
 const QLatin1Literal APPROACHTREE_SELECTED_WIDGET("ApproachTree/WidgetSelected");
@@ -22,14 +22,29 @@
 #include "geo/line.h"
 
 #include <marble/ViewportParams.h>
+#include <marble/AbstractProjection.h>
+#include <marble/MarbleGlobal.h>
+#include <marble/Quaternion.h>
 
 #include <QLineF>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITTLENAVMAP_BATCH_SSE2
+#include <emmintrin.h>
+#endif
 
 using namespace Marble;
 using namespace atools::geo;
 
 const QSize CoordinateConverter::DEFAULT_WTOS_SIZE(100, 100);
 
+/* Number of coordinates processed per pass in the batch functions. Temporary arrays are kept on the stack. */
+static Q_DECL_CONSTEXPR int BATCH_CHUNK_SIZE = 256;
+
 CoordinateConverter::CoordinateConverter(const ViewportParams *viewportParams)
   : viewport(viewportParams)
 {
@@ -233,6 +248,238 @@ Pos CoordinateConverter::sToW(const QPointF& point) const
   return sToW(atools::roundToInt(point.x()), atools::roundToInt(point.y()));
 }
 
+void CoordinateConverter::wToSBatch(const float *lonX, const float *latY, int num, double *x, double *y,
+                                    bool *visible, bool *isHidden, const QSize& size) const
+{
+  switch(viewport->projection())
+  {
+    case Marble::Spherical:
+      wToSBatchSpherical(lonX, latY, num, x, y, visible, isHidden, size);
+      break;
+
+    case Marble::Mercator:
+      wToSBatchMercator(lonX, latY, num, x, y, visible, isHidden, size);
+      break;
+
+    default:
+      for(int i = 0; i < num; i++)
+      {
+        bool hidden;
+        visible[i] = wToS(Pos(lonX[i], latY[i]), x[i], y[i], size, &hidden);
+        if(isHidden != nullptr)
+          isHidden[i] = hidden;
+      }
+      break;
+  }
+}
+
+/* Orthographic projection. Same as Marble::SphericalProjection::screenCoordinates for altitude 0.
+ * Trigonometric functions are computed in a scalar pass. Rotation and visibility test are done in a second
+ * branch free pass which uses SSE2 if available. */
+void CoordinateConverter::wToSBatchSpherical(const float *lonX, const float *latY, int num, double *x, double *y,
+                                             bool *visible, bool *isHidden, const QSize& size) const
+{
+  const Marble::matrix& axis = viewport->planetAxisMatrix();
+  const double width = viewport->width(), height = viewport->height();
+  const double halfWidth = width / 2., halfHeight = height / 2.;
+  // Marble scales the radius by (EARTH_RADIUS + altitude) / EARTH_RADIUS which is 1 for altitude 0
+  const double pixelRadius = viewport->radius();
+  const double sizeX2 = size.width() / 2., sizeY2 = size.height() / 2.;
+
+  // Screen bounds extended by half of the estimated object size
+  const double minX = -sizeX2, maxX = width + sizeX2, minY = -sizeY2, maxY = height + sizeY2;
+
+  double qx[BATCH_CHUNK_SIZE], qy[BATCH_CHUNK_SIZE], qz[BATCH_CHUNK_SIZE], rz[BATCH_CHUNK_SIZE];
+
+  for(int start = 0; start < num; start += BATCH_CHUNK_SIZE)
+  {
+    const int cnt = std::min(num - start, BATCH_CHUNK_SIZE);
+    const float *lons = lonX + start, *lats = latY + start;
+    double *xs = x + start, *ys = y + start;
+    bool *vis = visible + start;
+
+    // Unit vectors on the sphere - equivalent to Quaternion::fromSpherical
+    for(int i = 0; i < cnt; i++)
+    {
+      const double lon = lons[i] * DEG2RAD, lat = lats[i] * DEG2RAD;
+      const double cosLat = std::cos(lat);
+      qx[i] = cosLat * std::sin(lon);
+      qy[i] = std::sin(lat);
+      qz[i] = cosLat * std::cos(lon);
+    }
+
+    // Rotate into view - equivalent to Quaternion::rotateAroundAxis
+    int i = 0;
+#ifdef LITTLENAVMAP_BATCH_SSE2
+    const __m128d a00 = _mm_set1_pd(axis[0][0]), a10 = _mm_set1_pd(axis[1][0]), a20 = _mm_set1_pd(axis[2][0]);
+    const __m128d a01 = _mm_set1_pd(axis[0][1]), a11 = _mm_set1_pd(axis[1][1]), a21 = _mm_set1_pd(axis[2][1]);
+    const __m128d a02 = _mm_set1_pd(axis[0][2]), a12 = _mm_set1_pd(axis[1][2]), a22 = _mm_set1_pd(axis[2][2]);
+    const __m128d vHalfWidth = _mm_set1_pd(halfWidth), vHalfHeight = _mm_set1_pd(halfHeight);
+    const __m128d vRadius = _mm_set1_pd(pixelRadius), vZero = _mm_setzero_pd();
+    const __m128d vMinX = _mm_set1_pd(minX), vMaxX = _mm_set1_pd(maxX);
+    const __m128d vMinY = _mm_set1_pd(minY), vMaxY = _mm_set1_pd(maxY);
+
+    for(; i + 2 <= cnt; i += 2)
+    {
+      const __m128d vx = _mm_loadu_pd(qx + i), vy = _mm_loadu_pd(qy + i), vz = _mm_loadu_pd(qz + i);
+      const __m128d rx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a00, vx), _mm_mul_pd(a10, vy)), _mm_mul_pd(a20, vz));
+      const __m128d ry = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a01, vx), _mm_mul_pd(a11, vy)), _mm_mul_pd(a21, vz));
+      const __m128d vrz = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a02, vx), _mm_mul_pd(a12, vy)), _mm_mul_pd(a22, vz));
+
+      const __m128d sx = _mm_add_pd(vHalfWidth, _mm_mul_pd(vRadius, rx));
+      const __m128d sy = _mm_sub_pd(vHalfHeight, _mm_mul_pd(vRadius, ry));
+      _mm_storeu_pd(xs + i, sx);
+      _mm_storeu_pd(ys + i, sy);
+      _mm_storeu_pd(rz + i, vrz);
+
+      // Visible if in front of the globe and on screen
+      __m128d in = _mm_cmpge_pd(vrz, vZero);
+      in = _mm_and_pd(in, _mm_and_pd(_mm_cmpge_pd(sx, vMinX), _mm_cmplt_pd(sx, vMaxX)));
+      in = _mm_and_pd(in, _mm_and_pd(_mm_cmpge_pd(sy, vMinY), _mm_cmplt_pd(sy, vMaxY)));
+      const int mask = _mm_movemask_pd(in);
+      vis[i] = (mask & 1) != 0;
+      vis[i + 1] = (mask & 2) != 0;
+    }
+#endif
+
+    for(; i < cnt; i++)
+    {
+      const double rx = axis[0][0] * qx[i] + axis[1][0] * qy[i] + axis[2][0] * qz[i];
+      const double ry = axis[0][1] * qx[i] + axis[1][1] * qy[i] + axis[2][1] * qz[i];
+      rz[i] = axis[0][2] * qx[i] + axis[1][2] * qy[i] + axis[2][2] * qz[i];
+
+      const double sx = halfWidth + pixelRadius * rx, sy = halfHeight - pixelRadius * ry;
+      xs[i] = sx;
+      ys[i] = sy;
+
+      // Non short-circuit operators to avoid branches
+      vis[i] = (rz[i] >= 0.) & (sx >= minX) & (sx < maxX) & (sy >= minY) & (sy < maxY);
+    }
+
+    // Point is on the other side of the earth
+    if(isHidden != nullptr)
+    {
+      for(int j = 0; j < cnt; j++)
+        isHidden[start + j] = rz[j] < 0.;
+    }
+  }
+}
+
+/* Same as Marble::MercatorProjection::screenCoordinates returning the first repetition only.
+ * Like the spherical projection done in a scalar pass for the trigonometric functions and a second
+ * branch free pass for the screen coordinates. */
+void CoordinateConverter::wToSBatchMercator(const float *lonX, const float *latY, int num, double *x, double *y,
+                                            bool *visible, bool *isHidden, const QSize& size) const
+{
+  const Marble::AbstractProjection *projection = viewport->currentProjection();
+  const double maxLat = projection->maxValidLat();
+  const bool repeatX = projection->repeatX();
+
+  const int radius = viewport->radius();
+  const double width = viewport->width(), height = viewport->height();
+  const double rad2Pixel = 2. * radius / M_PI;
+  const double centerLon = viewport->centerLongitude();
+  const double centerLatY = std::atanh(std::sin(viewport->centerLatitude()));
+  const double sizeX = size.width(), sizeX2 = size.width() / 2., sizeY2 = size.height() / 2.;
+  const double xRepeatDistance = 4 * radius;
+
+  // Screen bounds extended by half of the estimated object size
+  const double minX = -sizeX2, maxX = width + sizeX2, minY = -sizeY2, maxY = height + sizeY2;
+
+  // Offsets to screen coordinates: xs = offsetX + rad2Pixel * lon and ys = offsetY - rad2Pixel * mercatorY
+  const double offsetX = width / 2. - rad2Pixel * centerLon, offsetY = height / 2. + rad2Pixel * centerLatY;
+
+  // Flat projection - nothing is hidden
+  if(isHidden != nullptr)
+    std::fill(isHidden, isHidden + num, false);
+
+  double lonRad[BATCH_CHUNK_SIZE], mercY[BATCH_CHUNK_SIZE], valid[BATCH_CHUNK_SIZE];
+
+  for(int start = 0; start < num; start += BATCH_CHUNK_SIZE)
+  {
+    const int cnt = std::min(num - start, BATCH_CHUNK_SIZE);
+    const float *lons = lonX + start, *lats = latY + start;
+    double *xs = x + start, *ys = y + start;
+    bool *vis = visible + start;
+
+    // Mercator y for the latitude clamped to the valid range. valid is 1 or 0 to be used as a factor.
+    for(int i = 0; i < cnt; i++)
+    {
+      const double lat = lats[i] * DEG2RAD;
+      const double clamped = std::max(-maxLat, std::min(lat, maxLat));
+      lonRad[i] = lons[i] * DEG2RAD;
+      mercY[i] = std::atanh(std::sin(clamped));
+      valid[i] = std::abs(lat) <= maxLat;
+    }
+
+    int i = 0;
+#ifdef LITTLENAVMAP_BATCH_SSE2
+    const __m128d vOffsetX = _mm_set1_pd(offsetX), vOffsetY = _mm_set1_pd(offsetY);
+    const __m128d vRad2Pixel = _mm_set1_pd(rad2Pixel), vZero = _mm_setzero_pd();
+    const __m128d vMinX = _mm_set1_pd(minX), vMaxX = _mm_set1_pd(maxX);
+    const __m128d vMinY = _mm_set1_pd(minY), vMaxY = _mm_set1_pd(maxY);
+    const __m128d vSizeX = _mm_set1_pd(sizeX), vRepeat = _mm_set1_pd(xRepeatDistance);
+
+    for(; i + 2 <= cnt; i += 2)
+    {
+      const __m128d vValid = _mm_cmpneq_pd(_mm_loadu_pd(valid + i), vZero);
+      const __m128d itX = _mm_add_pd(vOffsetX, _mm_mul_pd(vRad2Pixel, _mm_loadu_pd(lonRad + i)));
+      const __m128d sy = _mm_sub_pd(vOffsetY, _mm_mul_pd(vRad2Pixel, _mm_loadu_pd(mercY + i)));
+
+      __m128d in = _mm_and_pd(vValid, _mm_and_pd(_mm_cmpge_pd(sy, vMinY), _mm_cmplt_pd(sy, vMaxY)));
+      __m128d sx = itX;
+      if(!repeatX)
+        in = _mm_and_pd(in, _mm_and_pd(_mm_cmpgt_pd(itX, vMinX), _mm_cmplt_pd(itX, vMaxX)));
+      else
+      {
+        // Find the leftmost repetition which is visible on screen
+        const __m128d right = _mm_add_pd(itX, vSizeX);
+        const __m128d reps = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_div_pd(right, vRepeat)));
+        __m128d rep = _mm_sub_pd(itX, _mm_and_pd(_mm_cmpgt_pd(right, vRepeat), _mm_mul_pd(reps, vRepeat)));
+        rep = _mm_add_pd(rep, _mm_and_pd(_mm_cmplt_pd(rep, vMinX), vRepeat));
+        in = _mm_and_pd(in, _mm_cmple_pd(rep, vMaxX));
+
+        // Use repetition only if visible
+        sx = _mm_or_pd(_mm_and_pd(in, rep), _mm_andnot_pd(in, itX));
+      }
+
+      // Invalid latitudes result in 0, 0
+      _mm_storeu_pd(xs + i, _mm_and_pd(vValid, sx));
+      _mm_storeu_pd(ys + i, _mm_and_pd(vValid, sy));
+      const int mask = _mm_movemask_pd(in);
+      vis[i] = (mask & 1) != 0;
+      vis[i + 1] = (mask & 2) != 0;
+    }
+#endif
+
+    for(; i < cnt; i++)
+    {
+      const double itX = offsetX + rad2Pixel * lonRad[i];
+      const double sy = offsetY - rad2Pixel * mercY[i];
+
+      // Non short-circuit operators and selects to avoid branches
+      bool in = (valid[i] != 0.) & (sy >= minY) & (sy < maxY);
+      double sx = itX;
+      if(!repeatX)
+        in = in & (itX > minX) & (itX < maxX);
+      else
+      {
+        // Find the leftmost repetition which is visible on screen
+        const double right = itX + sizeX;
+        double rep = itX - (right > xRepeatDistance) * std::trunc(right / xRepeatDistance) * xRepeatDistance;
+        rep += (rep < minX) * xRepeatDistance;
+        in = in & (rep <= maxX);
+        sx = in ? rep : itX;
+      }
+
+      // Invalid latitudes result in 0, 0
+      xs[i] = sx * valid[i];
+      ys[i] = sy * valid[i];
+      vis[i] = in;
+    }
+  }
+}
+
 bool CoordinateConverter::wToSInternal(const Marble::GeoDataCoordinates& coords, double& x, double& y,
                                        const QSize& size, bool *isHidden) const
 {
@@ -103,6 +103,24 @@ public:
   bool wToS(const atools::geo::Line& coords, QLineF& line, const QSize& size = DEFAULT_WTOS_SIZE,
             bool *isHidden = nullptr) const;
 
+  /*
+   * Convert an array of world coordinates to screen coordinates in one pass. The spherical and Mercator
+   * projections are calculated here using the same formulas as Marble but without creating
+   * GeoDataCoordinates and going through the projection classes for each point. All other projections
+   * fall back to wToS for each point.
+   *
+   * @param lonX longitude array in degree
+   * @param latY latitude array in degree
+   * @param num number of coordinates
+   * @param x resulting screen coordinates. Not valid if hidden.
+   * @param y resulting screen coordinates. Not valid if hidden.
+   * @param visible true if coordinate is visible and not hidden
+   * @param isHidden if not null will indicate if coordinate is hidden behind globe
+   * @param size estimated screen size for Mercator projection
+   */
+  void wToSBatch(const float *lonX, const float *latY, int num, double *x, double *y, bool *visible,
+                 bool *isHidden = nullptr, const QSize& size = DEFAULT_WTOS_SIZE) const;
+
   bool sToW(int x, int y, Marble::GeoDataCoordinates& coords) const;
 
   /* Converte screen to world coordinates */
@@ -119,6 +137,11 @@ public:
     Marble::GeoDataCoordinates::FinalBearing;
 
 private:
+  void wToSBatchSpherical(const float *lonX, const float *latY, int num, double *x, double *y, bool *visible,
+                          bool *isHidden, const QSize& size) const;
+  void wToSBatchMercator(const float *lonX, const float *latY, int num, double *x, double *y, bool *visible,
+                         bool *isHidden, const QSize& size) const;
+
   bool wToSInternal(const Marble::GeoDataCoordinates& coords, double& x, double& y, const QSize& size,
                     bool *isHidden) const;
 
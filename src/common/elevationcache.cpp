@@ -0,0 +1,492 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "common/elevationcache.h"
+
+#include "fs/common/globereader.h"
+#include "geo/calculations.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+#include "geo/pos.h"
+#include "geo/rect.h"
+#include "settings/settings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using atools::geo::Pos;
+using atools::geo::Line;
+using atools::geo::LineString;
+using atools::geo::Rect;
+
+/* GLOBE tiles are 10800 samples wide and arranged in four rows of four tiles from north to south */
+static Q_DECL_CONSTEXPR int TILE_COLUMNS = 10800;
+static const int TILE_ROWS[4] = {4800, 6000, 6000, 4800};
+static const int TILE_ROW_OFFSET[4] = {0, 4800, 10800, 16800};
+
+/* Distance between points for getElevations */
+static Q_DECL_CONSTEXPR float SAMPLE_DISTANCE_METER = 500.f;
+
+static const quint32 PYRAMID_MAGIC = 0x4c4e4d50; /* "LNMP" */
+static const quint32 PYRAMID_VERSION = 1;
+
+Q_DECL_CONSTEXPR int ElevationCache::SAMPLES_PER_DEGREE;
+Q_DECL_CONSTEXPR int ElevationCache::GLOBE_COLUMNS;
+Q_DECL_CONSTEXPR int ElevationCache::GLOBE_ROWS;
+Q_DECL_CONSTEXPR int ElevationCache::PYRAMID_BASE_SAMPLES;
+Q_DECL_CONSTEXPR int ElevationCache::NUM_PYRAMID_LEVELS;
+
+namespace {
+
+/* Header of the pyramid file. Followed by the cells of all levels in row major order. */
+struct PyramidHeader
+{
+  quint32 magic;
+  quint32 version;
+  char fingerprint[16];
+  qint32 numLevels;
+  qint32 baseSamples;
+};
+
+/* Path of the GLOBE file for tile index 0 to 15 or empty if not found */
+QString globeFile(const QString& path, int index)
+{
+  QString name = QString(QChar('a' + index)) + "10g";
+  QFileInfo fi(QDir(path), name);
+  if(!fi.exists())
+    fi = QFileInfo(QDir(path), name.toUpper());
+  return fi.exists() ? fi.absoluteFilePath() : QString();
+}
+
+inline qint16 validElevation(qint16 value)
+{
+  return value > atools::fs::common::OCEAN && value < atools::fs::common::INVALID ? value : 0;
+}
+
+inline qint16 readSample(const uchar *data, int index)
+{
+  return validElevation(qFromLittleEndian<qint16>(data + index * 2));
+}
+
+/* Number of cells of the given size needed to cover num samples */
+inline int numCells(int num, int samples)
+{
+  return (num + samples - 1) / samples;
+}
+
+}
+
+ElevationCache::ElevationCache()
+{
+
+}
+
+ElevationCache::~ElevationCache()
+{
+  close();
+}
+
+QString ElevationCache::pyramidFilename()
+{
+  return atools::settings::Settings::getConfigFilename("_elevation.pyramid");
+}
+
+bool ElevationCache::openGlobe(const QString& path)
+{
+  close();
+
+  for(int i = 0; i < 16; i++)
+  {
+    QString filename = globeFile(path, i);
+    qint64 expectedSize = static_cast<qint64>(TILE_ROWS[i / 4]) * TILE_COLUMNS * 2;
+
+    QFile *file = new QFile(filename);
+    const uchar *data = nullptr;
+    if(!filename.isEmpty() && file->open(QIODevice::ReadOnly) && file->size() == expectedSize)
+      data = file->map(0, expectedSize);
+
+    if(data == nullptr)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot map GLOBE file" << i << filename << file->errorString();
+      delete file;
+      close();
+      return false;
+    }
+    tiles.append({file, data});
+  }
+
+  globePath = path;
+  return true;
+}
+
+bool ElevationCache::openPyramid()
+{
+  levels.clear();
+  pyramidFile.close();
+
+  if(!isGlobeValid())
+    return false;
+
+  pyramidFile.setFileName(pyramidFilename());
+  if(!pyramidFile.open(QIODevice::ReadOnly) || pyramidFile.size() < static_cast<qint64>(sizeof(PyramidHeader)))
+    return false;
+
+  const uchar *data = pyramidFile.map(0, pyramidFile.size());
+  if(data == nullptr)
+  {
+    pyramidFile.close();
+    return false;
+  }
+
+  const PyramidHeader *header = reinterpret_cast<const PyramidHeader *>(data);
+  if(header->magic != PYRAMID_MAGIC || header->version != PYRAMID_VERSION ||
+     header->numLevels != NUM_PYRAMID_LEVELS || header->baseSamples != PYRAMID_BASE_SAMPLES ||
+     QByteArray(header->fingerprint, sizeof(header->fingerprint)) != globeFingerprint(globePath))
+  {
+    qInfo() << Q_FUNC_INFO << "Elevation pyramid is outdated" << pyramidFile.fileName();
+    pyramidFile.close();
+    return false;
+  }
+
+  // Calculate level layout and check file size
+  qint64 offset = sizeof(PyramidHeader);
+  QVector<Level> lvls;
+  for(int i = 0, samples = PYRAMID_BASE_SAMPLES; i < NUM_PYRAMID_LEVELS; i++, samples *= 2)
+  {
+    Level level;
+    level.samples = samples;
+    level.columns = numCells(GLOBE_COLUMNS, samples);
+    level.rows = numCells(GLOBE_ROWS, samples);
+    level.cells = reinterpret_cast<const Cell *>(data + offset);
+    offset += static_cast<qint64>(level.columns) * level.rows * static_cast<qint64>(sizeof(Cell));
+    lvls.append(level);
+  }
+
+  if(offset != pyramidFile.size())
+  {
+    qWarning() << Q_FUNC_INFO << "Elevation pyramid has wrong size" << pyramidFile.fileName();
+    pyramidFile.close();
+    return false;
+  }
+
+  levels = lvls;
+  return true;
+}
+
+void ElevationCache::close()
+{
+  levels.clear();
+  pyramidFile.close();
+
+  for(const Tile& tile : tiles)
+  {
+    tile.file->close();
+    delete tile.file;
+  }
+  tiles.clear();
+  globePath.clear();
+}
+
+QByteArray ElevationCache::globeFingerprint(const QString& path)
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(QDir(path).absolutePath().toUtf8());
+  for(int i = 0; i < 16; i++)
+  {
+    QFileInfo fi(globeFile(path, i));
+    hash.addData(QByteArray::number(fi.size()));
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+  }
+  return hash.result();
+}
+
+bool ElevationCache::buildPyramid(const QString& path, const QAtomicInt& cancel)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  ElevationCache globe;
+  if(!globe.openGlobe(path))
+    return false;
+
+  // Level 1 directly from the GLOBE samples
+  QVector<QVector<Cell> > cellLevels;
+  int columns = numCells(GLOBE_COLUMNS, PYRAMID_BASE_SAMPLES), rows = numCells(GLOBE_ROWS, PYRAMID_BASE_SAMPLES);
+  QVector<Cell> base(columns * rows, {std::numeric_limits<qint16>::max(), std::numeric_limits<qint16>::min()});
+
+  for(int tileIdx = 0; tileIdx < globe.tiles.size(); tileIdx++)
+  {
+    const uchar *data = globe.tiles.at(tileIdx).data;
+    int rowOffset = TILE_ROW_OFFSET[tileIdx / 4], columnOffset = (tileIdx % 4) * TILE_COLUMNS;
+
+    for(int row = 0; row < TILE_ROWS[tileIdx / 4]; row++)
+    {
+      if(cancel.load() != 0)
+        return false;
+
+      Cell *cellRow = base.data() + ((rowOffset + row) / PYRAMID_BASE_SAMPLES) * columns;
+      for(int column = 0; column < TILE_COLUMNS; column++)
+      {
+        qint16 value = readSample(data, row * TILE_COLUMNS + column);
+        Cell& cell = cellRow[(columnOffset + column) / PYRAMID_BASE_SAMPLES];
+        cell.min = std::min(cell.min, value);
+        cell.max = std::max(cell.max, value);
+      }
+    }
+  }
+  cellLevels.append(base);
+
+  // Each following level combines 2 x 2 cells of the previous one
+  for(int i = 1; i < NUM_PYRAMID_LEVELS; i++)
+  {
+    const QVector<Cell>& prev = cellLevels.last();
+    int prevColumns = columns, prevRows = rows;
+    columns = numCells(prevColumns, 2);
+    rows = numCells(prevRows, 2);
+
+    QVector<Cell> level(columns * rows, {std::numeric_limits<qint16>::max(), std::numeric_limits<qint16>::min()});
+    for(int row = 0; row < prevRows; row++)
+    {
+      for(int column = 0; column < prevColumns; column++)
+      {
+        const Cell& from = prev.at(row * prevColumns + column);
+        Cell& to = level[(row / 2) * columns + column / 2];
+        to.min = std::min(to.min, from.min);
+        to.max = std::max(to.max, from.max);
+      }
+    }
+    cellLevels.append(level);
+  }
+
+  // Write to a temporary file which replaces the old one on commit
+  QSaveFile file(pyramidFilename());
+  if(!file.open(QIODevice::WriteOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot write elevation pyramid" << file.fileName() << file.errorString();
+    return false;
+  }
+
+  PyramidHeader header;
+  header.magic = PYRAMID_MAGIC;
+  header.version = PYRAMID_VERSION;
+  QByteArray fingerprint = globeFingerprint(path);
+  std::copy(fingerprint.constBegin(), fingerprint.constBegin() + sizeof(header.fingerprint), header.fingerprint);
+  header.numLevels = NUM_PYRAMID_LEVELS;
+  header.baseSamples = PYRAMID_BASE_SAMPLES;
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for(const QVector<Cell>& level : cellLevels)
+    file.write(reinterpret_cast<const char *>(level.constData()), level.size() * static_cast<qint64>(sizeof(Cell)));
+
+  if(cancel.load() != 0)
+  {
+    file.cancelWriting();
+    return false;
+  }
+
+  bool retval = file.commit();
+  qDebug() << Q_FUNC_INFO << "Elevation pyramid" << file.fileName() << "built in" << timer.elapsed() << "ms";
+  return retval;
+}
+
+qint16 ElevationCache::sample(int row, int column) const
+{
+  int tileRow = row < TILE_ROW_OFFSET[1] ? 0 : row < TILE_ROW_OFFSET[2] ? 1 : row < TILE_ROW_OFFSET[3] ? 2 : 3;
+  int tileColumn = column / TILE_COLUMNS;
+  return readSample(tiles.at(tileRow * 4 + tileColumn).data,
+                    (row - TILE_ROW_OFFSET[tileRow]) * TILE_COLUMNS + column - tileColumn * TILE_COLUMNS);
+}
+
+float ElevationCache::getElevation(const atools::geo::Pos& pos) const
+{
+  float elevation;
+  getElevations(&pos, 1, &elevation);
+  return elevation;
+}
+
+void ElevationCache::getElevations(const atools::geo::Pos *positions, int num, float *elevations) const
+{
+  if(!isGlobeValid())
+  {
+    std::fill(elevations, elevations + num, 0.f);
+    return;
+  }
+
+  // Bounds of the last used tile in global sample coordinates
+  const uchar *data = nullptr;
+  int firstRow = 0, lastRow = -1, firstColumn = 0, lastColumn = -1;
+
+  for(int i = 0; i < num; i++)
+  {
+    const Pos& pos = positions[i];
+    if(!pos.isValid())
+    {
+      elevations[i] = 0.f;
+      continue;
+    }
+
+    int row = std::min(std::max(static_cast<int>((90. - pos.getLatY()) * SAMPLES_PER_DEGREE), 0), GLOBE_ROWS - 1);
+    int column = std::min(std::max(static_cast<int>((pos.getLonX() + 180.) * SAMPLES_PER_DEGREE), 0),
+                          GLOBE_COLUMNS - 1);
+
+    if(row < firstRow || row > lastRow || column < firstColumn || column > lastColumn)
+    {
+      // Position is outside of the last tile
+      int tileRow = row < TILE_ROW_OFFSET[1] ? 0 : row < TILE_ROW_OFFSET[2] ? 1 : row < TILE_ROW_OFFSET[3] ? 2 : 3;
+      int tileColumn = column / TILE_COLUMNS;
+      data = tiles.at(tileRow * 4 + tileColumn).data;
+      firstRow = TILE_ROW_OFFSET[tileRow];
+      lastRow = firstRow + TILE_ROWS[tileRow] - 1;
+      firstColumn = tileColumn * TILE_COLUMNS;
+      lastColumn = firstColumn + TILE_COLUMNS - 1;
+    }
+
+    elevations[i] = readSample(data, (row - firstRow) * TILE_COLUMNS + column - firstColumn);
+  }
+}
+
+void ElevationCache::getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line) const
+{
+  if(!isGlobeValid() || !line.isValid())
+    return;
+
+  const Pos& pos1 = line.getPos1();
+  const Pos& pos2 = line.getPos2();
+  float length = pos1.distanceMeterTo(pos2);
+  int num = std::max(static_cast<int>(std::ceil(length / SAMPLE_DISTANCE_METER)), 1);
+
+  QVector<Pos> positions;
+  positions.reserve(num + 1);
+  for(int i = 0; i <= num; i++)
+    positions.append(i == 0 ? pos1 : (i == num ? pos2 : pos1.interpolate(pos2, length, static_cast<float>(i) / num)));
+
+  QVector<float> alts(positions.size());
+  getElevations(positions.constData(), positions.size(), alts.data());
+
+  for(int i = 0; i < positions.size(); i++)
+  {
+    // Drop points inside a stretch of same elevation but keep first and last one
+    if(i > 0 && i < positions.size() - 1 && alts.at(i) == alts.at(i - 1) && alts.at(i) == alts.at(i + 1))
+      continue;
+
+    Pos pos = positions.at(i);
+    pos.setAltitude(alts.at(i));
+    elevations.append(pos);
+  }
+}
+
+qint16 ElevationCache::maxInRect(int level, double west, double north, double east, double south) const
+{
+  int samples = level == 0 ? 1 : levels.at(level - 1).samples;
+  int columns = level == 0 ? GLOBE_COLUMNS : levels.at(level - 1).columns;
+  int rows = level == 0 ? GLOBE_ROWS : levels.at(level - 1).rows;
+  double cellsPerDegree = static_cast<double>(SAMPLES_PER_DEGREE) / samples;
+
+  int firstRow = std::min(std::max(static_cast<int>((90. - north) * cellsPerDegree), 0), rows - 1);
+  int lastRow = std::min(std::max(static_cast<int>((90. - south) * cellsPerDegree), 0), rows - 1);
+  int firstColumn = std::min(std::max(static_cast<int>((west + 180.) * cellsPerDegree), 0), columns - 1);
+  int lastColumn = std::min(std::max(static_cast<int>((east + 180.) * cellsPerDegree), 0), columns - 1);
+
+  // Wrap around at the anti-meridian
+  if(west > east)
+    lastColumn += columns;
+  lastColumn = std::min(lastColumn, firstColumn + columns - 1);
+
+  qint16 maxElevation = std::numeric_limits<qint16>::min();
+  for(int row = firstRow; row <= lastRow; row++)
+  {
+    for(int col = firstColumn; col <= lastColumn; col++)
+    {
+      int column = col % columns;
+      if(level == 0)
+        maxElevation = std::max(maxElevation, sample(row, column));
+      else
+        maxElevation = std::max(maxElevation, levels.at(level - 1).cells[row * columns + column].max);
+    }
+  }
+  return maxElevation;
+}
+
+float ElevationCache::getMaxElevation(const atools::geo::Rect& rect) const
+{
+  if(!isGlobeValid() || !rect.isValid())
+    return 0.f;
+
+  double west = rect.getWest(), east = rect.getEast(), north = rect.getNorth(), south = rect.getSouth();
+  double width = west > east ? 360. - west + east : east - west;
+  double sizeDeg = std::max(width, north - south);
+
+  // Use the coarsest level that still has a few cells across the rectangle
+  int level = 0;
+  for(int i = levels.size(); i > 0; i--)
+  {
+    if(static_cast<double>(levels.at(i - 1).samples) / SAMPLES_PER_DEGREE <= sizeDeg / 2.)
+    {
+      level = i;
+      break;
+    }
+  }
+
+  return maxInRect(level, west, north, east, south);
+}
+
+void ElevationCache::getMaxElevations(atools::geo::LineString& elevations, const atools::geo::Line& line,
+                                      float sampleDistMeter) const
+{
+  if(!isGlobeValid() || !line.isValid())
+    return;
+
+  const Pos& pos1 = line.getPos1();
+  const Pos& pos2 = line.getPos2();
+  sampleDistMeter = std::max(sampleDistMeter, 100.f);
+  float length = pos1.distanceMeterTo(pos2);
+  int num = std::max(static_cast<int>(std::ceil(length / sampleDistMeter)), 1);
+
+  // Half size of the area covered by one sample
+  float halfLatDeg = atools::geo::meterToNm(sampleDistMeter / 2.f) / 60.f;
+
+  for(int i = 0; i <= num; i++)
+  {
+    Pos pos = i == 0 ? pos1 : (i == num ? pos2 : pos1.interpolate(pos2, length, static_cast<float>(i) / num));
+    float halfLonDeg = std::min(halfLatDeg / std::max(std::cos(atools::geo::toRadians(pos.getLatY())), 0.01f), 180.f);
+
+    float west = pos.getLonX() - halfLonDeg, east = pos.getLonX() + halfLonDeg;
+    if(west < -180.f)
+      west += 360.f;
+    if(east > 180.f)
+      east -= 360.f;
+    if(halfLonDeg >= 180.f)
+    {
+      west = -180.f;
+      east = 180.f;
+    }
+
+    pos.setAltitude(getMaxElevation(Rect(west, std::min(pos.getLatY() + halfLatDeg, 90.f),
+                                         east, std::max(pos.getLatY() - halfLatDeg, -90.f))));
+    elevations.append(pos);
+  }
+}
@@ -0,0 +1,147 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ELEVATIONCACHE_H
+#define LITTLENAVMAP_ELEVATIONCACHE_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class Pos;
+class Line;
+class LineString;
+class Rect;
+}
+}
+
+/*
+ * Read only elevation data for lock free access from any number of threads.
+ *
+ * Level 0 is the full resolution GLOBE data which is accessed by memory mapping the 16 GLOBE tile files.
+ * Levels 1 to NUM_PYRAMID_LEVELS form a min/max pyramid stored in a memory mapped cache file in the settings
+ * directory. A cell of level 1 covers 16 x 16 GLOBE samples and each following level doubles the cell size.
+ *
+ * The pyramid file is built once from the GLOBE data with buildPyramid() and rebuilt if the GLOBE files change.
+ * All elevations are in meter. Ocean and invalid samples are returned as 0.
+ */
+class ElevationCache
+{
+public:
+  ElevationCache();
+  ~ElevationCache();
+
+  /* Map all GLOBE tile files in path. Returns false if any file is missing or cannot be mapped. */
+  bool openGlobe(const QString& path);
+
+  /* Map the pyramid file. Returns false if it does not exist or was built from other GLOBE files. */
+  bool openPyramid();
+
+  /* Unmap all files */
+  void close();
+
+  /* Build the pyramid file for the GLOBE files in path. Can be called from any thread. Stops and returns false if
+   * the value of cancel is not 0. */
+  static bool buildPyramid(const QString& path, const QAtomicInt& cancel);
+
+  /* Full path to pyramid file */
+  static QString pyramidFilename();
+
+  /* GLOBE files are mapped */
+  bool isGlobeValid() const
+  {
+    return !tiles.isEmpty();
+  }
+
+  /* GLOBE files and pyramid are mapped */
+  bool isValid() const
+  {
+    return isGlobeValid() && !levels.isEmpty();
+  }
+
+  /* Elevation at position from full resolution data */
+  float getElevation(const atools::geo::Pos& pos) const;
+
+  /* Elevations for num positions into the array elevations. Avoids repeated tile lookups for positions
+   * close to each other. */
+  void getElevations(const atools::geo::Pos *positions, int num, float *elevations) const;
+
+  /* Get elevations along a great circle line from full resolution data. Creates a point every 500 meters and
+   * removes consecutive ones with the same elevation. */
+  void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line) const;
+
+  /* Maximum elevation in rectangle. Uses the coarsest level which resolves the rectangle. The result covers at
+   * least the rectangle and can include elevations slightly outside. Slow for large rectangles if the pyramid
+   * is not available. */
+  float getMaxElevation(const atools::geo::Rect& rect) const;
+
+  /* Sample the great circle line every sampleDistMeter and return the maximum elevation of the area covered by
+   * each sample as altitude. Start and end point are always included. */
+  void getMaxElevations(atools::geo::LineString& elevations, const atools::geo::Line& line,
+                        float sampleDistMeter) const;
+
+  /* GLOBE grid has 120 samples per degree */
+  static Q_DECL_CONSTEXPR int SAMPLES_PER_DEGREE = 120;
+  static Q_DECL_CONSTEXPR int GLOBE_COLUMNS = 360 * SAMPLES_PER_DEGREE;
+  static Q_DECL_CONSTEXPR int GLOBE_ROWS = 180 * SAMPLES_PER_DEGREE;
+
+  /* Number of GLOBE samples along the side of a level 1 cell */
+  static Q_DECL_CONSTEXPR int PYRAMID_BASE_SAMPLES = 16;
+  static Q_DECL_CONSTEXPR int NUM_PYRAMID_LEVELS = 6;
+
+private:
+  struct Cell
+  {
+    qint16 min, max;
+  };
+
+  struct Level
+  {
+    int samples; /* GLOBE samples along the side of one cell */
+    int columns, rows;
+    const Cell *cells;
+  };
+
+  struct Tile
+  {
+    QFile *file;
+    const uchar *data;
+  };
+
+  /* Raw GLOBE value for global sample row and column with ocean and invalid values replaced by 0 */
+  qint16 sample(int row, int column) const;
+
+  /* Maximum of all cells of the level overlapping the rectangle */
+  qint16 maxInRect(int level, double west, double north, double east, double south) const;
+
+  /* Hash over path, sizes and modification times of the GLOBE files */
+  static QByteArray globeFingerprint(const QString& path);
+
+  /* 16 tiles a10g to p10g in row major order */
+  QVector<Tile> tiles;
+
+  /* Pyramid levels 1 to NUM_PYRAMID_LEVELS at index 0 to NUM_PYRAMID_LEVELS - 1 */
+  QVector<Level> levels;
+  QFile pyramidFile;
+
+  QString globePath;
+};
+
+#endif // LITTLENAVMAP_ELEVATIONCACHE_H
@@ -18,6 +18,7 @@
 #include "common/elevationprovider.h"
 
 #include "navapp.h"
+#include "common/elevationcache.h"
 #include "fs/common/globereader.h"
 #include "options/optiondata.h"
 #include "geo/line.h"
@@ -29,6 +30,7 @@
 #include <marble/ElevationModel.h>
 
 #include <QMessageBox>
+#include <QtConcurrent/QtConcurrentRun>
 
 /* Limt altitude to this value */
 static Q_DECL_CONSTEXPR float ALTITUDE_LIMIT_METER = 8800.f;
@@ -42,19 +44,39 @@ using atools::fs::common::GlobeReader;
 
 using namespace Marble;
 
+static void limitAltitude(LineString& elevations)
+{
+  for(Pos& pos : elevations)
+    // Limit ground altitude
+    pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
+}
+
 ElevationProvider::ElevationProvider(QObject *parent, const Marble::ElevationModel *model)
   : QObject(parent), marbleModel(model)
 {
   // Marble will let us know when updates are available
   connect(marbleModel, &ElevationModel::updateAvailable, this, &ElevationProvider::marbleUpdateAvailable);
+  connect(&pyramidWatcher, &QFutureWatcher<bool>::finished, this, &ElevationProvider::pyramidBuildFinished);
   updateReader();
 }
 
 ElevationProvider::~ElevationProvider()
 {
+  cancelPyramidBuild();
+  swapCache(nullptr);
   delete globeReader;
 }
 
+ElevationProvider::CacheReader::CacheReader(const ElevationProvider *provider)
+{
+  {
+    // Copy the reference only - elevations are read without lock
+    QMutexLocker locker(&provider->cacheMutex);
+    cacheRef = provider->elevationCache;
+  }
+  cache = cacheRef.data();
+}
+
 void ElevationProvider::marbleUpdateAvailable()
 {
   if(!isGlobeOfflineProvider())
@@ -63,6 +85,13 @@ void ElevationProvider::marbleUpdateAvailable()
 
 float ElevationProvider::getElevation(const atools::geo::Pos& pos)
 {
+  {
+    // Memory mapped data can be read by many threads at once
+    CacheReader reader(this);
+    if(reader.cache != nullptr)
+      return reader.cache->getElevation(pos);
+  }
+
   QMutexLocker locker(&mutex);
 
   if(isGlobeOfflineProvider())
@@ -82,6 +111,16 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   if(!line.isValid())
     return;
 
+  {
+    CacheReader reader(this);
+    if(reader.cache != nullptr)
+    {
+      reader.cache->getElevations(elevations, line);
+      limitAltitude(elevations);
+      return;
+    }
+  }
+
   QMutexLocker locker(&mutex);
 
   if(isGlobeOfflineProvider())
@@ -135,9 +174,51 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
     }
   }
 
-  for(Pos& pos : elevations)
-    // Limit ground altitude
-    pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
+  limitAltitude(elevations);
+}
+
+void ElevationProvider::getElevations(QVector<float>& elevations, const QVector<atools::geo::Pos>& positions)
+{
+  elevations.resize(positions.size());
+
+  {
+    CacheReader reader(this);
+    if(reader.cache != nullptr)
+    {
+      reader.cache->getElevations(positions.constData(), positions.size(), elevations.data());
+      return;
+    }
+  }
+
+  QMutexLocker locker(&mutex);
+  for(int i = 0; i < positions.size(); i++)
+  {
+    float elevation = isGlobeOfflineProvider() ? globeReader->getElevation(positions.at(i)) : 0.f;
+    elevations[i] = elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID ? elevation : 0.f;
+  }
+}
+
+void ElevationProvider::getMaxElevations(atools::geo::LineString& elevations, const atools::geo::Line& line,
+                                         float sampleDistMeter)
+{
+  {
+    CacheReader reader(this);
+    if(reader.cache != nullptr && reader.cache->isValid())
+    {
+      reader.cache->getMaxElevations(elevations, line, sampleDistMeter);
+      limitAltitude(elevations);
+      return;
+    }
+  }
+
+  // Cache was closed in the meantime
+  getElevations(elevations, line);
+}
+
+bool ElevationProvider::isElevationCacheValid() const
+{
+  CacheReader reader(this);
+  return reader.cache != nullptr && reader.cache->isValid();
 }
 
 bool ElevationProvider::isGlobeDirectoryValid(const QString& path) const
@@ -177,7 +258,10 @@ void ElevationProvider::updateReader()
           QMessageBox::warning(NavApp::getQMainWidget(), NavApp::applicationName(),
                                tr("Cannot open GLOBE data in directory<br/><i>%1</i>").arg(path));
           qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
+          updateCache(QString());
         }
+        else
+          updateCache(path);
       }
     }
   }
@@ -185,7 +269,74 @@ void ElevationProvider::updateReader()
   {
     delete globeReader;
     globeReader = nullptr;
+    updateCache(QString());
   }
 
   emit updateAvailable();
 }
+
+void ElevationProvider::updateCache(const QString& path)
+{
+  cancelPyramidBuild();
+
+  ElevationCache *cache = nullptr;
+  if(!path.isEmpty())
+  {
+    cache = new ElevationCache;
+    if(!cache->openGlobe(path))
+    {
+      // Probably not enough address space - fall back to the GLOBE reader
+      delete cache;
+      cache = nullptr;
+    }
+    else if(!cache->openPyramid())
+    {
+      qDebug() << Q_FUNC_INFO << "Building elevation pyramid";
+      pyramidWatcher.setFuture(QtConcurrent::run([ = ]() -> bool
+      {
+        return ElevationCache::buildPyramid(path, pyramidCancel);
+      }));
+    }
+  }
+
+  cachePath = cache != nullptr ? path : QString();
+  swapCache(cache);
+}
+
+void ElevationProvider::pyramidBuildFinished()
+{
+  if(pyramidWatcher.result() && !cachePath.isEmpty())
+  {
+    // Open a new instance including the pyramid since published caches are never changed
+    ElevationCache *cache = new ElevationCache;
+    if(cache->openGlobe(cachePath) && cache->openPyramid())
+    {
+      swapCache(cache);
+      emit updateAvailable();
+    }
+    else
+      delete cache;
+  }
+}
+
+void ElevationProvider::swapCache(ElevationCache *cache)
+{
+  QSharedPointer<const ElevationCache> old;
+  {
+    QMutexLocker locker(&cacheMutex);
+    old = elevationCache;
+    elevationCache = QSharedPointer<const ElevationCache>(cache);
+  }
+
+  // Old cache is deleted here or later by the last reader still using it
+}
+
+void ElevationProvider::cancelPyramidBuild()
+{
+  if(pyramidWatcher.isRunning())
+  {
+    pyramidCancel.store(1);
+    pyramidWatcher.waitForFinished();
+  }
+  pyramidCancel.store(0);
+}
@@ -18,13 +18,19 @@
 #ifndef LITTLENAVMAP_ELEVATIONPROVIDER_H
 #define LITTLENAVMAP_ELEVATIONPROVIDER_H
 
+#include <QAtomicInt>
+#include <QFutureWatcher>
 #include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
+#include <QVector>
 
 namespace Marble {
 class ElevationModel;
 }
 
+class ElevationCache;
+
 namespace atools {
 namespace fs {
 namespace common {
@@ -43,7 +49,9 @@ class Line;
  * Wraps the slow Marble online elevation provider and the fast offline GLOBE data provider.
  * Use GLOBE data if all paramters are set properly in settings.
  *
- * Class is thread safe.
+ * Class is thread safe. Offline data is read from memory mapped GLOBE files by any number of threads without
+ * locking. Only copying the shared cache pointer is guarded by a short lock. The mutex is only used for the
+ * Marble model and the GLOBE reader fallback.
  */
 class ElevationProvider :
   public QObject
@@ -61,6 +69,18 @@ public:
    * consecutive ones with same elevation. Elevation given in meter */
   void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line);
 
+  /* Elevations in meter for all positions. Faster than calling getElevation for each position.
+   * elevations is resized to the number of positions. Only for offline data. */
+  void getElevations(QVector<float>& elevations, const QVector<atools::geo::Pos>& positions);
+
+  /* Get points along a great circle line every sampleDistMeter. Altitude of each point is the maximum elevation
+   * of the area covered by the point. Falls back to getElevations if the elevation pyramid is not available.
+   * Elevation given in meter */
+  void getMaxElevations(atools::geo::LineString& elevations, const atools::geo::Line& line, float sampleDistMeter);
+
+  /* true if the memory mapped GLOBE data and the min/max pyramid are available for getMaxElevations */
+  bool isElevationCacheValid() const;
+
   /* true if the data is provided from the fast offline source */
   bool isGlobeOfflineProvider() const
   {
@@ -81,12 +101,43 @@ private:
   void marbleUpdateAvailable();
   void updateReader();
 
+  /* Keeps the current elevation cache alive while in scope. cache is null if no cache is available. */
+  class CacheReader
+  {
+public:
+    CacheReader(const ElevationProvider *provider);
+
+    const ElevationCache *cache;
+
+private:
+    QSharedPointer<const ElevationCache> cacheRef;
+  };
+
+  /* Map GLOBE files and start building the pyramid in background if needed */
+  void updateCache(const QString& path);
+  void pyramidBuildFinished();
+  void cancelPyramidBuild();
+
+  /* Publish new cache. The old one is deleted by whoever releases the last reference to it. */
+  void swapCache(ElevationCache *cache);
+
   const Marble::ElevationModel *marbleModel = nullptr;
   atools::fs::common::GlobeReader *globeReader = nullptr;
 
   /* Need to synchronize here since it is called from profile widget thread */
   mutable QMutex mutex;
 
+  /* Read only memory mapped elevation data. Never changed after publishing. Replaced as a whole.
+   * Each reader holds its own reference so the last user of a replaced cache deletes it. */
+  QSharedPointer<const ElevationCache> elevationCache;
+
+  /* Guards only copying and replacing elevationCache */
+  mutable QMutex cacheMutex;
+  QString cachePath;
+
+  QFutureWatcher<bool> pyramidWatcher;
+  QAtomicInt pyramidCancel;
+
 };
 
 #endif // LITTLENAVMAP_ELEVATIONPROVIDER_H
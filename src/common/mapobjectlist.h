@@ -0,0 +1,258 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPOBJECTLIST_H
+#define LITTLENAVMAP_MAPOBJECTLIST_H
+
+#include "common/maptypes.h"
+
+#include <QVector>
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace map {
+
+/* Bits of the packed flags column for navaids. Airports use the map::MapAirportFlags. */
+enum MapObjectListFlag
+{
+  OBJ_NONE = 0,
+  OBJ_VOR_DME_ONLY = 1 << 0,
+  OBJ_VOR_HAS_DME = 1 << 1,
+  OBJ_VOR_TACAN = 1 << 2,
+  OBJ_VOR_VORTAC = 1 << 3,
+  OBJ_WAYPOINT_VICTOR = 1 << 4,
+  OBJ_WAYPOINT_JET = 1 << 5
+};
+
+/* Flags packed into the flags column of MapObjectList */
+template<typename TYPE>
+quint32 packedFlags(const TYPE&)
+{
+  return OBJ_NONE;
+}
+
+inline quint32 packedFlags(const map::MapAirport& airport)
+{
+  return static_cast<quint32>(airport.flags);
+}
+
+inline quint32 packedFlags(const map::MapVor& vor)
+{
+  return (vor.dmeOnly ? OBJ_VOR_DME_ONLY : OBJ_NONE) | (vor.hasDme ? OBJ_VOR_HAS_DME : OBJ_NONE) |
+         (vor.tacan ? OBJ_VOR_TACAN : OBJ_NONE) | (vor.vortac ? OBJ_VOR_VORTAC : OBJ_NONE);
+}
+
+inline quint32 packedFlags(const map::MapWaypoint& waypoint)
+{
+  return (waypoint.hasVictorAirways ? OBJ_WAYPOINT_VICTOR : OBJ_NONE) |
+         (waypoint.hasJetAirways ? OBJ_WAYPOINT_JET : OBJ_NONE);
+}
+
+/*
+ * Columnar list of map objects.
+ *
+ * Objects are kept in one contiguous vector instead of a QList which allocates each of the large map structs
+ * separately. Coordinates, ids and flags are additionally stored in separate arrays which allows to cull
+ * objects against the viewport by streaming through a few floats only. The full object is accessed only for
+ * objects passing the culling.
+ *
+ * The interface is a subset of QList to allow range based loops and index access.
+ */
+template<typename TYPE>
+class MapObjectList
+{
+public:
+  typedef typename QVector<TYPE>::const_iterator const_iterator;
+
+  void clear()
+  {
+    objects.clear();
+    lonX.clear();
+    latY.clear();
+    ids.clear();
+    flags.clear();
+  }
+
+  void reserve(int size)
+  {
+    objects.reserve(size);
+    lonX.reserve(size);
+    latY.reserve(size);
+    ids.reserve(size);
+    flags.reserve(size);
+  }
+
+  void append(const TYPE& obj)
+  {
+    const atools::geo::Pos& pos = obj.getPosition();
+    objects.append(obj);
+    lonX.append(pos.getLonX());
+    latY.append(pos.getLatY());
+    ids.append(obj.getId());
+    flags.append(packedFlags(obj));
+  }
+
+  int size() const
+  {
+    return objects.size();
+  }
+
+  /* Remove num objects starting at index pos */
+  void remove(int pos, int num)
+  {
+    objects.remove(pos, num);
+    lonX.remove(pos, num);
+    latY.remove(pos, num);
+    ids.remove(pos, num);
+    flags.remove(pos, num);
+  }
+
+  bool isEmpty() const
+  {
+    return objects.isEmpty();
+  }
+
+  const TYPE& at(int i) const
+  {
+    return objects.at(i);
+  }
+
+  const_iterator begin() const
+  {
+    return objects.constBegin();
+  }
+
+  const_iterator end() const
+  {
+    return objects.constEnd();
+  }
+
+  /* Columns */
+  float lonXAt(int i) const
+  {
+    return lonX.at(i);
+  }
+
+  float latYAt(int i) const
+  {
+    return latY.at(i);
+  }
+
+  int idAt(int i) const
+  {
+    return ids.at(i);
+  }
+
+  quint32 flagsAt(int i) const
+  {
+    return flags.at(i);
+  }
+
+  /* Copy the coordinates of the objects at the given indexes into lonXs and latYs */
+  void positions(const QVector<int>& indexes, QVector<float>& lonXs, QVector<float>& latYs) const
+  {
+    lonXs.resize(indexes.size());
+    latYs.resize(indexes.size());
+    for(int i = 0; i < indexes.size(); i++)
+    {
+      lonXs[i] = lonX.at(indexes.at(i));
+      latYs[i] = latY.at(indexes.at(i));
+    }
+  }
+
+  /* Get indexes of all objects having their position inside the rectangle. Rectangle is enlarged by
+   * margin degrees on each side and can cross the anti-meridian. */
+  void indexesInRect(const atools::geo::Rect& rect, float margin, QVector<int>& indexes) const;
+
+  /* Stable sort of all columns by the given object comparison function */
+  template<typename LESS>
+  void sort(LESS lessThan);
+
+private:
+  QVector<TYPE> objects;
+  QVector<float> lonX, latY;
+  QVector<int> ids;
+  QVector<quint32> flags;
+};
+
+// ---------------------------------------------------------------------------------
+template<typename TYPE>
+void MapObjectList<TYPE>::indexesInRect(const atools::geo::Rect& rect, float margin, QVector<int>& indexes) const
+{
+  float north = std::min(rect.getNorth() + margin, 90.f), south = std::max(rect.getSouth() - margin, -90.f);
+  float west = rect.getWest(), east = rect.getEast();
+  float width = west > east ? 360.f - west + east : east - west;
+
+  bool crossing = false;
+  if(width + 2.f * margin >= 360.f)
+  {
+    // Covers all longitudes
+    west = -180.f;
+    east = 180.f;
+  }
+  else
+  {
+    // Normalize and check if the enlarged rectangle crosses the anti-meridian
+    west -= margin;
+    if(west < -180.f)
+      west += 360.f;
+    east += margin;
+    if(east > 180.f)
+      east -= 360.f;
+    crossing = west > east;
+  }
+
+  const float *lons = lonX.constData(), *lats = latY.constData();
+  for(int i = 0; i < lonX.size(); i++)
+  {
+    float lon = lons[i], lat = lats[i];
+    if(lat >= south && lat <= north &&
+       (crossing ? (lon >= west || lon <= east) : (lon >= west && lon <= east)))
+      indexes.append(i);
+  }
+}
+
+template<typename TYPE>
+template<typename LESS>
+void MapObjectList<TYPE>::sort(LESS lessThan)
+{
+  // Sort an index permutation and rebuild all columns from it
+  QVector<int> order(objects.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this, &lessThan](int i1, int i2) -> bool
+  {
+    return lessThan(objects.at(i1), objects.at(i2));
+  });
+
+  MapObjectList<TYPE> sorted;
+  sorted.reserve(objects.size());
+  for(int i : order)
+  {
+    sorted.objects.append(objects.at(i));
+    sorted.lonX.append(lonX.at(i));
+    sorted.latY.append(latY.at(i));
+    sorted.ids.append(ids.at(i));
+    sorted.flags.append(flags.at(i));
+  }
+  *this = std::move(sorted);
+}
+
+} // namespace map
+
+#endif // LITTLENAVMAP_MAPOBJECTLIST_H
@@ -16,3 +16,82 @@
 *****************************************************************************/
 
 #include "common/maptools.h"
+
+#include "geo/linestring.h"
+
+#include <algorithm>
+#include <cmath>
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+
+namespace maptools {
+
+void douglasPeucker(QVector<bool>& keep, const LineString& lineString, float tolerance)
+{
+  int num = lineString.size();
+  keep.fill(num < 4, num);
+  if(num < 4)
+    return;
+
+  keep[0] = keep[num - 1] = true;
+
+  // Scale longitude to get approximately equal distances
+  float lonScale = std::cos(atools::geo::toRadians(lineString.first().getLatY()));
+  float toleranceSq = tolerance * tolerance;
+
+  // Avoid recursion for boundaries with many points
+  QVector<std::pair<int, int> > stack;
+  stack.append(std::make_pair(0, num - 1));
+  while(!stack.isEmpty())
+  {
+    std::pair<int, int> range = stack.takeLast();
+    const Pos& p1 = lineString.at(range.first);
+    const Pos& p2 = lineString.at(range.second);
+    float x1 = p1.getLonX() * lonScale, y1 = p1.getLatY();
+    float dx = p2.getLonX() * lonScale - x1, dy = p2.getLatY() - y1;
+    float lenSq = dx * dx + dy * dy;
+
+    float maxDistSq = -1.f;
+    int maxIndex = -1;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      // Squared distance to segment which can be degenerated for closed lines
+      float px = lineString.at(i).getLonX() * lonScale - x1, py = lineString.at(i).getLatY() - y1;
+      float t = lenSq > 0.f ? std::min(std::max((px * dx + py * dy) / lenSq, 0.f), 1.f) : 0.f;
+      float ex = px - t * dx, ey = py - t * dy;
+      float distSq = ex * ex + ey * ey;
+      if(distSq > maxDistSq)
+      {
+        maxDistSq = distSq;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDistSq > toleranceSq)
+    {
+      keep[maxIndex] = true;
+      stack.append(std::make_pair(range.first, maxIndex));
+      stack.append(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  // Keep at least a triangle
+  if(std::count(keep.begin(), keep.end(), true) < 3)
+    keep.fill(true);
+}
+
+void simplify(LineString& result, const LineString& lineString, float tolerance)
+{
+  QVector<bool> keep;
+  douglasPeucker(keep, lineString, tolerance);
+
+  result.clear();
+  for(int i = 0; i < lineString.size(); i++)
+  {
+    if(keep.at(i))
+      result.append(lineString.at(i));
+  }
+}
+
+} // namespace maptools
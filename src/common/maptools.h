@@ -24,14 +24,28 @@
 #include "geo/pos.h"
 
 #include <QList>
+#include <QVector>
 #include <QSet>
 #include <algorithm>
 #include <functional>
 
 class CoordinateConverter;
 
+namespace atools {
+namespace geo {
+class LineString;
+}
+}
+
 namespace maptools {
 
+/* Douglas-Peucker simplification. Sets all points to true in keep which have to be kept for the given tolerance
+ * in degree. Keeps at least three points. */
+void douglasPeucker(QVector<bool>& keep, const atools::geo::LineString& lineString, float tolerance);
+
+/* Douglas-Peucker simplification of lineString into result for the given tolerance in degree */
+void simplify(atools::geo::LineString& result, const atools::geo::LineString& lineString, float tolerance);
+
 /* Erase all elements in the list except the closest. Returns distance in meter to the closest */
 template<typename TYPE>
 float removeFarthest(const atools::geo::Pos& pos, QList<TYPE>& list)
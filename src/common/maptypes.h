@@ -596,6 +596,11 @@ struct MapAirspace
     return bounding.isValid();
   }
 
+  atools::geo::Pos getPosition() const
+  {
+    return bounding.getCenter();
+  }
+
   int getId() const
   {
     return id;
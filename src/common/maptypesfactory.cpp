@@ -36,6 +36,15 @@ MapTypesFactory::~MapTypesFactory()
 
 }
 
+QString MapTypesFactory::intern(const QString& str)
+{
+  if(strings.size() > MAX_INTERNED_STRINGS)
+    // Strings in objects stay valid since they are implicitly shared
+    strings.clear();
+
+  return *strings.insert(str);
+}
+
 void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airport, bool complete, bool nav)
 {
   fillAirportBase(record, airport, complete);
@@ -55,7 +64,7 @@ void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airp
     airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"),
                            record.valueFloat("altitude"));
 
-    airport.region = record.valueStr("region", QString());
+    airport.region = intern(record.valueStr("region", QString()));
   }
   else
     airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), 0.f);
@@ -130,7 +139,7 @@ void MapTypesFactory::fillAirportBase(const SqlRecord& record, map::MapAirport&
   if(complete)
   {
     ap.towerFrequency = record.valueInt("tower_frequency");
-    ap.ident = record.valueStr("ident");
+    ap.ident = intern(record.valueStr("ident"));
     ap.name = record.valueStr("name");
     ap.rating = record.valueInt("rating", -1);
     ap.longestRunwayLength = record.valueInt("longest_runway_length");
@@ -273,20 +282,20 @@ void MapTypesFactory::fillVorFromNav(const SqlRecord& record, map::MapVor& vor)
 void MapTypesFactory::fillVorBase(const SqlRecord& record, map::MapVor& vor)
 {
   vor.id = record.valueInt("vor_id");
-  vor.ident = record.valueStr("ident");
-  vor.region = record.valueStr("region");
+  vor.ident = intern(record.valueStr("ident"));
+  vor.region = intern(record.valueStr("region"));
   vor.name = atools::capString(record.valueStr("name"));
 
   // Check also for types from the nav_search table and VORTACs
   QString type = record.valueStr("type");
   if(type == "VH" || type == "VTH")
-    vor.type = "H";
+    vor.type = intern("H");
   else if(type == "VL" || type == "VTL")
-    vor.type = "L";
+    vor.type = intern("L");
   else if(type == "VT" || type == "VTT")
-    vor.type = "T";
+    vor.type = intern("T");
   else
-    vor.type = type;
+    vor.type = intern(type);
 
   vor.tacan = type == "TC";
   vor.vortac = type.startsWith("VT");
@@ -306,10 +315,10 @@ void MapTypesFactory::fillVorBase(const SqlRecord& record, map::MapVor& vor)
 void MapTypesFactory::fillNdb(const SqlRecord& record, map::MapNdb& ndb)
 {
   ndb.id = record.valueInt("ndb_id");
-  ndb.ident = record.valueStr("ident");
-  ndb.region = record.valueStr("region");
+  ndb.ident = intern(record.valueStr("ident"));
+  ndb.region = intern(record.valueStr("region"));
   ndb.name = atools::capString(record.valueStr("name"));
-  ndb.type = record.valueStr("type");
+  ndb.type = intern(record.valueStr("type"));
   ndb.frequency = record.valueInt("frequency");
   ndb.range = record.valueInt("range");
   ndb.magvar = record.valueFloat("mag_var");
@@ -342,10 +351,10 @@ void MapTypesFactory::fillHelipad(const SqlRecord& record, map::MapHelipad& heli
 void MapTypesFactory::fillWaypoint(const SqlRecord& record, map::MapWaypoint& waypoint)
 {
   waypoint.id = record.valueInt("waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
+  waypoint.ident = intern(record.valueStr("ident"));
+  waypoint.region = intern(record.valueStr("region"));
   // waypoint.airportIdent = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
+  waypoint.type = intern(record.valueStr("type"));
   waypoint.magvar = record.valueFloat("mag_var");
   waypoint.hasVictorAirways = record.valueInt("num_victor_airway") > 0;
   waypoint.hasJetAirways = record.valueInt("num_jet_airway") > 0;
@@ -355,9 +364,9 @@ void MapTypesFactory::fillWaypoint(const SqlRecord& record, map::MapWaypoint& wa
 void MapTypesFactory::fillWaypointFromNav(const SqlRecord& record, map::MapWaypoint& waypoint)
 {
   waypoint.id = record.valueInt("waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
+  waypoint.ident = intern(record.valueStr("ident"));
+  waypoint.region = intern(record.valueStr("region"));
+  waypoint.type = intern(record.valueStr("type"));
   waypoint.magvar = record.valueFloat("mag_var");
   waypoint.hasVictorAirways = record.valueInt("waypoint_num_victor_airway") > 0;
   waypoint.hasJetAirways = record.valueInt("waypoint_num_jet_airway") > 0;
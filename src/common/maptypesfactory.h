@@ -20,6 +20,8 @@
 
 #include "common/mapflags.h"
 
+#include <QSet>
+
 namespace atools {
 namespace sql {
 
@@ -91,6 +93,9 @@ public:
   void fillHelipad(const atools::sql::SqlRecord& record, map::MapHelipad& helipad);
 
 private:
+  /* Get a shared copy of the string. Used for idents, regions and types which are repeated in many objects. */
+  QString intern(const QString& str);
+
   void fillVorBase(const atools::sql::SqlRecord& record, map::MapVor& vor);
 
   void fillAirportBase(const atools::sql::SqlRecord& record, map::MapAirport& ap, bool complete);
@@ -99,6 +104,10 @@ private:
                                    map::MapAirportFlags airportFlag);
   map::MapAirportFlags fillAirportFlags(const atools::sql::SqlRecord& record, bool overview);
 
+  /* String pool is cleared if it grows beyond this size */
+  static Q_DECL_CONSTEXPR int MAX_INTERNED_STRINGS = 100000;
+  QSet<QString> strings;
+
 };
 
 #endif // LITTLENAVMAP_MAPTYPESFACTORY_H
@@ -17,6 +17,7 @@
 
 #include "connect/connectclient.h"
 
+#include "connect/simconnectreplay.h"
 #include "navapp.h"
 #include "common/constants.h"
 #include "fs/sc/simconnectreply.h"
@@ -30,12 +31,12 @@
 #include "fs/sc/xpconnecthandler.h"
 
 #include <QDataStream>
-#include <QTcpSocket>
 #include <QWidget>
 #include <QApplication>
-#include <QThread>
+#include <QElapsedTimer>
 
 using atools::fs::sc::DataReaderThread;
+using atools::settings::Settings;
 
 ConnectClient::ConnectClient(MainWindow *parent)
   : QObject(parent), mainWindow(parent), metarIdentCache(WEATHER_TIMEOUT_FS_SECS)
@@ -81,6 +82,36 @@ ConnectClient::ConnectClient(MainWindow *parent)
   flushQueuedRequestsTimer.setInterval(2000);
   connect(&flushQueuedRequestsTimer, &QTimer::timeout, this, &ConnectClient::flushQueuedRequests);
   flushQueuedRequestsTimer.start();
+
+  // Network connection to Little Navconnect is read in a separate thread
+  qRegisterMetaType<SimConnectDataPtr>();
+  networkReader = new ConnectNetworkReader(verbose);
+  networkReader->moveToThread(&networkThread);
+
+  // All connections are queued since sender and receiver live in different threads
+  connect(networkReader, &ConnectNetworkReader::packetReceived, this, &ConnectClient::packetReceivedFromSocket);
+  connect(networkReader, &ConnectNetworkReader::connected, this, &ConnectClient::connectedToServerSocket);
+  connect(networkReader, &ConnectNetworkReader::socketError, this, &ConnectClient::readFromSocketError);
+  connect(networkReader, &ConnectNetworkReader::packetError, this, &ConnectClient::packetErrorFromSocket);
+
+  networkThread.setObjectName("ConnectNetworkReader");
+  networkThread.start();
+
+  // Recording and replay for benchmarks
+  if(settings.getAndStoreValue(lnm::SETTINGS_CONNECT_REPLAY + "Record", false).toBool())
+  {
+    recorder = new SimConnectRecorder();
+    recorder->open(settings.getAndStoreValue(lnm::SETTINGS_CONNECT_REPLAY + "RecordFile",
+                                             Settings::getConfigFilename(".lnmreplay")).toString());
+  }
+
+  replayFile = settings.getAndStoreValue(lnm::SETTINGS_CONNECT_REPLAY + "ReplayFile", QString()).toString();
+  replaySpeed = settings.getAndStoreValue(lnm::SETTINGS_CONNECT_REPLAY + "ReplaySpeed", 1.f).toFloat();
+  replayLoop = settings.getAndStoreValue(lnm::SETTINGS_CONNECT_REPLAY + "ReplayLoop", false).toBool();
+
+  replay = new SimConnectReplay(this);
+  connect(replay, &SimConnectReplay::dataPacket, this, &ConnectClient::replayPacket);
+  connect(replay, &SimConnectReplay::finished, this, &ConnectClient::replayFinished);
 }
 
 ConnectClient::~ConnectClient()
@@ -92,6 +123,13 @@ ConnectClient::~ConnectClient()
 
   disconnectClicked();
 
+  qDebug() << Q_FUNC_INFO << "stop networkThread";
+  networkThread.quit();
+  networkThread.wait();
+  delete networkReader;
+
+  delete recorder;
+
   qDebug() << Q_FUNC_INFO << "delete dataReader";
   delete dataReader;
 
@@ -138,7 +176,10 @@ void ConnectClient::connectToServerDialog()
 
 void ConnectClient::tryConnectOnStartup()
 {
-  if(dialog->isAutoConnect())
+  if(!replayFile.isEmpty())
+    // Replace connection with replay of recorded packets
+    startReplay();
+  else if(dialog->isAutoConnect())
   {
     reconnectNetworkTimer.stop();
 
@@ -207,9 +248,61 @@ void ConnectClient::disconnectedFromSimulatorDirect()
   manualDisconnect = false;
 }
 
+void ConnectClient::startReplay()
+{
+  if(replay->open(replayFile, replaySpeed, replayLoop))
+  {
+    replayReceiverNs = replayReceiverMaxNs = 0;
+    replayPackets = 0;
+
+    mainWindow->setConnectionStatusMessageText(tr("Replay"), tr("Replaying \"%1\".").arg(replayFile));
+    dialog->setConnected(isConnected());
+    emit connectedToSimulator();
+    emit weatherUpdated();
+
+    replay->start();
+  }
+  else
+    mainWindow->setConnectionStatusMessageText(tr("Replay Error"), tr("Cannot replay \"%1\".").arg(replayFile));
+}
+
+void ConnectClient::replayPacket(const atools::fs::sc::SimConnectData& dataPacket)
+{
+  // Measure time spent in all receivers
+  QElapsedTimer timer;
+  timer.start();
+  postSimConnectData(dataPacket);
+  qint64 ns = timer.nsecsElapsed();
+
+  replayReceiverNs += ns;
+  replayReceiverMaxNs = std::max(replayReceiverMaxNs, ns);
+  replayPackets++;
+}
+
+void ConnectClient::replayFinished()
+{
+  if(replayPackets > 0)
+    qInfo().nospace() << Q_FUNC_INFO << " Replayed " << replayPackets << " packets. Receivers took "
+                      << (replayReceiverNs / 1000000.) << " ms total, "
+                      << (replayReceiverNs / replayPackets / 1000000.) << " ms average, "
+                      << (replayReceiverMaxNs / 1000000.) << " ms maximum";
+
+  mainWindow->setConnectionStatusMessageText(tr("Disconnected"), tr("Replay finished."));
+  dialog->setConnected(isConnected());
+
+  if(!NavApp::isShuttingDown())
+  {
+    emit disconnectedFromSimulator();
+    emit weatherUpdated();
+  }
+}
+
 /* Posts data received directly from simconnect or the socket and caches any metar reports */
-void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket)
+void ConnectClient::postSimConnectData(const atools::fs::sc::SimConnectData& dataPacket)
 {
+  if(recorder != nullptr && !replay->isActive())
+    recorder->write(dataPacket);
+
   emit dataPacketReceived(dataPacket);
 
   if(!dataPacket.getMetars().isEmpty())
@@ -304,7 +397,7 @@ atools::fs::sc::MetarResult ConnectClient::requestWeather(const QString& station
     if(verbose)
       qDebug() << "ConnectClient::requestWeather" << station;
 
-    if((socket != nullptr && socket->isOpen()) || (dataReader->isFsxHandler() && dataReader->isConnected()))
+    if(socketOpen || (dataReader->isFsxHandler() && dataReader->isConnected()))
     {
       atools::fs::sc::WeatherRequest weatherRequest;
       weatherRequest.setStation(station);
@@ -329,7 +422,7 @@ void ConnectClient::requestWeather(const atools::fs::sc::WeatherRequest& weather
   if(dataReader->isFsxHandler() && dataReader->isConnected())
     dataReader->setWeatherRequest(weatherRequest);
 
-  if(socket != nullptr && socket->isOpen() && outstandingReplies.isEmpty())
+  if(socketOpen && outstandingReplies.isEmpty())
   {
     if(verbose)
       qDebug() << "requestWeather" << weatherRequest.getStation();
@@ -364,6 +457,12 @@ void ConnectClient::disconnectClicked()
 
   reconnectNetworkTimer.stop();
 
+  if(replay->isActive())
+  {
+    replay->stop();
+    replayFinished();
+  }
+
   if(dataReader->isConnected())
     // Tell disconnectedFromSimulatorDirect not to reconnect
     manualDisconnect = true;
@@ -391,21 +490,15 @@ void ConnectClient::connectInternal()
     mainWindow->setConnectionStatusMessageText(tr("Connecting (%1)...").arg(simShortName()),
                                                tr("Trying to connect to local flight simulator (%1).").arg(simName()));
   }
-  else if(socket == nullptr && !dialog->getRemoteHostname().isEmpty())
+  else if(!socketOpen && !dialog->getRemoteHostname().isEmpty())
   {
     // qDebug() << "Starting network connection";
 
-    // Create new socket and connect signals
-    socket = new QTcpSocket(this);
-
-    connect(socket, &QTcpSocket::readyRead, this, &ConnectClient::readFromSocket);
-    connect(socket, &QTcpSocket::connected, this, &ConnectClient::connectedToServerSocket);
-    connect(socket,
-            static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error),
-            this, &ConnectClient::readFromSocketError);
-
-    qDebug() << "Connecting to" << dialog->getRemoteHostname() << ":" << dialog->getRemotePort();
-    socket->connectToHost(dialog->getRemoteHostname(), dialog->getRemotePort(), QAbstractSocket::ReadWrite);
+    // Socket is created in the network thread
+    socketOpen = true;
+    QMetaObject::invokeMethod(networkReader, "connectToHost", Qt::QueuedConnection,
+                              Q_ARG(QString, dialog->getRemoteHostname()),
+                              Q_ARG(int, static_cast<int>(dialog->getRemotePort())));
 
     mainWindow->setConnectionStatusMessageText(tr("Connecting..."),
                                                tr("Trying to connect to remote flight simulator on \"%1\".").
@@ -415,26 +508,33 @@ void ConnectClient::connectInternal()
 
 bool ConnectClient::isConnected() const
 {
-  if(dataReader != nullptr)
-    return (socket != nullptr && socket->isOpen()) || dataReader->isConnected();
+  if(replay != nullptr && replay->isActive())
+    return true;
+  else if(dataReader != nullptr)
+    return socketOpen || dataReader->isConnected();
   else
-    return socket != nullptr && socket->isOpen();
+    return socketOpen;
 }
 
-/* Called by signal QAbstractSocket::error */
-void ConnectClient::readFromSocketError(QAbstractSocket::SocketError error)
+/* Called by signal ConnectNetworkReader::socketError */
+void ConnectClient::readFromSocketError(int error, const QString& errorString, const QString& peerName)
 {
-  Q_UNUSED(error);
   // qDebug() << Q_FUNC_INFO << error;
+  if(!socketOpen)
+    // Error from a closed connection still in the queue
+    return;
 
   reconnectNetworkTimer.stop();
 
-  qWarning() << "Error reading from" << socket->peerName() << ":" << dialog->getRemotePort()
-             << socket->errorString() << "open" << socket->isOpen() << "state" << socket->state();
+  socketError = static_cast<QAbstractSocket::SocketError>(error);
+  socketErrorString = errorString;
+  socketPeerName = peerName;
+
+  qWarning() << "Error reading from" << peerName << ":" << dialog->getRemotePort() << errorString;
 
   if(!silent)
   {
-    if(socket->error() == QAbstractSocket::RemoteHostClosedError)
+    if(socketError == QAbstractSocket::RemoteHostClosedError)
     {
       // Nicely closed on the other end
       atools::gui::Dialog(mainWindow).showInfoMsgBox(lnm::ACTIONS_SHOW_DISCONNECT_INFO,
@@ -444,8 +544,8 @@ void ConnectClient::readFromSocketError(QAbstractSocket::SocketError error)
     else
     {
       QString msg = tr("Error in server connection: %1 (%2).%3").
-                    arg(socket->errorString()).
-                    arg(socket->error()).
+                    arg(errorString).
+                    arg(error).
                     arg(dialog->isAutoConnect() ? tr("\nWill retry to connect.") : QString());
 
       // Closed due to error
@@ -464,19 +564,22 @@ void ConnectClient::closeSocket(bool allowRestart)
 
   QAbstractSocket::SocketError error = QAbstractSocket::SocketError::UnknownSocketError;
   QString peer("Unknown"), errorStr("No error");
-  if(socket != nullptr)
+  if(socketOpen)
   {
-    error = socket->error();
-    errorStr = socket->errorString();
-    peer = socket->peerName();
-
-    socket->abort();
-    socket->deleteLater();
-    socket = nullptr;
+    error = socketError;
+    if(!socketErrorString.isEmpty())
+      errorStr = socketErrorString;
+    if(!socketPeerName.isEmpty())
+      peer = socketPeerName;
+
+    // Wait until the socket is closed to avoid packets from the old connection
+    QMetaObject::invokeMethod(networkReader, "closeSocket", Qt::BlockingQueuedConnection);
+    socketOpen = false;
   }
 
-  delete simConnectData;
-  simConnectData = nullptr;
+  socketError = QAbstractSocket::UnknownSocketError;
+  socketErrorString.clear();
+  socketPeerName.clear();
 
   QString msgTooltip, msg;
   if(error == QAbstractSocket::RemoteHostClosedError || error == QAbstractSocket::UnknownSocketError)
@@ -530,35 +633,26 @@ void ConnectClient::closeSocket(bool allowRestart)
 
 void ConnectClient::writeReplyToSocket(atools::fs::sc::SimConnectReply& reply)
 {
-  if(socket != nullptr && socketConnected)
-  {
-    reply.write(socket);
-
-    if(reply.getStatus() != atools::fs::sc::OK)
-    {
-      // Something went wrong - shutdown
-      QMessageBox::critical(mainWindow, QApplication::applicationName(),
-                            QString(tr("Error writing reply to Little Navconnect: %1.")).
-                            arg(reply.getStatusText()));
-      closeSocket(false);
-      return;
-    }
-
-    if(!socket->flush())
-      qWarning() << "Reply to server not flushed";
-  }
+  if(socketOpen && socketConnected)
+    // Written in the network thread - errors are reported by packetErrorFromSocket
+    networkReader->writeReply(reply);
 }
 
-/* Called by signal QTcpSocket::connected */
-void ConnectClient::connectedToServerSocket()
+/* Called by signal ConnectNetworkReader::connected */
+void ConnectClient::connectedToServerSocket(const QString& peerName, int peerPort)
 {
-  qInfo() << Q_FUNC_INFO << "Connected to" << socket->peerName() << ":" << socket->peerPort();
+  if(!socketOpen)
+    // Closed in the meantime
+    return;
+
+  qInfo() << Q_FUNC_INFO << "Connected to" << peerName << ":" << peerPort;
   socketConnected = true;
+  socketPeerName = peerName;
   reconnectNetworkTimer.stop();
 
   mainWindow->setConnectionStatusMessageText(tr("Connected"),
                                              tr("Connected to remote flight simulator on \"%1\".").
-                                             arg(socket->peerName()));
+                                             arg(peerName));
 
   silent = false;
 
@@ -569,62 +663,47 @@ void ConnectClient::connectedToServerSocket()
   emit weatherUpdated();
 }
 
-/* Called by signal QTcpSocket::readyRead - read data from socket */
-void ConnectClient::readFromSocket()
+/* Called by signal ConnectNetworkReader::packetReceived */
+void ConnectClient::packetReceivedFromSocket(SimConnectDataPtr packet)
 {
-  if(socket != nullptr)
+  if(!socketConnected)
+    // Packet from a closed connection still in the queue
+    return;
+
+  if(verbose)
+    qDebug() << "packetReceivedFromSocket id " << packet->getPacketId();
+
+  if(packet->getPacketId() <= 0 && !packet->getMetars().isEmpty())
   {
-    while(socket->bytesAvailable())
-    {
-      if(verbose)
-        qDebug() << "readFromSocket" << socket->bytesAvailable();
-      if(simConnectData == nullptr)
-        // Need to keep the data in background since this method can be called multiple times until the data is filled
-        simConnectData = new atools::fs::sc::SimConnectData;
+    for(const atools::fs::sc::MetarResult& metar : packet->getMetars())
+      outstandingReplies.remove(metar.requestIdent);
 
-      bool read = simConnectData->read(socket);
-      if(simConnectData->getStatus() != atools::fs::sc::OK)
-      {
-        // Something went wrong - shutdown
-        QMessageBox::critical(mainWindow, QApplication::applicationName(),
-                              QString(tr("Error reading data from Little Navconnect: %1.")).
-                              arg(simConnectData->getStatusText()));
-        closeSocket(false);
-        return;
-      }
+    if(outstandingReplies.isEmpty() && !queuedRequests.isEmpty())
+      requestWeather(queuedRequests.takeLast());
+  }
 
-      if(verbose)
-        qDebug() << "readFromSocket 2" << socket->bytesAvailable();
-      if(read)
-      {
-        if(verbose)
-          qDebug() << "readFromSocket id " << simConnectData->getPacketId();
-
-        if(simConnectData->getPacketId() > 0)
-        {
-          // Data was read completely and successfully - reply to server
-          atools::fs::sc::SimConnectReply reply;
-          reply.setPacketId(simConnectData->getPacketId());
-          writeReplyToSocket(reply);
-        }
-        else if(!simConnectData->getMetars().isEmpty())
-        {
-          for(const atools::fs::sc::MetarResult& metar : simConnectData->getMetars())
-            outstandingReplies.remove(metar.requestIdent);
-
-          if(outstandingReplies.isEmpty() && !queuedRequests.isEmpty())
-            requestWeather(queuedRequests.takeLast());
-        }
-
-        // Send around in the application
-        postSimConnectData(*simConnectData);
-        delete simConnectData;
-        simConnectData = nullptr;
-      }
-      else
-        return;
-    }
-    if(verbose)
-      qDebug() << "outstanding" << outstandingReplies;
+  // Send around in the application - packet is shared and not copied
+  postSimConnectData(*packet);
+
+  if(packet->getPacketId() > 0)
+  {
+    // Reply to server only after processing - server waits for the reply before sending the next packet
+    atools::fs::sc::SimConnectReply reply;
+    reply.setPacketId(packet->getPacketId());
+    writeReplyToSocket(reply);
   }
+
+  if(verbose)
+    qDebug() << "outstanding" << outstandingReplies;
+}
+
+/* Called by signal ConnectNetworkReader::packetError */
+void ConnectClient::packetErrorFromSocket(const QString& message)
+{
+  if(!socketOpen)
+    return;
+
+  // Something went wrong - shutdown
+  QMessageBox::critical(mainWindow, QApplication::applicationName(), message);
+  closeSocket(false);
 }
@@ -18,17 +18,19 @@
 #ifndef LITTLENAVMAP_CONNECTCLIENT_H
 #define LITTLENAVMAP_CONNECTCLIENT_H
 
-#include "fs/sc/simconnectdata.h"
+#include "connect/connectnetworkreader.h"
 #include "util/timedcache.h"
 #include "connectdialog.h"
 
 #include <QAbstractSocket>
 #include <QCache>
+#include <QThread>
 #include <QTimer>
 
-class QTcpSocket;
 class ConnectDialog;
 class MainWindow;
+class SimConnectRecorder;
+class SimConnectReplay;
 
 namespace atools {
 namespace fs {
@@ -47,7 +49,11 @@ class SimConnectReply;
 
 /*
  * Client for the Little Navconnect Simconnect agent/server. Receives data and passes it around by emitting a signal.
- * Does not use multithreading - runs completely in the event loop.
+ * Network packets are read and decoded by ConnectNetworkReader in a separate thread. Received packets are shared
+ * and passed by reference to all receivers without copying.
+ *
+ * Received packets can be recorded to a file which can be replayed instead of connecting for benchmarking.
+ * Both are enabled in group "Settings/ConnectReplay" of the configuration file.
  */
 class ConnectClient :
   public QObject
@@ -75,8 +81,8 @@ public:
 
 signals:
   /* Emitted when new data was received from the server (Little Navconnect).
-   * can be aircraft position or weather update */
-  void dataPacketReceived(atools::fs::sc::SimConnectData simConnectData);
+   * can be aircraft position or weather update. Receivers have to copy the data if they want to keep it. */
+  void dataPacketReceived(const atools::fs::sc::SimConnectData& simConnectData);
 
   /* Emitted when a new SimConnect data was received that contains weather data */
   void weatherUpdated();
@@ -96,15 +102,19 @@ private:
   /* Any metar fetched from the Simulator will time out in 15 seconds */
   const int WEATHER_TIMEOUT_FS_SECS = 15;
 
-  void readFromSocket();
-  void readFromSocketError(QAbstractSocket::SocketError error);
-  void connectedToServerSocket();
+  void packetReceivedFromSocket(SimConnectDataPtr packet);
+  void readFromSocketError(int error, const QString& errorString, const QString& peerName);
+  void packetErrorFromSocket(const QString& message);
+  void connectedToServerSocket(const QString& peerName, int peerPort);
   void closeSocket(bool allowRestart);
   void connectInternal();
   void writeReplyToSocket(atools::fs::sc::SimConnectReply& reply);
   void disconnectClicked();
-  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+  void postSimConnectData(const atools::fs::sc::SimConnectData& dataPacket);
   void postLogMessage(QString message, bool warning);
+  void startReplay();
+  void replayPacket(const atools::fs::sc::SimConnectData& dataPacket);
+  void replayFinished();
   void connectedToSimulatorDirect();
   void disconnectedFromSimulatorDirect();
   void autoConnectToggled(bool state);
@@ -126,10 +136,16 @@ private:
   atools::fs::sc::SimConnectHandler *simConnectHandler = nullptr;
   atools::fs::sc::XpConnectHandler *xpConnectHandler = nullptr;
 
-  /* Have to keep it since it is read multiple times */
-  atools::fs::sc::SimConnectData *simConnectData = nullptr;
+  /* Reads from socket in networkThread */
+  ConnectNetworkReader *networkReader = nullptr;
+  QThread networkThread;
 
-  QTcpSocket *socket = nullptr;
+  /* Socket is connecting or connected */
+  bool socketOpen = false;
+
+  /* Last error reported by the network reader */
+  QAbstractSocket::SocketError socketError = QAbstractSocket::UnknownSocketError;
+  QString socketErrorString, socketPeerName;
   /* Used to trigger reconnects on socket base connections */
   QTimer reconnectNetworkTimer, flushQueuedRequestsTimer;
   MainWindow *mainWindow;
@@ -140,6 +156,19 @@ private:
 
   // have to remember state separately to avoid sending signals when autoconnect fails
   bool socketConnected = false;
+
+  /* Writes all received packets to a file if enabled */
+  SimConnectRecorder *recorder = nullptr;
+
+  /* Sends packets from a recorded file instead of connecting if a file is given */
+  SimConnectReplay *replay = nullptr;
+  QString replayFile;
+  float replaySpeed = 1.f;
+  bool replayLoop = false;
+
+  /* Time spent in receivers of dataPacketReceived while replaying */
+  qint64 replayReceiverNs = 0, replayReceiverMaxNs = 0;
+  int replayPackets = 0;
 };
 
 #endif // LITTLENAVMAP_CONNECTCLIENT_H
@@ -0,0 +1,145 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "connect/connectnetworkreader.h"
+
+#include <QDebug>
+#include <QTcpSocket>
+
+ConnectNetworkReader::ConnectNetworkReader(bool verboseLogging)
+  : verbose(verboseLogging)
+{
+  // Queued since called from the GUI thread
+  connect(this, &ConnectNetworkReader::repliesQueued, this, &ConnectNetworkReader::writeQueuedReplies,
+          Qt::QueuedConnection);
+}
+
+ConnectNetworkReader::~ConnectNetworkReader()
+{
+  closeSocket();
+}
+
+void ConnectNetworkReader::connectToHost(const QString& hostname, int port)
+{
+  closeSocket();
+
+  socket = new QTcpSocket(this);
+
+  connect(socket, &QTcpSocket::readyRead, this, &ConnectNetworkReader::readFromSocket);
+  connect(socket, &QTcpSocket::connected, this, [ = ]()
+  {
+    emit connected(socket->peerName(), socket->peerPort());
+  });
+  connect(socket,
+          static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error),
+          this, &ConnectNetworkReader::readFromSocketError);
+
+  qDebug() << Q_FUNC_INFO << "Connecting to" << hostname << ":" << port;
+  socket->connectToHost(hostname, static_cast<quint16>(port), QAbstractSocket::ReadWrite);
+}
+
+void ConnectNetworkReader::closeSocket()
+{
+  if(socket != nullptr)
+  {
+    socket->abort();
+    socket->deleteLater();
+    socket = nullptr;
+  }
+
+  delete packet;
+  packet = nullptr;
+
+  QMutexLocker locker(&replyMutex);
+  replies.clear();
+}
+
+void ConnectNetworkReader::writeReply(const atools::fs::sc::SimConnectReply& reply)
+{
+  {
+    QMutexLocker locker(&replyMutex);
+    replies.append(reply);
+  }
+  emit repliesQueued();
+}
+
+void ConnectNetworkReader::writeQueuedReplies()
+{
+  QVector<atools::fs::sc::SimConnectReply> queued;
+  {
+    QMutexLocker locker(&replyMutex);
+    queued.swap(replies);
+  }
+
+  for(atools::fs::sc::SimConnectReply& reply : queued)
+    writeReplyInternal(reply);
+}
+
+void ConnectNetworkReader::writeReplyInternal(atools::fs::sc::SimConnectReply& reply)
+{
+  if(socket == nullptr || socket->state() != QAbstractSocket::ConnectedState)
+    return;
+
+  reply.write(socket);
+
+  if(reply.getStatus() != atools::fs::sc::OK)
+    // Something went wrong - receiver will shut down
+    emit packetError(tr("Error writing reply to Little Navconnect: %1.").arg(reply.getStatusText()));
+  else if(!socket->flush())
+    qWarning() << "Reply to server not flushed";
+}
+
+void ConnectNetworkReader::readFromSocketError()
+{
+  emit socketError(socket->error(), socket->errorString(), socket->peerName());
+}
+
+/* Called by signal QTcpSocket::readyRead - read data from socket */
+void ConnectNetworkReader::readFromSocket()
+{
+  while(socket != nullptr && socket->bytesAvailable())
+  {
+    if(verbose)
+      qDebug() << "readFromSocket" << socket->bytesAvailable();
+
+    if(packet == nullptr)
+      packet = new atools::fs::sc::SimConnectData;
+
+    bool read = packet->read(socket);
+    if(packet->getStatus() != atools::fs::sc::OK)
+    {
+      // Something went wrong - receiver will shut down
+      emit packetError(tr("Error reading data from Little Navconnect: %1.").arg(packet->getStatusText()));
+      delete packet;
+      packet = nullptr;
+      return;
+    }
+
+    if(!read)
+      // Wait for more data
+      return;
+
+    if(verbose)
+      qDebug() << "readFromSocket id " << packet->getPacketId();
+
+    // Pass ownership - packet is not changed anymore from here on
+    // Not acknowledged here - the GUI thread replies once it has processed the packet so the server does not
+    // send more packets than the GUI can handle
+    emit packetReceived(SimConnectDataPtr(packet));
+    packet = nullptr;
+  }
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_CONNECTNETWORKREADER_H
+#define LITTLENAVMAP_CONNECTNETWORKREADER_H
+
+#include "fs/sc/simconnectdata.h"
+#include "fs/sc/simconnectreply.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+class QTcpSocket;
+
+/* Immutable data packet shared between all receivers. Never modified after it was read. */
+typedef QSharedPointer<const atools::fs::sc::SimConnectData> SimConnectDataPtr;
+
+Q_DECLARE_METATYPE(SimConnectDataPtr);
+
+/*
+ * Reads and decodes data packets from Little Navconnect in the network thread and writes replies.
+ * Owns the socket which is created and used in the network thread only. Packets are acknowledged by the
+ * receiver with writeReply after processing which keeps the server from sending faster than the GUI handles them.
+ *
+ * All results are sent by signals which are queued into the GUI thread.
+ */
+class ConnectNetworkReader :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  ConnectNetworkReader(bool verboseLogging);
+  virtual ~ConnectNetworkReader();
+
+  /* Create socket and connect. Has to be called in the network thread. */
+  Q_INVOKABLE void connectToHost(const QString& hostname, int port);
+
+  /* Abort connection and delete socket. Has to be called in the network thread. */
+  Q_INVOKABLE void closeSocket();
+
+  /* Queue reply and write it in the network thread. Thread safe. */
+  void writeReply(const atools::fs::sc::SimConnectReply& reply);
+
+signals:
+  /* A packet was read completely */
+  void packetReceived(SimConnectDataPtr packet);
+
+  /* Socket is connected */
+  void connected(const QString& peerName, int peerPort);
+
+  /* Socket error. Socket is left open and has to be closed by the receiver. */
+  void socketError(int error, const QString& errorString, const QString& peerName);
+
+  /* Reading or writing a packet failed */
+  void packetError(const QString& message);
+
+  /* Internal - write queued replies in the network thread */
+  void repliesQueued();
+
+private:
+  void readFromSocket();
+  void readFromSocketError();
+  void writeQueuedReplies();
+  void writeReplyInternal(atools::fs::sc::SimConnectReply& reply);
+
+  QTcpSocket *socket = nullptr;
+
+  /* Partially read packet. Kept since it can take several calls of readFromSocket until it is filled. */
+  atools::fs::sc::SimConnectData *packet = nullptr;
+
+  /* Replies from the GUI thread */
+  QMutex replyMutex;
+  QVector<atools::fs::sc::SimConnectReply> replies;
+
+  bool verbose = false;
+};
+
+#endif // LITTLENAVMAP_CONNECTNETWORKREADER_H
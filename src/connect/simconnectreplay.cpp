@@ -0,0 +1,214 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "connect/simconnectreplay.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+#include <algorithm>
+
+using atools::fs::sc::SimConnectData;
+
+Q_DECL_CONSTEXPR quint32 SimConnectRecorder::MAGIC_NUMBER;
+Q_DECL_CONSTEXPR quint16 SimConnectRecorder::FILE_VERSION;
+
+SimConnectRecorder::SimConnectRecorder()
+{
+
+}
+
+SimConnectRecorder::~SimConnectRecorder()
+{
+  close();
+}
+
+bool SimConnectRecorder::open(const QString& filename)
+{
+  close();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  QDataStream out(&file);
+  out.setByteOrder(QDataStream::LittleEndian);
+  out << MAGIC_NUMBER << FILE_VERSION;
+
+  numPackets = 0;
+  timer.start();
+
+  qInfo() << Q_FUNC_INFO << "Recording to" << filename;
+  return true;
+}
+
+void SimConnectRecorder::close()
+{
+  if(file.isOpen())
+  {
+    qInfo() << Q_FUNC_INFO << "Recorded" << numPackets << "packets to" << file.fileName();
+    file.close();
+  }
+}
+
+void SimConnectRecorder::write(const SimConnectData& data)
+{
+  if(!file.isOpen())
+    return;
+
+  QDataStream out(&file);
+  out.setByteOrder(QDataStream::LittleEndian);
+  out << static_cast<qint64>(timer.elapsed());
+
+  // Writing needs a non const object - this is a shallow copy
+  SimConnectData packet(data);
+  packet.write(&file);
+
+  if(packet.getStatus() != atools::fs::sc::OK)
+  {
+    qWarning() << Q_FUNC_INFO << "Error writing packet" << packet.getStatusText() << "- stopping recording";
+    close();
+  }
+  else
+    numPackets++;
+}
+
+// ---------------------------------------------------------------------------------
+SimConnectReplay::SimConnectReplay(QObject *parent)
+  : QObject(parent)
+{
+  timer.setSingleShot(true);
+  timer.setTimerType(Qt::PreciseTimer);
+  connect(&timer, &QTimer::timeout, this, &SimConnectReplay::sendPacket);
+}
+
+SimConnectReplay::~SimConnectReplay()
+{
+  stop();
+}
+
+bool SimConnectReplay::open(const QString& filename, float speedFactor, bool loopReplay)
+{
+  stop();
+
+  speed = std::max(speedFactor, 0.f);
+  loop = loopReplay;
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  if(!readHeader() || !readNext())
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid or empty replay file" << filename;
+    file.close();
+    return false;
+  }
+
+  qInfo() << Q_FUNC_INFO << "Replaying" << filename << "speed" << speed << "loop" << loop;
+  return true;
+}
+
+void SimConnectReplay::start()
+{
+  if(file.isOpen())
+  {
+    numPackets = 0;
+    lastTimestampMs = nextTimestampMs;
+    timer.start(0);
+  }
+}
+
+void SimConnectReplay::stop()
+{
+  timer.stop();
+  if(file.isOpen())
+  {
+    qInfo() << Q_FUNC_INFO << "Replayed" << numPackets << "packets from" << file.fileName();
+    file.close();
+  }
+}
+
+bool SimConnectReplay::readHeader()
+{
+  QDataStream in(&file);
+  in.setByteOrder(QDataStream::LittleEndian);
+
+  quint32 magicNumber = 0;
+  quint16 version = 0;
+  in >> magicNumber >> version;
+
+  if(magicNumber != SimConnectRecorder::MAGIC_NUMBER || version != SimConnectRecorder::FILE_VERSION)
+  {
+    qWarning() << Q_FUNC_INFO << "Wrong magic number or version" << magicNumber << version;
+    return false;
+  }
+  return in.status() == QDataStream::Ok;
+}
+
+bool SimConnectReplay::readNext()
+{
+  if(file.atEnd())
+    return false;
+
+  QDataStream in(&file);
+  in.setByteOrder(QDataStream::LittleEndian);
+  in >> nextTimestampMs;
+  if(in.status() != QDataStream::Ok)
+    return false;
+
+  next = SimConnectData();
+  if(!next.read(&file) || next.getStatus() != atools::fs::sc::OK)
+  {
+    qWarning() << Q_FUNC_INFO << "Error reading packet" << next.getStatusText();
+    return false;
+  }
+  return true;
+}
+
+void SimConnectReplay::sendPacket()
+{
+  emit dataPacket(next);
+  numPackets++;
+  lastTimestampMs = nextTimestampMs;
+
+  if(!file.isOpen())
+    // Stopped by receiver
+    return;
+
+  if(!readNext())
+  {
+    if(loop && file.isOpen() && file.seek(0) && readHeader() && readNext())
+      // Start over and keep the recorded delay to the first packet short
+      lastTimestampMs = nextTimestampMs;
+    else
+    {
+      stop();
+      emit finished();
+      return;
+    }
+  }
+
+  qint64 delayMs = speed > 0.f ? static_cast<qint64>((nextTimestampMs - lastTimestampMs) / speed) : 0;
+  timer.start(static_cast<int>(std::max(delayMs, Q_INT64_C(0))));
+}
@@ -0,0 +1,114 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_SIMCONNECTREPLAY_H
+#define LITTLENAVMAP_SIMCONNECTREPLAY_H
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+/*
+ * Writes a stream of simulator data packets to a binary file.
+ *
+ * File format is a header with magic number and version followed by records. Each record consists of the
+ * milliseconds since start of recording (qint64) and the packet in the Little Navconnect network format.
+ */
+class SimConnectRecorder
+{
+public:
+  SimConnectRecorder();
+  ~SimConnectRecorder();
+
+  /* Truncate or create file and write header. Returns false on error. */
+  bool open(const QString& filename);
+  void close();
+
+  bool isOpen() const
+  {
+    return file.isOpen();
+  }
+
+  /* Append packet with current timestamp */
+  void write(const atools::fs::sc::SimConnectData& data);
+
+  static Q_DECL_CONSTEXPR quint32 MAGIC_NUMBER = 0x524D4E4C; /* "LNMR" */
+  static Q_DECL_CONSTEXPR quint16 FILE_VERSION = 1;
+
+private:
+  QFile file;
+  QElapsedTimer timer;
+  int numPackets = 0;
+};
+
+/*
+ * Replays a file written by SimConnectRecorder in the event loop. Acts as a local stand-in for Little Navconnect
+ * and emits the packets with the recorded time differences divided by the speed factor. A speed of 0 sends
+ * packets as fast as the event loop allows.
+ */
+class SimConnectReplay :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SimConnectReplay(QObject *parent);
+  virtual ~SimConnectReplay();
+
+  /* Open file and read the first packet. Returns false if file cannot be read or has a wrong format. */
+  bool open(const QString& filename, float speedFactor, bool loopReplay);
+
+  /* Start sending packets */
+  void start();
+
+  /* Stop and close file */
+  void stop();
+
+  bool isActive() const
+  {
+    return file.isOpen();
+  }
+
+signals:
+  /* Next packet is due */
+  void dataPacket(const atools::fs::sc::SimConnectData& data);
+
+  /* End of file reached or read error. Not sent if looping. */
+  void finished();
+
+private:
+  /* Read header and position to first record */
+  bool readHeader();
+
+  /* Read next record into next and nextTimestampMs. Returns false at end of file or error. */
+  bool readNext();
+
+  void sendPacket();
+
+  QFile file;
+  QTimer timer;
+  float speed = 1.f;
+  bool loop = false;
+
+  atools::fs::sc::SimConnectData next;
+  qint64 nextTimestampMs = 0, lastTimestampMs = 0;
+  int numPackets = 0;
+};
+
+#endif // LITTLENAVMAP_SIMCONNECTREPLAY_H
@@ -0,0 +1,119 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "db/airspacegeometrylod.h"
+
+#include "common/maptools.h"
+#include "fs/common/binarygeometry.h"
+#include "geo/linestring.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlUtil;
+using atools::geo::LineString;
+using atools::fs::common::BinaryGeometry;
+
+Q_DECL_CONSTEXPR int AirspaceGeometryLod::NUM_LEVELS;
+
+/* Level 1 is used up to about 200 km zoom distance, level 2 up to 750 km and level 3 above */
+static const float TOLERANCES[AirspaceGeometryLod::NUM_LEVELS] = {0.001f, 0.0025f, 0.01f};
+
+float AirspaceGeometryLod::tolerance(int level)
+{
+  return TOLERANCES[std::min(std::max(level, 1), NUM_LEVELS) - 1];
+}
+
+int AirspaceGeometryLod::create(SqlDatabase *db, const ProgressCallback& callback)
+{
+  if(!SqlUtil(db).hasTable("boundary"))
+    return 0;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  db->exec("drop table if exists boundary_lod");
+  db->exec("create table boundary_lod ("
+           "boundary_id integer not null, "
+           "lod integer not null, "
+           "geometry blob, "
+           "primary key (boundary_id, lod))");
+
+  SqlQuery insertQuery(db);
+  insertQuery.prepare("insert into boundary_lod (boundary_id, lod, geometry) values (:id, :lod, :geometry)");
+
+  int total = 0;
+  if(callback)
+  {
+    total = SqlUtil(db).rowCount("boundary");
+    if(callback(0, total))
+      return -1;
+  }
+
+  int numWritten = 0, numBoundaries = 0;
+  SqlQuery query(db);
+  query.exec("select boundary_id, geometry from boundary");
+  while(query.next())
+  {
+    if(callback && (numBoundaries % 100) == 0 && callback(numBoundaries, total))
+    {
+      // Leave an empty table which results in full resolution boundaries
+      query.finish();
+      db->exec("delete from boundary_lod");
+      db->commit();
+      return -1;
+    }
+
+    LineString boundary;
+    BinaryGeometry(query.value("geometry").toByteArray()).swapGeometry(boundary);
+    numBoundaries++;
+
+    // Simplify each level from the previous one since tolerances are increasing
+    LineString simplified(boundary);
+    for(int level = 1; level <= NUM_LEVELS; level++)
+    {
+      int lastSize = simplified.size();
+      LineString next;
+      maptools::simplify(next, simplified, tolerance(level));
+      simplified = next;
+
+      if(simplified.size() < lastSize)
+      {
+        insertQuery.bindValue(":id", query.value("boundary_id"));
+        insertQuery.bindValue(":lod", level);
+        insertQuery.bindValue(":geometry", BinaryGeometry(simplified).writeToByteArray());
+        insertQuery.exec();
+        numWritten++;
+      }
+    }
+  }
+  db->commit();
+
+  if(callback)
+    callback(total, total);
+
+  qInfo() << Q_FUNC_INFO << "Wrote" << numWritten << "simplified geometries for" << numBoundaries
+          << "boundaries in" << timer.elapsed() << "ms";
+  return numWritten;
+}
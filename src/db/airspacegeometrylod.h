@@ -0,0 +1,58 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_AIRSPACEGEOMETRYLOD_H
+#define LITTLENAVMAP_AIRSPACEGEOMETRYLOD_H
+
+#include <QtGlobal>
+
+#include <functional>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/*
+ * Creates simplified airspace boundaries for display at larger zoom distances.
+ *
+ * Boundaries of table "boundary" are simplified with the Douglas-Peucker algorithm for NUM_LEVELS tolerances and
+ * stored in table "boundary_lod" with the detail level in column "lod". Level 0 is the full resolution geometry in
+ * table "boundary". A level is not stored if the simplification does not remove any points.
+ *
+ * Map layers select the detail level with MapLayer::airspaceDetail().
+ */
+class AirspaceGeometryLod
+{
+public:
+  /* Number of simplified detail levels */
+  static Q_DECL_CONSTEXPR int NUM_LEVELS = 3;
+
+  /* Simplification tolerance in degree for detail level 1 to NUM_LEVELS */
+  static float tolerance(int level);
+
+  /* Called with number of processed and total boundaries. Return true to cancel. */
+  typedef std::function<bool (int current, int total)> ProgressCallback;
+
+  /* Drop and create table boundary_lod and fill it from table boundary. Does nothing if the database has no
+   * boundary table. Commits and returns the number of geometries written or -1 if canceled by the callback.
+   * Throws an exception on error. */
+  static int create(atools::sql::SqlDatabase *db, const ProgressCallback& callback = ProgressCallback());
+};
+
+#endif // LITTLENAVMAP_AIRSPACEGEOMETRYLOD_H
@@ -17,6 +17,7 @@
 
 #include "db/databasemanager.h"
 
+#include "db/airspacegeometrylod.h"
 #include "db/databaseerrordialog.h"
 #include "gui/application.h"
 #include "options/optiondata.h"
@@ -442,6 +443,11 @@ void DatabaseManager::checkCopyAndPrepareDatabases()
           atools::gui::Application::processEventsExtended();
           NavDatabase::runPreparationScript(tempDb);
 
+          dialog->setText(tr("Preparing %1 Database: Simplifying airspaces ...").
+                          arg(FsPaths::typeToName(FsPaths::NAVIGRAPH)));
+          atools::gui::Application::processEventsExtended();
+          AirspaceGeometryLod::create(&tempDb);
+
           dialog->setText(tr("Preparing %1 Database: Analyzing ...").arg(FsPaths::typeToName(FsPaths::NAVIGRAPH)));
           atools::gui::Application::processEventsExtended();
           tempDb.analyze();
@@ -471,6 +477,7 @@ void DatabaseManager::checkCopyAndPrepareDatabases()
     SqlDatabase tempDb(DATABASE_NAME_TEMP);
     openDatabaseFile(&tempDb, settingsDb, false /* readonly */);
     NavDatabase::runPreparationScript(tempDb);
+    AirspaceGeometryLod::create(&tempDb);
     tempDb.analyze();
     closeDatabaseFile(&tempDb);
 
@@ -886,6 +893,9 @@ void DatabaseManager::copyAirspaces()
           int copied = SqlUtil::copyResultValues(fromQuery, xpQuery, func);
           xpDb.commit();
 
+          // Simplified boundaries have to match the new ids
+          AirspaceGeometryLod::create(&xpDb);
+
           QGuiApplication::restoreOverrideCursor();
           QMessageBox::information(mainWindow, QApplication::applicationName(),
                                    tr("Copied %1 airspaces to the X-Plane scenery database.").
@@ -1086,6 +1096,9 @@ bool DatabaseManager::loadScenery(atools::sql::SqlDatabase *db)
     atools::fs::NavDatabase nd(&navDatabaseOpts, db, &errors, GIT_REVISION);
     QString sceneryCfgCodec = selectedFsType == atools::fs::FsPaths::P3D_V4 ? "UTF-8" : QString();
     nd.create(sceneryCfgCodec);
+
+    if(!progressDialog->wasCanceled())
+      createAirspaceLod(db);
   }
   catch(atools::Exception& e)
   {
@@ -1176,6 +1189,39 @@ bool DatabaseManager::loadScenery(atools::sql::SqlDatabase *db)
   return success;
 }
 
+/* Create simplified airspace boundaries for larger zoom distances as last step of the loading progress */
+void DatabaseManager::createAirspaceLod(atools::sql::SqlDatabase *db)
+{
+  // Keep the final statistics of the compilation
+  QString doneText = progressDialog->labelText();
+  QElapsedTimer timer;
+  timer.start();
+
+  int written = AirspaceGeometryLod::create(db, [ =, &timer](int current, int total) -> bool
+  {
+    progressDialog->setMaximum(total);
+    progressDialog->setValue(current);
+    progressDialog->setLabelText(tr("<big>Simplifying airspaces ...</big><br/><br/>"
+                                    "Time: %1<br/>Airspaces: %L2 of %L3").
+                                 arg(formatter::formatElapsed(timer)).arg(current).arg(total));
+    QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    return progressDialog->wasCanceled();
+  });
+
+  if(written == -1)
+  {
+    // Canceled while simplifying - keep the compiled database since an empty boundary_lod table falls back to
+    // full resolution boundaries. Clear the cancel state to avoid discarding the database.
+    qInfo() << Q_FUNC_INFO << "Simplifying airspaces canceled";
+    progressDialog->reset();
+    progressDialog->show();
+  }
+
+  progressDialog->setMaximum(1);
+  progressDialog->setValue(1);
+  progressDialog->setLabelText(doneText);
+}
+
 /* Simulator was changed in scenery database loading dialog */
 void DatabaseManager::simulatorChangedFromComboBox(FsPaths::SimulatorType value)
 {
@@ -177,6 +177,7 @@ private:
   void updateSimulatorFlags();
   void updateSimulatorPathsFromDialog();
   bool loadScenery(atools::sql::SqlDatabase *db);
+  void createAirspaceLod(atools::sql::SqlDatabase *db);
   void correctSimulatorType();
   QMessageBox *showSimpleProgressDialog(const QString& message);
   void deleteSimpleProgressDialog(QMessageBox *messageBox);
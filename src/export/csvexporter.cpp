@@ -71,30 +71,28 @@ int CsvExporter::exportAll(bool open)
       qDebug() << "Used codec" << stream.codec()->name();
 
       // Run the current query to get all results - not only the visible
-      atools::sql::SqlDatabase *db = controller->getSqlDatabase();
-      SqlQuery query(db);
-      query.exec(controller->getCurrentSqlQuery());
+      // Rows are read in a background thread on a separate connection to keep the window responsive
+      atools::sql::SqlRecord rec = controller->getSqlModel()->getSqlRecord();
+      int numCols = rec.count();
 
       SqlExport sqlExport;
       sqlExport.setSeparatorChar(';');
-      QVariantList values;
+      stream << sqlExport.getResultSetHeader(headerNames(numCols));
 
-      int row = 0;
-      while(query.next())
+      QVariantList values;
+      readAllRows([ =, &stream, &sqlExport, &values, &exported](const SqlModelPage& page)
       {
-        atools::sql::SqlRecord rec = query.record();
-        if(row == 0)
-          stream << sqlExport.getResultSetHeader(headerNames(rec.count()));
-
-        // Write all columns
-        values.clear();
-        for(int col = 0; col < rec.count(); ++col)
-          // Get data formatted as shown in the table
-          values.append(controller->formatModelData(rec.fieldName(col), rec.value(col)));
-        stream << sqlExport.getResultSetRow(values);
-        row++;
-        exported++;
-      }
+        for(int idx = 0; idx + numCols <= page.size(); idx += numCols)
+        {
+          // Write all columns
+          values.clear();
+          for(int col = 0; col < numCols; ++col)
+            // Get data formatted as shown in the table
+            values.append(controller->formatModelData(rec.fieldName(col), page.at(idx + col)));
+          stream << sqlExport.getResultSetRow(values);
+          exported++;
+        }
+      });
 
       stream.flush();
       file.close();
@@ -117,6 +115,10 @@ int CsvExporter::exportSelected(bool open)
   {
     qDebug() << "exportSelectedCsv" << filename;
 
+    // Fetch all selected rows which are not loaded yet
+    if(!controller->loadSelectedRows())
+      return exported;
+
     QFile file(filename);
     if(file.open(QIODevice::WriteOnly | QIODevice::Text))
     {
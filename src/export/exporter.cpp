@@ -20,19 +20,26 @@
 #include "gui/dialog.h"
 #include "gui/errorhandler.h"
 #include "search/column.h"
+#include "search/sqlmodel.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlrecord.h"
 
 #include <QDebug>
 #include <QUrl>
 #include <QDesktopServices>
 #include <QApplication>
+#include <QEventLoop>
+#include <QProgressDialog>
 #include <QSqlField>
 #include <QSqlRecord>
 
+#include <algorithm>
+
 using atools::gui::Dialog;
 using atools::gui::ErrorHandler;
 
 Exporter::Exporter(QWidget *parentWidget, SqlController *controllerObj)
-  : controller(controllerObj)
+  : parentWidget(parentWidget), controller(controllerObj)
 {
   dialog = new Dialog(parentWidget);
   errorHandler = new ErrorHandler(parentWidget);
@@ -116,3 +123,39 @@ void Exporter::fillRecord(const QVariantList& values, const QStringList& cols, Q
       rec.setValue(i, values.at(i));
   }
 }
+
+bool Exporter::readAllRows(const std::function<void(const SqlModelPage& values)>& pageFunc)
+{
+  int totalRows = controller->getTotalRowCount();
+  int numColumns = controller->getSqlModel()->getSqlRecord().count();
+
+  QProgressDialog progress(tr("Exporting ..."), tr("&Cancel"), 0, totalRows, parentWidget);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+
+  SqlModelBulkReader reader;
+  QEventLoop loop;
+  bool success = false;
+  int rowsRead = 0;
+
+  QObject::connect(&reader, &SqlModelBulkReader::pageRead, &loop, [&](const SqlModelPage& values)
+  {
+    pageFunc(values);
+    reader.pageProcessed();
+
+    rowsRead += numColumns > 0 ? values.size() / numColumns : 0;
+    progress.setValue(std::min(rowsRead, totalRows));
+  });
+  QObject::connect(&reader, &SqlModelBulkReader::finished, &loop, [&](bool ok)
+  {
+    success = ok;
+    loop.quit();
+  });
+  QObject::connect(&progress, &QProgressDialog::canceled, &loop, &QEventLoop::quit);
+
+  reader.start("LNMEXPORT", controller->getSqlDatabase()->databaseName(), controller->getCurrentSqlQuery());
+  loop.exec();
+  reader.cancel();
+
+  return success && !progress.wasCanceled();
+}
@@ -18,8 +18,12 @@
 #ifndef LITTLELOGBOOK_EXPORTER_H
 #define LITTLELOGBOOK_EXPORTER_H
 
+#include "search/sqlmodelpager.h"
+
 #include <QApplication>
 
+#include <functional>
+
 namespace atools {
 namespace gui {
 class Dialog;
@@ -69,6 +73,10 @@ protected:
   /* Create an SQL record from column names and values */
   void fillRecord(const QVariantList& values, const QStringList& cols, QSqlRecord& rec);
 
+  /* Run the current query of the controller on a separate connection in a background thread and call pageFunc
+   * in the GUI thread for each page of rows. Shows a progress dialog. Returns false if failed or canceled. */
+  bool readAllRows(const std::function<void(const SqlModelPage& values)>& pageFunc);
+
 };
 
 #endif // LITTLELOGBOOK_EXPORTER_H
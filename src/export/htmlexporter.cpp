@@ -109,9 +109,9 @@ int HtmlExporter::exportAll(bool open)
     return 0;
 
   // Run the current query to get all results - not only the visible
-  atools::sql::SqlDatabase *db = controller->getSqlDatabase();
-  SqlQuery query(db);
-  query.exec(controller->getCurrentSqlQuery());
+  // Rows are read in a background thread on a separate connection to keep the window responsive
+  atools::sql::SqlRecord rec = controller->getSqlModel()->getSqlRecord();
+  int numCols = rec.count();
   totalToExport = controller->getTotalRowCount();
   totalPages = static_cast<int>(std::ceil(static_cast<float>(totalToExport) / static_cast<float>(pageSize)));
 
@@ -124,45 +124,50 @@ int HtmlExporter::exportAll(bool open)
     return exported;
 
   QVector<int> visualColumnIndex;
-  while(query.next())
+  bool fileError = false;
+  readAllRows([ =, &file, &stream, &visualColumnIndex, &exported, &exportedPage, &currentPage,
+                &fileError](const SqlModelPage& page)
   {
-    atools::sql::SqlRecord rec = query.record();
-
-    if(exportedPage == 0)
+    for(int idx = 0; idx + numCols <= page.size() && !fileError; idx += numCols)
     {
-      // Create an index that maps the (probably reordered) columns of the
-      // view to the model
-      createVisualColumnIndex(rec.count(), visualColumnIndex);
-      writeHtmlTableHeader(stream, headerNames(rec.count(), visualColumnIndex));
-    }
-    exportedPage++;
+      if(exportedPage == 0)
+      {
+        // Create an index that maps the (probably reordered) columns of the
+        // view to the model
+        createVisualColumnIndex(numCols, visualColumnIndex);
+        writeHtmlTableHeader(stream, headerNames(numCols, visualColumnIndex));
+      }
+      exportedPage++;
 
-    stream.writeStartElement("tr");
-    if((exportedPage % 2) == 1)
-      // Use alternating color CSS class to row
-      stream.writeAttribute("class", "alt");
+      stream.writeStartElement("tr");
+      if((exportedPage % 2) == 1)
+        // Use alternating color CSS class to row
+        stream.writeAttribute("class", "alt");
 
-    for(int col = 0; col < rec.count(); ++col)
-    {
-      // Get data formatted as shown in the table
-      int physIndex = visualColumnIndex[col];
-      if(physIndex != -1)
-        writeHtmlTableCellFormatted(stream, rec.fieldName(physIndex), rec.value(physIndex), exportedPage);
-    }
-    stream.writeEndElement(); // tr
+      for(int col = 0; col < numCols; ++col)
+      {
+        // Get data formatted as shown in the table
+        int physIndex = visualColumnIndex[col];
+        if(physIndex != -1)
+          writeHtmlTableCellFormatted(stream, rec.fieldName(physIndex), page.at(idx + physIndex), exportedPage);
+      }
+      stream.writeEndElement(); // tr
 
-    exported++;
-    if((exported % pageSize) == 0)
-    {
-      endFile(file, basename, stream, currentPage, totalPages);
-      currentPage++;
-      exportedPage = 0;
+      exported++;
+      if((exported % pageSize) == 0)
+      {
+        endFile(file, basename, stream, currentPage, totalPages);
+        currentPage++;
+        exportedPage = 0;
 
-      file.setFileName(filenameForPage(filename, currentPage));
-      if(!startFile(file, basename, stream, currentPage, totalPages))
-        return exported;
+        file.setFileName(filenameForPage(filename, currentPage));
+        fileError = !startFile(file, basename, stream, currentPage, totalPages);
+      }
     }
-  }
+  });
+
+  if(fileError)
+    return exported;
 
   endFile(file, basename, stream, currentPage, totalPages);
 
@@ -183,6 +188,10 @@ int HtmlExporter::exportSelected(bool open)
   if(filename.isEmpty())
     return 0;
 
+  // Fetch all selected rows which are not loaded yet
+  if(!controller->loadSelectedRows())
+    return 0;
+
   const QItemSelection sel = controller->getSelection();
   for(QItemSelectionRange rng : sel)
     totalToExport += rng.height();
@@ -680,7 +680,7 @@ void InfoController::updateAiAircraftText()
     ui->textBrowserAircraftAiInfo->clear();
 }
 
-void InfoController::simulatorDataReceived(atools::fs::sc::SimConnectData data)
+void InfoController::simulatorDataReceived(const atools::fs::sc::SimConnectData& data)
 {
   if(databaseLoadStatus)
     return;
@@ -80,7 +80,7 @@ public:
   void postDatabaseLoad();
 
   /* Update aircraft and aircraft progress tab */
-  void simulatorDataReceived(atools::fs::sc::SimConnectData data);
+  void simulatorDataReceived(const atools::fs::sc::SimConnectData& data);
   void connectedToSimulator();
   void disconnectedFromSimulator();
 
@@ -37,9 +37,13 @@
 #include "common/maptypes.h"
 #include "common/proctypes.h"
 #include "common/unit.h"
+#include "route/routestringbatch.h"
 
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
 #include <QSplashScreen>
 #include <QSslSocket>
 #include <QStyleFactory>
@@ -57,6 +61,74 @@ using atools::logging::LoggingUtil;
 using atools::settings::Settings;
 using atools::gui::Translator;
 
+/* Parse all route strings from file routesFilename on a thread pool, write one CSV line per route to
+ * outputFilename or stdout if empty and print throughput to stderr.
+ * Returns the process exit code which is 2 if any route string could not be parsed. */
+static int validateRouteStrings(const QString& routesFilename, const QString& simDbFilename,
+                                const QString& navDbFilename, const QString& outputFilename, int numThreads)
+{
+  // Units and formats are needed by the parser - load options without showing a window
+  OptionsDialog optionsDialog(nullptr);
+  optionsDialog.restoreState();
+  Unit::init();
+  map::updateUnits();
+
+  QTextStream err(stderr);
+  QStringList routeStrings;
+  if(!RouteString::readRouteStrings(routesFilename, routeStrings))
+  {
+    err << "Cannot read route strings from " << routesFilename << endl;
+    return 1;
+  }
+
+  QFile outFile;
+  if(outputFilename.isEmpty())
+    outFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+  else if(!outFile.open(outputFilename, QIODevice::WriteOnly | QIODevice::Text))
+  {
+    err << "Cannot open " << outputFilename << " " << outFile.errorString() << endl;
+    return 1;
+  }
+
+  RouteStringBatch batch(simDbFilename, navDbFilename);
+  if(numThreads > 0)
+    batch.setNumThreads(numThreads);
+
+  QElapsedTimer timer;
+  timer.start();
+  QVector<rs::RouteStringResult> results = batch.createRoutesFromStrings(routeStrings);
+  qint64 wallMs = timer.elapsed();
+
+  QTextStream out(&outFile);
+  out << "route;valid;entries;time_ms;messages" << endl;
+
+  int numValid = 0;
+  qint64 sumMicroseconds = 0;
+  for(const rs::RouteStringResult& result : results)
+  {
+    // Keep one route per line and do not break the columns
+    QString messages = result.messages.join(" | ");
+    messages.replace(';', ',').replace('\n', ' ');
+
+    out << result.routeString << ";" << (result.valid ? 1 : 0) << ";" << result.numEntries << ";"
+        << QString::number(result.timeMicroseconds / 1000., 'f', 3) << ";" << messages << "\n";
+
+    if(result.valid)
+      numValid++;
+    sumMicroseconds += result.timeMicroseconds;
+  }
+  out.flush();
+
+  int num = results.size();
+  err << "Routes " << num << ", valid " << numValid << ", invalid " << num - numValid << endl;
+  err << "Wall time " << wallMs << " ms, "
+      << QString::number(wallMs > 0 ? num * 1000. / wallMs : 0., 'f', 1) << " routes/s" << endl;
+  err << "Parser time " << QString::number(num > 0 ? sumMicroseconds / 1000. / num : 0., 'f', 3)
+      << " ms/route" << endl;
+
+  return numValid == num ? 0 : 2;
+}
+
 int main(int argc, char *argv[])
 {
   // Initialize the resources from atools static library
@@ -115,6 +187,36 @@ int main(int argc, char *argv[])
                                       QObject::tr("settings-directory"));
     parser.addOption(settingsDirOpt);
 
+    // Headless route string validation which exits after printing the results
+    QCommandLineOption validateRoutesOpt("validate-routes",
+                                         QObject::tr("Parse route strings from <file> with one route per line, "
+                                                     "print results and throughput and exit."),
+                                         QObject::tr("file"));
+    parser.addOption(validateRoutesOpt);
+
+    QCommandLineOption validateDbOpt("validate-database",
+                                     QObject::tr("Simulator database <file> for --validate-routes."),
+                                     QObject::tr("file"));
+    parser.addOption(validateDbOpt);
+
+    QCommandLineOption validateDbNavOpt("validate-database-nav",
+                                        QObject::tr("Navigation database <file> for --validate-routes. "
+                                                    "Uses the simulator database if not given."),
+                                        QObject::tr("file"));
+    parser.addOption(validateDbNavOpt);
+
+    QCommandLineOption validateOutputOpt("validate-output",
+                                         QObject::tr("Write CSV results of --validate-routes to <file> "
+                                                     "instead of stdout."),
+                                         QObject::tr("file"));
+    parser.addOption(validateOutputOpt);
+
+    QCommandLineOption validateThreadsOpt("validate-threads",
+                                          QObject::tr("Number of threads for --validate-routes. "
+                                                      "Default is the number of cores."),
+                                          QObject::tr("number"));
+    parser.addOption(validateThreadsOpt);
+
     // Process the actual command line arguments given by the user
     parser.process(*QCoreApplication::instance());
 
@@ -176,6 +278,22 @@ int main(int argc, char *argv[])
     map::initTranslateableTexts();
     proc::initTranslateableTexts();
 
+    if(parser.isSet(validateRoutesOpt))
+    {
+      NavApp::deleteSplashScreen();
+
+      if(!parser.isSet(validateDbOpt))
+      {
+        QTextStream(stderr) << "--validate-routes needs --validate-database" << endl;
+        return 1;
+      }
+
+      QString navDb = parser.isSet(validateDbNavOpt) ?
+                      parser.value(validateDbNavOpt) : parser.value(validateDbOpt);
+      return validateRouteStrings(parser.value(validateRoutesOpt), parser.value(validateDbOpt), navDb,
+                                  parser.value(validateOutputOpt), parser.value(validateThreadsOpt).toInt());
+    }
+
 #if defined(Q_OS_MACOS)
     // Check for minimum macOS version 10.10
     if(QSysInfo::macVersion() != QSysInfo::MV_None && QSysInfo::macVersion() < QSysInfo::MV_10_10)
@@ -0,0 +1,233 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapairspacegeometrycache.h"
+
+#include "common/constants.h"
+#include "common/coordinateconverter.h"
+#include "common/maptools.h"
+#include "mapgui/maplayer.h"
+#include "query/mapquery.h"
+#include "settings/settings.h"
+#include "atools.h"
+
+#include <marble/AbstractProjection.h>
+#include <marble/ViewportParams.h>
+
+#include <cmath>
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+
+/* Zoom levels where each level doubles the pixels per degree. Boundaries are not simplified above MAX_LEVEL. */
+static Q_DECL_CONSTEXPR int MIN_LEVEL = -4;
+static Q_DECL_CONSTEXPR int MAX_LEVEL = 14;
+
+/* Maximum deviation of the simplified boundary in pixel */
+static Q_DECL_CONSTEXPR float TOLERANCE_PIXEL = 0.75f;
+
+/* Long segments are interpolated every INTERPOLATE_PIXEL but not more than MAX_INTERPOLATE times */
+static Q_DECL_CONSTEXPR float INTERPOLATE_PIXEL = 32.f;
+static Q_DECL_CONSTEXPR int MAX_INTERPOLATE = 64;
+
+/* Polygons having longer screen segments or coordinates too far outside are left to Marble for drawing */
+static Q_DECL_CONSTEXPR int MAX_SEGMENT_PIXEL = 256;
+static Q_DECL_CONSTEXPR int MAX_SCREENS_OUTSIDE = 8;
+
+static Q_DECL_CONSTEXPR float METER_PER_DEGREE = 111319.5f;
+
+bool MapAirspaceGeometryCache::ViewportKey::operator==(const ViewportKey& other) const
+{
+  return projection == other.projection && radius == other.radius && width == other.width &&
+         height == other.height && detail == other.detail && centerLon == other.centerLon &&
+         centerLat == other.centerLat;
+}
+
+MapAirspaceGeometryCache::MapAirspaceGeometryCache(MapQuery *mapQueryParam)
+  : mapQuery(mapQueryParam)
+{
+  geometryCache.setMaxCost(atools::settings::Settings::instance().getAndStoreValue(
+                             lnm::SETTINGS_MAPQUERY + "AirspaceSimplifiedCache", 200000).toInt());
+}
+
+MapAirspaceGeometryCache::~MapAirspaceGeometryCache()
+{
+
+}
+
+void MapAirspaceGeometryCache::clear()
+{
+  geometryCache.clear();
+  uncachedGeometry.clear();
+  screenPolygons.clear();
+  viewportKey = ViewportKey();
+}
+
+void MapAirspaceGeometryCache::updateViewport(const Marble::ViewportParams *viewport, const MapLayer *mapLayer)
+{
+  ViewportKey key;
+  key.projection = viewport->projection();
+  key.radius = viewport->radius();
+  key.width = viewport->width();
+  key.height = viewport->height();
+  key.centerLon = viewport->centerLongitude();
+  key.centerLat = viewport->centerLatitude();
+  key.detail = mapLayer->getAirspaceDetail();
+
+  if(key != viewportKey)
+  {
+    screenPolygons.clear();
+    viewportKey = key;
+  }
+}
+
+int MapAirspaceGeometryCache::zoomLevel(const Marble::ViewportParams *viewport)
+{
+  // Radius is earth radius in pixel
+  double pixelPerDegree = viewport->radius() * M_PI / 180.;
+  if(pixelPerDegree <= 0.)
+    return MIN_LEVEL;
+
+  int level = static_cast<int>(std::floor(std::log2(pixelPerDegree)));
+  return std::min(std::max(level, MIN_LEVEL), MAX_LEVEL + 1);
+}
+
+const LineString *MapAirspaceGeometryCache::getGeometry(const Marble::ViewportParams *viewport,
+                                                       const MapLayer *mapLayer, int airspaceId)
+{
+  int detail = mapLayer->getAirspaceDetail();
+  int level = zoomLevel(viewport);
+  if(level > MAX_LEVEL)
+    // Too close for simplification
+    return mapQuery->getAirspaceGeometry(airspaceId, detail);
+
+  // Five bits for level and three for the database detail level
+  quint64 key = (static_cast<quint64>(airspaceId) << 8) | static_cast<quint64>(detail << 5) |
+                static_cast<quint64>(level - MIN_LEVEL);
+  LineString *geometry = geometryCache.object(key);
+  if(geometry == nullptr)
+  {
+    geometry = new LineString;
+    simplify(*geometry, *mapQuery->getAirspaceGeometry(airspaceId, detail), level);
+
+    int cost = std::max(geometry->size(), 1);
+    if(cost > geometryCache.maxCost())
+    {
+      // Cache would delete the object immediately on insert - keep it outside until the next call
+      uncachedGeometry = *geometry;
+      delete geometry;
+      return &uncachedGeometry;
+    }
+    geometryCache.insert(key, geometry, cost);
+  }
+  return geometry;
+}
+
+const MapAirspaceScreenPolygon *MapAirspaceGeometryCache::getScreenPolygon(const Marble::ViewportParams *viewport,
+                                                                           const MapLayer *mapLayer, int airspaceId)
+{
+  updateViewport(viewport, mapLayer);
+
+  QHash<int, MapAirspaceScreenPolygon>::iterator it = screenPolygons.find(airspaceId);
+  if(it != screenPolygons.end())
+    return &it.value();
+
+  MapAirspaceScreenPolygon screen;
+  const LineString *geometry = getGeometry(viewport, mapLayer, airspaceId);
+  int num = geometry->size();
+
+  if(num > 0)
+  {
+    QVector<float> lonX(num), latY(num);
+    for(int i = 0; i < num; i++)
+    {
+      lonX[i] = geometry->at(i).getLonX();
+      latY[i] = geometry->at(i).getLatY();
+    }
+
+    QVector<double> xs(num), ys(num);
+    QVector<bool> visible(num), hidden(num);
+    CoordinateConverter conv(viewport);
+    conv.wToSBatch(lonX.constData(), latY.constData(), num, xs.data(), ys.data(), visible.data(), hidden.data());
+
+    bool mercator = viewport->projection() == Marble::Mercator;
+    double maxLat = viewport->currentProjection()->maxValidLat() * 180. / M_PI;
+
+    // Wrapped repetitions in Mercator differ by four times the radius
+    double maxJump = 2. * viewport->radius();
+    double limitX = MAX_SCREENS_OUTSIDE * std::max(viewport->width(), 1);
+    double limitY = MAX_SCREENS_OUTSIDE * std::max(viewport->height(), 1);
+
+    screen.complete = true;
+    screen.polygon.reserve(num);
+    for(int i = 0; i < num; i++)
+    {
+      double x = xs.at(i), y = ys.at(i);
+
+      if(hidden.at(i) || (mercator && std::abs(latY.at(i)) > maxLat) ||
+         std::abs(x) > limitX || std::abs(y) > limitY)
+      {
+        screen.complete = false;
+
+        // Avoid integer overflow for points far outside
+        x = std::min(std::max(x, -limitX), limitX);
+        y = std::min(std::max(y, -limitY), limitY);
+      }
+
+      QPoint point(atools::roundToInt(x), atools::roundToInt(y));
+
+      if(i > 0 && screen.complete)
+      {
+        QPoint diff = point - screen.polygon.last();
+        if((mercator && std::abs(diff.x()) > maxJump) || diff.manhattanLength() > MAX_SEGMENT_PIXEL)
+          screen.complete = false;
+      }
+      screen.polygon.append(point);
+    }
+  }
+
+  return &screenPolygons.insert(airspaceId, screen).value();
+}
+
+void MapAirspaceGeometryCache::simplify(LineString& result, const LineString& boundary, int level)
+{
+  // Largest number of pixels per degree for this level
+  float pixelPerDegree = std::pow(2.f, static_cast<float>(level + 1));
+
+  QVector<bool> keep;
+  maptools::douglasPeucker(keep, boundary, TOLERANCE_PIXEL / pixelPerDegree);
+
+  result.clear();
+  for(int i = 0; i < boundary.size(); i++)
+  {
+    if(!keep.at(i))
+      continue;
+
+    const Pos& pos = boundary.at(i);
+    if(!result.isEmpty())
+    {
+      // Interpolate along the great circle since the result is drawn with straight lines
+      Pos last = result.last();
+      float distanceMeter = last.distanceMeterTo(pos);
+      int num = std::min(static_cast<int>(distanceMeter / METER_PER_DEGREE * pixelPerDegree / INTERPOLATE_PIXEL),
+                         MAX_INTERPOLATE);
+      for(int j = 1; j < num; j++)
+        result.append(last.interpolate(pos, distanceMeter, static_cast<float>(j) / num));
+    }
+    result.append(pos);
+  }
+}
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPAIRSPACEGEOMETRYCACHE_H
+#define LITTLENAVMAP_MAPAIRSPACEGEOMETRYCACHE_H
+
+#include "geo/linestring.h"
+
+#include <QCache>
+#include <QHash>
+#include <QPolygon>
+
+namespace Marble {
+class ViewportParams;
+}
+
+class MapLayer;
+class MapQuery;
+
+/* Airspace boundary in screen coordinates for the current viewport */
+struct MapAirspaceScreenPolygon
+{
+  QPolygon polygon;
+
+  /* All points are projected consistently, i.e. none is hidden behind the globe, wrapped around in the
+   * Mercator projection or clamped far outside the screen. Polygon can be drawn directly and used for hit testing.
+   * Otherwise the polygon is distorted and must not be used. */
+  bool complete = false;
+};
+
+/*
+ * Cache for airspace boundaries shared by the airspace painter and the screen index.
+ *
+ * Boundaries are loaded with the detail level of the map layer and simplified with the Douglas-Peucker algorithm
+ * once per airspace and zoom level and kept in a cache. Long segments are interpolated along the great circle
+ * since the simplified boundary is drawn with straight screen lines.
+ *
+ * The simplified boundaries are projected to screen coordinates which are kept until the viewport
+ * (projection, center, zoom or size) changes. This allows painting and hit testing to use the same polygons
+ * and avoids projecting all points again for repaints that do not change the view.
+ */
+class MapAirspaceGeometryCache
+{
+public:
+  MapAirspaceGeometryCache(MapQuery *mapQueryParam);
+  ~MapAirspaceGeometryCache();
+
+  /* Remove all simplified boundaries and polygons. Has to be called if the database changes. */
+  void clear();
+
+  /* Get the boundary simplified for the zoom level of the viewport. Pointer is valid until the next call. */
+  const atools::geo::LineString *getGeometry(const Marble::ViewportParams *viewport, const MapLayer *mapLayer,
+                                             int airspaceId);
+
+  /* Get the simplified boundary in screen coordinates of the viewport. Pointer is valid until the next call. */
+  const MapAirspaceScreenPolygon *getScreenPolygon(const Marble::ViewportParams *viewport, const MapLayer *mapLayer,
+                                                   int airspaceId);
+
+private:
+  /* Values defining the world to screen transformation */
+  struct ViewportKey
+  {
+    int projection = -1, radius = 0, width = 0, height = 0, detail = 0;
+    double centerLon = 0., centerLat = 0.;
+
+    bool operator==(const ViewportKey& other) const;
+
+    bool operator!=(const ViewportKey& other) const
+    {
+      return !operator==(other);
+    }
+  };
+
+  /* Drop projected polygons if the viewport has changed */
+  void updateViewport(const Marble::ViewportParams *viewport, const MapLayer *mapLayer);
+
+  /* Zoom level for viewport. Each level doubles pixel per degree. */
+  static int zoomLevel(const Marble::ViewportParams *viewport);
+
+  /* Simplify and interpolate boundary for the given zoom level */
+  static void simplify(atools::geo::LineString& result, const atools::geo::LineString& boundary, int level);
+
+  /* Key is airspace id and zoom level - cost is number of points */
+  QCache<quint64, atools::geo::LineString> geometryCache;
+
+  /* Simplified boundary too large for the cache */
+  atools::geo::LineString uncachedGeometry;
+
+  /* Screen polygons for current viewport */
+  QHash<int, MapAirspaceScreenPolygon> screenPolygons;
+  ViewportKey viewportKey;
+
+  MapQuery *mapQuery;
+};
+
+#endif // LITTLENAVMAP_MAPAIRSPACEGEOMETRYCACHE_H
@@ -359,6 +359,12 @@ MapLayer& MapLayer::airspaceOther(bool value)
   return *this;
 }
 
+MapLayer& MapLayer::airspaceDetail(int level)
+{
+  layerAirspaceDetail = level;
+  return *this;
+}
+
 MapLayer& MapLayer::aiAircraftLarge(bool value)
 {
   layerAiAircraftLarge = value;
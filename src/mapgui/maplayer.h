@@ -154,6 +154,9 @@ public:
   MapLayer& airspaceSpecial(bool value = true);
   MapLayer& airspaceOther(bool value = true);
 
+  /* Simplified airspace boundaries from the database. 0 is full resolution. */
+  MapLayer& airspaceDetail(int level);
+
   MapLayer& aiAircraftGround(bool value = true);
   MapLayer& aiAircraftLarge(bool value = true);
   MapLayer& aiAircraftSmall(bool value = true);
@@ -429,6 +432,11 @@ public:
     return layerAirspaceOther;
   }
 
+  int getAirspaceDetail() const
+  {
+    return layerAirspaceDetail;
+  }
+
   bool isAiAircraftLarge() const
   {
     return layerAiAircraftLarge;
@@ -501,6 +509,7 @@ private:
 
   bool layerAirspaceCenter = false, layerAirspaceIcao = false, layerAirspaceFir = false, layerAirspaceRestricted =
     false, layerAirspaceSpecial = false, layerAirspaceOther = false;
+  int layerAirspaceDetail = 0;
 
   bool layerAiAircraftGround = false, layerAiAircraftLarge = false, layerAiAircraftSmall = false,
        layerAiShipLarge = false, layerAiShipSmall = false,
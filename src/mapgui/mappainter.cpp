@@ -25,6 +25,7 @@
 
 #include <marble/GeoDataLineString.h>
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -204,6 +205,14 @@ void MapPainter::drawLine(const PaintContext *context, const atools::geo::Line&
   }
 }
 
+float MapPainter::cullMargin(const PaintContext *context) const
+{
+  const GeoDataLatLonAltBox& box = context->viewport->viewLatLonAltBox();
+  double degPerPixel = std::max(box.width(GeoDataCoordinates::Degree) / std::max(context->viewport->width(), 1),
+                                box.height(GeoDataCoordinates::Degree) / std::max(context->viewport->height(), 1));
+  return static_cast<float>(degPerPixel * DEFAULT_WTOS_SIZE.width() * 2.);
+}
+
 void MapPainter::paintArc(QPainter *painter, const QPointF& p1, const QPointF& p2, const QPointF& center, bool left)
 {
   QRectF arcRect;
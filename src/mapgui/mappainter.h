@@ -20,6 +20,7 @@
 
 #include "common/coordinateconverter.h"
 #include "common/mapflags.h"
+#include "common/mapobjectlist.h"
 #include "options/optiondata.h"
 #include "geo/rect.h"
 
@@ -82,6 +83,9 @@ struct PaintContext
   static Q_DECL_CONSTEXPR int MAX_OBJECT_COUNT = 4000;
   int objectCount = 0;
 
+  /* Number of objects dropped by viewport culling before projection. Used for profiling. */
+  int objectsCulled = 0;
+
   /* Increase drawn object count and return true if exceeded */
   bool objCount()
   {
@@ -135,6 +139,20 @@ struct PaintContext
 
 };
 
+/* Screen coordinates for a part of a map object list. Filled by MapPainter::wToSObjects. */
+struct ObjectScreenCoords
+{
+  QVector<int> indexes; /* Index into the object list */
+  QVector<double> x, y;
+  QVector<bool> visible, hidden;
+
+  int size() const
+  {
+    return indexes.size();
+  }
+
+};
+
 /*
  * Base class for all map painters
  */
@@ -159,6 +177,15 @@ protected:
   void drawLineString(const PaintContext *context, const atools::geo::LineString& linestring);
   void drawLine(const PaintContext *context, const atools::geo::Line& line);
 
+  /* Margin in degree around the viewport rectangle for culling point objects before projection.
+   * Uses the default screen size of visibility checks and allows for distortion at the globe borders. */
+  float cullMargin(const PaintContext *context) const;
+
+  /* Convert the positions of all objects referenced by coords.indexes to screen coordinates in one batch */
+  template<typename TYPE>
+  void wToSObjects(const map::MapObjectList<TYPE>& objects, ObjectScreenCoords& coords,
+                   const QSize& size = DEFAULT_WTOS_SIZE) const;
+
   void paintArc(QPainter *painter, const QPointF& p1, const QPointF& p2, const QPointF& center, bool left);
 
   void paintHoldWithText(QPainter *painter, float x, float y, float direction, float lengthNm, float minutes, bool left,
@@ -182,4 +209,20 @@ protected:
 
 };
 
+template<typename TYPE>
+void MapPainter::wToSObjects(const map::MapObjectList<TYPE>& objects, ObjectScreenCoords& coords,
+                             const QSize& size) const
+{
+  QVector<float> lonX, latY;
+  objects.positions(coords.indexes, lonX, latY);
+
+  int num = coords.indexes.size();
+  coords.x.resize(num);
+  coords.y.resize(num);
+  coords.visible.resize(num);
+  coords.hidden.resize(num);
+  wToSBatch(lonX.constData(), latY.constData(), num, coords.x.data(), coords.y.data(), coords.visible.data(),
+            coords.hidden.data(), size);
+}
+
 #endif // LITTLENAVMAP_MAPPAINTER_H
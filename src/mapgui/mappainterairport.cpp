@@ -40,6 +40,9 @@ using namespace Marble;
 using namespace atools::geo;
 using namespace map;
 
+/* Minimum culling margin in degree. Larger than the bounding rectangle of any airport. */
+static const float AIRPORT_CULL_MARGIN_DEG = 0.2f;
+
 MapPainterAirport::MapPainterAirport(MapWidget *mapWidget, MapScale *mapScale,
                                      const Route *routeParam)
   : MapPainter(mapWidget, mapScale), route(routeParam)
@@ -77,22 +80,27 @@ void MapPainterAirport::render(PaintContext *context)
 
   // Get airports from cache/database for the bounding rectangle and add them to the map
   const GeoDataLatLonAltBox& curBox = context->viewport->viewLatLonAltBox();
-  const QList<MapAirport> *airportCache = nullptr;
+  const MapObjectList<MapAirport> *airportCache = nullptr;
   if(context->mapLayerEffective->isAirportDiagram())
     airportCache = mapQuery->getAirports(curBox, context->mapLayerEffective, context->lazyUpdate);
   else
     airportCache = mapQuery->getAirports(curBox, context->mapLayer, context->lazyUpdate);
 
-  for(const MapAirport& ap : *airportCache)
-    airportMap.insert(ap.id, &ap);
+  // Cull by position first - margin has to cover the bounding rectangle of airport diagrams and overview runways
+  QVector<int> indexes;
+  airportCache->indexesInRect(context->viewportRect, std::max(cullMargin(context), AIRPORT_CULL_MARGIN_DEG),
+                              indexes);
+  context->objectsCulled += airportCache->size() - indexes.size();
+  for(int i : indexes)
+    airportMap.insert(airportCache->idAt(i), &airportCache->at(i));
 
   if(airportMap.isEmpty())
     // Nothing found in bounding rectangle and route
     return;
 
-  // Collect all airports that are visible
-  QList<const MapAirport *> visibleAirports;
-  QList<QPointF> visiblePoints;
+  // Collect all airports which are candidates for drawing
+  QVector<const MapAirport *> airports;
+  QVector<float> lonX, latY;
   for(const MapAirport *airport : airportMap.values())
   {
     // Either part of the route or enabled in the actions/menus/toolbar
@@ -102,23 +110,45 @@ void MapPainterAirport::render(PaintContext *context)
     // Avoid drawing too many airports during animation when zooming out
     if(airport->longestRunwayLength >= context->mapLayer->getMinRunwayLength())
     {
-      float x, y;
-      bool hidden;
-      bool visible = wToS(airport->position, x, y, scale->getScreeenSizeForRect(airport->bounding), &hidden);
+      airports.append(airport);
+      lonX.append(airport->position.getLonX());
+      latY.append(airport->position.getLatY());
+    }
+  }
+
+  // Convert all positions in one batch using the default screen size
+  int num = airports.size();
+  QVector<double> xs(num), ys(num);
+  QVector<bool> visibles(num), hiddens(num);
+  wToSBatch(lonX.constData(), latY.constData(), num, xs.data(), ys.data(), visibles.data(), hiddens.data());
 
-      if(!hidden)
+  // Collect all airports that are visible
+  QList<const MapAirport *> visibleAirports;
+  QList<QPointF> visiblePoints;
+  for(int i = 0; i < num; i++)
+  {
+    const MapAirport *airport = airports.at(i);
+    bool visible = visibles.at(i), hidden = hiddens.at(i);
+    double x = xs.at(i), y = ys.at(i);
+
+    if(!hidden)
+    {
+      if(!visible)
       {
-        if(!visible && context->mapLayer->isAirportOverviewRunway())
-          // Check bounding rect for visibility if relevant - not for point symbols
-          visible = airport->bounding.overlaps(context->viewportRect);
+        // Airport diagrams or runway overviews can be larger than the default size - check again with real size
+        QSize size = scale->getScreeenSizeForRect(airport->bounding);
+        if(size.width() > DEFAULT_WTOS_SIZE.width() || size.height() > DEFAULT_WTOS_SIZE.height())
+          visible = wToS(airport->position, x, y, size);
+      }
 
-        airport->bounding.overlaps(context->viewportRect);
+      if(!visible && context->mapLayer->isAirportOverviewRunway())
+        // Check bounding rect for visibility if relevant - not for point symbols
+        visible = airport->bounding.overlaps(context->viewportRect);
 
-        if(visible)
-        {
-          visibleAirports.append(airport);
-          visiblePoints.append(QPointF(x, y));
-        }
+      if(visible)
+      {
+        visibleAirports.append(airport);
+        visiblePoints.append(QPointF(x, y));
       }
     }
   }
@@ -18,6 +18,7 @@
 #include "mapgui/mappainterairspace.h"
 
 #include "common/mapcolors.h"
+#include "mapgui/mapairspacegeometrycache.h"
 #include "util/paintercontextsaver.h"
 #include "route/route.h"
 #include "query/mapquery.h"
@@ -34,8 +35,8 @@ using namespace atools::geo;
 using namespace map;
 
 MapPainterAirspace::MapPainterAirspace(MapWidget *mapWidget, MapScale *mapScale,
-                                       const Route *routeParam)
-  : MapPainter(mapWidget, mapScale), route(routeParam)
+                                       const Route *routeParam, MapAirspaceGeometryCache *geometryCacheParam)
+  : MapPainter(mapWidget, mapScale), route(routeParam), geometryCache(geometryCacheParam)
 {
 }
 
@@ -50,7 +51,7 @@ void MapPainterAirspace::render(PaintContext *context)
     return;
 
   const GeoDataLatLonAltBox& curBox = context->viewport->viewLatLonAltBox();
-  const QList<MapAirspace> *airspaces =
+  const MapObjectList<MapAirspace> *airspaces =
     mapQuery->getAirspaces(curBox, context->mapLayer, context->airspaceFilterByLayer, route->getCruisingAltitudeFeet(),
                         context->viewContext == Marble::Animation);
   if(airspaces != nullptr)
@@ -73,20 +74,27 @@ void MapPainterAirspace::render(PaintContext *context)
 
         // qDebug() << airspace.getId() << airspace.name;
 
-        Marble::GeoDataLinearRing linearRing;
-        linearRing.setTessellate(true);
-
         painter->setPen(mapcolors::penForAirspace(airspace));
 
         if(!context->drawFast)
           painter->setBrush(mapcolors::colorForAirspaceFill(airspace));
 
-        const LineString *lines = mapQuery->getAirspaceGeometry(airspace.id);
-
-        for(const Pos& pos : *lines)
-          linearRing.append(Marble::GeoDataCoordinates(pos.getLonX(), pos.getLatY(), 0, DEG));
-
-        painter->drawPolygon(linearRing);
+        // Use the projected polygon shared with the screen index if possible
+        const MapAirspaceScreenPolygon *screen = geometryCache->getScreenPolygon(context->viewport, context->mapLayer,
+                                                                                        airspace.id);
+        if(screen->complete)
+          painter->QPainter::drawPolygon(screen->polygon);
+        else
+        {
+          // Partially hidden behind the globe or wrapped around - let Marble clip the simplified boundary
+          Marble::GeoDataLinearRing linearRing;
+          linearRing.setTessellate(true);
+
+          for(const Pos& pos : *geometryCache->getGeometry(context->viewport, context->mapLayer, airspace.id))
+            linearRing.append(Marble::GeoDataCoordinates(pos.getLonX(), pos.getLatY(), 0, DEG));
+
+          painter->drawPolygon(linearRing);
+        }
       }
     }
   }
@@ -24,6 +24,7 @@ namespace Marble {
 class GeoDataLineString;
 }
 
+class MapAirspaceGeometryCache;
 class MapWidget;
 class Route;
 
@@ -34,13 +35,15 @@ class MapPainterAirspace :
   public MapPainter
 {
 public:
-  MapPainterAirspace(MapWidget *mapWidget, MapScale *mapScale, const Route *routeParam);
+  MapPainterAirspace(MapWidget *mapWidget, MapScale *mapScale, const Route *routeParam,
+                     MapAirspaceGeometryCache *geometryCacheParam);
   virtual ~MapPainterAirspace();
 
   virtual void render(PaintContext *context) override;
 
 private:
   const Route *route;
+  MapAirspaceGeometryCache *geometryCache;
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERAIRSPACE_H
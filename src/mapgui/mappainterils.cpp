@@ -51,7 +51,7 @@ void MapPainterIls::render(PaintContext *context)
   {
     const GeoDataLatLonBox& curBox = context->viewport->viewLatLonAltBox();
 
-    const QList<MapIls> *ilsList = mapQuery->getIls(curBox, context->mapLayer, context->lazyUpdate);
+    const map::MapObjectList<MapIls> *ilsList = mapQuery->getIls(curBox, context->mapLayer, context->lazyUpdate);
     if(ilsList != nullptr)
     {
       atools::util::PainterContextSaver saver(context->painter);
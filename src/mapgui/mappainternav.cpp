@@ -25,6 +25,7 @@
 #include "util/paintercontextsaver.h"
 #include "mapgui/maplayer.h"
 #include "query/mapquery.h"
+#include "atools.h"
 
 #include <QElapsedTimer>
 
@@ -62,7 +63,7 @@ void MapPainterNav::render(PaintContext *context)
   if(drawAirway && !context->isOverflow())
   {
     // Draw airway lines
-    const QList<MapAirway> *airways = mapQuery->getAirways(curBox, context->mapLayer,
+    const MapObjectList<MapAirway> *airways = mapQuery->getAirways(curBox, context->mapLayer,
                                                            context->viewContext == Marble::Animation);
     if(airways != nullptr)
       paintAirways(context, airways, context->drawFast);
@@ -73,7 +74,8 @@ void MapPainterNav::render(PaintContext *context)
   if((drawWaypoint || drawAirway) && !context->isOverflow())
   {
     // If airways are drawn we also have to go through waypoints
-    const QList<MapWaypoint> *waypoints = mapQuery->getWaypoints(curBox, context->mapLayer, context->lazyUpdate);
+    const MapObjectList<MapWaypoint> *waypoints = mapQuery->getWaypoints(curBox, context->mapLayer,
+                                                                         context->lazyUpdate);
     if(waypoints != nullptr)
       paintWaypoints(context, waypoints, drawWaypoint, context->drawFast);
   }
@@ -81,7 +83,7 @@ void MapPainterNav::render(PaintContext *context)
   // VOR -------------------------------------------------
   if(context->mapLayer->isVor() && context->objectTypes.testFlag(map::VOR) && !context->isOverflow())
   {
-    const QList<MapVor> *vors = mapQuery->getVors(curBox, context->mapLayer, context->lazyUpdate);
+    const MapObjectList<MapVor> *vors = mapQuery->getVors(curBox, context->mapLayer, context->lazyUpdate);
     if(vors != nullptr)
       paintVors(context, vors, context->drawFast);
   }
@@ -89,7 +91,7 @@ void MapPainterNav::render(PaintContext *context)
   // NDB -------------------------------------------------
   if(context->mapLayer->isNdb() && context->objectTypes.testFlag(map::NDB) && !context->isOverflow())
   {
-    const QList<MapNdb> *ndbs = mapQuery->getNdbs(curBox, context->mapLayer, context->lazyUpdate);
+    const MapObjectList<MapNdb> *ndbs = mapQuery->getNdbs(curBox, context->mapLayer, context->lazyUpdate);
     if(ndbs != nullptr)
       paintNdbs(context, ndbs, context->drawFast);
   }
@@ -97,14 +99,14 @@ void MapPainterNav::render(PaintContext *context)
   // Marker -------------------------------------------------
   if(context->mapLayer->isMarker() && context->objectTypes.testFlag(map::ILS) && !context->isOverflow())
   {
-    const QList<MapMarker> *markers = mapQuery->getMarkers(curBox, context->mapLayer, context->lazyUpdate);
+    const MapObjectList<MapMarker> *markers = mapQuery->getMarkers(curBox, context->mapLayer, context->lazyUpdate);
     if(markers != nullptr)
       paintMarkers(context, markers, context->drawFast);
   }
 }
 
 /* Draw airways and texts */
-void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *airways, bool fast)
+void MapPainterNav::paintAirways(PaintContext *context, const MapObjectList<MapAirway> *airways, bool fast)
 {
   QFontMetrics metrics = context->painter->fontMetrics();
 
@@ -274,23 +276,35 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
 }
 
 /* Draw waypoints. If airways are enabled corresponding waypoints are drawn too */
-void MapPainterNav::paintWaypoints(PaintContext *context, const QList<MapWaypoint> *waypoints,
+void MapPainterNav::paintWaypoints(PaintContext *context, const MapObjectList<MapWaypoint> *waypoints,
                                    bool drawWaypoint, bool drawFast)
 {
   bool drawAirwayV = context->mapLayer->isAirwayWaypoint() && context->objectTypes.testFlag(map::AIRWAYV);
   bool drawAirwayJ = context->mapLayer->isAirwayWaypoint() && context->objectTypes.testFlag(map::AIRWAYJ);
 
-  for(const MapWaypoint& waypoint : *waypoints)
+  ObjectScreenCoords coords;
+  waypoints->indexesInRect(context->viewportRect, cullMargin(context), coords.indexes);
+  context->objectsCulled += waypoints->size() - coords.indexes.size();
+
+  if(!drawWaypoint)
   {
-    // If waypoints are off, airways are on and waypoint has no airways skip it
-    if(!(drawWaypoint || (drawAirwayV && waypoint.hasVictorAirways) || (drawAirwayJ && waypoint.hasJetAirways)))
-      continue;
+    // Waypoints are off and airways are on - skip waypoints having no airways before projecting
+    coords.indexes.erase(std::remove_if(coords.indexes.begin(), coords.indexes.end(), [ = ](int index) -> bool
+    {
+      quint32 flags = waypoints->flagsAt(index);
+      return !((drawAirwayV && flags & OBJ_WAYPOINT_VICTOR) || (drawAirwayJ && flags & OBJ_WAYPOINT_JET));
+    }), coords.indexes.end());
+  }
 
-    int x, y;
-    bool visible = wToS(waypoint.position, x, y);
+  wToSObjects(*waypoints, coords);
 
-    if(visible)
+  for(int i = 0; i < coords.size(); i++)
+  {
+    if(coords.visible.at(i))
     {
+      const MapWaypoint& waypoint = waypoints->at(coords.indexes.at(i));
+      int x = atools::roundToInt(coords.x.at(i)), y = atools::roundToInt(coords.y.at(i));
+
       if(context->objCount())
         return;
 
@@ -305,15 +319,20 @@ void MapPainterNav::paintWaypoints(PaintContext *context, const QList<MapWaypoin
   }
 }
 
-void MapPainterNav::paintVors(PaintContext *context, const QList<MapVor> *vors, bool drawFast)
+void MapPainterNav::paintVors(PaintContext *context, const MapObjectList<MapVor> *vors, bool drawFast)
 {
-  for(const MapVor& vor : *vors)
-  {
-    int x, y;
-    bool visible = wToS(vor.position, x, y);
+  ObjectScreenCoords coords;
+  vors->indexesInRect(context->viewportRect, cullMargin(context), coords.indexes);
+  context->objectsCulled += vors->size() - coords.indexes.size();
+  wToSObjects(*vors, coords);
 
-    if(visible)
+  for(int i = 0; i < coords.size(); i++)
+  {
+    if(coords.visible.at(i))
     {
+      const MapVor& vor = vors->at(coords.indexes.at(i));
+      int x = atools::roundToInt(coords.x.at(i)), y = atools::roundToInt(coords.y.at(i));
+
       if(context->objCount())
         return;
 
@@ -334,15 +353,20 @@ void MapPainterNav::paintVors(PaintContext *context, const QList<MapVor> *vors,
   }
 }
 
-void MapPainterNav::paintNdbs(PaintContext *context, const QList<MapNdb> *ndbs, bool drawFast)
+void MapPainterNav::paintNdbs(PaintContext *context, const MapObjectList<MapNdb> *ndbs, bool drawFast)
 {
-  for(const MapNdb& ndb : *ndbs)
-  {
-    int x, y;
-    bool visible = wToS(ndb.position, x, y);
+  ObjectScreenCoords coords;
+  ndbs->indexesInRect(context->viewportRect, cullMargin(context), coords.indexes);
+  context->objectsCulled += ndbs->size() - coords.indexes.size();
+  wToSObjects(*ndbs, coords);
 
-    if(visible)
+  for(int i = 0; i < coords.size(); i++)
+  {
+    if(coords.visible.at(i))
     {
+      const MapNdb& ndb = ndbs->at(coords.indexes.at(i));
+      int x = atools::roundToInt(coords.x.at(i)), y = atools::roundToInt(coords.y.at(i));
+
       if(context->objCount())
         return;
 
@@ -361,10 +385,15 @@ void MapPainterNav::paintNdbs(PaintContext *context, const QList<MapNdb> *ndbs,
   }
 }
 
-void MapPainterNav::paintMarkers(PaintContext *context, const QList<MapMarker> *markers, bool drawFast)
+void MapPainterNav::paintMarkers(PaintContext *context, const MapObjectList<MapMarker> *markers, bool drawFast)
 {
-  for(const MapMarker& marker : *markers)
+  QVector<int> indexes;
+  markers->indexesInRect(context->viewportRect, cullMargin(context), indexes);
+  context->objectsCulled += markers->size() - indexes.size();
+
+  for(int i : indexes)
   {
+    const MapMarker& marker = markers->at(i);
     int x, y;
     bool visible = wToS(marker.position, x, y);
 
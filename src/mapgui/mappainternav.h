@@ -20,7 +20,7 @@
 
 #include "mapgui/mappainter.h"
 
-#include "common/maptypes.h"
+#include "common/mapobjectlist.h"
 
 class SymbolPainter;
 
@@ -39,12 +39,12 @@ public:
   virtual void render(PaintContext *context) override;
 
 private:
-  void paintMarkers(PaintContext *context, const QList<map::MapMarker> *markers, bool drawFast);
-  void paintNdbs(PaintContext *context, const QList<map::MapNdb> *ndbs, bool drawFast);
-  void paintVors(PaintContext *context, const QList<map::MapVor> *vors, bool drawFast);
-  void paintWaypoints(PaintContext *context, const QList<map::MapWaypoint> *waypoints,
+  void paintMarkers(PaintContext *context, const map::MapObjectList<map::MapMarker> *markers, bool drawFast);
+  void paintNdbs(PaintContext *context, const map::MapObjectList<map::MapNdb> *ndbs, bool drawFast);
+  void paintVors(PaintContext *context, const map::MapObjectList<map::MapVor> *vors, bool drawFast);
+  void paintWaypoints(PaintContext *context, const map::MapObjectList<map::MapWaypoint> *waypoints,
                       bool drawWaypoint, bool drawFast);
-  void paintAirways(PaintContext *context, const QList<map::MapAirway> *airways, bool fast);
+  void paintAirways(PaintContext *context, const map::MapObjectList<map::MapAirway> *airways, bool fast);
 
 };
 
@@ -28,6 +28,7 @@
 #include "settings/settings.h"
 
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -129,68 +130,114 @@ void MapPainterVehicle::paintUserAircraft(const PaintContext *context,
 
 void MapPainterVehicle::paintTrack(const PaintContext *context)
 {
-  const AircraftTrack& aircraftTrack = mapWidget->getAircraftTrack();
+  // Use decimated track where positions closer than the minimum line length are already removed
+  float toleranceMeter = 0.f;
+  if(scale->isValid())
+    toleranceMeter = AIRCRAFT_TRACK_MIN_LINE_LENGTH * 1000.f / scale->getPixelForMeter(1000.f);
+  const at::AircraftTrackRing& aircraftTrack = mapWidget->getAircraftTrack().getTrack(toleranceMeter);
 
-  if(!aircraftTrack.isEmpty())
+  if(aircraftTrack.size() > 1)
   {
-    QPolygon polyline;
+    updateTrackCache(context, aircraftTrack);
 
     GeoPainter *painter = context->painter;
 
     float size = context->sz(context->thicknessTrail, 2);
     painter->setPen(mapcolors::aircraftTrailPen(size));
-    bool lastVisible = false;
 
-    int x1, y1;
-    int x2 = -1, y2 = -1;
-    QRect vpRect(painter->viewport());
-    wToS(aircraftTrack.first().pos, x1, y1);
+    for(const QPolygon& polyline : trackCache.polylines)
+      painter->drawPolyline(polyline);
 
-    for(int i = 1; i < aircraftTrack.size(); i++)
+    // Draw rest
+    if(!trackCache.polyline.isEmpty())
     {
-      const at::AircraftTrackPos& trackPos = aircraftTrack.at(i);
-      wToS(trackPos.pos, x2, y2);
+      QPolygon polyline(trackCache.polyline);
+      polyline.append(QPoint(trackCache.x1, trackCache.y1));
+      painter->drawPolyline(polyline);
+    }
+  }
+  else
+    trackCache = TrackCache();
+}
 
-      QRect rect(QPoint(x1, y1), QPoint(x2, y2));
-      rect = rect.normalized();
-      rect.adjust(-1, -1, 1, 1);
+void MapPainterVehicle::updateTrackCache(const PaintContext *context, const at::AircraftTrackRing& aircraftTrack)
+{
+  const Marble::ViewportParams *viewport = context->viewport;
+  TrackCache& cache = trackCache;
+
+  int numNew = static_cast<int>(aircraftTrack.getNumAppended() - cache.numAppended);
+  bool full = aircraftTrack.size() == aircraftTrack.getCapacity();
+
+  if(cache.track != &aircraftTrack || cache.generation != aircraftTrack.getGeneration() ||
+     cache.projection != viewport->projection() || cache.radius != viewport->radius() ||
+     cache.width != viewport->width() || cache.height != viewport->height() ||
+     cache.centerLon != viewport->centerLongitude() || cache.centerLat != viewport->centerLatitude() ||
+     numNew < 0 || numNew >= aircraftTrack.size() ||
+     (full && cache.numDropped + numNew > TRACK_CACHE_MAX_DROPPED))
+  {
+    // Project the whole track
+    cache = TrackCache();
+    cache.track = &aircraftTrack;
+    cache.generation = aircraftTrack.getGeneration();
+    cache.projection = viewport->projection();
+    cache.radius = viewport->radius();
+    cache.width = viewport->width();
+    cache.height = viewport->height();
+    cache.centerLon = viewport->centerLongitude();
+    cache.centerLat = viewport->centerLatitude();
+
+    wToS(aircraftTrack.first().pos, cache.x1, cache.y1);
+    numNew = aircraftTrack.size() - 1;
+  }
+  else if(full)
+    // Dropped positions stay in the polylines until the next full update
+    cache.numDropped += numNew;
 
-      // Current line is visible (most likely)
-      bool nowVisible = rect.intersects(vpRect);
+  QRect vpRect(context->painter->viewport());
+  int x2 = -1, y2 = -1;
+  for(int i = aircraftTrack.size() - numNew; i < aircraftTrack.size(); i++)
+  {
+    wToS(aircraftTrack.at(i).pos, x2, y2);
+    addTrackPoint(x2, y2, vpRect);
+  }
 
-      if(lastVisible || nowVisible)
-      {
-        if(!polyline.isEmpty())
-        {
-          const QPoint& lastPt = polyline.last();
-          // Last line or this one are visible add coords
-          if(atools::geo::manhattanDistance(lastPt.x(), lastPt.y(), x2, y2) > AIRCRAFT_TRACK_MIN_LINE_LENGTH)
-            polyline.append(QPoint(x1, y1));
-        }
-        else
-          // Always add first visible point
-          polyline.append(QPoint(x1, y1));
-      }
+  cache.numAppended = aircraftTrack.getNumAppended();
+}
 
-      if(lastVisible && !nowVisible)
-      {
-        // Not visible anymore draw previous line segment
-        painter->drawPolyline(polyline);
-        polyline.clear();
-      }
+void MapPainterVehicle::addTrackPoint(int x2, int y2, const QRect& viewportRect)
+{
+  TrackCache& cache = trackCache;
+  QRect rect(QPoint(cache.x1, cache.y1), QPoint(x2, y2));
+  rect = rect.normalized();
+  rect.adjust(-1, -1, 1, 1);
 
-      lastVisible = nowVisible;
-      x1 = x2;
-      y1 = y2;
-    }
+  // Current line is visible (most likely)
+  bool nowVisible = rect.intersects(viewportRect);
 
-    // Draw rest
-    if(!polyline.isEmpty())
+  if(cache.lastVisible || nowVisible)
+  {
+    if(!cache.polyline.isEmpty())
     {
-      polyline.append(QPoint(x2, y2));
-      painter->drawPolyline(polyline);
+      const QPoint& lastPt = cache.polyline.last();
+      // Last line or this one are visible add coords
+      if(atools::geo::manhattanDistance(lastPt.x(), lastPt.y(), x2, y2) > AIRCRAFT_TRACK_MIN_LINE_LENGTH)
+        cache.polyline.append(QPoint(cache.x1, cache.y1));
     }
+    else
+      // Always add first visible point
+      cache.polyline.append(QPoint(cache.x1, cache.y1));
+  }
+
+  if(cache.lastVisible && !nowVisible)
+  {
+    // Not visible anymore - finish previous line segment
+    cache.polylines.append(cache.polyline);
+    cache.polyline.clear();
   }
+
+  cache.lastVisible = nowVisible;
+  cache.x1 = x2;
+  cache.y1 = y2;
 }
 
 void MapPainterVehicle::paintTextLabelAi(const PaintContext *context, float x, float y, int size,
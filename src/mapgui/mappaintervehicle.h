@@ -26,6 +26,10 @@ namespace Marble {
 class GeoDataLineString;
 }
 
+namespace at {
+class AircraftTrackRing;
+}
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -104,9 +108,41 @@ protected:
   static Q_DECL_CONSTEXPR int WIND_POINTER_SIZE = 40;
 
 private:
+  /* Projected aircraft track for the last viewport. Positions appended to the track are projected and added
+   * to the polylines without projecting the whole track again. */
+  struct TrackCache
+  {
+    const at::AircraftTrackRing *track = nullptr;
+    quint32 generation = 0, numAppended = 0;
+    int numDropped = 0;
+
+    /* Viewport */
+    int projection = -1, radius = 0, width = 0, height = 0;
+    double centerLon = 0., centerLat = 0.;
+
+    /* Finished visible parts and the currently open one */
+    QVector<QPolygon> polylines;
+    QPolygon polyline;
+
+    /* Screen position of the last added track point */
+    int x1 = 0, y1 = 0;
+    bool lastVisible = false;
+  };
+
+  /* Project the whole track again if the viewport or track changed. Otherwise only add new positions. */
+  void updateTrackCache(const PaintContext *context, const at::AircraftTrackRing& aircraftTrack);
+
+  /* Add the next projected track point to the cached polylines */
+  void addTrackPoint(int x2, int y2, const QRect& viewportRect);
+
   /* Caches pixmaps generated from SVG graphics */
   QCache<PixmapKey, QPixmap> aircraftPixmaps;
 
+  TrackCache trackCache;
+
+  /* Project whole track again if more than this number of old positions were dropped since last update */
+  static Q_DECL_CONSTEXPR int TRACK_CACHE_MAX_DROPPED = 200;
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERVECHICLE_H
@@ -20,6 +20,7 @@
 #include "navapp.h"
 #include "connect/connectclient.h"
 #include "mapgui/mapwidget.h"
+#include "mapgui/mapairspacegeometrycache.h"
 #include "mapgui/maplayersettings.h"
 #include "mapgui/mappainteraircraft.h"
 #include "mapgui/mappaintership.h"
@@ -30,6 +31,7 @@
 #include "mapgui/mappainternav.h"
 #include "mapgui/mappainterroute.h"
 #include "mapgui/mapscale.h"
+#include "query/mapqueryprefetch.h"
 #include "route/route.h"
 #include "options/optiondata.h"
 
@@ -48,22 +50,39 @@ MapPaintLayer::MapPaintLayer(MapWidget *widget, MapQuery *mapQueries)
 
   mapScale = new MapScale();
 
+  airspaceGeometryCache = new MapAirspaceGeometryCache(mapQuery);
+
   // Create all painters
   mapPainterNav = new MapPainterNav(mapWidget, mapScale);
   mapPainterIls = new MapPainterIls(mapWidget, mapScale);
   mapPainterAirport = new MapPainterAirport(mapWidget, mapScale, &NavApp::getRoute());
-  mapPainterAirspace = new MapPainterAirspace(mapWidget, mapScale, &NavApp::getRoute());
+  mapPainterAirspace = new MapPainterAirspace(mapWidget, mapScale, &NavApp::getRoute(),
+                                              airspaceGeometryCache);
   mapPainterMark = new MapPainterMark(mapWidget, mapScale);
   mapPainterRoute = new MapPainterRoute(mapWidget, mapScale, &NavApp::getRoute());
   mapPainterAircraft = new MapPainterAircraft(mapWidget, mapScale);
   mapPainterShip = new MapPainterShip(mapWidget, mapScale);
 
+  // Prefetched tiles are inserted into the GUI map query and trigger a repaint if they are visible
+  prefetch = new MapQueryPrefetch(nullptr);
+  QObject::connect(prefetch, &MapQueryPrefetch::tilesLoaded, mapWidget, [this](const MapQueryTiles& tiles)
+  {
+    if(!databaseLoadStatus && mapQuery->insertTiles(tiles))
+      mapWidget->update();
+  });
+  prefetch->initQueries();
+
+  profiler = new MapPaintProfiler();
+
   // Default for visible object types
   objectTypes = map::MapObjectTypes(map::AIRPORT | map::VOR | map::NDB | map::AP_ILS | map::MARKER | map::WAYPOINT);
 }
 
 MapPaintLayer::~MapPaintLayer()
 {
+  delete prefetch;
+  delete profiler;
+
   delete mapPainterIls;
   delete mapPainterNav;
   delete mapPainterAirport;
@@ -72,6 +91,7 @@ MapPaintLayer::~MapPaintLayer()
   delete mapPainterRoute;
   delete mapPainterAircraft;
   delete mapPainterShip;
+  delete airspaceGeometryCache;
 
   delete layers;
   delete mapScale;
@@ -80,11 +100,14 @@ MapPaintLayer::~MapPaintLayer()
 void MapPaintLayer::preDatabaseLoad()
 {
   databaseLoadStatus = true;
+  prefetch->deInitQueries();
+  airspaceGeometryCache->clear();
 }
 
 void MapPaintLayer::postDatabaseLoad()
 {
   databaseLoadStatus = false;
+  prefetch->initQueries();
 }
 
 void MapPaintLayer::setShowMapObjects(map::MapObjectTypes type, bool show)
@@ -250,6 +273,7 @@ void MapPaintLayer::initMapLayerSettings()
          ndbSymbolSize(12).
          airwayWaypoint().
          marker(false).ils(false).
+         airspaceDetail(1).
          maxTextLength(16)).
 
   // airport > 4000, VOR
@@ -259,6 +283,7 @@ void MapPaintLayer::initMapLayerSettings()
          aiAircraftGround(false).aiShipSmall(false).aiAircraftGroundText(false).aiAircraftText(false).
          airwayWaypoint().
          vorSymbolSize(8).ndb(false).waypoint(false).marker(false).ils(false).
+         airspaceDetail(1).
          maxTextLength(16)).
 
   // airport > 4000
@@ -269,6 +294,7 @@ void MapPaintLayer::initMapLayerSettings()
          aiAircraftGroundText(false).aiAircraftText(false).
          ndb(false).waypoint(false).marker(false).ils(false).
          airportRouteInfo(false).waypointRouteName(false).
+         airspaceDetail(2).
          maxTextLength(16)).
 
   // airport > 8000
@@ -280,6 +306,7 @@ void MapPaintLayer::initMapLayerSettings()
          airspaceOther(false).airspaceRestricted(false).airspaceSpecial(false).
          vor(false).ndb(false).waypoint(false).marker(false).ils(false).airway(false).
          airportRouteInfo(false).vorRouteInfo(false).ndbRouteInfo(false).waypointRouteName(false).
+         airspaceDetail(2).
          maxTextLength(16)).
 
   // airport > 8000
@@ -292,6 +319,7 @@ void MapPaintLayer::initMapLayerSettings()
          airspaceIcao(false).
          vor(false).ndb(false).waypoint(false).marker(false).ils(false).airway(false).
          airportRouteInfo(false).vorRouteInfo(false).ndbRouteInfo(false).waypointRouteName(false).
+         airspaceDetail(3).
          maxTextLength(16)).
 
   // Display only points for airports until the cutoff limit
@@ -334,6 +362,18 @@ void MapPaintLayer::updateLayers()
   mapLayer = layers->getLayer(dist, detailFactor);
 }
 
+void MapPaintLayer::renderPainter(MapPainter *painter, PaintContext *context, MapPaintProfilerPainter type)
+{
+  if(profiler->isEnabled())
+  {
+    profiler->beginPainter();
+    painter->render(context);
+    profiler->endPainter(type);
+  }
+  else
+    painter->render(context);
+}
+
 bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
                            const QString& renderPos, GeoSceneLayer *layer)
 {
@@ -353,6 +393,12 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
     {
       updateLayers();
 
+      if(profiler->isEnabled())
+      {
+        mapQuery->resetStatistics();
+        profiler->beginFrame();
+      }
+
       PaintContext context;
       context.mapLayer = mapLayer;
       context.mapLayerEffective = mapLayerEffective;
@@ -407,50 +453,58 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
         painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
       }
 
-      mapPainterShip->render(&context);
+      renderPainter(mapPainterShip, &context, PROFILE_SHIP);
 
       if(mapWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
       {
+        // Load surrounding tiles in background so that lazy updates while scrolling find them in the cache
+        prefetch->prefetch(box, mapLayer, mapLayerEffective, objectTypes, context.airspaceFilterByLayer,
+                           NavApp::getRoute().getCruisingAltitudeFeet());
+
         if(!context.isOverflow())
-          mapPainterAirspace->render(&context);
+          renderPainter(mapPainterAirspace, &context, PROFILE_AIRSPACE);
 
         if(context.mapLayerEffective->isAirportDiagram())
         {
           // Put ILS below and navaids on top of airport diagram
-          mapPainterIls->render(&context);
+          renderPainter(mapPainterIls, &context, PROFILE_ILS);
 
           if(!context.isOverflow())
-            mapPainterAirport->render(&context);
+            renderPainter(mapPainterAirport, &context, PROFILE_AIRPORT);
 
           if(!context.isOverflow())
-            mapPainterNav->render(&context);
+            renderPainter(mapPainterNav, &context, PROFILE_NAV);
         }
         else
         {
           // Airports on top of all
           if(!context.isOverflow())
-            mapPainterIls->render(&context);
+            renderPainter(mapPainterIls, &context, PROFILE_ILS);
 
           if(!context.isOverflow())
-            mapPainterNav->render(&context);
+            renderPainter(mapPainterNav, &context, PROFILE_NAV);
 
           if(!context.isOverflow())
-            mapPainterAirport->render(&context);
+            renderPainter(mapPainterAirport, &context, PROFILE_AIRPORT);
         }
       }
 
       // if(!context.isOverflow()) always paint route even if number of objets is too large
-      mapPainterRoute->render(&context);
+      renderPainter(mapPainterRoute, &context, PROFILE_ROUTE);
 
       // if(!context.isOverflow())
-      mapPainterMark->render(&context);
+      renderPainter(mapPainterMark, &context, PROFILE_MARK);
 
-      mapPainterAircraft->render(&context);
+      renderPainter(mapPainterAircraft, &context, PROFILE_AIRCRAFT);
 
       if(context.isOverflow())
         overflow = PaintContext::MAX_OBJECT_COUNT;
       else
         overflow = 0;
+
+      if(profiler->isEnabled())
+        profiler->endFrame(context.objectCount, context.objectsCulled, mapQuery->getStatistics(),
+                           static_cast<float>(mapWidget->distance()));
     }
 
     // Dim the map by drawing a semi-transparent black rectangle
@@ -461,6 +515,9 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
       painter->fillRect(QRect(0, 0, painter->device()->width(), painter->device()->height()), col);
     }
 
+    if(profiler->isEnabled())
+      profiler->paintHud(painter);
+
   }
   return true;
 }
@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_MAPPAINTLAYER_H
 
 #include "mapgui/mappainter.h"
+#include "mapgui/mappaintprofiler.h"
 
 #include <QPen>
 
@@ -43,6 +44,8 @@ class MapPainterMark;
 class MapPainterRoute;
 class MapPainterAircraft;
 class MapPainterShip;
+class MapQueryPrefetch;
+class MapAirspaceGeometryCache;
 
 /*
  * Implements the Marble layer interface that paints upon the Marble map. Contains all painter instances
@@ -103,10 +106,19 @@ public:
     return overflow;
   }
 
+  /* Simplified and projected airspace boundaries shared by painter and screen index */
+  MapAirspaceGeometryCache *getAirspaceGeometryCache() const
+  {
+    return airspaceGeometryCache;
+  }
+
 private:
   void initMapLayerSettings();
   void updateLayers();
 
+  /* Call render of the painter and measure time if profiling is enabled */
+  void renderPainter(MapPainter *painter, PaintContext *context, MapPaintProfilerPainter type);
+
   /* Implemented from LayerInterface: We  draw above all but below user tools */
   virtual QStringList renderPosition() const override
   {
@@ -139,6 +151,14 @@ private:
   /* Database source */
   MapQuery *mapQuery = nullptr;
 
+  /* Loads map objects around the viewport in background */
+  MapQueryPrefetch *prefetch = nullptr;
+
+  MapAirspaceGeometryCache *airspaceGeometryCache = nullptr;
+
+  /* Frame time measurement and overlay */
+  MapPaintProfiler *profiler = nullptr;
+
   MapScale *mapScale = nullptr;
   MapLayerSettings *layers = nullptr;
   MapWidget *mapWidget = nullptr;
@@ -0,0 +1,219 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mappaintprofiler.h"
+
+#include "common/constants.h"
+#include "settings/settings.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFontDatabase>
+#include <QPainter>
+
+#include <algorithm>
+
+using atools::settings::Settings;
+
+static const QString CSV_SUFFIX("_mapprofile.csv");
+static const QString CSV_ROLLED_SUFFIX("_mapprofile_1.csv");
+
+static const char *PAINTER_NAMES[PROFILE_NUM_PAINTERS] =
+{"Ship", "Airspace", "ILS", "Nav", "Airport", "Route", "Mark", "Aircraft"};
+
+Q_DECL_CONSTEXPR int MapPaintProfiler::HISTORY_SIZE;
+
+static double toMs(qint64 ns)
+{
+  return static_cast<double>(ns) / 1000000.;
+}
+
+MapPaintProfiler::MapPaintProfiler()
+{
+  Settings& settings = Settings::instance();
+  enabled = settings.getAndStoreValue(lnm::SETTINGS_MAP_PROFILE + "Enabled", false).toBool();
+  writeCsvFile = settings.getAndStoreValue(lnm::SETTINGS_MAP_PROFILE + "WriteCsv", true).toBool();
+  csvMaxFrames = settings.getAndStoreValue(lnm::SETTINGS_MAP_PROFILE + "CsvMaxFrames", 100000).toInt();
+
+  history.fill(0, HISTORY_SIZE);
+
+  if(enabled && writeCsvFile)
+    openCsv();
+}
+
+MapPaintProfiler::~MapPaintProfiler()
+{
+  closeCsv();
+}
+
+void MapPaintProfiler::beginFrame()
+{
+  current = MapPaintProfilerFrame();
+  frameTimer.start();
+}
+
+void MapPaintProfiler::beginPainter()
+{
+  painterTimer.start();
+}
+
+void MapPaintProfiler::endPainter(MapPaintProfilerPainter painter)
+{
+  current.painterNs[painter] += painterTimer.nsecsElapsed();
+}
+
+void MapPaintProfiler::endFrame(int objectsDrawn, int objectsCulled, const MapQueryStatistics& queryStatistics,
+                                float distanceKm)
+{
+  current.frameNs = frameTimer.nsecsElapsed();
+  current.timestampMs = QDateTime::currentMSecsSinceEpoch();
+  current.distanceKm = distanceKm;
+  current.objectsDrawn = objectsDrawn;
+  current.objectsCulled = objectsCulled;
+  current.queryStatistics = queryStatistics;
+
+  history[historyIndex] = current.frameNs;
+  historyIndex = (historyIndex + 1) % HISTORY_SIZE;
+
+  last = current;
+
+  if(csvFile.isOpen())
+  {
+    writeCsv(current);
+
+    if(++csvFrames >= csvMaxFrames)
+    {
+      // Roll over - keep one old file
+      closeCsv();
+      QFile::remove(Settings::getConfigFilename(CSV_ROLLED_SUFFIX));
+      QFile::rename(Settings::getConfigFilename(CSV_SUFFIX), Settings::getConfigFilename(CSV_ROLLED_SUFFIX));
+      openCsv();
+    }
+  }
+}
+
+double MapPaintProfiler::averageFrameMs() const
+{
+  qint64 sum = 0;
+  int num = 0;
+  for(qint64 ns : history)
+  {
+    if(ns > 0)
+    {
+      sum += ns;
+      num++;
+    }
+  }
+  return num > 0 ? toMs(sum) / num : 0.;
+}
+
+void MapPaintProfiler::paintHud(QPainter *painter) const
+{
+  const MapTileCacheStatistics total = last.queryStatistics.total();
+
+  QStringList lines;
+  lines.append(QString("Frame %1 ms, avg %2 ms").
+               arg(toMs(last.frameNs), 0, 'f', 1).arg(averageFrameMs(), 0, 'f', 1));
+  for(int i = 0; i < PROFILE_NUM_PAINTERS; i++)
+    lines.append(QString("%1 %2 ms").arg(PAINTER_NAMES[i], -9).arg(toMs(last.painterNs[i]), 6, 'f', 1));
+  lines.append(QString("Objects %1 drawn, %2 culled").arg(last.objectsDrawn).arg(last.objectsCulled));
+  lines.append(QString("Tiles %1 hit, %2 miss, %3 ms").
+               arg(total.hits).arg(total.misses).arg(toMs(total.loadTimeNs), 0, 'f', 1));
+  lines.append(QString("Distance %1 km").arg(last.distanceKm, 0, 'f', 0));
+
+  painter->save();
+  QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+  painter->setFont(font);
+  painter->setRenderHint(QPainter::TextAntialiasing, true);
+
+  QFontMetrics metrics(font);
+  int width = 0;
+  for(const QString& line : lines)
+    width = std::max(width, metrics.width(line));
+
+  const int margin = 4;
+  QRect rect(margin, margin, width + 2 * margin, lines.size() * metrics.height() + 2 * margin);
+  painter->setPen(Qt::black);
+  painter->setBrush(QColor::fromRgb(255, 255, 255, 200));
+  painter->drawRect(rect);
+
+  int y = rect.top() + margin + metrics.ascent();
+  for(const QString& line : lines)
+  {
+    painter->drawText(rect.left() + margin, y, line);
+    y += metrics.height();
+  }
+  painter->restore();
+}
+
+void MapPaintProfiler::openCsv()
+{
+  csvFile.setFileName(Settings::getConfigFilename(CSV_SUFFIX));
+  bool exists = csvFile.exists() && csvFile.size() > 0;
+
+  if(csvFile.open(QIODevice::Append | QIODevice::Text))
+  {
+    csvStream.setDevice(&csvFile);
+    csvFrames = 0;
+
+    if(!exists)
+    {
+      // Write header
+      csvStream << "timestamp;distance_km;frame_ms";
+      for(int i = 0; i < PROFILE_NUM_PAINTERS; i++)
+        csvStream << ";" << QString(PAINTER_NAMES[i]).toLower() << "_ms";
+      csvStream << ";objects_drawn;objects_culled";
+      for(const QString& type :
+          {"airport", "waypoint", "vor", "ndb", "marker", "ils", "airway", "airspace"})
+        csvStream << ";" << type << "_hits;" << type << "_misses;" << type << "_load_ms";
+      csvStream << endl;
+    }
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot open profile file" << csvFile.fileName() << csvFile.errorString();
+}
+
+void MapPaintProfiler::closeCsv()
+{
+  if(csvFile.isOpen())
+  {
+    csvStream.flush();
+    csvStream.setDevice(nullptr);
+    csvFile.close();
+  }
+}
+
+void MapPaintProfiler::writeCsv(const MapPaintProfilerFrame& frame)
+{
+  csvStream << QDateTime::fromMSecsSinceEpoch(frame.timestampMs).toString("yyyy-MM-dd HH:mm:ss.zzz") << ";"
+            << QString::number(frame.distanceKm, 'f', 1) << ";"
+            << QString::number(toMs(frame.frameNs), 'f', 3);
+
+  for(int i = 0; i < PROFILE_NUM_PAINTERS; i++)
+    csvStream << ";" << QString::number(toMs(frame.painterNs[i]), 'f', 3);
+
+  csvStream << ";" << frame.objectsDrawn << ";" << frame.objectsCulled;
+
+  const MapQueryStatistics& stats = frame.queryStatistics;
+  for(const MapTileCacheStatistics& cache :
+      {stats.airports, stats.waypoints, stats.vors, stats.ndbs, stats.markers, stats.ils, stats.airways,
+       stats.airspaces})
+    csvStream << ";" << cache.hits << ";" << cache.misses << ";" << QString::number(toMs(cache.loadTimeNs), 'f', 3);
+
+  // No flush - the stream buffer is written when full or on close
+  csvStream << "\n";
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPPAINTPROFILER_H
+#define LITTLENAVMAP_MAPPAINTPROFILER_H
+
+#include "query/mapquery.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+
+class QPainter;
+
+/* Painters measured by the profiler. Order is the order of columns in HUD and CSV. */
+enum MapPaintProfilerPainter
+{
+  PROFILE_SHIP,
+  PROFILE_AIRSPACE,
+  PROFILE_ILS,
+  PROFILE_NAV,
+  PROFILE_AIRPORT,
+  PROFILE_ROUTE,
+  PROFILE_MARK,
+  PROFILE_AIRCRAFT,
+  PROFILE_NUM_PAINTERS
+};
+
+/* Values measured for one painted frame */
+struct MapPaintProfilerFrame
+{
+  qint64 timestampMs = 0;
+  float distanceKm = 0.f;
+  qint64 frameNs = 0;
+  qint64 painterNs[PROFILE_NUM_PAINTERS] = {};
+  int objectsDrawn = 0, objectsCulled = 0;
+  MapQueryStatistics queryStatistics;
+};
+
+/*
+ * Collects wall time per painter and frame, object counts and map query cache statistics for each painted frame.
+ * Shows the values in a small overlay and appends them to a CSV file in the settings directory which is rolled
+ * over after a configurable number of frames.
+ *
+ * Enabled by setting "Enabled" in group "Settings/MapProfile" of the configuration file. Does nothing otherwise.
+ */
+class MapPaintProfiler
+{
+public:
+  MapPaintProfiler();
+  ~MapPaintProfiler();
+
+  bool isEnabled() const
+  {
+    return enabled;
+  }
+
+  /* Start measuring a new frame */
+  void beginFrame();
+
+  /* Start and stop the timer for a single painter call. Times of repeated calls are summed up. */
+  void beginPainter();
+  void endPainter(MapPaintProfilerPainter painter);
+
+  /* Finish the frame and write it to the CSV file */
+  void endFrame(int objectsDrawn, int objectsCulled, const MapQueryStatistics& queryStatistics, float distanceKm);
+
+  /* Draw the overlay into the top left corner of the map */
+  void paintHud(QPainter *painter) const;
+
+private:
+  void openCsv();
+  void closeCsv();
+  void writeCsv(const MapPaintProfilerFrame& frame);
+
+  /* Average of the frame times in history in ms */
+  double averageFrameMs() const;
+
+  /* Number of frames used to calculate the average frame time in the overlay */
+  static Q_DECL_CONSTEXPR int HISTORY_SIZE = 60;
+
+  bool enabled = false, writeCsvFile = false;
+  int csvMaxFrames = 0, csvFrames = 0;
+
+  QElapsedTimer frameTimer, painterTimer;
+  MapPaintProfilerFrame current, last;
+
+  /* Ring buffer of the last frame times in ns */
+  QVector<qint64> history;
+  int historyIndex = 0;
+
+  QFile csvFile;
+  QTextStream csvStream;
+};
+
+#endif // LITTLENAVMAP_MAPPAINTPROFILER_H
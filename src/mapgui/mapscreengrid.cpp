@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapscreengrid.h"
+
+#include <algorithm>
+
+MapScreenGrid::MapScreenGrid()
+{
+
+}
+
+MapScreenGrid::~MapScreenGrid()
+{
+
+}
+
+void MapScreenGrid::reset(const QRect& screenRect)
+{
+  gridRect = screenRect;
+  numColumns = std::max((screenRect.width() + CELL_SIZE - 1) / CELL_SIZE, 1);
+  numRows = std::max((screenRect.height() + CELL_SIZE - 1) / CELL_SIZE, 1);
+
+  // Keep allocated cell vectors if the size did not change
+  cells.resize(numColumns * numRows);
+  clear();
+}
+
+void MapScreenGrid::clear()
+{
+  for(QVector<int>& cell : cells)
+    cell.clear();
+}
+
+int MapScreenGrid::column(int x) const
+{
+  return std::min(std::max((x - gridRect.left()) / CELL_SIZE, 0), numColumns - 1);
+}
+
+int MapScreenGrid::row(int y) const
+{
+  return std::min(std::max((y - gridRect.top()) / CELL_SIZE, 0), numRows - 1);
+}
+
+void MapScreenGrid::insert(int index, const QRect& rect)
+{
+  if(cells.isEmpty())
+    return;
+
+  QRect clipped = rect.normalized().intersected(gridRect);
+  if(clipped.isEmpty())
+    return;
+
+  for(int r = row(clipped.top()); r <= row(clipped.bottom()); r++)
+  {
+    for(int c = column(clipped.left()); c <= column(clipped.right()); c++)
+      cells[r * numColumns + c].append(index);
+  }
+}
+
+void MapScreenGrid::getNearest(int xs, int ys, int maxDistance, QVector<int>& indexes) const
+{
+  if(cells.isEmpty())
+    return;
+
+  QRect rect(xs - maxDistance, ys - maxDistance, maxDistance * 2 + 1, maxDistance * 2 + 1);
+  if(!rect.intersects(gridRect))
+    return;
+
+  int first = indexes.size();
+  for(int r = row(rect.top()); r <= row(rect.bottom()); r++)
+  {
+    for(int c = column(rect.left()); c <= column(rect.right()); c++)
+      indexes.append(cells.at(r * numColumns + c));
+  }
+
+  // Objects can be registered in more than one cell
+  std::sort(indexes.begin() + first, indexes.end());
+  indexes.erase(std::unique(indexes.begin() + first, indexes.end()), indexes.end());
+}
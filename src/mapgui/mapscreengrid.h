@@ -0,0 +1,60 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPSCREENGRID_H
+#define LITTLENAVMAP_MAPSCREENGRID_H
+
+#include <QRect>
+#include <QVector>
+
+/*
+ * Uniform grid in screen coordinates that maps cells to indexes of screen objects like lines or polygons.
+ * An object is registered in all cells covered by its bounding rectangle. Used to find candidates for
+ * mouse hit tests without scanning all objects.
+ */
+class MapScreenGrid
+{
+public:
+  MapScreenGrid();
+  ~MapScreenGrid();
+
+  /* Remove all objects and set the screen area covered by the grid. Objects outside are clipped. */
+  void reset(const QRect& screenRect);
+
+  /* Remove all objects */
+  void clear();
+
+  /* Register object index for all cells overlapping the rectangle */
+  void insert(int index, const QRect& rect);
+
+  /* Get indexes of all objects having a bounding rectangle within maxDistance of xs/ys.
+   * Indexes are sorted ascending and unique. Caller has to do the exact test. */
+  void getNearest(int xs, int ys, int maxDistance, QVector<int>& indexes) const;
+
+private:
+  int column(int x) const;
+  int row(int y) const;
+
+  /* Cell size in pixel */
+  static Q_DECL_CONSTEXPR int CELL_SIZE = 32;
+
+  QRect gridRect;
+  int numColumns = 0, numRows = 0;
+  QVector<QVector<int> > cells;
+};
+
+#endif // LITTLENAVMAP_MAPSCREENGRID_H
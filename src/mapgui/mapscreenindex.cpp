@@ -20,6 +20,7 @@
 #include "navapp.h"
 #include "common/proctypes.h"
 #include "route/routecontroller.h"
+#include "mapgui/mapairspacegeometrycache.h"
 #include "mapgui/mapscale.h"
 #include "mapgui/mapwidget.h"
 #include "mapgui/mappaintlayer.h"
@@ -56,21 +57,23 @@ MapScreenIndex::~MapScreenIndex()
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonAltBox& curBox)
 {
   airspacePolygons.clear();
+  airspaces.clear();
+  airspaceGrid.reset(mapWidget->rect());
 
   if(!paintLayer->getMapLayer()->isAirspace() || !paintLayer->getShownMapObjects().testFlag(map::AIRSPACE))
     return;
 
-  CoordinateConverter conv(mapWidget->viewport());
+  MapAirspaceGeometryCache *geometryCache = paintLayer->getAirspaceGeometryCache();
   const MapScale *scale = paintLayer->getMapScale();
   if(scale->isValid())
   {
-    const QList<map::MapAirspace> *airspaces = mapQuery->getAirspaces(
+    const map::MapObjectList<map::MapAirspace> *airspaceList = mapQuery->getAirspaces(
       curBox, paintLayer->getMapLayer(), mapWidget->getShownAirspaceTypesByLayer(),
       NavApp::getRoute().getCruisingAltitudeFeet(), false);
 
-    if(airspaces != nullptr)
+    if(airspaceList != nullptr)
     {
-      for(const map::MapAirspace& airspace : *airspaces)
+      for(const map::MapAirspace& airspace : *airspaceList)
       {
         if(!(airspace.type & mapWidget->getShownAirspaceTypesByLayer().types))
           continue;
@@ -81,25 +84,21 @@ void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonAlt
 
         if(airspacebox.intersects(curBox))
         {
-          QPolygon polygon;
-          int x, y;
+          // Same simplified polygon as used by the painter
+          const MapAirspaceScreenPolygon *screen =
+            geometryCache->getScreenPolygon(mapWidget->viewport(), paintLayer->getMapLayer(), airspace.id);
 
-          const atools::geo::LineString *lines = mapQuery->getAirspaceGeometry(airspace.id);
+          if(!screen->complete)
+            // Hidden, wrapped or clamped points give wrong hits
+            continue;
 
-          for(const Pos& pos : *lines)
+          const QPolygon& polygon = screen->polygon;
+          if(polygon.boundingRect().intersects(mapWidget->rect()))
           {
-            conv.wToS(pos, x, y /*, QSize(2000, 2000)*/);
-            // qDebug() << airspace.name << pos << x << y;
-            polygon.append(QPoint(x, y));
+            airspaceGrid.insert(airspacePolygons.size(), polygon.boundingRect());
+            airspacePolygons.append(std::make_pair(airspaces.size(), polygon));
+            airspaces.append(airspace);
           }
-
-          // qDebug() << airspace.name << polygon;
-
-          polygon = polygon.intersected(QPolygon(mapWidget->geometry()));
-
-          // qDebug() << airspace.name << polygon;
-
-          airspacePolygons.append(std::make_pair(airspace.id, polygon));
         }
       }
     }
@@ -109,6 +108,8 @@ void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonAlt
 void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonAltBox& curBox)
 {
   airwayLines.clear();
+  airways.clear();
+  airwayGrid.reset(mapWidget->rect());
 
   CoordinateConverter conv(mapWidget->viewport());
   const MapScale *scale = paintLayer->getMapScale();
@@ -118,12 +119,12 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonAltBo
   if(scale->isValid() && paintLayer->getMapLayer()->isAirway() && (showJet || showVictor))
   {
     // Airways are visible on map - get them from the cache/database
-    const QList<MapAirway> *airways = mapQuery->getAirways(curBox, paintLayer->getMapLayer(), false);
+    const map::MapObjectList<MapAirway> *airwayList = mapQuery->getAirways(curBox, paintLayer->getMapLayer(), false);
     const QRect& mapGeo = mapWidget->rect();
 
-    for(int i = 0; i < airways->size(); i++)
+    for(int i = 0; i < airwayList->size(); i++)
     {
-      const MapAirway& airway = airways->at(i);
+      const MapAirway& airway = airwayList->at(i);
       if((airway.type == map::VICTOR && !showVictor) || (airway.type == map::JET && !showJet))
         continue;
 
@@ -140,6 +141,7 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonAltBo
         float step = 1.f / numSegments;
 
         // Split the segments into smaller lines and add them only if visible
+        bool added = false;
         for(int j = 0; j < numSegments; j++)
         {
           float cur = step * static_cast<float>(j);
@@ -153,8 +155,15 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonAltBo
           rect.adjust(-1, -1, 1, 1);
 
           if(mapGeo.intersects(rect))
-            airwayLines.append(std::make_pair(airway.id, QLine(xs1, ys1, xs2, ys2)));
+          {
+            airwayGrid.insert(airwayLines.size(), rect);
+            airwayLines.append(std::make_pair(airways.size(), QLine(xs1, ys1, xs2, ys2)));
+            added = true;
+          }
         }
+
+        if(added)
+          airways.append(airway);
       }
     }
   }
@@ -180,6 +189,7 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonAltBox
 
   routeLines.clear();
   routePoints.clear();
+  routeGrid.reset(mapWidget->rect());
 
   QList<std::pair<int, QPoint> > airportPoints;
   QList<std::pair<int, QPoint> > otherPoints;
@@ -250,7 +260,10 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonAltBox
               rect.adjust(-1, -1, 1, 1);
 
               if(mapGeo.intersects(rect))
+              {
+                routeGrid.insert(routeLines.size(), rect);
                 routeLines.append(std::make_pair(i - 1, QLine(xs1, ys1, xs2, ys2)));
+              }
             }
           }
         }
@@ -478,18 +491,17 @@ void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapSearchResult& r
   if(!paintLayer->getShownMapObjects().testFlag(map::AIRSPACE))
     return;
 
-  for(int i = 0; i < airspacePolygons.size(); i++)
+  QVector<int> indexes;
+  airspaceGrid.getNearest(xs, ys, 0, indexes);
+
+  for(int i : indexes)
   {
     const std::pair<int, QPolygon>& polyPair = airspacePolygons.at(i);
 
     const QPolygon& poly = polyPair.second;
 
     if(poly.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
-    {
-      map::MapAirspace airspace;
-      mapQuery->getAirspaceById(airspace, polyPair.first);
-      result.airspaces.append(airspace);
-    }
+      result.airspaces.append(airspaces.at(polyPair.first));
   }
 }
 
@@ -500,7 +512,10 @@ void MapScreenIndex::getNearestAirways(int xs, int ys, int maxDistance, map::Map
      !paintLayer->getShownMapObjects().testFlag(map::AIRWAYV))
     return;
 
-  for(int i = 0; i < airwayLines.size(); i++)
+  QVector<int> indexes;
+  airwayGrid.getNearest(xs, ys, maxDistance, indexes);
+
+  for(int i : indexes)
   {
     const std::pair<int, QLine>& linePair = airwayLines.at(i);
 
@@ -508,11 +523,7 @@ void MapScreenIndex::getNearestAirways(int xs, int ys, int maxDistance, map::Map
 
     if(atools::geo::distanceToLine(xs, ys, line.x1(), line.y1(), line.x2(), line.y2(),
                                    true /* no dist to points */) < maxDistance)
-    {
-      map::MapAirway airway;
-      mapQuery->getAirwayById(airway, linePair.first);
-      result.airways.append(airway);
-    }
+      result.airways.append(airways.at(linePair.first));
   }
 }
 
@@ -524,7 +535,10 @@ int MapScreenIndex::getNearestRouteLegIndex(int xs, int ys, int maxDistance)
   int minIndex = -1;
   float minDist = std::numeric_limits<float>::max();
 
-  for(int i = 0; i < routeLines.size(); i++)
+  QVector<int> indexes;
+  routeGrid.getNearest(xs, ys, maxDistance, indexes);
+
+  for(int i : indexes)
   {
     const std::pair<int, QLine>& line = routeLines.at(i);
 
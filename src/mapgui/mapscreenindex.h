@@ -20,6 +20,7 @@
 
 #include "fs/sc/simconnectdata.h"
 
+#include "mapgui/mapscreengrid.h"
 #include "route/route.h"
 
 namespace map {
@@ -193,11 +194,22 @@ private:
   QList<int> routeHighlights;
   QList<map::RangeMarker> rangeMarks;
   QList<map::DistanceMarker> distanceMarks;
-  QList<std::pair<int, QLine> > routeLines;
-  QList<std::pair<int, QLine> > airwayLines;
-  QList<std::pair<int, QPolygon> > airspacePolygons;
   QList<std::pair<int, QPoint> > routePoints;
 
+  /* Route leg index and screen line */
+  QVector<std::pair<int, QLine> > routeLines;
+
+  /* Index into airways or airspaces and screen geometry */
+  QVector<std::pair<int, QLine> > airwayLines;
+  QVector<std::pair<int, QPolygon> > airspacePolygons;
+
+  /* Objects loaded for the current view. Avoids queries for each hit. */
+  QVector<map::MapAirway> airways;
+  QVector<map::MapAirspace> airspaces;
+
+  /* Index into the line and polygon lists above */
+  MapScreenGrid routeGrid, airwayGrid, airspaceGrid;
+
 };
 
 #endif // LITTLENAVMAP_MAPSCREENINDEX_H
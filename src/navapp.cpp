@@ -27,6 +27,7 @@
 #include "mapgui/mapwidget.h"
 #include "gui/mainwindow.h"
 #include "route/routecontroller.h"
+#include "route/routestringcache.h"
 #include "common/elevationprovider.h"
 #include "fs/common/magdecreader.h"
 #include "common/updatehandler.h"
@@ -43,6 +44,7 @@ AirportQuery *NavApp::airportQueryNav = nullptr;
 MapQuery *NavApp::mapQuery = nullptr;
 InfoQuery *NavApp::infoQuery = nullptr;
 ProcedureQuery *NavApp::procedureQuery = nullptr;
+RouteStringCache *NavApp::routeStringCache = nullptr;
 
 ConnectClient *NavApp::connectClient = nullptr;
 DatabaseManager *NavApp::databaseManager = nullptr;
@@ -101,6 +103,8 @@ void NavApp::init(MainWindow *mainWindowParam)
   procedureQuery = new ProcedureQuery(databaseManager->getDatabaseNav());
   procedureQuery->initQueries();
 
+  routeStringCache = new RouteStringCache(databaseManager->getDatabaseNav(), mapQuery, airportQuerySim);
+
   qDebug() << "MainWindow Creating ConnectClient";
   connectClient = new ConnectClient(mainWindow);
 
@@ -150,6 +154,10 @@ void NavApp::deInit()
   delete procedureQuery;
   procedureQuery = nullptr;
 
+  qDebug() << Q_FUNC_INFO << "delete routeStringCache";
+  delete routeStringCache;
+  routeStringCache = nullptr;
+
   qDebug() << Q_FUNC_INFO << "delete databaseManager";
   delete databaseManager;
   databaseManager = nullptr;
@@ -190,6 +198,7 @@ void NavApp::preDatabaseLoad()
   airportQueryNav->deInitQueries();
   mapQuery->deInitQueries();
   procedureQuery->deInitQueries();
+  routeStringCache->clear();
 
   delete databaseMeta;
   databaseMeta = nullptr;
@@ -248,6 +257,11 @@ ProcedureQuery *NavApp::getProcedureQuery()
   return procedureQuery;
 }
 
+RouteStringCache *NavApp::getRouteStringCache()
+{
+  return routeStringCache;
+}
+
 const Route& NavApp::getRoute()
 {
   return mainWindow->getRouteController()->getRoute();
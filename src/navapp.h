@@ -28,6 +28,7 @@ class MapQuery;
 class InfoQuery;
 class ProcedureQuery;
 class Route;
+class RouteStringCache;
 class MainWindow;
 class ConnectClient;
 class DatabaseManager;
@@ -103,6 +104,7 @@ public:
   static MapQuery *getMapQuery();
   static InfoQuery *getInfoQuery();
   static ProcedureQuery *getProcedureQuery();
+  static RouteStringCache *getRouteStringCache();
   static const Route& getRoute();
   static float getSpeedKts();
 
@@ -171,6 +173,7 @@ private:
   static MapQuery *mapQuery;
   static InfoQuery *infoQuery;
   static ProcedureQuery *procedureQuery;
+  static RouteStringCache *routeStringCache;
   static ElevationProvider *elevationProvider;
   /* Most important handlers */
   static ConnectClient *connectClient;
@@ -34,6 +34,7 @@
 #include <QTimer>
 #include <QRubberBand>
 #include <QMouseEvent>
+#include <QThreadPool>
 #include <QtConcurrent/QtConcurrentRun>
 
 #include <marble/ElevationModel.h>
@@ -72,6 +73,8 @@ ProfileWidget::ProfileWidget(QMainWindow *parent)
   updateTimer->setSingleShot(true);
   connect(updateTimer, &QTimer::timeout, this, &ProfileWidget::updateTimeout);
 
+  legThreadPool = new QThreadPool(this);
+
   // Marble will let us know when updates are available
   connect(NavApp::getElevationProvider(), &ElevationProvider::updateAvailable,
           this, &ProfileWidget::elevationUpdateAvailable);
@@ -215,8 +218,11 @@ bool ProfileWidget::aircraftTrackValid()
     int minTrackX = std::numeric_limits<int>::max(), maxTrackX = 0;
     if(!NavApp::getRoute().isFlightplanEmpty() && showAircraftTrack)
     {
-      for(const at::AircraftTrackPos& trackPos : NavApp::getMapWidget()->getAircraftTrack())
+      const at::AircraftTrackRing& aircraftTrack =
+        NavApp::getMapWidget()->getAircraftTrack().getTrack(trackToleranceMeter());
+      for(int i = 0; i < aircraftTrack.size(); i++)
       {
+        const at::AircraftTrackPos& trackPos = aircraftTrack.at(i);
         float distFromStart = legList.route.getDistanceFromStart(trackPos.pos);
         if(distFromStart < map::INVALID_DISTANCE_VALUE)
         {
@@ -231,6 +237,15 @@ bool ProfileWidget::aircraftTrackValid()
   return false;
 }
 
+/* Distance of the minimum screen distance between track points in meter */
+float ProfileWidget::trackToleranceMeter() const
+{
+  if(horizontalScale > 0.f)
+    return atools::geo::nmToMeter(MIN_TRACK_POINT_DISTANCE / horizontalScale);
+  else
+    return 0.f;
+}
+
 void ProfileWidget::updateScreenCoords()
 {
   /* Update all screen coordinates and scale factors */
@@ -300,7 +315,7 @@ void ProfileWidget::updateScreenCoords()
   {
     // Update aircraft track screen coordinates
     const Route& route = legList.route;
-    const AircraftTrack& aircraftTrack = mapWidget->getAircraftTrack();
+    const at::AircraftTrackRing& aircraftTrack = mapWidget->getAircraftTrack().getTrack(trackToleranceMeter());
 
     for(int i = 0; i < aircraftTrack.size(); i++)
     {
@@ -312,7 +327,8 @@ void ProfileWidget::updateScreenCoords()
         QPoint pt(X0 + static_cast<int>(distFromStart *horizontalScale),
                   Y0 + static_cast<int>(rect().height() - Y0 - aircraftPos.getAltitude() * verticalScale));
 
-        if(aircraftTrackPoints.isEmpty() || (aircraftTrackPoints.last() - pt).manhattanLength() > 3)
+        if(aircraftTrackPoints.isEmpty() ||
+           (aircraftTrackPoints.last() - pt).manhattanLength() > MIN_TRACK_POINT_DISTANCE)
           aircraftTrackPoints.append(pt);
       }
     }
@@ -661,6 +677,10 @@ void ProfileWidget::paintEvent(QPaintEvent *)
 /* Update signal from Marble elevation model */
 void ProfileWidget::elevationUpdateAvailable()
 {
+  // All legs have to be calculated again
+  legCache.clear();
+  legCacheGeneration++;
+
   if(!widgetVisible || databaseLoadStatus)
     return;
 
@@ -721,6 +741,18 @@ void ProfileWidget::updateTimeout()
   ElevationLegList legs;
   legs.route = routeController->getRoute();
 
+  // Sample the elevation pyramid at about screen resolution - round down to a power of two to keep cached legs
+  // valid when the total distance changes slightly
+  if(NavApp::getElevationProvider()->isElevationCacheValid())
+  {
+    float dist = atools::geo::nmToMeter(legs.route.getTotalDistance()) / std::max(width() - X0 * 2, 100);
+    legs.sampleDistanceMeter = std::pow(2.f, std::floor(std::log2(std::max(dist, 100.f))));
+  }
+
+  // Pass legs of the last run to avoid recalculation of unchanged legs
+  legs.legCache = legCache;
+  legs.legCacheGeneration = legCacheGeneration;
+
   // Start thread
   future = QtConcurrent::run(this, &ProfileWidget::fetchRouteElevationsThread, legs);
 
@@ -740,6 +772,11 @@ void ProfileWidget::updateThreadFinished()
   {
     // Was not terminated in the middle of calculations - get result from the future
     legList = future.result();
+
+    // Keep calculated legs unless elevation data has changed in the meantime
+    if(legList.legCacheGeneration == legCacheGeneration)
+      legCache = legList.legCache;
+    legList.legCache.clear();
     updateScreenCoords();
     update();
   }
@@ -748,7 +785,7 @@ void ProfileWidget::updateThreadFinished()
 /* Get elevation points between the two points. This returns also correct results if the antimeridian is crossed
  * @return true if not aborted */
 bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
-                                         const atools::geo::LineString& geometry) const
+                                         const atools::geo::LineString& geometry, float sampleDistanceMeter) const
 {
   ElevationProvider *elevationProvider = NavApp::getElevationProvider();
   for(int i = 0; i < geometry.size() - 1; i++)
@@ -776,7 +813,11 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
 
         p1.toDeg();
         p2.toDeg();
-        elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2));
+        if(sampleDistanceMeter > 0.f)
+          // Maximum elevation per sample from the pyramid
+          elevationProvider->getMaxElevations(elevations, atools::geo::Line(p1, p2), sampleDistanceMeter);
+        else
+          elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2));
       }
     }
     qDeleteAll(coordsCorrected);
@@ -796,83 +837,85 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations,
   return true;
 }
 
-/* Background thread. Fetches elevation points from Marble elevation model and updates totals. */
+/* Background thread. Fetches elevation points for changed legs and updates totals. */
 ProfileWidget::ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs) const
 {
   QThread::currentThread()->setPriority(QThread::LowestPriority);
   // qDebug() << "priority" << QThread::currentThread()->priority();
 
   using atools::geo::meterToNm;
-  using atools::geo::meterToFeet;
 
   legs.totalNumPoints = 0;
   legs.totalDistance = 0.f;
   legs.maxElevationFt = 0.f;
   legs.elevationLegs.clear();
 
-  // Loop over all route legs
+  bool globe = NavApp::getElevationProvider()->isGlobeOfflineProvider();
+
+  // Start calculation of all legs not found in the cache - legs are independent and run in parallel
+  QVector<QByteArray> keys(legs.route.size());
+  QHash<QByteArray, QFuture<ElevationLeg> > futures;
   for(int i = 1; i < legs.route.size(); i++)
   {
-    if(terminateThreadSignal)
-      // Return empty result
-      return ElevationLegList();
-
     const RouteLeg& routeLeg = legs.route.at(i);
     if(routeLeg.getProcedureLeg().isMissed())
       break;
 
-    const RouteLeg& lastLeg = legs.route.at(i - 1);
-    ElevationLeg leg;
-
     // Skip for too long segments when using the marble online provider
-    if(routeLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::getElevationProvider()->isGlobeOfflineProvider())
+    if(routeLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || globe)
     {
-      LineString geometry;
-      if(routeLeg.isAnyProcedure() && routeLeg.getGeometry().size() > 2)
-        geometry = routeLeg.getGeometry();
-      else
-        geometry << lastLeg.getPosition() << routeLeg.getPosition();
+      LineString geometry = legGeometry(legs.route, i);
+      keys[i] = legCacheKey(geometry, legs.sampleDistanceMeter);
 
-      geometry.removeInvalid();
+      if(!legs.legCache.contains(keys.at(i)) && !futures.contains(keys.at(i)))
+      {
+        float sampleDistanceMeter = legs.sampleDistanceMeter;
+        futures.insert(keys.at(i), QtConcurrent::run(legThreadPool, [ = ]() -> ElevationLeg
+        {
+          return calculateElevationLeg(geometry, sampleDistanceMeter);
+        }));
+      }
+    }
+  }
 
-      LineString elevations;
-      if(!fetchRouteElevations(elevations, geometry))
-        return ElevationLegList();
+  // Collect results - always wait for all since the tasks refer to this
+  QHash<QByteArray, ElevationLeg> newCache;
+  for(auto it = futures.begin(); it != futures.end(); ++it)
+    newCache.insert(it.key(), it.value().result());
 
-      float dist = legs.totalDistance;
-      // Loop over all elevation points for the current leg
-      Pos lastPos;
-      for(int j = 0; j < elevations.size(); j++)
-      {
-        if(terminateThreadSignal)
-          return ElevationLegList();
+  if(terminateThreadSignal)
+    // Return empty result
+    return ElevationLegList();
 
-        Pos& coord = elevations[j];
-        float altFeet = meterToFeet(coord.getAltitude());
-        coord.setAltitude(altFeet);
+  // Loop over all route legs and put the relative leg elevations together
+  for(int i = 1; i < legs.route.size(); i++)
+  {
+    const RouteLeg& routeLeg = legs.route.at(i);
+    if(routeLeg.getProcedureLeg().isMissed())
+      break;
 
-        // Adjust maximum
-        if(altFeet > leg.maxElevation)
-          leg.maxElevation = altFeet;
-        if(altFeet > legs.maxElevationFt)
-          legs.maxElevationFt = altFeet;
+    const RouteLeg& lastLeg = legs.route.at(i - 1);
+    ElevationLeg leg;
 
-        leg.elevation.append(coord);
-        if(j > 0)
-          // Update total distance
-          dist += meterToNm(lastPos.distanceMeterTo(coord));
+    if(!keys.at(i).isEmpty())
+    {
+      if(!newCache.contains(keys.at(i)))
+        newCache.insert(keys.at(i), legs.legCache.value(keys.at(i)));
+      const ElevationLeg& relLeg = newCache[keys.at(i)];
 
-        // Distance to elevation point from departure
-        leg.distances.append(dist);
+      leg.maxElevation = relLeg.maxElevation;
+      legs.maxElevationFt = std::max(legs.maxElevationFt, relLeg.maxElevation);
 
-        legs.totalNumPoints++;
-        lastPos = coord;
-      }
+      // Convert distances from leg start to distances from departure
+      leg.elevation = relLeg.elevation;
+      leg.distances.reserve(relLeg.distances.size() + 1);
+      for(float dist : relLeg.distances)
+        leg.distances.append(legs.totalDistance + dist);
+      legs.totalNumPoints += relLeg.elevation.size();
 
       legs.totalDistance += routeLeg.getDistanceTo();
-      leg.elevation.append(lastPos);
+      leg.elevation.append(relLeg.elevation.isEmpty() ? Pos() : relLeg.elevation.last());
       leg.distances.append(legs.totalDistance);
-
     }
     else
     {
@@ -886,9 +929,78 @@ ProfileWidget::ElevationLegList ProfileWidget::fetchRouteElevationsThread(Elevat
     legs.elevationLegs.append(leg);
   }
 
+  // Keep only the legs of this route for the next run
+  legs.legCache = newCache;
   return legs;
 }
 
+ProfileWidget::ElevationLeg ProfileWidget::calculateElevationLeg(const atools::geo::LineString& geometry,
+                                                                 float sampleDistanceMeter) const
+{
+  using atools::geo::meterToNm;
+  using atools::geo::meterToFeet;
+
+  ElevationLeg leg;
+  LineString elevations;
+  if(!fetchRouteElevations(elevations, geometry, sampleDistanceMeter))
+    return leg;
+
+  float dist = 0.f;
+  // Loop over all elevation points for the current leg
+  Pos lastPos;
+  for(int j = 0; j < elevations.size(); j++)
+  {
+    if(terminateThreadSignal)
+      return ElevationLeg();
+
+    Pos& coord = elevations[j];
+    float altFeet = meterToFeet(coord.getAltitude());
+    coord.setAltitude(altFeet);
+
+    // Adjust maximum
+    if(altFeet > leg.maxElevation)
+      leg.maxElevation = altFeet;
+
+    leg.elevation.append(coord);
+    if(j > 0)
+      // Update distance from leg start
+      dist += meterToNm(lastPos.distanceMeterTo(coord));
+
+    leg.distances.append(dist);
+    lastPos = coord;
+  }
+  return leg;
+}
+
+LineString ProfileWidget::legGeometry(const Route& route, int index)
+{
+  const RouteLeg& routeLeg = route.at(index);
+
+  LineString geometry;
+  if(routeLeg.isAnyProcedure() && routeLeg.getGeometry().size() > 2)
+    geometry = routeLeg.getGeometry();
+  else
+    geometry << route.at(index - 1).getPosition() << routeLeg.getPosition();
+
+  geometry.removeInvalid();
+  return geometry;
+}
+
+QByteArray ProfileWidget::legCacheKey(const atools::geo::LineString& geometry, float sampleDistanceMeter)
+{
+  // Raw coordinates - altitude is not relevant for ground elevation
+  QByteArray key;
+  key.reserve((geometry.size() * 2 + 1) * static_cast<int>(sizeof(float)));
+  key.append(reinterpret_cast<const char *>(&sampleDistanceMeter), sizeof(float));
+  for(const Pos& pos : geometry)
+  {
+    float lonX = pos.getLonX(), latY = pos.getLatY();
+    key.append(reinterpret_cast<const char *>(&lonX), sizeof(float));
+    key.append(reinterpret_cast<const char *>(&latY), sizeof(float));
+  }
+  return key;
+}
+
 void ProfileWidget::showEvent(QShowEvent *)
 {
   widgetVisible = true;
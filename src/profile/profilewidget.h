@@ -23,6 +23,7 @@
 
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QHash>
 #include <QWidget>
 
 namespace Marble {
@@ -34,6 +35,7 @@ class QMainWindow;
 class RouteController;
 class QTimer;
 class QRubberBand;
+class QThreadPool;
 
 /*
  * Loads and displays the flight plan elevation profile. The elevation data is
@@ -98,7 +100,7 @@ signals:
   void highlightProfilePoint(const atools::geo::Pos& pos);
 
 private:
-  /* Route leg storing all elevation points */
+  /* Route leg storing all elevation points. Distances are relative to the leg start when used in the leg cache. */
   struct ElevationLeg
   {
     atools::geo::LineString elevation; /* Ground elevation (Pos.altitude) and position */
@@ -115,6 +117,13 @@ private:
     float maxElevationFt = 0.f /* Maximum ground elevation for the route */,
           totalDistance = 0.f /* Total route distance in nautical miles */;
     int totalNumPoints = 0; /* Number of elevation points in whole flight plan */
+    float sampleDistanceMeter = 0.f; /* Distance between elevation points if using the elevation pyramid.
+                                      * About one screen pixel. */
+
+    /* Legs of the last calculation keyed by geometry and sample distance. Legs found here are not calculated
+     * again. Replaced with the legs of the current route by the thread. */
+    QHash<QByteArray, ElevationLeg> legCache;
+    int legCacheGeneration = 0;
   };
 
   virtual void paintEvent(QPaintEvent *) override;
@@ -124,8 +133,16 @@ private:
   virtual void resizeEvent(QResizeEvent *) override;
   virtual void leaveEvent(QEvent *) override;
 
-  bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
+  bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry,
+                            float sampleDistanceMeter) const;
   ElevationLegList fetchRouteElevationsThread(ElevationLegList legs) const;
+
+  /* Calculate elevations for a single leg with distances relative to leg start. Runs in the leg thread pool. */
+  ElevationLeg calculateElevationLeg(const atools::geo::LineString& geometry, float sampleDistanceMeter) const;
+
+  /* Geometry of the leg from route index - 1 to index */
+  static atools::geo::LineString legGeometry(const Route& route, int index);
+  static QByteArray legCacheKey(const atools::geo::LineString& geometry, float sampleDistanceMeter);
   void elevationUpdateAvailable();
   void updateTimeout();
   void updateThreadFinished();
@@ -134,6 +151,7 @@ private:
   float calcGroundBuffer(float maxElevation);
   void updateLabel();
   bool aircraftTrackValid();
+  float trackToleranceMeter() const;
 
   /* Scale levels to test for display */
   static Q_DECL_CONSTEXPR int NUM_SCALE_STEPS = 5;
@@ -157,6 +175,9 @@ private:
   /* Minimum screen size of the aircraft track on the screen to be shown and to alter the profile altitude */
   static Q_DECL_CONSTEXPR int MIN_AIRCRAFT_TRACK_WIDTH = 10;
 
+  /* Minimum manhattan distance between track points on screen */
+  static Q_DECL_CONSTEXPR int MIN_TRACK_POINT_DISTANCE = 3;
+
   /* User aircraft data */
   atools::fs::sc::SimConnectData simData, lastSimData;
   QPolygon aircraftTrackPoints;
@@ -177,6 +198,14 @@ private:
   QFutureWatcher<ElevationLegList> watcher;
   bool terminateThreadSignal = false;
 
+  /* Elevations of legs of the last calculation. Generation is increased when elevation data changes to
+   * drop results of threads started before. */
+  QHash<QByteArray, ElevationLeg> legCache;
+  int legCacheGeneration = 0;
+
+  /* Legs are calculated in parallel in this pool */
+  QThreadPool *legThreadPool = nullptr;
+
   bool databaseLoadStatus = false;
 
   QRubberBand *rubberBand = nullptr;
@@ -22,6 +22,7 @@
 #include "common/maptools.h"
 #include "fs/common/binarygeometry.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
 #include "query/airportquery.h"
 #include "navapp.h"
 #include "common/maptools.h"
@@ -42,6 +43,7 @@ using map::MapMarker;
 using map::MapIls;
 using map::MapParking;
 using map::MapHelipad;
+using namespace std::placeholders;
 
 static double queryRectInflationFactor = 0.2;
 static double queryRectInflationIncrement = 0.1;
@@ -70,6 +72,17 @@ MapQuery::MapQuery(QObject *parent, atools::sql::SqlDatabase *sqlDb, SqlDatabase
     lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
   queryMaxRows = settings.getAndStoreValue(
     lnm::SETTINGS_MAPQUERY + "QueryRowLimit", 5000).toInt();
+
+  // Maximum number of objects kept in the tiles of each spatial cache
+  int tileCacheObjects = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheMaxObjects", 50000).toInt();
+  airportCache.setMaxObjects(tileCacheObjects);
+  waypointCache.setMaxObjects(tileCacheObjects);
+  vorCache.setMaxObjects(tileCacheObjects);
+  ndbCache.setMaxObjects(tileCacheObjects);
+  markerCache.setMaxObjects(tileCacheObjects);
+  ilsCache.setMaxObjects(tileCacheObjects);
+  airwayCache.setMaxObjects(tileCacheObjects);
+  airspaceCache.setMaxObjects(tileCacheObjects);
 }
 
 MapQuery::~MapQuery()
@@ -78,12 +91,22 @@ MapQuery::~MapQuery()
   delete mapTypesFactory;
 }
 
+AirportQuery *MapQuery::getAirportQuerySim() const
+{
+  return airportQuerySim != nullptr ? airportQuerySim : NavApp::getAirportQuerySim();
+}
+
+AirportQuery *MapQuery::getAirportQueryNav() const
+{
+  return airportQueryNav != nullptr ? airportQueryNav : NavApp::getAirportQueryNav();
+}
+
 map::MapAirport MapQuery::getAirportSim(const map::MapAirport& airport)
 {
   if(airport.navdata)
   {
     map::MapAirport retval;
-    NavApp::getAirportQuerySim()->getAirportByIdent(retval, airport.ident);
+    getAirportQuerySim()->getAirportByIdent(retval, airport.ident);
     return retval;
   }
   return airport;
@@ -94,7 +117,7 @@ map::MapAirport MapQuery::getAirportNav(const map::MapAirport& airport)
   if(!airport.navdata)
   {
     map::MapAirport retval;
-    NavApp::getAirportQueryNav()->getAirportByIdent(retval, airport.ident);
+    getAirportQueryNav()->getAirportByIdent(retval, airport.ident);
     return retval;
   }
   return airport;
@@ -103,13 +126,13 @@ map::MapAirport MapQuery::getAirportNav(const map::MapAirport& airport)
 void MapQuery::getAirportSimReplace(map::MapAirport& airport)
 {
   if(airport.navdata)
-    NavApp::getAirportQuerySim()->getAirportByIdent(airport, airport.ident);
+    getAirportQuerySim()->getAirportByIdent(airport, airport.ident);
 }
 
 void MapQuery::getAirportNavReplace(map::MapAirport& airport)
 {
   if(!airport.navdata)
-    NavApp::getAirportQueryNav()->getAirportByIdent(airport, airport.ident);
+    getAirportQueryNav()->getAirportByIdent(airport, airport.ident);
 }
 
 void MapQuery::getVorForWaypoint(map::MapVor& vor, int waypointId)
@@ -291,9 +314,9 @@ void MapQuery::mapObjectByIdentInternal(map::MapSearchResult& result, map::MapOb
     map::MapAirport ap;
 
     if(airportFromNavDatabase)
-      NavApp::getAirportQueryNav()->getAirportByIdent(ap, ident);
+      getAirportQueryNav()->getAirportByIdent(ap, ident);
     else
-      NavApp::getAirportQuerySim()->getAirportByIdent(ap, ident);
+      getAirportQuerySim()->getAirportByIdent(ap, ident);
 
     if(ap.isValid())
     {
@@ -366,9 +389,9 @@ void MapQuery::mapObjectByIdentInternal(map::MapSearchResult& result, map::MapOb
   if(type & map::RUNWAYEND)
   {
     if(airportFromNavDatabase)
-      NavApp::getAirportQueryNav()->getRunwayEndByNames(result, ident, airport);
+      getAirportQueryNav()->getRunwayEndByNames(result, ident, airport);
     else
-      NavApp::getAirportQuerySim()->getRunwayEndByNames(result, ident, airport);
+      getAirportQuerySim()->getRunwayEndByNames(result, ident, airport);
   }
 
   if(type & map::AIRWAY)
@@ -390,8 +413,8 @@ void MapQuery::getMapObjectById(map::MapSearchResult& result, map::MapObjectType
   if(type == map::AIRPORT)
   {
     map::MapAirport airport = (airportFromNavDatabase ?
-                               NavApp::getAirportQueryNav() :
-                               NavApp::getAirportQuerySim())->getAirportById(id);
+                               getAirportQueryNav() :
+                               getAirportQuerySim())->getAirportById(id);
     if(airport.isValid())
       result.airports.append(airport);
   }
@@ -422,8 +445,8 @@ void MapQuery::getMapObjectById(map::MapSearchResult& result, map::MapObjectType
   else if(type == map::RUNWAYEND)
   {
     map::MapRunwayEnd end = (airportFromNavDatabase ?
-                             NavApp::getAirportQueryNav() :
-                             NavApp::getAirportQuerySim())->getRunwayEndById(id);
+                             getAirportQueryNav() :
+                             getAirportQuerySim())->getRunwayEndById(id);
     if(end.isValid())
       result.runwayEnds.append(end);
   }
@@ -583,7 +606,7 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
   {
     if(airportDiagram)
     {
-      QHash<int, QList<map::MapParking> > parkingCache = NavApp::getAirportQuerySim()->getParkingCache();
+      QHash<int, QList<map::MapParking> > parkingCache = getAirportQuerySim()->getParkingCache();
 
       // Also check parking and helipads in airport diagrams
       for(int id : parkingCache.keys())
@@ -596,7 +619,7 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
         }
       }
 
-      QHash<int, QList<map::MapHelipad> > helipadCache = NavApp::getAirportQuerySim()->getHelipadCache();
+      QHash<int, QList<map::MapHelipad> > helipadCache = getAirportQuerySim()->getHelipadCache();
 
       for(int id : helipadCache.keys())
       {
@@ -611,391 +634,507 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
   }
 }
 
-const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonBox& rect,
-                                                    const MapLayer *mapLayer, bool lazy)
+const map::MapObjectList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonBox& rect,
+                                                                 const MapLayer *mapLayer, bool lazy)
 {
-  airportCache.updateCache(rect, mapLayer, lazy,
-                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bool rebuilt = airportCache.updateCache(inflateRect(rect), mapLayer, lazy,
+                                          &MapLayer::hasSameQueryParametersAirport, airportLoadFunc(mapLayer));
+
+  if(rebuilt)
   {
-    return curLayer->hasSameQueryParametersAirport(newLayer);
-  });
+    // Reverse order "rating desc, longest_runway_length desc" over all tiles
+    // to have unimportant small ones below in painting order
+    airportCache.list.sort([](const map::MapAirport& airport1, const map::MapAirport& airport2) -> bool
+    {
+      if(airport1.rating == airport2.rating)
+        return airport1.longestRunwayLength < airport2.longestRunwayLength;
+      else
+        return airport1.rating < airport2.rating;
+    });
+
+    // Limit the merged tiles and keep the most important airports which are at the end
+    if(airportCache.list.size() > queryMaxRows)
+      airportCache.list.remove(0, airportCache.list.size() - queryMaxRows);
+  }
+
+  return &airportCache.list;
+}
+
+const map::MapObjectList<map::MapWaypoint> *MapQuery::getWaypoints(const GeoDataLatLonBox& rect,
+                                                                   const MapLayer *mapLayer, bool lazy)
+{
+  if(waypointCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersWaypoint,
+                               std::bind(&MapQuery::loadWaypoints, this, _1, _2)))
+    limitList(waypointCache.list);
+  return &waypointCache.list;
+}
+
+const map::MapObjectList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                         bool lazy)
+{
+  if(vorCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersVor,
+                          std::bind(&MapQuery::loadVors, this, _1, _2)))
+    limitList(vorCache.list);
+  return &vorCache.list;
+}
+
+const map::MapObjectList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                         bool lazy)
+{
+  if(ndbCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersNdb,
+                          std::bind(&MapQuery::loadNdbs, this, _1, _2)))
+    limitList(ndbCache.list);
+  return &ndbCache.list;
+}
+
+const map::MapObjectList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
+                                                               const MapLayer *mapLayer, bool lazy)
+{
+  if(markerCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersMarker,
+                             std::bind(&MapQuery::loadMarkers, this, _1, _2)))
+    limitList(markerCache.list);
+  return &markerCache.list;
+}
+
+const map::MapObjectList<map::MapIls> *MapQuery::getIls(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                        bool lazy)
+{
+  if(ilsCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersIls,
+                          std::bind(&MapQuery::loadIls, this, _1, _2)))
+    limitList(ilsCache.list);
+  return &ilsCache.list;
+}
+
+const map::MapObjectList<map::MapAirway> *MapQuery::getAirways(const GeoDataLatLonBox& rect,
+                                                               const MapLayer *mapLayer, bool lazy)
+{
+  airwayCache.updateCache(inflateRect(rect), mapLayer, lazy, &MapLayer::hasSameQueryParametersAirway,
+                          std::bind(&MapQuery::loadAirways, this, _1, _2));
+  return &airwayCache.list;
+}
+
+const map::MapObjectList<map::MapAirspace> *MapQuery::getAirspaces(const GeoDataLatLonBox& rect,
+                                                                   const MapLayer *mapLayer,
+                                                                   map::MapAirspaceFilter filter,
+                                                                   float flightPlanAltitude, bool lazy)
+{
+  updateAirspaceFilter(filter, flightPlanAltitude);
+
+  bool rebuilt = airspaceCache.updateCache(inflateRect(rect), mapLayer, lazy,
+                                           &MapLayer::hasSameQueryParametersAirspace,
+                                           airspaceLoadFunc(filter, flightPlanAltitude));
+
+  if(rebuilt)
+    // Sort by importance
+    airspaceCache.list.sort([](const map::MapAirspace& airspace1, const map::MapAirspace& airspace2) -> bool
+    {
+      return map::airspaceDrawingOrder(airspace1.type) < map::airspaceDrawingOrder(airspace2.type);
+    });
+
+  return &airspaceCache.list;
+}
+
+void MapQuery::prefetch(const Marble::GeoDataLatLonBox& rect, const Marble::GeoDataLatLonBox& excludeRect,
+                        const MapLayer *mapLayer, const MapLayer *mapLayerEffective, map::MapObjectTypes types,
+                        map::MapAirspaceFilter airspaceFilter, float flightPlanAltitude)
+{
+  GeoDataLatLonBox inflated = inflateRect(rect);
+
+  // Same inflation as in the queries of the GUI thread to get the same tiles
+  GeoDataLatLonBox exclude = excludeRect.isEmpty() ? excludeRect : inflateRect(excludeRect);
+
+  // Same selection of layers and object types as in the map painters
+  const MapLayer *airportLayer = nullptr;
+  if(mapLayerEffective->isAirportDiagram())
+    airportLayer = mapLayerEffective;
+  else if(types.testFlag(map::AIRPORT) && mapLayer->isAirport())
+    airportLayer = mapLayer;
+
+  if(airportLayer != nullptr)
+    airportCache.loadTiles(inflated, exclude, airportLayer, &MapLayer::hasSameQueryParametersAirport,
+                           airportLoadFunc(airportLayer));
+
+  bool airway = mapLayer->isAirway() && (types.testFlag(map::AIRWAYJ) || types.testFlag(map::AIRWAYV));
+  if(airway)
+    airwayCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersAirway,
+                          std::bind(&MapQuery::loadAirways, this, _1, _2));
+
+  if(airway || (mapLayer->isWaypoint() && types.testFlag(map::WAYPOINT)))
+    waypointCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersWaypoint,
+                            std::bind(&MapQuery::loadWaypoints, this, _1, _2));
+
+  if(mapLayer->isVor() && types.testFlag(map::VOR))
+    vorCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersVor,
+                       std::bind(&MapQuery::loadVors, this, _1, _2));
+
+  if(mapLayer->isNdb() && types.testFlag(map::NDB))
+    ndbCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersNdb,
+                       std::bind(&MapQuery::loadNdbs, this, _1, _2));
 
+  if(mapLayer->isMarker() && types.testFlag(map::ILS))
+    markerCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersMarker,
+                          std::bind(&MapQuery::loadMarkers, this, _1, _2));
+
+  if(mapLayer->isIls() && types.testFlag(map::ILS))
+    ilsCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersIls,
+                       std::bind(&MapQuery::loadIls, this, _1, _2));
+
+  if(mapLayer->isAirspace() && types.testFlag(map::AIRSPACE))
+  {
+    updateAirspaceFilter(airspaceFilter, flightPlanAltitude);
+    airspaceCache.loadTiles(inflated, exclude, mapLayer, &MapLayer::hasSameQueryParametersAirspace,
+                            airspaceLoadFunc(airspaceFilter, flightPlanAltitude));
+  }
+}
+
+void MapQuery::setRecordLoadedTiles(bool value)
+{
+  airportCache.setRecordLoadedTiles(value);
+  waypointCache.setRecordLoadedTiles(value);
+  vorCache.setRecordLoadedTiles(value);
+  ndbCache.setRecordLoadedTiles(value);
+  markerCache.setRecordLoadedTiles(value);
+  ilsCache.setRecordLoadedTiles(value);
+  airwayCache.setRecordLoadedTiles(value);
+  airspaceCache.setRecordLoadedTiles(value);
+}
+
+MapQueryTiles MapQuery::takeLoadedTiles()
+{
+  MapQueryTiles tiles;
+  tiles.airports = airportCache.takeLoadedTiles();
+  tiles.waypoints = waypointCache.takeLoadedTiles();
+  tiles.vors = vorCache.takeLoadedTiles();
+  tiles.ndbs = ndbCache.takeLoadedTiles();
+  tiles.markers = markerCache.takeLoadedTiles();
+  tiles.ils = ilsCache.takeLoadedTiles();
+  tiles.airways = airwayCache.takeLoadedTiles();
+  tiles.airspaces = airspaceCache.takeLoadedTiles();
+  tiles.airspaceFilter = lastAirspaceFilter;
+  tiles.flightPlanAltitude = lastFlightplanAltitude;
+  return tiles;
+}
+
+MapQueryStatistics MapQuery::getStatistics() const
+{
+  MapQueryStatistics statistics;
+  statistics.airports = airportCache.getStatistics();
+  statistics.waypoints = waypointCache.getStatistics();
+  statistics.vors = vorCache.getStatistics();
+  statistics.ndbs = ndbCache.getStatistics();
+  statistics.markers = markerCache.getStatistics();
+  statistics.ils = ilsCache.getStatistics();
+  statistics.airways = airwayCache.getStatistics();
+  statistics.airspaces = airspaceCache.getStatistics();
+  return statistics;
+}
+
+void MapQuery::resetStatistics()
+{
+  airportCache.resetStatistics();
+  waypointCache.resetStatistics();
+  vorCache.resetStatistics();
+  ndbCache.resetStatistics();
+  markerCache.resetStatistics();
+  ilsCache.resetStatistics();
+  airwayCache.resetStatistics();
+  airspaceCache.resetStatistics();
+}
+
+bool MapQuery::insertTiles(const MapQueryTiles& tiles)
+{
+  bool visible = false;
+  for(const MapTile<map::MapAirport>& tile : tiles.airports)
+    visible |= airportCache.insertTile(tile, &MapLayer::hasSameQueryParametersAirport);
+  for(const MapTile<map::MapWaypoint>& tile : tiles.waypoints)
+    visible |= waypointCache.insertTile(tile, &MapLayer::hasSameQueryParametersWaypoint);
+  for(const MapTile<map::MapVor>& tile : tiles.vors)
+    visible |= vorCache.insertTile(tile, &MapLayer::hasSameQueryParametersVor);
+  for(const MapTile<map::MapNdb>& tile : tiles.ndbs)
+    visible |= ndbCache.insertTile(tile, &MapLayer::hasSameQueryParametersNdb);
+  for(const MapTile<map::MapMarker>& tile : tiles.markers)
+    visible |= markerCache.insertTile(tile, &MapLayer::hasSameQueryParametersMarker);
+  for(const MapTile<map::MapIls>& tile : tiles.ils)
+    visible |= ilsCache.insertTile(tile, &MapLayer::hasSameQueryParametersIls);
+  for(const MapTile<map::MapAirway>& tile : tiles.airways)
+    visible |= airwayCache.insertTile(tile, &MapLayer::hasSameQueryParametersAirway);
+
+  // Airspace tiles depend on filter and altitude
+  if(tiles.airspaceFilter.types == lastAirspaceFilter.types && tiles.airspaceFilter.flags == lastAirspaceFilter.flags &&
+     atools::almostEqual(tiles.flightPlanAltitude, lastFlightplanAltitude))
+  {
+    for(const MapTile<map::MapAirspace>& tile : tiles.airspaces)
+      visible |= airspaceCache.insertTile(tile, &MapLayer::hasSameQueryParametersAirspace);
+  }
+  return visible;
+}
+
+void MapQuery::updateAirspaceFilter(map::MapAirspaceFilter filter, float flightPlanAltitude)
+{
+  if(filter.types != lastAirspaceFilter.types || filter.flags != lastAirspaceFilter.flags ||
+     atools::almostNotEqual(lastFlightplanAltitude, flightPlanAltitude))
+  {
+    // Need a few more parameters to clear the cache which is different to other map features
+    airspaceCache.clear();
+    lastAirspaceFilter = filter;
+    lastFlightplanAltitude = flightPlanAltitude;
+  }
+}
+
+MapTileCache<map::MapAirport>::LoadFunc MapQuery::airportLoadFunc(const MapLayer *mapLayer)
+{
   switch(mapLayer->getDataSource())
   {
     case layer::ALL:
-      airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-      return fetchAirports(rect, airportByRectQuery, true /* reverse */, lazy, false /* overview */);
+      return std::bind(&MapQuery::loadAirports, this, _1, _2, airportByRectQuery, false /* overview */,
+                       mapLayer->getMinRunwayLength());
 
     case layer::MEDIUM:
       // Airports > 4000 ft
-      return fetchAirports(rect, airportMediumByRectQuery, false /* reverse */, lazy, true /* overview */);
+      return std::bind(&MapQuery::loadAirports, this, _1, _2, airportMediumByRectQuery, true /* overview */, -1);
 
     case layer::LARGE:
       // Airports > 8000 ft
-      return fetchAirports(rect, airportLargeByRectQuery, false /* reverse */, lazy, true /* overview */);
-
+      return std::bind(&MapQuery::loadAirports, this, _1, _2, airportLargeByRectQuery, true /* overview */, -1);
   }
   return nullptr;
 }
 
-const QList<map::MapWaypoint> *MapQuery::getWaypoints(const GeoDataLatLonBox& rect,
-                                                      const MapLayer *mapLayer, bool lazy)
+MapTileCache<map::MapAirspace>::LoadFunc MapQuery::airspaceLoadFunc(map::MapAirspaceFilter filter,
+                                                                    float flightPlanAltitude)
 {
-  waypointCache.updateCache(rect, mapLayer, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  QStringList typeStrings;
+  // Build a list of query strings based on the bitfield
+  if(filter.types == map::AIRSPACE_ALL)
+    typeStrings.append("%");
+  else if(filter.types != map::AIRSPACE_NONE)
   {
-    return curLayer->hasSameQueryParametersWaypoint(newLayer);
-  });
-
-  if(waypointCache.list.isEmpty() && !lazy)
-  {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
+    for(int i = 0; i <= map::MAP_AIRSPACE_TYPE_BITS; i++)
     {
-      bindCoordinatePointInRect(r, waypointsByRectQuery);
-      waypointsByRectQuery->exec();
-      while(waypointsByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp);
-        waypointCache.list.append(wp);
-      }
+      map::MapAirspaceTypes t(1 << i);
+      if(filter.types & t)
+        typeStrings.append(map::airspaceTypeToDatabase(t));
     }
   }
-  waypointCache.validate();
-  return &waypointCache.list;
-}
 
-const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                            bool lazy)
-{
-  vorCache.updateCache(rect, mapLayer, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  SqlQuery *query = nullptr;
+  int alt;
+  if(filter.flags & map::AIRSPACE_AT_FLIGHTPLAN)
   {
-    return curLayer->hasSameQueryParametersVor(newLayer);
-  });
-
-  if(vorCache.list.isEmpty() && !lazy)
+    query = airspaceByRectAtAltQuery;
+    alt = atools::roundToInt(flightPlanAltitude);
+  }
+  else if(filter.flags & map::AIRSPACE_BELOW_10000)
   {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, vorsByRectQuery);
-      vorsByRectQuery->exec();
-      while(vorsByRectQuery->next())
-      {
-        map::MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
-        vorCache.list.append(vor);
-      }
-    }
+    query = airspaceByRectBelowAltQuery;
+    alt = 10000;
   }
-  vorCache.validate();
-  return &vorCache.list;
+  else if(filter.flags & map::AIRSPACE_BELOW_18000)
+  {
+    query = airspaceByRectBelowAltQuery;
+    alt = 18000;
+  }
+  else if(filter.flags & map::AIRSPACE_ABOVE_10000)
+  {
+    query = airspaceByRectAboveAltQuery;
+    alt = 10000;
+  }
+  else if(filter.flags & map::AIRSPACE_ABOVE_18000)
+  {
+    query = airspaceByRectAboveAltQuery;
+    alt = 18000;
+  }
+  else
+  {
+    query = airspaceByRectQuery;
+    alt = 0;
+  }
+
+  return std::bind(&MapQuery::loadAirspaces, this, _1, _2, query, alt, typeStrings);
 }
 
-const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                            bool lazy)
+/*
+ * Load airports of a tile
+ * @param overview fetch only incomplete data for overview airports
+ * @param minRunwayLength bound to the query if not -1
+ */
+void MapQuery::loadAirports(const GeoDataLatLonBox& tileRect, QVector<map::MapAirport>& airports, SqlQuery *query,
+                            bool overview, int minRunwayLength)
 {
-  ndbCache.updateCache(rect, mapLayer, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-  {
-    return curLayer->hasSameQueryParametersNdb(newLayer);
-  });
+  if(minRunwayLength != -1)
+    query->bindValue(":minlength", minRunwayLength);
 
-  if(ndbCache.list.isEmpty() && !lazy)
+  bindCoordinatePointInRect(tileRect, query);
+  query->exec();
+  while(query->next())
   {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, ndbsByRectQuery);
-      ndbsByRectQuery->exec();
-      while(ndbsByRectQuery->next())
-      {
-        map::MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
-        ndbCache.list.append(ndb);
-      }
-    }
+    map::MapAirport ap;
+    if(overview)
+      // Fill only a part of the object
+      mapTypesFactory->fillAirportForOverview(query->record(), ap);
+    else
+      mapTypesFactory->fillAirport(query->record(), ap, true /* complete */, false /* nav */);
+    airports.append(ap);
   }
-  ndbCache.validate();
-  return &ndbCache.list;
 }
 
-const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                                  bool lazy)
+void MapQuery::loadWaypoints(const GeoDataLatLonBox& tileRect, QVector<map::MapWaypoint>& waypoints)
 {
-  markerCache.updateCache(rect, mapLayer, lazy,
-                          [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bindCoordinatePointInRect(tileRect, waypointsByRectQuery);
+  waypointsByRectQuery->exec();
+  while(waypointsByRectQuery->next())
   {
-    return curLayer->hasSameQueryParametersMarker(newLayer);
-  });
+    map::MapWaypoint wp;
+    mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp);
+    waypoints.append(wp);
+  }
+}
 
-  if(markerCache.list.isEmpty() && !lazy)
+void MapQuery::loadVors(const GeoDataLatLonBox& tileRect, QVector<map::MapVor>& vors)
+{
+  bindCoordinatePointInRect(tileRect, vorsByRectQuery);
+  vorsByRectQuery->exec();
+  while(vorsByRectQuery->next())
   {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, markersByRectQuery);
-      markersByRectQuery->exec();
-      while(markersByRectQuery->next())
-      {
-        map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
-        markerCache.list.append(marker);
-      }
-    }
+    map::MapVor vor;
+    mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
+    vors.append(vor);
   }
-  markerCache.validate();
-  return &markerCache.list;
 }
 
-const QList<map::MapIls> *MapQuery::getIls(const GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy)
+void MapQuery::loadNdbs(const GeoDataLatLonBox& tileRect, QVector<map::MapNdb>& ndbs)
 {
-  ilsCache.updateCache(rect, mapLayer, lazy,
-                       [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bindCoordinatePointInRect(tileRect, ndbsByRectQuery);
+  ndbsByRectQuery->exec();
+  while(ndbsByRectQuery->next())
   {
-    return curLayer->hasSameQueryParametersIls(newLayer);
-  });
+    map::MapNdb ndb;
+    mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
+    ndbs.append(ndb);
+  }
+}
 
-  if(ilsCache.list.isEmpty() && !lazy)
+void MapQuery::loadMarkers(const GeoDataLatLonBox& tileRect, QVector<map::MapMarker>& markers)
+{
+  bindCoordinatePointInRect(tileRect, markersByRectQuery);
+  markersByRectQuery->exec();
+  while(markersByRectQuery->next())
   {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, ilsByRectQuery);
-      ilsByRectQuery->exec();
-      while(ilsByRectQuery->next())
-      {
-        map::MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils);
-        ilsCache.list.append(ils);
-      }
-    }
+    map::MapMarker marker;
+    mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+    markers.append(marker);
   }
-  ilsCache.validate();
-  return &ilsCache.list;
 }
 
-const QList<map::MapAirway> *MapQuery::getAirways(const GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy)
+void MapQuery::loadIls(const GeoDataLatLonBox& tileRect, QVector<map::MapIls>& ils)
 {
-  airwayCache.updateCache(rect, mapLayer, lazy,
-                          [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  bindCoordinatePointInRect(tileRect, ilsByRectQuery);
+  ilsByRectQuery->exec();
+  while(ilsByRectQuery->next())
   {
-    return curLayer->hasSameQueryParametersAirway(newLayer);
-  });
+    map::MapIls i;
+    mapTypesFactory->fillIls(ilsByRectQuery->record(), i);
+    ils.append(i);
+  }
+}
 
-  if(airwayCache.list.isEmpty() && !lazy)
+void MapQuery::loadAirways(const GeoDataLatLonBox& tileRect, QVector<map::MapAirway>& airways)
+{
+  bindCoordinatePointInRect(tileRect, airwayByRectQuery);
+  airwayByRectQuery->exec();
+  while(airwayByRectQuery->next())
   {
-    QSet<int> ids;
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, airwayByRectQuery);
-      airwayByRectQuery->exec();
-      while(airwayByRectQuery->next())
-      {
-        if(ids.contains(airwayByRectQuery->valueInt("airway_id")))
-          continue;
-
-        // qreal north, qreal south, qreal east, qreal west
-        if(rect.intersects(GeoDataLatLonBox(airwayByRectQuery->valueFloat("top_laty"),
+    // qreal north, qreal south, qreal east, qreal west
+    if(tileRect.intersects(GeoDataLatLonBox(airwayByRectQuery->valueFloat("top_laty"),
                                             airwayByRectQuery->valueFloat("bottom_laty"),
                                             airwayByRectQuery->valueFloat("right_lonx"),
                                             airwayByRectQuery->valueFloat("left_lonx"),
                                             GeoDataCoordinates::GeoDataCoordinates::Degree)))
-        {
-          map::MapAirway airway;
-          mapTypesFactory->fillAirway(airwayByRectQuery->record(), airway);
-          airwayCache.list.append(airway);
-          ids.insert(airway.id);
-        }
-      }
+    {
+      map::MapAirway airway;
+      mapTypesFactory->fillAirway(airwayByRectQuery->record(), airway);
+      airways.append(airway);
     }
   }
-  airwayCache.validate();
-  return &airwayCache.list;
 }
 
-const QList<map::MapAirspace> *MapQuery::getAirspaces(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                                      map::MapAirspaceFilter filter, float flightPlanAltitude,
-                                                      bool lazy)
+/* Get the airspace objects without geometry */
+void MapQuery::loadAirspaces(const GeoDataLatLonBox& tileRect, QVector<map::MapAirspace>& airspaces, SqlQuery *query,
+                             int alt, const QStringList& typeStrings)
 {
-  airspaceCache.updateCache(rect, mapLayer, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-  {
-    return curLayer->hasSameQueryParametersAirspace(newLayer);
-  });
-
-  if(filter.types != lastAirspaceFilter.types || filter.flags != lastAirspaceFilter.flags ||
-     atools::almostNotEqual(lastFlightplanAltitude, flightPlanAltitude))
+  for(const QString& typeStr : typeStrings)
   {
-    // Need a few more parameters to clear the cache which is different to other map features
-    airspaceCache.list.clear();
-    lastAirspaceFilter = filter;
-    lastFlightplanAltitude = flightPlanAltitude;
-  }
+    bindCoordinatePointInRect(tileRect, query);
+    query->bindValue(":type", typeStr);
 
-  if(airspaceCache.list.isEmpty() && !lazy)
-  {
-    QStringList typeStrings;
+    if(alt > 0)
+      query->bindValue(":alt", alt);
 
-    if(filter.types != map::AIRSPACE_NONE)
+    query->exec();
+    while(query->next())
     {
-      // Build a list of query strings based on the bitfield
-      if(filter.types == map::AIRSPACE_ALL)
-        typeStrings.append("%");
-      else
-      {
-        for(int i = 0; i <= map::MAP_AIRSPACE_TYPE_BITS; i++)
-        {
-          map::MapAirspaceTypes t(1 << i);
-          if(filter.types & t)
-            typeStrings.append(map::airspaceTypeToDatabase(t));
-        }
-      }
-
-      SqlQuery *query = nullptr;
-      int alt;
-      if(filter.flags & map::AIRSPACE_AT_FLIGHTPLAN)
+      // qreal north, qreal south, qreal east, qreal west
+      if(tileRect.intersects(GeoDataLatLonBox(query->valueFloat("max_laty"), query->valueFloat("min_laty"),
+                                              query->valueFloat("max_lonx"), query->valueFloat("min_lonx"),
+                                              GeoDataCoordinates::GeoDataCoordinates::Degree)))
       {
-        query = airspaceByRectAtAltQuery;
-        alt = atools::roundToInt(flightPlanAltitude);
+        map::MapAirspace airspace;
+        mapTypesFactory->fillAirspace(query->record(), airspace);
+        airspaces.append(airspace);
       }
-      else if(filter.flags & map::AIRSPACE_BELOW_10000)
-      {
-        query = airspaceByRectBelowAltQuery;
-        alt = 10000;
-      }
-      else if(filter.flags & map::AIRSPACE_BELOW_18000)
-      {
-        query = airspaceByRectBelowAltQuery;
-        alt = 18000;
-      }
-      else if(filter.flags & map::AIRSPACE_ABOVE_10000)
-      {
-        query = airspaceByRectAboveAltQuery;
-        alt = 10000;
-      }
-      else if(filter.flags & map::AIRSPACE_ABOVE_18000)
-      {
-        query = airspaceByRectAboveAltQuery;
-        alt = 18000;
-      }
-      else
-      {
-        query = airspaceByRectQuery;
-        alt = 0;
-      }
-
-      QSet<int> ids;
-
-      // qDebug() << rect.toString(GeoDataCoordinates::Degree);
-
-      // Get the airspace objects without geometry
-      for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-      {
-        // qDebug() << r.toString(GeoDataCoordinates::Degree);
-
-        for(const QString& typeStr : typeStrings)
-        {
-          bindCoordinatePointInRect(r, query);
-          query->bindValue(":type", typeStr);
-
-          if(alt > 0)
-            query->bindValue(":alt", alt);
-
-          // qDebug() << "==================== query" << endl << query->getFullQueryString();
-
-          query->exec();
-          while(query->next())
-          {
-            // Avoid double airspaces which can happen if they cross the date boundary
-            if(ids.contains(query->valueInt("boundary_id")))
-              continue;
-
-            // qreal north, qreal south, qreal east, qreal west
-            if(rect.intersects(GeoDataLatLonBox(query->valueFloat("max_laty"), query->valueFloat("min_laty"),
-                                                query->valueFloat("max_lonx"), query->valueFloat("min_lonx"),
-                                                GeoDataCoordinates::GeoDataCoordinates::Degree)))
-            {
-              map::MapAirspace airspace;
-              mapTypesFactory->fillAirspace(query->record(), airspace);
-              airspaceCache.list.append(airspace);
-
-              ids.insert(airspace.id);
-            }
-          }
-        }
-      }
-
-      // Sort by importance
-      std::sort(airspaceCache.list.begin(), airspaceCache.list.end(),
-                [](const map::MapAirspace& airspace1, const map::MapAirspace& airspace2) -> bool
-      {
-        return map::airspaceDrawingOrder(airspace1.type) < map::airspaceDrawingOrder(airspace2.type);
-      });
     }
   }
-  airspaceCache.validate();
-  return &airspaceCache.list;
 }
 
-const LineString *MapQuery::getAirspaceGeometry(int boundaryId)
+const LineString *MapQuery::getAirspaceGeometry(int boundaryId, int detail)
 {
-  if(airspaceLineCache.contains(boundaryId))
-    return airspaceLineCache.object(boundaryId);
+  if(airspaceLodLinesByIdQuery == nullptr)
+    // No simplified boundaries in database
+    detail = 0;
+
+  quint64 key = (static_cast<quint64>(boundaryId) << 3) | static_cast<quint64>(detail);
+  if(airspaceLineCache.contains(key))
+    return airspaceLineCache.object(key);
   else
   {
     LineString *lines = new LineString;
 
-    airspaceLinesByIdQuery->bindValue(":id", boundaryId);
-    airspaceLinesByIdQuery->exec();
-    if(airspaceLinesByIdQuery->next())
+    // Get the closest available simplified boundary with the same or finer detail or fall back to full resolution
+    SqlQuery *query = nullptr;
+    if(detail > 0)
     {
-      atools::fs::common::BinaryGeometry geometry(airspaceLinesByIdQuery->value("geometry").toByteArray());
+      airspaceLodLinesByIdQuery->bindValue(":id", boundaryId);
+      airspaceLodLinesByIdQuery->bindValue(":lod", detail);
+      airspaceLodLinesByIdQuery->exec();
+      if(airspaceLodLinesByIdQuery->next())
+        query = airspaceLodLinesByIdQuery;
+      else
+        airspaceLodLinesByIdQuery->finish();
+    }
+
+    if(query == nullptr)
+    {
+      airspaceLinesByIdQuery->bindValue(":id", boundaryId);
+      airspaceLinesByIdQuery->exec();
+      if(airspaceLinesByIdQuery->next())
+        query = airspaceLinesByIdQuery;
+    }
+
+    if(query != nullptr)
+    {
+      atools::fs::common::BinaryGeometry geometry(query->value("geometry").toByteArray());
       geometry.swapGeometry(*lines);
+      query->finish();
 
       // qDebug() << *lines;
     }
 
-    airspaceLineCache.insert(boundaryId, lines);
+    airspaceLineCache.insert(key, lines);
 
     return lines;
   }
 }
 
-/*
- * Get airport cache
- * @param reverse reverse order of airports to have unimportant small ones below in painting order
- * @param lazy do not update cache - instead return incomplete resut
- * @param overview fetch only incomplete data for overview airports
- * @return pointer to the airport cache
- */
-const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect,
-                                                      atools::sql::SqlQuery *query, bool reverse,
-                                                      bool lazy, bool overview)
-{
-  if(airportCache.list.isEmpty() && !lazy)
-  {
-    for(const GeoDataLatLonBox& r : splitAtAntiMeridian(rect))
-    {
-      bindCoordinatePointInRect(r, query);
-      query->exec();
-      while(query->next())
-      {
-        map::MapAirport ap;
-        if(overview)
-          // Fill only a part of the object
-          mapTypesFactory->fillAirportForOverview(query->record(), ap);
-        else
-          mapTypesFactory->fillAirport(query->record(), ap, true /* complete */, false /* nav */);
-
-        if(reverse)
-          airportCache.list.prepend(ap);
-        else
-          airportCache.list.append(ap);
-      }
-    }
-  }
-  airportCache.validate();
-  return &airportCache.list;
-}
-
 const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
 {
   if(runwayOverwiewCache.contains(airportId))
@@ -1034,50 +1173,29 @@ void MapQuery::bindCoordinatePointInRect(const Marble::GeoDataLatLonBox& rect, a
   query->bindValue(":" + prefix + "topy", rect.north(GeoDataCoordinates::Degree));
 }
 
-/* Inflates the rectangle and splits it at the antimeridian (date line) if it overlaps */
-QList<Marble::GeoDataLatLonBox> MapQuery::splitAtAntiMeridian(const Marble::GeoDataLatLonBox& rect)
-{
-  GeoDataLatLonBox newRect = rect;
-  inflateRect(newRect);
-
-  if(newRect.crossesDateLine())
-  {
-    // Split in western and eastern part
-    GeoDataLatLonBox westOf;
-    westOf.setBoundaries(newRect.north(GeoDataCoordinates::Degree),
-                         newRect.south(GeoDataCoordinates::Degree),
-                         180.,
-                         newRect.west(GeoDataCoordinates::Degree), GeoDataCoordinates::Degree);
-
-    GeoDataLatLonBox eastOf;
-    eastOf.setBoundaries(newRect.north(GeoDataCoordinates::Degree),
-                         newRect.south(GeoDataCoordinates::Degree),
-                         newRect.east(GeoDataCoordinates::Degree),
-                         -180., GeoDataCoordinates::Degree);
-
-    return QList<GeoDataLatLonBox>({westOf, eastOf});
-  }
-  else
-    return QList<GeoDataLatLonBox>({newRect});
-}
-
 /* Inflate rect by width and height in degrees. If it crosses the poles or date line it will be limited */
-void MapQuery::inflateRect(Marble::GeoDataLatLonBox& rect)
+Marble::GeoDataLatLonBox MapQuery::inflateRect(const Marble::GeoDataLatLonBox& rect)
 {
-  rect.scale(1. + queryRectInflationFactor, 1. + queryRectInflationFactor);
-
-  if(rect.east(GeoDataCoordinates::Degree) + queryRectInflationIncrement < 180.f)
-    rect.setEast(rect.east(GeoDataCoordinates::Degree) + queryRectInflationIncrement, GeoDataCoordinates::Degree);
-
-  if(rect.west(GeoDataCoordinates::Degree) - queryRectInflationIncrement > -180.f)
-    rect.setWest(rect.west(GeoDataCoordinates::Degree) - queryRectInflationIncrement, GeoDataCoordinates::Degree);
-
-  if(rect.north(GeoDataCoordinates::Degree) + queryRectInflationIncrement < 90.f)
-    rect.setNorth(rect.north(GeoDataCoordinates::Degree) + queryRectInflationIncrement, GeoDataCoordinates::Degree);
-  if(rect.south(GeoDataCoordinates::Degree) - queryRectInflationIncrement > -90.f)
-    rect.setSouth(rect.south(GeoDataCoordinates::Degree) - queryRectInflationIncrement, GeoDataCoordinates::Degree);
-
-  // qDebug() << rect.toString(GeoDataCoordinates::Degree);
+  GeoDataLatLonBox newRect(rect);
+  newRect.scale(1. + queryRectInflationFactor, 1. + queryRectInflationFactor);
+
+  if(newRect.east(GeoDataCoordinates::Degree) + queryRectInflationIncrement < 180.f)
+    newRect.setEast(newRect.east(GeoDataCoordinates::Degree) + queryRectInflationIncrement,
+                    GeoDataCoordinates::Degree);
+
+  if(newRect.west(GeoDataCoordinates::Degree) - queryRectInflationIncrement > -180.f)
+    newRect.setWest(newRect.west(GeoDataCoordinates::Degree) - queryRectInflationIncrement,
+                    GeoDataCoordinates::Degree);
+
+  if(newRect.north(GeoDataCoordinates::Degree) + queryRectInflationIncrement < 90.f)
+    newRect.setNorth(newRect.north(GeoDataCoordinates::Degree) + queryRectInflationIncrement,
+                     GeoDataCoordinates::Degree);
+  if(newRect.south(GeoDataCoordinates::Degree) - queryRectInflationIncrement > -90.f)
+    newRect.setSouth(newRect.south(GeoDataCoordinates::Degree) - queryRectInflationIncrement,
+                     GeoDataCoordinates::Degree);
+
+  // qDebug() << newRect.toString(GeoDataCoordinates::Degree);
+  return newRect;
 }
 
 void MapQuery::initQueries()
@@ -1176,16 +1294,15 @@ void MapQuery::initQueries()
   airportByRectQuery = new SqlQuery(db);
   airportByRectQuery->prepare(
     "select " + airportQueryBase.join(", ") + " from airport where " + whereRect +
-    " and longest_runway_length >= :minlength order by rating desc, longest_runway_length desc "
-    + whereLimit);
+    " and longest_runway_length >= :minlength");
 
   airportMediumByRectQuery = new SqlQuery(db);
   airportMediumByRectQuery->prepare(
-    "select " + airportQueryBaseOverview + "from airport_medium where " + whereRect + " " + whereLimit);
+    "select " + airportQueryBaseOverview + "from airport_medium where " + whereRect);
 
   airportLargeByRectQuery = new SqlQuery(db);
   airportLargeByRectQuery->prepare(
-    "select " + airportQueryBaseOverview + "from airport_large where " + whereRect + " " + whereLimit);
+    "select " + airportQueryBaseOverview + "from airport_large where " + whereRect);
 
   // Runways > 4000 feet for simplyfied runway overview
   runwayOverviewQuery = new SqlQuery(db);
@@ -1195,22 +1312,22 @@ void MapQuery::initQueries()
 
   waypointsByRectQuery = new SqlQuery(dbNav);
   waypointsByRectQuery->prepare(
-    "select " + waypointQueryBase + " from waypoint where " + whereRect + " " + whereLimit);
+    "select " + waypointQueryBase + " from waypoint where " + whereRect);
 
   vorsByRectQuery = new SqlQuery(dbNav);
-  vorsByRectQuery->prepare("select " + vorQueryBase + " from vor where " + whereRect + " " + whereLimit);
+  vorsByRectQuery->prepare("select " + vorQueryBase + " from vor where " + whereRect);
 
   ndbsByRectQuery = new SqlQuery(dbNav);
-  ndbsByRectQuery->prepare("select " + ndbQueryBase + " from ndb where " + whereRect + " " + whereLimit);
+  ndbsByRectQuery->prepare("select " + ndbQueryBase + " from ndb where " + whereRect);
 
   markersByRectQuery = new SqlQuery(dbNav);
   markersByRectQuery->prepare(
     "select marker_id, type, ident, heading, lonx, laty "
     "from marker "
-    "where " + whereRect + " " + whereLimit);
+    "where " + whereRect);
 
   ilsByRectQuery = new SqlQuery(db);
-  ilsByRectQuery->prepare("select " + ilsQueryBase + " from ils where " + whereRect + " " + whereLimit);
+  ilsByRectQuery->prepare("select " + ilsQueryBase + " from ils where " + whereRect);
 
   // Get all that are crossing the anti meridian too and filter them out from the query result
   airwayByRectQuery = new SqlQuery(dbNav);
@@ -1287,6 +1404,15 @@ void MapQuery::initQueries()
   airspaceLinesByIdQuery = new SqlQuery(dbNav);
   airspaceLinesByIdQuery->prepare("select geometry from boundary where boundary_id = :id");
 
+  if(SqlUtil(dbNav).hasTable("boundary_lod"))
+  {
+    // Simplified boundaries are created after loading the database.
+    // Level is missing if simplification did not remove points - use the next finer level in this case
+    airspaceLodLinesByIdQuery = new SqlQuery(dbNav);
+    airspaceLodLinesByIdQuery->prepare("select geometry from boundary_lod where boundary_id = :id and lod <= :lod "
+                                       "order by lod desc limit 1");
+  }
+
 }
 
 void MapQuery::deInitQueries()
@@ -1336,6 +1462,8 @@ void MapQuery::deInitQueries()
 
   delete airspaceLinesByIdQuery;
   airspaceLinesByIdQuery = nullptr;
+  delete airspaceLodLinesByIdQuery;
+  airspaceLodLinesByIdQuery = nullptr;
   delete airspaceByIdQuery;
   airspaceByIdQuery = nullptr;
 
@@ -20,12 +20,11 @@
 
 #include "common/maptypes.h"
 #include "mapgui/maplayer.h"
+#include "query/maptilecache.h"
 
 #include <QCache>
 #include <QList>
 
-#include <functional>
-
 #include <marble/GeoDataLatLonBox.h>
 
 namespace atools {
@@ -38,10 +37,56 @@ class SqlQuery;
 }
 }
 
+class AirportQuery;
 class CoordinateConverter;
 class MapTypesFactory;
 class MapLayer;
 
+/* Tiles loaded by one map query instance which can be inserted into another one */
+struct MapQueryTiles
+{
+  QVector<MapTile<map::MapAirport> > airports;
+  QVector<MapTile<map::MapWaypoint> > waypoints;
+  QVector<MapTile<map::MapVor> > vors;
+  QVector<MapTile<map::MapNdb> > ndbs;
+  QVector<MapTile<map::MapMarker> > markers;
+  QVector<MapTile<map::MapIls> > ils;
+  QVector<MapTile<map::MapAirway> > airways;
+  QVector<MapTile<map::MapAirspace> > airspaces;
+
+  /* Airspace tiles are only valid for this filter and altitude */
+  map::MapAirspaceFilter airspaceFilter = {map::AIRSPACE_NONE, map::AIRSPACE_FLAG_NONE};
+  float flightPlanAltitude = 0.f;
+
+  bool isEmpty() const
+  {
+    return airports.isEmpty() && waypoints.isEmpty() && vors.isEmpty() && ndbs.isEmpty() && markers.isEmpty() &&
+           ils.isEmpty() && airways.isEmpty() && airspaces.isEmpty();
+  }
+};
+
+Q_DECLARE_METATYPE(MapQueryTiles);
+
+/* Cache statistics of all object types since the last reset */
+struct MapQueryStatistics
+{
+  MapTileCacheStatistics airports, waypoints, vors, ndbs, markers, ils, airways, airspaces;
+
+  MapTileCacheStatistics total() const
+  {
+    MapTileCacheStatistics retval;
+    retval += airports;
+    retval += waypoints;
+    retval += vors;
+    retval += ndbs;
+    retval += markers;
+    retval += ils;
+    retval += airways;
+    retval += airspaces;
+    return retval;
+  }
+};
+
 /*
  * Provides map related database queries. Fill objects of the maptypes namespace and maintains a cache.
  * Objects from methods returning a pointer to a list might be deleted from the cache and should be copied
@@ -61,6 +106,14 @@ public:
   MapQuery(QObject *parent, atools::sql::SqlDatabase *sqlDb, atools::sql::SqlDatabase *sqlDbNav);
   ~MapQuery();
 
+  /* Use the given airport queries instead of the global ones from NavApp. Needed for instances which are used
+   * outside of the main thread. */
+  void setAirportQueries(AirportQuery *airportQuerySimParam, AirportQuery *airportQueryNavParam)
+  {
+    airportQuerySim = airportQuerySimParam;
+    airportQueryNav = airportQueryNavParam;
+  }
+
   /* Convert airport instances from/to simulator and third party nav databases */
   map::MapAirport  getAirportSim(const map::MapAirport& airport);
   map::MapAirport  getAirportNav(const map::MapAirport& airport);
@@ -145,30 +198,63 @@ public:
    * @return pointer to airport cache. Create a copy if this is needed for a longer
    * time than for e.g. one drawing request.
    */
-  const QList<map::MapAirport> *getAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapAirport> *getAirports(const Marble::GeoDataLatLonBox& rect,
+                                                         const MapLayer *mapLayer, bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapWaypoint> *getWaypoints(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                              bool lazy);
+  const map::MapObjectList<map::MapWaypoint> *getWaypoints(const Marble::GeoDataLatLonBox& rect,
+                                                           const MapLayer *mapLayer, bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapVor> *getVors(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapVor> *getVors(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                 bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapNdb> *getNdbs(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapNdb> *getNdbs(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                 bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapMarker> *getMarkers(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapMarker> *getMarkers(const Marble::GeoDataLatLonBox& rect,
+                                                       const MapLayer *mapLayer, bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapIls> *getIls(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapIls> *getIls(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                bool lazy);
 
   /* Similar to getAirports */
-  const QList<map::MapAirway> *getAirways(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
+  const map::MapObjectList<map::MapAirway> *getAirways(const Marble::GeoDataLatLonBox& rect,
+                                                       const MapLayer *mapLayer, bool lazy);
+
+  const map::MapObjectList<map::MapAirspace> *getAirspaces(const Marble::GeoDataLatLonBox& rect,
+                                                           const MapLayer *mapLayer, map::MapAirspaceFilter filter,
+                                                           float flightPlanAltitude, bool lazy);
+
+  /* Get airspace boundary for the detail level from MapLayer::getAirspaceDetail(). Level 0 is full resolution.
+   * Uses the closest stored level which is not coarser than the requested one. Returns full resolution if the
+   * database has no simplified boundaries. */
+  const atools::geo::LineString *getAirspaceGeometry(int boundaryId, int detail = 0);
+
+  /*
+   * Load all missing tiles covering the rectangle into the caches without changing the object lists.
+   * Tiles covering excludeRect are skipped since they are already loaded elsewhere.
+   * Object types are selected like in the map painters. Used by the prefetch thread.
+   */
+  void prefetch(const Marble::GeoDataLatLonBox& rect, const Marble::GeoDataLatLonBox& excludeRect,
+                const MapLayer *mapLayer, const MapLayer *mapLayerEffective, map::MapObjectTypes types,
+                map::MapAirspaceFilter airspaceFilter, float flightPlanAltitude);
+
+  /* Keep all tiles loaded from the database for takeLoadedTiles */
+  void setRecordLoadedTiles(bool value);
+
+  /* Get all tiles loaded since the last call */
+  MapQueryTiles takeLoadedTiles();
 
-  const QList<map::MapAirspace> *getAirspaces(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                              map::MapAirspaceFilter filter, float flightPlanAltitude, bool lazy);
-  const atools::geo::LineString *getAirspaceGeometry(int boundaryId);
+  /* Insert tiles loaded by another instance. Returns true if any of these are visible, i.e. a map update is needed. */
+  bool insertTiles(const MapQueryTiles& tiles);
+
+  /* Get tile cache hits, misses and load times. Used for profiling. */
+  MapQueryStatistics getStatistics() const;
+  void resetStatistics();
 
   /* Get a partially filled runway list for the overview */
   const QList<map::MapRunway> *getRunwaysForOverview(int airportId);
@@ -180,64 +266,68 @@ public:
   void deInitQueries();
 
 private:
-  /* Simple spatial cache that deals with objects in a bounding rectangle but does not run any queries to load data */
-  template<typename TYPE>
-  struct SimpleRectCache
-  {
-    typedef std::function<bool (const MapLayer *curLayer, const MapLayer *mapLayer)> LayerCompareFunc;
-
-    /*
-     * @param rect bounding rectangle - all objects inside this rectangle are returned
-     * @param mapLayer current map layer
-     * @param lazy if true do not fetch new data but return the old potentially incomplete dataset
-     * @return true after clearing the cache. The caller has to request new data
-     */
-    bool updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
-                     LayerCompareFunc funcSameLayer);
-    void clear();
-    void validate();
-
-    Marble::GeoDataLatLonBox curRect;
-    const MapLayer *curMapLayer = nullptr;
-    QList<TYPE> list;
-  };
+  /* Airport queries set by setAirportQueries or the global ones */
+  AirportQuery *getAirportQuerySim() const;
+  AirportQuery *getAirportQueryNav() const;
 
   void mapObjectByIdentInternal(map::MapSearchResult& result, map::MapObjectTypes type,
                                 const QString& ident, const QString& region, const QString& airport,
                                 const atools::geo::Pos& sortByDistancePos,
                                 float maxDistance, bool airportFromNavDatabase);
 
-  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect,
-                                              atools::sql::SqlQuery *query, bool reverse,
-                                              bool lazy, bool overview);
+  /* Clears airspace cache if filter or altitude have changed */
+  void updateAirspaceFilter(map::MapAirspaceFilter filter, float flightPlanAltitude);
+
+  /* Get load functions with all query parameters bound */
+  MapTileCache<map::MapAirport>::LoadFunc airportLoadFunc(const MapLayer *mapLayer);
+  MapTileCache<map::MapAirspace>::LoadFunc airspaceLoadFunc(map::MapAirspaceFilter filter, float flightPlanAltitude);
+
+  /* Load all objects of one tile from the database */
+  void loadAirports(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapAirport>& airports,
+                    atools::sql::SqlQuery *query, bool overview, int minRunwayLength);
+  void loadWaypoints(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapWaypoint>& waypoints);
+  void loadVors(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapVor>& vors);
+  void loadNdbs(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapNdb>& ndbs);
+  void loadMarkers(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapMarker>& markers);
+  void loadIls(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapIls>& ils);
+  void loadAirways(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapAirway>& airways);
+  void loadAirspaces(const Marble::GeoDataLatLonBox& tileRect, QVector<map::MapAirspace>& airspaces,
+                     atools::sql::SqlQuery *query, int alt, const QStringList& typeStrings);
 
   void bindCoordinatePointInRect(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
                                  const QString& prefix = QString());
 
-  QList<Marble::GeoDataLatLonBox> splitAtAntiMeridian(const Marble::GeoDataLatLonBox& rect);
+  static Marble::GeoDataLatLonBox inflateRect(const Marble::GeoDataLatLonBox& rect);
 
-  static void inflateRect(Marble::GeoDataLatLonBox& rect);
+  /* Limit the objects merged from all tiles to queryMaxRows */
+  template<typename TYPE>
+  static void limitList(map::MapObjectList<TYPE>& list)
+  {
+    if(list.size() > queryMaxRows)
+      list.remove(queryMaxRows, list.size() - queryMaxRows);
+  }
 
   bool runwayCompare(const map::MapRunway& r1, const map::MapRunway& r2);
 
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *db, *dbNav;
 
-  /* Simple bounding rectangle caches */
-  SimpleRectCache<map::MapAirport> airportCache;
-  SimpleRectCache<map::MapWaypoint> waypointCache;
-  SimpleRectCache<map::MapVor> vorCache;
-  SimpleRectCache<map::MapNdb> ndbCache;
-  SimpleRectCache<map::MapMarker> markerCache;
-  SimpleRectCache<map::MapIls> ilsCache;
-  SimpleRectCache<map::MapAirway> airwayCache;
-  SimpleRectCache<map::MapAirspace> airspaceCache;
+  /* Tiled spatial caches */
+  MapTileCache<map::MapAirport> airportCache;
+  MapTileCache<map::MapWaypoint> waypointCache;
+  MapTileCache<map::MapVor> vorCache;
+  MapTileCache<map::MapNdb> ndbCache;
+  MapTileCache<map::MapMarker> markerCache;
+  MapTileCache<map::MapIls> ilsCache;
+  MapTileCache<map::MapAirway> airwayCache;
+  MapTileCache<map::MapAirspace> airspaceCache;
   map::MapAirspaceFilter lastAirspaceFilter = {map::AIRSPACE_NONE, map::AIRSPACE_FLAG_NONE};
   float lastFlightplanAltitude = 0.f;
 
   /* ID/object caches */
   QCache<int, QList<map::MapRunway> > runwayOverwiewCache;
-  QCache<int, atools::geo::LineString> airspaceLineCache;
+  /* Key is boundary id and detail level */
+  QCache<quint64, atools::geo::LineString> airspaceLineCache;
 
   static int queryMaxRows;
 
@@ -251,7 +341,7 @@ private:
                         *airwayByRectQuery = nullptr, *airspaceByRectQuery = nullptr,
                         *airspaceByRectBelowAltQuery = nullptr, *airspaceByRectAboveAltQuery = nullptr,
                         *airspaceByRectAtAltQuery = nullptr,
-                        *airspaceLinesByIdQuery = nullptr;
+                        *airspaceLinesByIdQuery = nullptr, *airspaceLodLinesByIdQuery = nullptr;
 
   atools::sql::SqlQuery *vorByIdentQuery = nullptr, *ndbByIdentQuery = nullptr, *waypointByIdentQuery = nullptr,
                         *ilsByIdentQuery = nullptr;
@@ -265,48 +355,8 @@ private:
                         *airspaceByIdQuery = nullptr, *airwayWaypointByIdentQuery = nullptr,
                         *airwayWaypointsQuery = nullptr,
                         *airwayByNameQuery = nullptr;
-};
-
-// ---------------------------------------------------------------------------------
-template<typename TYPE>
-bool MapQuery::SimpleRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
-                                                  bool lazy, LayerCompareFunc funcSameLayer)
-{
-  if(lazy)
-    // Nothing changed11
-    return false;
-
-  // Store bounding rectangle and inflate it
-  Marble::GeoDataLatLonBox cur(curRect);
-  MapQuery::inflateRect(cur);
-
-  if(curRect.isEmpty() || !cur.contains(rect) || !funcSameLayer(curMapLayer, mapLayer))
-  {
-    // Rectangle not covered by loaded data or new layer selected
-    list.clear();
-    curRect = rect;
-    curMapLayer = mapLayer;
-    return true;
-  }
-  return false;
-}
 
-template<typename TYPE>
-void MapQuery::SimpleRectCache<TYPE>::validate()
-{
-  if(list.size() >= queryMaxRows)
-  {
-    curRect.clear();
-    curMapLayer = nullptr;
-  }
-}
-
-template<typename TYPE>
-void MapQuery::SimpleRectCache<TYPE>::clear()
-{
-  list.clear();
-  curRect.clear();
-  curMapLayer = nullptr;
-}
+  AirportQuery *airportQuerySim = nullptr, *airportQueryNav = nullptr;
+};
 
 #endif // LITTLENAVMAP_MAPQUERY_H
@@ -0,0 +1,287 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "query/mapqueryprefetch.h"
+
+#include "common/constants.h"
+#include "navapp.h"
+#include "settings/settings.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+#include "atools.h"
+
+#include <QDebug>
+
+#include <cmath>
+
+using atools::sql::SqlDatabase;
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+static const QString DATABASE_NAME_SIM("LNMPREFETCHSIM");
+static const QString DATABASE_NAME_NAV("LNMPREFETCHNAV");
+
+/* Shift rectangle by degrees. Longitude wraps around at the anti-meridian. Returns an empty box if
+ * the rectangle is moved beyond the poles. */
+static GeoDataLatLonBox shiftRect(const GeoDataLatLonBox& rect, double lonXDeg, double latYDeg)
+{
+  double north = std::min(rect.north(GeoDataCoordinates::Degree) + latYDeg, 90.);
+  double south = std::max(rect.south(GeoDataCoordinates::Degree) + latYDeg, -90.);
+  if(north <= south)
+    return GeoDataLatLonBox();
+
+  double west = std::fmod(rect.west(GeoDataCoordinates::Degree) + lonXDeg + 540., 360.) - 180.;
+  double east = std::fmod(rect.east(GeoDataCoordinates::Degree) + lonXDeg + 540., 360.) - 180.;
+
+  // qreal north, qreal south, qreal east, qreal west
+  return GeoDataLatLonBox(north, south, east, west, GeoDataCoordinates::Degree);
+}
+
+// ---------------------------------------------------------------------------------
+MapQueryPrefetchWorker::MapQueryPrefetchWorker(const QAtomicInt& latestRequestId)
+  : latestRequest(latestRequestId)
+{
+
+}
+
+MapQueryPrefetchWorker::~MapQueryPrefetchWorker()
+{
+  deInitQueries();
+}
+
+void MapQueryPrefetchWorker::initQueries(const QString& simDbFile, const QString& navDbFile)
+{
+  deInitQueries();
+
+  try
+  {
+    openDatabase(dbSim, DATABASE_NAME_SIM, simDbFile);
+    openDatabase(dbNav, DATABASE_NAME_NAV, navDbFile);
+
+    mapQuery = new MapQuery(nullptr, dbSim, dbNav);
+    mapQuery->initQueries();
+    mapQuery->setRecordLoadedTiles(true);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open prefetch database" << e.what();
+    deInitQueries();
+  }
+}
+
+void MapQueryPrefetchWorker::deInitQueries()
+{
+  delete mapQuery;
+  mapQuery = nullptr;
+
+  closeDatabase(dbSim, DATABASE_NAME_SIM);
+  closeDatabase(dbNav, DATABASE_NAME_NAV);
+}
+
+void MapQueryPrefetchWorker::openDatabase(SqlDatabase *& db, const QString& name, const QString& file)
+{
+  // Assign before opening so that deInitQueries() can clean up if open throws
+  SqlDatabase::addDatabase("QSQLITE", name);
+  db = new SqlDatabase(name);
+  db->setDatabaseName(file);
+  db->setReadonly();
+  db->open({"PRAGMA cache_size=-10000", "PRAGMA synchronous=OFF"});
+}
+
+void MapQueryPrefetchWorker::closeDatabase(SqlDatabase *& db, const QString& name)
+{
+  if(db != nullptr)
+  {
+    if(db->isOpen())
+      db->close();
+    delete db;
+    db = nullptr;
+
+    // Remove the named connection to avoid keeping a stale connection around after switching databases
+    SqlDatabase::removeDatabase(name);
+  }
+}
+
+void MapQueryPrefetchWorker::prefetch(const MapPrefetchRequest& request)
+{
+  if(mapQuery == nullptr || request.mapLayer == nullptr || request.mapLayerEffective == nullptr)
+    return;
+
+  for(const GeoDataLatLonBox& rect : request.rects)
+  {
+    if(latestRequest.load() != request.id)
+      // A newer request is waiting
+      break;
+
+    try
+    {
+      mapQuery->prefetch(rect, request.viewRect, request.mapLayer, request.mapLayerEffective, request.types,
+                         request.airspaceFilter, request.flightPlanAltitude);
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Prefetch failed" << e.what();
+      break;
+    }
+
+    // Send tiles after each rectangle to have the most important ones available early
+    MapQueryTiles tiles = mapQuery->takeLoadedTiles();
+    if(!tiles.isEmpty())
+      emit tilesLoaded(request.id, tiles);
+  }
+}
+
+// ---------------------------------------------------------------------------------
+MapQueryPrefetch::MapQueryPrefetch(QObject *parent)
+  : QObject(parent)
+{
+  qRegisterMetaType<MapPrefetchRequest>();
+  qRegisterMetaType<MapQueryTiles>();
+
+  enabled = atools::settings::Settings::instance().getAndStoreValue(lnm::SETTINGS_MAPQUERY + "Prefetch",
+                                                                     true).toBool();
+
+  worker = new MapQueryPrefetchWorker(latestRequestId);
+  worker->moveToThread(&thread);
+
+  // Both connections are queued since sender and receiver live in different threads
+  connect(this, &MapQueryPrefetch::prefetchRequested, worker, &MapQueryPrefetchWorker::prefetch);
+  connect(worker, &MapQueryPrefetchWorker::tilesLoaded, this, &MapQueryPrefetch::workerTilesLoaded);
+
+  thread.setObjectName("MapQueryPrefetch");
+  thread.start(QThread::LowPriority);
+}
+
+MapQueryPrefetch::~MapQueryPrefetch()
+{
+  deInitQueries();
+  thread.quit();
+  thread.wait();
+  delete worker;
+}
+
+void MapQueryPrefetch::initQueries()
+{
+  if(!enabled)
+    return;
+
+  deInitQueries();
+
+  // Ignore all tiles from requests sent before
+  firstValidRequestId = latestRequestId.load() + 1;
+
+  // Block until the connections are open to avoid concurrent access to the settings
+  QMetaObject::invokeMethod(worker, "initQueries", Qt::BlockingQueuedConnection,
+                            Q_ARG(QString, NavApp::getDatabaseSim()->databaseName()),
+                            Q_ARG(QString, NavApp::getDatabaseNav()->databaseName()));
+  initialized = true;
+}
+
+void MapQueryPrefetch::deInitQueries()
+{
+  if(!initialized)
+    return;
+
+  // Cancel running request
+  latestRequestId.fetchAndAddOrdered(1);
+
+  QMetaObject::invokeMethod(worker, "deInitQueries", Qt::BlockingQueuedConnection);
+
+  initialized = false;
+  lastRequest = MapPrefetchRequest();
+  lastViewRect = GeoDataLatLonBox();
+}
+
+void MapQueryPrefetch::prefetch(const Marble::GeoDataLatLonBox& viewRect, const MapLayer *mapLayer,
+                                const MapLayer *mapLayerEffective, map::MapObjectTypes types,
+                                map::MapAirspaceFilter airspaceFilter, float flightPlanAltitude)
+{
+  if(!initialized || viewRect.isEmpty())
+    return;
+
+  if(viewRect == lastViewRect && mapLayer == lastRequest.mapLayer &&
+     mapLayerEffective == lastRequest.mapLayerEffective && types == lastRequest.types &&
+     airspaceFilter.types == lastRequest.airspaceFilter.types &&
+     airspaceFilter.flags == lastRequest.airspaceFilter.flags &&
+     atools::almostEqual(flightPlanAltitude, lastRequest.flightPlanAltitude))
+    // Nothing changed
+    return;
+
+  MapPrefetchRequest request;
+  request.id = latestRequestId.fetchAndAddOrdered(1) + 1;
+  request.mapLayer = mapLayer;
+  request.mapLayerEffective = mapLayerEffective;
+  request.types = types;
+  request.airspaceFilter = airspaceFilter;
+  request.flightPlanAltitude = flightPlanAltitude;
+
+  // Visible area is loaded synchronously by the GUI thread - prefetch only motion direction and ring
+  request.viewRect = viewRect;
+
+  double width = viewRect.width(GeoDataCoordinates::Degree), height = viewRect.height(GeoDataCoordinates::Degree);
+
+  // No ring if the view covers most of the globe already
+  if(width < 180.)
+  {
+    // Direction of motion - one view size ahead
+    if(!lastViewRect.isEmpty())
+    {
+      double dx = viewRect.center().longitude(GeoDataCoordinates::Degree) -
+                  lastViewRect.center().longitude(GeoDataCoordinates::Degree);
+      double dy = viewRect.center().latitude(GeoDataCoordinates::Degree) -
+                  lastViewRect.center().latitude(GeoDataCoordinates::Degree);
+
+      // Ignore wrap at the anti-meridian
+      if(std::abs(dx) < 180.)
+      {
+        double len = std::sqrt(dx * dx + dy * dy);
+        if(len > 0.)
+        {
+          GeoDataLatLonBox ahead = shiftRect(viewRect, dx / len * width, dy / len * height);
+          if(!ahead.isEmpty())
+            request.rects.append(ahead);
+        }
+      }
+    }
+
+    // Ring of eight neighbours
+    for(int y = -1; y <= 1; y++)
+    {
+      for(int x = -1; x <= 1; x++)
+      {
+        if(x != 0 || y != 0)
+        {
+          GeoDataLatLonBox neighbour = shiftRect(viewRect, x * width, y * height);
+          if(!neighbour.isEmpty())
+            request.rects.append(neighbour);
+        }
+      }
+    }
+  }
+
+  lastRequest = request;
+  lastViewRect = viewRect;
+
+  emit prefetchRequested(request);
+}
+
+void MapQueryPrefetch::workerTilesLoaded(int requestId, const MapQueryTiles& tiles)
+{
+  // Drop tiles of requests sent before the database was reopened
+  if(initialized && requestId >= firstValidRequestId)
+    emit tilesLoaded(tiles);
+}
@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPQUERYPREFETCH_H
+#define LITTLENAVMAP_MAPQUERYPREFETCH_H
+
+#include "query/mapquery.h"
+
+#include <QAtomicInt>
+#include <QThread>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/* Rectangles and parameters for one prefetch run */
+struct MapPrefetchRequest
+{
+  /* Increasing request number. A worker stops processing a request as soon as a newer one arrives. */
+  int id = 0;
+
+  /* Rectangles in order of priority */
+  QList<Marble::GeoDataLatLonBox> rects;
+
+  /* Visible area which is loaded by the GUI thread. Tiles covering it are not prefetched. */
+  Marble::GeoDataLatLonBox viewRect;
+
+  const MapLayer *mapLayer = nullptr, *mapLayerEffective = nullptr;
+  map::MapObjectTypes types = map::NONE;
+  map::MapAirspaceFilter airspaceFilter = {map::AIRSPACE_NONE, map::AIRSPACE_FLAG_NONE};
+  float flightPlanAltitude = 0.f;
+};
+
+Q_DECLARE_METATYPE(MapPrefetchRequest);
+
+/*
+ * Runs in the prefetch thread. Uses its own read only database connections and an own map query instance
+ * which records all loaded tiles.
+ */
+class MapQueryPrefetchWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  MapQueryPrefetchWorker(const QAtomicInt& latestRequestId);
+  virtual ~MapQueryPrefetchWorker();
+
+  /* Open database connections and create the map query. Has to be called in the worker thread. */
+  Q_INVOKABLE void initQueries(const QString& simDbFile, const QString& navDbFile);
+
+  /* Delete map query and close database connections. Has to be called in the worker thread. */
+  Q_INVOKABLE void deInitQueries();
+
+  /* Load all tiles of the request and emit tilesLoaded after each rectangle */
+  void prefetch(const MapPrefetchRequest& request);
+
+signals:
+  void tilesLoaded(int requestId, const MapQueryTiles& tiles);
+
+private:
+  void openDatabase(atools::sql::SqlDatabase *& db, const QString& name, const QString& file);
+  void closeDatabase(atools::sql::SqlDatabase *& db, const QString& name);
+
+  atools::sql::SqlDatabase *dbSim = nullptr, *dbNav = nullptr;
+  MapQuery *mapQuery = nullptr;
+  const QAtomicInt& latestRequest;
+};
+
+/*
+ * Prefetches map objects in a background thread for the ring of tiles around the current viewport and for
+ * the direction of motion. Loaded tiles are delivered by signal and have to be inserted into the map query
+ * of the GUI thread which can then serve lazy paint requests without blocking on SQL.
+ */
+class MapQueryPrefetch :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  MapQueryPrefetch(QObject *parent);
+  virtual ~MapQueryPrefetch();
+
+  /* Open own database connections on the current database files. Blocks until done. */
+  void initQueries();
+
+  /* Stop any running request and close database connections. Blocks until done. */
+  void deInitQueries();
+
+  /*
+   * Start prefetching around the viewport. Does nothing if rectangle and parameters are the same as for
+   * the last call. A running request is cancelled.
+   */
+  void prefetch(const Marble::GeoDataLatLonBox& viewRect, const MapLayer *mapLayer,
+                const MapLayer *mapLayerEffective, map::MapObjectTypes types,
+                map::MapAirspaceFilter airspaceFilter, float flightPlanAltitude);
+
+  bool isEnabled() const
+  {
+    return enabled;
+  }
+
+signals:
+  /* Tiles loaded in the background. Sent in the GUI thread. */
+  void tilesLoaded(const MapQueryTiles& tiles);
+
+  /* Internal - passes a request to the worker thread */
+  void prefetchRequested(const MapPrefetchRequest& request);
+
+private:
+  void workerTilesLoaded(int requestId, const MapQueryTiles& tiles);
+
+  QThread thread;
+  MapQueryPrefetchWorker *worker = nullptr;
+  QAtomicInt latestRequestId;
+  int firstValidRequestId = 0;
+  bool enabled = false, initialized = false;
+
+  /* Last request to detect motion and avoid duplicate requests */
+  MapPrefetchRequest lastRequest;
+  Marble::GeoDataLatLonBox lastViewRect;
+};
+
+#endif // LITTLENAVMAP_MAPQUERYPREFETCH_H
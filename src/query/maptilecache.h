@@ -0,0 +1,416 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPTILECACHE_H
+#define LITTLENAVMAP_MAPTILECACHE_H
+
+#include "common/mapobjectlist.h"
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <marble/GeoDataLatLonBox.h>
+
+class MapLayer;
+
+/* Objects of one tile which can be passed between caches, e.g. from a prefetching thread */
+template<typename TYPE>
+struct MapTile
+{
+  /* Any layer of the layer class */
+  const MapLayer *layer;
+  int level, x, y;
+  QVector<TYPE> objects;
+};
+
+/* Tile hits, misses and time spent in load functions since the last reset */
+struct MapTileCacheStatistics
+{
+  int hits = 0, misses = 0;
+  qint64 loadTimeNs = 0;
+
+  MapTileCacheStatistics& operator+=(const MapTileCacheStatistics& other)
+  {
+    hits += other.hits;
+    misses += other.misses;
+    loadTimeNs += other.loadTimeNs;
+    return *this;
+  }
+};
+
+/*
+ * Spatial cache that keeps map objects in tiles of a regular latitude/longitude grid.
+ *
+ * Tiles are keyed by zoom class and tile x/y coordinates. The zoom class consists of the layer class, i.e. all
+ * layers having the same query parameters, and the tile level which is derived from the size of the requested
+ * rectangle. Tile size is 2^level degrees.
+ *
+ * Least recently used tiles are evicted if the number of cached objects exceeds the budget.
+ * The cache does not run any queries itself but calls the load function for each missing tile.
+ */
+template<typename TYPE>
+class MapTileCache
+{
+public:
+  typedef std::function<bool (const MapLayer *curLayer, const MapLayer *mapLayer)> LayerCompareFunc;
+  typedef std::function<void (const Marble::GeoDataLatLonBox& tileRect, QVector<TYPE>& objects)> LoadFunc;
+
+  MapTileCache()
+  {
+    tiles.setMaxCost(50000);
+  }
+
+  /*
+   * Collect all objects of the tiles covering rect into list and load missing tiles.
+   *
+   * @param rect bounding rectangle - all tiles overlapping this rectangle are returned
+   * @param mapLayer current map layer
+   * @param lazy if true do not load missing tiles and return the potentially incomplete dataset
+   * @param funcSameLayer returns true if both layers need the same query
+   * @param funcLoad loads all objects for a tile rectangle
+   * @return true if list was rebuilt. The caller has to do sorting in this case.
+   */
+  bool updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
+                   LayerCompareFunc funcSameLayer, LoadFunc funcLoad);
+
+  /* Load all missing tiles covering rect but do not touch list. Tiles covering excludeRect are skipped.
+   * Returns false if all tiles were present. */
+  bool loadTiles(const Marble::GeoDataLatLonBox& rect, const Marble::GeoDataLatLonBox& excludeRect,
+                 const MapLayer *mapLayer, LayerCompareFunc funcSameLayer, LoadFunc funcLoad);
+
+  /* Insert a tile loaded elsewhere if not already present.
+   * @return true if the tile is needed for list. The next call to updateCache will rebuild list then. */
+  bool insertTile(const MapTile<TYPE>& tile, LayerCompareFunc funcSameLayer);
+
+  /* Keep a copy of all tiles loaded from now on. Get them with takeLoadedTiles. */
+  void setRecordLoadedTiles(bool value)
+  {
+    recordLoadedTiles = value;
+  }
+
+  /* Get all tiles loaded since last call and clear the internal list */
+  QVector<MapTile<TYPE> > takeLoadedTiles()
+  {
+    QVector<MapTile<TYPE> > retval;
+    retval.swap(loadedTiles);
+    return retval;
+  }
+
+  /* Remove all tiles and objects */
+  void clear();
+
+  /* Maximum number of objects kept in all tiles */
+  void setMaxObjects(int value)
+  {
+    tiles.setMaxCost(value);
+  }
+
+  const MapTileCacheStatistics& getStatistics() const
+  {
+    return statistics;
+  }
+
+  void resetStatistics()
+  {
+    statistics = MapTileCacheStatistics();
+  }
+
+  /* Objects of all tiles covering the last requested rectangle without duplicates */
+  map::MapObjectList<TYPE> list;
+
+private:
+  int layerClass(const MapLayer *mapLayer, LayerCompareFunc funcSameLayer);
+  static int tileLevel(const Marble::GeoDataLatLonBox& rect);
+  static QVector<quint64> tileKeys(const Marble::GeoDataLatLonBox& rect, int layerCls, int level);
+  void loadTile(quint64 key, int layerCls, int level, LoadFunc funcLoad, QVector<TYPE>& objects);
+  static Marble::GeoDataLatLonBox tileRect(int level, int x, int y);
+
+  static quint64 tileKey(int layerCls, int level, int x, int y)
+  {
+    return (static_cast<quint64>(layerCls) << 40) | (static_cast<quint64>(level - MIN_LEVEL) << 32) |
+           (static_cast<quint64>(y) << 16) | static_cast<quint64>(x);
+  }
+
+  static int tileX(quint64 key)
+  {
+    return static_cast<int>(key & 0xffff);
+  }
+
+  static int tileY(quint64 key)
+  {
+    return static_cast<int>((key >> 16) & 0xffff);
+  }
+
+  /* Smallest tile is 1/8 degree and largest is 64 degree */
+  static Q_DECL_CONSTEXPR int MIN_LEVEL = -3;
+  static Q_DECL_CONSTEXPR int MAX_LEVEL = 6;
+
+  /* Aim for this number of tiles across the larger side of the rectangle */
+  static Q_DECL_CONSTEXPR double TILES_PER_RECT = 4.;
+
+  /* Cost is the number of objects in the tile */
+  QCache<quint64, QVector<TYPE> > tiles;
+
+  /* Tiles having more objects than the cache can hold. Kept only while in list to avoid loading them again
+   * on every update. */
+  QHash<quint64, QVector<TYPE> > largeTiles;
+
+  /* Keys of large tiles loaded by loadTiles which are not kept since list is not used there */
+  QSet<quint64> largeTileKeys;
+
+  /* Representative layer for each layer class */
+  QVector<const MapLayer *> layerClasses;
+
+  /* Keys of the tiles in list and flag indicating if all were available */
+  QVector<quint64> curKeys;
+  bool curComplete = false;
+
+  bool recordLoadedTiles = false;
+  QVector<MapTile<TYPE> > loadedTiles;
+
+  MapTileCacheStatistics statistics;
+};
+
+// ---------------------------------------------------------------------------------
+template<typename TYPE>
+Q_DECL_CONSTEXPR int MapTileCache<TYPE>::MIN_LEVEL;
+
+template<typename TYPE>
+Q_DECL_CONSTEXPR int MapTileCache<TYPE>::MAX_LEVEL;
+
+template<typename TYPE>
+bool MapTileCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
+                                     LayerCompareFunc funcSameLayer, LoadFunc funcLoad)
+{
+  int cls = layerClass(mapLayer, funcSameLayer);
+  int level = tileLevel(rect);
+  QVector<quint64> keys = tileKeys(rect, cls, level);
+
+  if(keys == curKeys && (curComplete || lazy))
+  {
+    // Same tiles as before and nothing to load
+    if(curComplete)
+      statistics.hits += keys.size();
+    return false;
+  }
+
+  list.clear();
+  curKeys = keys;
+  curComplete = true;
+
+  // Drop large tiles which are not needed anymore
+  for(auto it = largeTiles.begin(); it != largeTiles.end();)
+  {
+    if(keys.contains(it.key()))
+      ++it;
+    else
+      it = largeTiles.erase(it);
+  }
+
+  // Objects can be part of more than one tile
+  QSet<int> ids;
+  for(quint64 key : keys)
+  {
+    QVector<TYPE> objects;
+    QVector<TYPE> *tile = tiles.object(key);
+    if(tile != nullptr)
+    {
+      objects = *tile;
+      statistics.hits++;
+    }
+    else if(largeTiles.contains(key))
+    {
+      objects = largeTiles.value(key);
+      statistics.hits++;
+    }
+    else if(lazy)
+    {
+      curComplete = false;
+      statistics.misses++;
+      continue;
+    }
+    else
+    {
+      loadTile(key, cls, level, funcLoad, objects);
+      if(objects.size() > tiles.maxCost())
+        largeTiles.insert(key, objects);
+    }
+
+    for(const TYPE& obj : objects)
+    {
+      if(!ids.contains(obj.id))
+      {
+        list.append(obj);
+        ids.insert(obj.id);
+      }
+    }
+  }
+  return true;
+}
+
+template<typename TYPE>
+bool MapTileCache<TYPE>::loadTiles(const Marble::GeoDataLatLonBox& rect, const Marble::GeoDataLatLonBox& excludeRect,
+                                   const MapLayer *mapLayer, LayerCompareFunc funcSameLayer, LoadFunc funcLoad)
+{
+  int cls = layerClass(mapLayer, funcSameLayer);
+  int level = tileLevel(rect);
+
+  QVector<quint64> excludeKeys;
+  if(!excludeRect.isEmpty())
+    excludeKeys = tileKeys(excludeRect, cls, level);
+
+  bool loaded = false;
+  for(quint64 key : tileKeys(rect, cls, level))
+  {
+    if(!tiles.contains(key) && !largeTileKeys.contains(key) && !excludeKeys.contains(key))
+    {
+      QVector<TYPE> objects;
+      loadTile(key, cls, level, funcLoad, objects);
+      loaded = true;
+
+      if(objects.size() > tiles.maxCost())
+        largeTileKeys.insert(key);
+    }
+  }
+  return loaded;
+}
+
+template<typename TYPE>
+bool MapTileCache<TYPE>::insertTile(const MapTile<TYPE>& tile, LayerCompareFunc funcSameLayer)
+{
+  quint64 key = tileKey(layerClass(tile.layer, funcSameLayer), tile.level, tile.x, tile.y);
+  if(tiles.contains(key) || largeTiles.contains(key))
+    return false;
+
+  if(tile.objects.size() > tiles.maxCost())
+  {
+    // Too large for the cache - keep only if currently needed for list
+    if(!curKeys.contains(key))
+      return false;
+    largeTiles.insert(key, tile.objects);
+  }
+  else
+    tiles.insert(key, new QVector<TYPE>(tile.objects), std::max(tile.objects.size(), 1));
+
+  if(curKeys.contains(key))
+  {
+    // Force rebuild of list on next update
+    curKeys.clear();
+    return true;
+  }
+  return false;
+}
+
+template<typename TYPE>
+void MapTileCache<TYPE>::loadTile(quint64 key, int layerCls, int level, LoadFunc funcLoad, QVector<TYPE>& objects)
+{
+  QElapsedTimer timer;
+  timer.start();
+  funcLoad(tileRect(level, tileX(key), tileY(key)), objects);
+  statistics.loadTimeNs += timer.nsecsElapsed();
+  statistics.misses++;
+
+  // Cache would delete a large tile immediately - caller has to keep it
+  if(objects.size() <= tiles.maxCost())
+    // Insert a copy since the cache might still delete the object
+    tiles.insert(key, new QVector<TYPE>(objects), std::max(objects.size(), 1));
+
+  if(recordLoadedTiles)
+    loadedTiles.append({layerClasses.at(layerCls), level, tileX(key), tileY(key), objects});
+}
+
+template<typename TYPE>
+void MapTileCache<TYPE>::clear()
+{
+  list.clear();
+  tiles.clear();
+  largeTiles.clear();
+  largeTileKeys.clear();
+  layerClasses.clear();
+  loadedTiles.clear();
+  curKeys.clear();
+  curComplete = false;
+}
+
+template<typename TYPE>
+int MapTileCache<TYPE>::layerClass(const MapLayer *mapLayer, LayerCompareFunc funcSameLayer)
+{
+  for(int i = 0; i < layerClasses.size(); i++)
+  {
+    if(funcSameLayer(layerClasses.at(i), mapLayer))
+      return i;
+  }
+  layerClasses.append(mapLayer);
+  return layerClasses.size() - 1;
+}
+
+template<typename TYPE>
+int MapTileCache<TYPE>::tileLevel(const Marble::GeoDataLatLonBox& rect)
+{
+  double size = std::max(rect.width(Marble::GeoDataCoordinates::Degree),
+                         rect.height(Marble::GeoDataCoordinates::Degree)) / TILES_PER_RECT;
+  int level = size > 0. ? static_cast<int>(std::ceil(std::log2(size))) : MIN_LEVEL;
+  return std::min(std::max(level, MIN_LEVEL), MAX_LEVEL);
+}
+
+template<typename TYPE>
+QVector<quint64> MapTileCache<TYPE>::tileKeys(const Marble::GeoDataLatLonBox& rect, int layerCls, int level)
+{
+  using Marble::GeoDataCoordinates;
+
+  double size = std::pow(2., level);
+  int numCols = static_cast<int>(std::ceil(360. / size)), numRows = static_cast<int>(std::ceil(180. / size));
+
+  double west = rect.west(GeoDataCoordinates::Degree), east = rect.east(GeoDataCoordinates::Degree);
+  int firstCol = std::min(std::max(static_cast<int>((west + 180.) / size), 0), numCols - 1);
+  int lastCol = std::min(std::max(static_cast<int>((east + 180.) / size), 0), numCols - 1);
+  int firstRow = std::min(std::max(static_cast<int>((rect.south(GeoDataCoordinates::Degree) + 90.) / size), 0),
+                          numRows - 1);
+  int lastRow = std::min(std::max(static_cast<int>((rect.north(GeoDataCoordinates::Degree) + 90.) / size), 0),
+                         numRows - 1);
+
+  // Wrap around at the anti-meridian
+  int cols = rect.crossesDateLine() || lastCol < firstCol ? numCols - firstCol + lastCol + 1 : lastCol - firstCol + 1;
+
+  QVector<quint64> keys;
+  for(int row = firstRow; row <= lastRow; row++)
+  {
+    for(int col = 0; col < cols; col++)
+      keys.append(tileKey(layerCls, level, (firstCol + col) % numCols, row));
+  }
+  return keys;
+}
+
+template<typename TYPE>
+Marble::GeoDataLatLonBox MapTileCache<TYPE>::tileRect(int level, int x, int y)
+{
+  double size = std::pow(2., level);
+  double west = -180. + x * size, south = -90. + y * size;
+
+  // qreal north, qreal south, qreal east, qreal west
+  return Marble::GeoDataLatLonBox(std::min(south + size, 90.), south, std::min(west + size, 180.), west,
+                                  Marble::GeoDataCoordinates::Degree);
+}
+
+#endif // LITTLENAVMAP_MAPTILECACHE_H
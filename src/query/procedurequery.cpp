@@ -25,6 +25,7 @@
 #include "common/constants.h"
 #include "geo/line.h"
 #include "fs/pln/flightplan.h"
+#include "fs/db/databasemeta.h"
 
 #include "sql/sqlquery.h"
 
@@ -45,11 +46,12 @@ using proc::MapSpeedRestriction;
 
 namespace pln = atools::fs::pln;
 
-ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav)
+ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam,
+                               AirportQuery *airportQueryNavParam)
   : dbNav(sqlDbNav)
 {
-  mapQuery = NavApp::getMapQuery();
-  airportQueryNav = NavApp::getAirportQueryNav();
+  mapQuery = mapQueryParam != nullptr ? mapQueryParam : NavApp::getMapQuery();
+  airportQueryNav = airportQueryNavParam != nullptr ? airportQueryNavParam : NavApp::getAirportQueryNav();
 }
 
 ProcedureQuery::~ProcedureQuery()
@@ -1373,6 +1375,8 @@ void ProcedureQuery::initQueries()
 {
   deInitQueries();
 
+  sidStarInDatabase = atools::fs::db::DatabaseMeta(dbNav).hasSidStar();
+
   approachLegQuery = new SqlQuery(dbNav);
   approachLegQuery->prepare("select * from approach_leg where approach_id = :id "
                             "order by approach_leg_id");
@@ -1982,7 +1986,7 @@ int ProcedureQuery::findProcedureLegId(const map::MapAirport& airport, atools::s
 
 void ProcedureQuery::assignType(proc::MapProcedureLegs& procedure)
 {
-  if(NavApp::hasSidStarInDatabase() && procedure.approachType == "GPS" &&
+  if(sidStarInDatabase && procedure.approachType == "GPS" &&
      (procedure.approachSuffix == "A" || procedure.approachSuffix == "D") && procedure.gpsOverlay)
   {
     if(procedure.approachSuffix == "A")
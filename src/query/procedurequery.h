@@ -49,10 +49,11 @@ class ProcedureQuery :
 
 public:
   /*
-   * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
+   * @param mapQueryParam and airportQueryNavParam are used instead of the global ones from NavApp if not null
    */
-  ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav);
+  ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam = nullptr,
+                 AirportQuery *airportQueryNavParam = nullptr);
   virtual ~ProcedureQuery();
 
   const proc::MapProcedureLeg *getApproachLeg(const map::MapAirport& airport, int approachId, int legId);
@@ -167,6 +168,9 @@ private:
   MapQuery *mapQuery = nullptr;
   AirportQuery *airportQueryNav = nullptr;
 
+  /* Database contains SID and STAR - read from metadata in initQueries */
+  bool sidStarInDatabase = false;
+
   /* Use this value as an id base for the artifical runway legs. Add id of the predecessor to it to be able to find the
    * leg again */
   Q_DECL_CONSTEXPR static int RUNWAY_LEG_ID_BASE = 1000000000;
@@ -26,9 +26,9 @@
 using atools::fs::pln::Flightplan;
 using atools::fs::pln::FlightplanEntry;
 
-FlightplanEntryBuilder::FlightplanEntryBuilder()
+FlightplanEntryBuilder::FlightplanEntryBuilder(MapQuery *mapQueryParam)
 {
-  mapQuery = NavApp::getMapQuery();
+  mapQuery = mapQueryParam != nullptr ? mapQueryParam : NavApp::getMapQuery();
 }
 
 FlightplanEntryBuilder::~FlightplanEntryBuilder()
@@ -55,7 +55,8 @@ class MapQuery;
 class FlightplanEntryBuilder
 {
 public:
-  FlightplanEntryBuilder();
+  /* Uses the global map query from NavApp if mapQueryParam is null */
+  FlightplanEntryBuilder(MapQuery *mapQueryParam = nullptr);
   virtual ~FlightplanEntryBuilder();
 
   void buildFlightplanEntry(const map::MapAirport& airport, atools::fs::pln::FlightplanEntry& entry) const;
@@ -0,0 +1,218 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routebatch.h"
+
+#include "route/routenetworkairway.h"
+#include "route/routenetworkradio.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "exception.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::geo::Pos;
+
+/* Calculates routes until all requests are taken. Each worker has its own database connection and network. */
+class RouteBatchWorker :
+  public QRunnable
+{
+public:
+  RouteBatchWorker(const RouteBatch *routeBatch, int workerIndex, const QVector<rb::RouteBatchRequest>& routeRequests,
+                   rb::RouteBatchResult *routeResults, QAtomicInt& nextRequestIndex, QMutex& networkMutex)
+    : batch(routeBatch), index(workerIndex), requests(routeRequests), results(routeResults),
+    nextIndex(nextRequestIndex), initMutex(networkMutex)
+  {
+  }
+
+  virtual void run() override;
+
+private:
+  void calculateRoutes(SqlDatabase *db);
+  Pos fetchAirportPos(SqlQuery& query, const QString& ident);
+
+  /* Fill all requests not taken yet with the given error message */
+  void failRemaining(const QString& message);
+
+  const RouteBatch *batch;
+  int index;
+  const QVector<rb::RouteBatchRequest>& requests;
+  rb::RouteBatchResult *results; /* Each worker writes only to the slots of its own requests */
+  QAtomicInt& nextIndex;
+  QMutex& initMutex;
+};
+
+void RouteBatchWorker::run()
+{
+  QString connectionName = QString("LNMROUTEBATCH%1").arg(index);
+  SqlDatabase::addDatabase("QSQLITE", connectionName);
+
+  {
+    SqlDatabase db(connectionName);
+    try
+    {
+      db.setDatabaseName(batch->databaseFile);
+      db.setReadonly();
+      db.open();
+
+      calculateRoutes(&db);
+
+      db.close();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "worker" << index << "caught exception" << e.what();
+      failRemaining(e.what());
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "worker" << index << "caught unknown exception";
+      failRemaining("Unknown error");
+    }
+  }
+
+  SqlDatabase::removeDatabase(connectionName);
+}
+
+void RouteBatchWorker::failRemaining(const QString& message)
+{
+  int requestIndex;
+  while((requestIndex = nextIndex.fetchAndAddOrdered(1)) < requests.size())
+  {
+    rb::RouteBatchResult& result = results[requestIndex];
+    result.departureIdent = requests.at(requestIndex).departureIdent;
+    result.destinationIdent = requests.at(requestIndex).destinationIdent;
+    result.found = false;
+    result.error = message;
+  }
+}
+
+void RouteBatchWorker::calculateRoutes(SqlDatabase *db)
+{
+  // Deleted when leaving or on exception
+  QScopedPointer<RouteNetwork> network;
+  {
+    // Load graphs one after the other - landmarks are loaded on first use and serialized by the network
+    QMutexLocker locker(&initMutex);
+    if(batch->mode & nw::ROUTE_RADIONAV)
+      network.reset(new RouteNetworkRadio(db));
+    else
+      network.reset(new RouteNetworkAirway(db));
+    network->setNumLandmarks(batch->numLandmarks);
+    network->setPreloadGraph(batch->preloadGraph);
+  }
+  network->setMode(batch->mode);
+
+  SqlQuery airportQuery(db);
+  airportQuery.prepare("select lonx, laty from airport where ident = :ident");
+
+  int requestIndex;
+  while((requestIndex = nextIndex.fetchAndAddOrdered(1)) < requests.size())
+  {
+    const rb::RouteBatchRequest& request = requests.at(requestIndex);
+    rb::RouteBatchResult& result = results[requestIndex];
+    result.departureIdent = request.departureIdent;
+    result.destinationIdent = request.destinationIdent;
+
+    try
+    {
+      Pos departurePos = fetchAirportPos(airportQuery, request.departureIdent);
+      Pos destinationPos = fetchAirportPos(airportQuery, request.destinationIdent);
+
+      if(!departurePos.isValid())
+        result.error = QString("Departure airport %1 not found").arg(request.departureIdent);
+      else if(!destinationPos.isValid())
+        result.error = QString("Destination airport %1 not found").arg(request.destinationIdent);
+      else
+      {
+        network->resetCacheStatistics();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        RouteFinder routeFinder(network.data());
+        routeFinder.setBidirectional(batch->bidirectional);
+        routeFinder.setUseLandmarks(batch->useLandmarks);
+
+        result.found = routeFinder.calculateRoute(departurePos, destinationPos, batch->altitude);
+        if(result.found)
+          routeFinder.extractRoute(result.route, result.distanceMeter);
+
+        result.timeMicroseconds = timer.nsecsElapsed() / 1000;
+        result.nodesExpanded = routeFinder.getNumNodesExpanded();
+        result.cacheHits = network->getCacheHits();
+        result.cacheMisses = network->getCacheMisses();
+      }
+    }
+    catch(atools::Exception& e)
+    {
+      result.error = e.what();
+    }
+    catch(...)
+    {
+      result.error = "Unknown error";
+    }
+  }
+}
+
+Pos RouteBatchWorker::fetchAirportPos(SqlQuery& query, const QString& ident)
+{
+  Pos pos;
+  query.bindValue(":ident", ident);
+  query.exec();
+  if(query.next())
+    pos = Pos(query.valueFloat("lonx"), query.valueFloat("laty"));
+  query.finish();
+  return pos;
+}
+
+RouteBatch::RouteBatch(const QString& databaseFilename, nw::Modes routeMode)
+  : databaseFile(databaseFilename), mode(routeMode)
+{
+  numThreads = QThread::idealThreadCount();
+}
+
+RouteBatch::~RouteBatch()
+{
+
+}
+
+QVector<rb::RouteBatchResult> RouteBatch::calculate(const QVector<rb::RouteBatchRequest>& requests)
+{
+  QVector<rb::RouteBatchResult> results(requests.size());
+  QAtomicInt nextIndex(0);
+  QMutex initMutex;
+
+  int workers = std::max(1, std::min(numThreads, requests.size()));
+  qDebug() << Q_FUNC_INFO << "routes" << requests.size() << "workers" << workers;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(workers);
+  for(int i = 0; i < workers; i++)
+    pool.start(new RouteBatchWorker(this, i, requests, results.data(), nextIndex, initMutex));
+  pool.waitForDone();
+
+  return results;
+}
@@ -0,0 +1,121 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTEBATCH_H
+#define LITTLENAVMAP_ROUTEBATCH_H
+
+#include "route/routefinder.h"
+
+namespace rb {
+
+/* Departure and destination airport idents for one route */
+struct RouteBatchRequest
+{
+  QString departureIdent, destinationIdent;
+};
+
+/* Result and statistics for one route */
+struct RouteBatchResult
+{
+  QString departureIdent, destinationIdent;
+
+  /* Error message if airports were not found or a database error occured */
+  QString error;
+
+  bool found = false;
+
+  /* Route points excluding departure and destination like RouteFinder::extractRoute */
+  QVector<rf::RouteEntry> route;
+  float distanceMeter = 0.f;
+
+  /* Time for calculation and extraction of the route */
+  qint64 timeMicroseconds = 0;
+
+  /* Nodes expanded by the route finder */
+  int nodesExpanded = 0;
+
+  /* Node cache hits and misses in the route network */
+  int cacheHits = 0, cacheMisses = 0;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(rb::RouteBatchRequest, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(rb::RouteBatchResult, Q_MOVABLE_TYPE);
+
+/*
+ * Calculates many routes between airports without user interface.
+ *
+ * Routes are distributed on a thread pool. Each worker thread opens its own read only connection to the
+ * navigation database and uses its own route network instance which is kept for all routes of the worker.
+ */
+class RouteBatch
+{
+public:
+  /*
+   * @param databaseFilename Navigation database file containing airports and the routing network tables
+   * @param routeMode ROUTE_RADIONAV, ROUTE_VICTOR, ROUTE_JET or ROUTE_VICTOR | ROUTE_JET
+   */
+  RouteBatch(const QString& databaseFilename, nw::Modes routeMode);
+  ~RouteBatch();
+
+  /* Calculate all routes and return results in the same order as the requests. Blocks until all are done. */
+  QVector<rb::RouteBatchResult> calculate(const QVector<rb::RouteBatchRequest>& requests);
+
+  /* Number of worker threads. Default is the ideal thread count. */
+  void setNumThreads(int value)
+  {
+    numThreads = value;
+  }
+
+  /* Options passed to RouteNetwork and RouteFinder */
+  void setPreloadGraph(bool value)
+  {
+    preloadGraph = value;
+  }
+
+  void setNumLandmarks(int value)
+  {
+    numLandmarks = value;
+  }
+
+  void setBidirectional(bool value)
+  {
+    bidirectional = value;
+  }
+
+  void setUseLandmarks(bool value)
+  {
+    useLandmarks = value;
+  }
+
+  /* Use airways for the given altitude in feet. 0 ignores altitude restrictions. */
+  void setAltitude(int value)
+  {
+    altitude = value;
+  }
+
+private:
+  friend class RouteBatchWorker;
+
+  QString databaseFile;
+  nw::Modes mode;
+  int numThreads, numLandmarks = 0, altitude = 0;
+  bool preloadGraph = false, bidirectional = false, useLandmarks = false;
+};
+
+#endif // LITTLENAVMAP_ROUTEBATCH_H
@@ -137,6 +137,18 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
   routeNetworkRadio = new RouteNetworkRadio(NavApp::getDatabaseNav());
   routeNetworkAirway = new RouteNetworkAirway(NavApp::getDatabaseNav());
 
+  // Load the whole network into memory instead of fetching nodes on demand while routing
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  bool preloadGraph = settings.getAndStoreValue(lnm::SETTINGS_ROUTE_NETWORK + "PreloadGraph", false).toBool();
+
+  // Landmarks for the ALT heuristic are only available for the preloaded graph
+  int numLandmarks = settings.getAndStoreValue(lnm::SETTINGS_ROUTE_NETWORK + "Landmarks", 8).toInt();
+  routeNetworkRadio->setNumLandmarks(numLandmarks);
+  routeNetworkAirway->setNumLandmarks(numLandmarks);
+
+  routeNetworkRadio->setPreloadGraph(preloadGraph);
+  routeNetworkAirway->setPreloadGraph(preloadGraph);
+
   // Set up undo/redo framework
   undoStack = new QUndoStack(mainWindow);
   undoStack->setUndoLimit(ROUTE_UNDO_LIMIT);
@@ -1003,7 +1015,8 @@ bool RouteController::exportFlighplanAsGpx(const QString& filename)
 {
   qDebug() << Q_FUNC_INFO << filename;
 
-  const AircraftTrack& aircraftTrack = NavApp::getAircraftTrack();
+  QVector<at::AircraftTrackPos> aircraftTrack;
+  NavApp::getAircraftTrack().getFullTrack(aircraftTrack);
   atools::geo::LineString track;
   QVector<quint32> timestamps;
 
@@ -1230,6 +1243,12 @@ bool RouteController::calculateRouteInternal(RouteFinder *routeFinder, atools::f
   routeFinder->setPreferVorToAirway(OptionData::instance().getFlags() & opts::ROUTE_PREFER_VOR);
   routeFinder->setPreferNdbToAirway(OptionData::instance().getFlags() & opts::ROUTE_PREFER_NDB);
 
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  routeFinder->setBidirectional(settings.getAndStoreValue(lnm::SETTINGS_ROUTE_NETWORK + "Bidirectional",
+                                                          true).toBool());
+  routeFinder->setUseLandmarks(settings.getAndStoreValue(lnm::SETTINGS_ROUTE_NETWORK + "UseLandmarks",
+                                                         true).toBool());
+
   Pos departurePos, destinationPos;
 
   if(calcRange)
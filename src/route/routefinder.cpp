@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "route/routefinder.h"
+#include "route/routelandmarks.h"
 #include "geo/calculations.h"
 #include "atools.h"
 
@@ -24,7 +25,7 @@ using nw::Edge;
 using atools::geo::Pos;
 
 RouteFinder::RouteFinder(RouteNetwork *routeNetwork)
-  : network(routeNetwork), openNodesHeap(5000)
+  : network(routeNetwork), openNodesHeap(5000), backwardOpenNodesHeap(5000)
 {
   closedNodes.reserve(10000);
   nodeCosts.reserve(10000);
@@ -45,7 +46,10 @@ RouteFinder::~RouteFinder()
 bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo::Pos& to, int flownAltitude)
 {
   altitude = flownAltitude;
-  network->addDepartureAndDestinationNodes(from, to);
+  landmarks = useLandmarks ? network->getLandmarks() : nullptr;
+
+  // Edges of the destination node are only needed for the backward search and the landmark bounds
+  network->addDepartureAndDestinationNodes(from, to, bidirectional || landmarks != nullptr);
   Node startNode = network->getDepartureNode();
   Node destNode = network->getDestinationNode();
 
@@ -54,6 +58,32 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
   if(startNode.edges.isEmpty())
     return false;
 
+  if(landmarks != nullptr)
+  {
+    initLandmarkBounds(startNode, departureBounds);
+    initLandmarkBounds(destNode, destinationBounds);
+  }
+
+  bool destinationFound;
+  if(bidirectional)
+    destinationFound = calculateRouteBidirectional(startNode, destNode, numNodesTotal);
+  else
+    destinationFound = calculateRouteUnidirectional(startNode, destNode, numNodesTotal);
+
+  qDebug() << "found" << destinationFound << "bidirectional" << bidirectional
+           << "landmarks" << (landmarks != nullptr)
+           << "heap size" << openNodesHeap.size() << backwardOpenNodesHeap.size()
+           << "close nodes size" << closedNodes.size() << backwardClosedNodes.size();
+
+  qDebug() << "num nodes database" << network->getNumberOfNodesDatabase()
+           << "num nodes cache" << network->getNumberOfNodesCache();
+
+  return destinationFound;
+}
+
+bool RouteFinder::calculateRouteUnidirectional(const nw::Node& startNode, const nw::Node& destNode,
+                                               int numNodesTotal)
+{
   openNodesHeap.push(startNode, 0.f);
   nodeCosts[startNode.id] = 0.f;
   nodeAltRange[startNode.id] = std::make_pair(0, std::numeric_limits<int>::max());
@@ -74,48 +104,128 @@ bool RouteFinder::calculateRoute(const atools::geo::Pos& from, const atools::geo
     // Contains nodes with known shortest path
     closedNodes.insert(currentNode.id);
 
-    if(closedNodes.size() > numNodesTotal / 2)
-      // If we read too much nodes routing will fail
+    if(closedNodes.size() > numNodesTotal)
+      // All nodes were visited - only a safety net since the heap runs empty before
       break;
 
     // Work on successors
     expandNode(currentNode, destNode);
   }
 
-  qDebug() << "found" << destinationFound << "heap size" << openNodesHeap.size()
-           << "close nodes size" << closedNodes.size();
+  return destinationFound;
+}
 
-  qDebug() << "num nodes database" << network->getNumberOfNodesDatabase()
-           << "num nodes cache" << network->getNumberOfNodesCache();
+/* Runs a forward search from departure and a backward search from destination. Expands the side with the smaller
+ * open heap first and stops if the best possible costs of the next node exceed the costs of the best
+ * connection found so far. */
+bool RouteFinder::calculateRouteBidirectional(const nw::Node& startNode, const nw::Node& destNode,
+                                              int numNodesTotal)
+{
+  // Remember edges of the virtual departure node since other nodes do not have edges back to it
+  departureEdgeLength.clear();
+  for(const Edge& edge : startNode.edges)
+    departureEdgeLength.insert(edge.toNodeId, edge.lengthMeter);
 
-  return destinationFound;
+  meetingNodeId = -1;
+  meetingCosts = std::numeric_limits<float>::max();
+
+  openNodesHeap.push(startNode, 0.f);
+  nodeCosts[startNode.id] = 0.f;
+  nodeAltRange[startNode.id] = std::make_pair(0, std::numeric_limits<int>::max());
+
+  backwardOpenNodesHeap.push(destNode, 0.f);
+  backwardNodeCosts[destNode.id] = 0.f;
+  backwardNodeAltRange[destNode.id] = std::make_pair(0, std::numeric_limits<int>::max());
+
+  Node currentNode;
+  while(!openNodesHeap.isEmpty() && !backwardOpenNodesHeap.isEmpty())
+  {
+    if(openNodesHeap.size() <= backwardOpenNodesHeap.size())
+    {
+      openNodesHeap.pop(currentNode);
+
+      if(nodeCosts.value(currentNode.id) + costEstimate(currentNode, destNode) >= meetingCosts)
+        // Cannot find a cheaper connection anymore
+        break;
+
+      closedNodes.insert(currentNode.id);
+      if(currentNode.id != destNode.id)
+        expandNode(currentNode, destNode);
+    }
+    else
+    {
+      backwardOpenNodesHeap.pop(currentNode);
+
+      if(backwardNodeCosts.value(currentNode.id) + costEstimate(currentNode, startNode) >= meetingCosts)
+        break;
+
+      backwardClosedNodes.insert(currentNode.id);
+      if(currentNode.id != startNode.id)
+        expandNodeBackward(currentNode, startNode);
+    }
+
+    if(closedNodes.size() + backwardClosedNodes.size() > numNodesTotal)
+      // All nodes were visited by both searches together - only a safety net since the heaps run empty before
+      break;
+  }
+
+  if(meetingNodeId == -1)
+    return false;
+
+  // Collect forward path to avoid loops when joining
+  QSet<int> forwardPath;
+  for(int id = meetingNodeId; id != -1; id = nodePredecessor.value(id, -1))
+    forwardPath.insert(id);
+
+  // Append backward path to the forward predecessors so extractRoute can walk from the destination
+  int id = meetingNodeId;
+  while(id != destNode.id)
+  {
+    int next = backwardNodeSuccessor.value(id, -1);
+    if(next == -1 || forwardPath.contains(next))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot join forward and backward path at" << id;
+      return false;
+    }
+
+    nodePredecessor[next] = id;
+    nodeAirwayId[next] = backwardNodeAirwayId.value(id, -1);
+    forwardPath.insert(next);
+    id = next;
+  }
+  return true;
 }
 
 void RouteFinder::extractRoute(QVector<rf::RouteEntry>& route, float& distanceMeter)
 {
   distanceMeter = 0.f;
-  route.reserve(500);
 
-  // Build route
-  nw::Node pred = network->getDestinationNode();
-  while(pred.id != -1)
+  // Collect node ids from destination to departure
+  QVector<int> nodeIds;
+  nodeIds.reserve(500);
+  for(int id = network->getDestinationNode().id; id != -1; id = nodePredecessor.value(id, -1))
+    nodeIds.append(id);
+
+  // Get all nodes in one go - nav id and type are already loaded with the nodes
+  QVector<nw::Node> nodes;
+  network->getNodes(nodeIds, nodes);
+
+  // Build route in reverse order
+  route.reserve(route.size() + nodes.size());
+  for(int i = nodes.size() - 1; i >= 0; i--)
   {
-    int navId;
-    nw::NodeType type;
-    network->getNavIdAndTypeForNode(pred.id, navId, type);
+    const nw::Node& node = nodes.at(i);
 
-    if(type != nw::DEPARTURE && type != nw::DESTINATION)
+    if(node.type != nw::DEPARTURE && node.type != nw::DESTINATION)
     {
       rf::RouteEntry entry;
-      entry.ref = {navId, toMapObjectType(type)};
-      entry.airwayId = nodeAirwayId.value(pred.id, -1);
-      route.prepend(entry);
+      entry.ref = {node.navId, toMapObjectType(node.type)};
+      entry.airwayId = nodeAirwayId.value(node.id, -1);
+      route.append(entry);
     }
 
-    nw::Node next = network->getNode(nodePredecessor.value(pred.id, -1));
-    if(next.pos.isValid())
-      distanceMeter += pred.pos.distanceMeterTo(next.pos);
-    pred = next;
+    if(i > 0 && node.pos.isValid() && nodes.at(i - 1).pos.isValid())
+      distanceMeter += node.pos.distanceMeterTo(nodes.at(i - 1).pos);
   }
 }
 
@@ -183,6 +293,10 @@ void RouteFinder::expandNode(const nw::Node& currentNode, const nw::Node& destNo
     nodeCosts[successor.id] = successorNodeCosts;
     nodeAltRange[successor.id] = successorNodeAltRange;
 
+    if(backwardNodeCosts.contains(successor.id))
+      // Backward search was already here - remember connection
+      updateMeetingNode(successor.id);
+
     // Costs from start to successor + estimate to destination = sort order in heap
     float totalCost = successorNodeCosts + costEstimate(successor, destNode);
 
@@ -194,6 +308,105 @@ void RouteFinder::expandNode(const nw::Node& currentNode, const nw::Node& destNo
   }
 }
 
+/* Expands a node in the backward search by investigating all predecessors.
+ * Edges are traversed from predecessor to the current node. */
+void RouteFinder::expandNodeBackward(const nw::Node& currentNode, const nw::Node& startNode)
+{
+  successorNodes.clear();
+  successorEdges.clear();
+  network->getNeighbours(currentNode, successorNodes, successorEdges);
+
+  // Departure node is not part of the network - add reverse edge manually
+  if(departureEdgeLength.contains(currentNode.id))
+  {
+    successorNodes.append(startNode);
+    successorEdges.append(Edge(startNode.id, departureEdgeLength.value(currentNode.id)));
+  }
+
+  QString currentNodeAirway;
+  if(network->isAirwayRouting())
+    currentNodeAirway = backwardNodeAirwayName[currentNode.id];
+
+  for(int i = 0; i < successorNodes.size(); i++)
+  {
+    const Node& predecessor = successorNodes.at(i);
+
+    if(backwardClosedNodes.contains(predecessor.id))
+      // Already has a shortest path
+      continue;
+
+    const Edge& edge = successorEdges.at(i);
+
+    if(altitude > 0 && !(altitude >= edge.minAltFt && altitude <= edge.maxAltFt))
+      continue;
+
+    if(edge.direction == nw::FORWARD)
+      // Edge is seen from the current node - travelling from predecessor to current is against a one-way airway
+      continue;
+
+    int lengthMeter = edge.lengthMeter;
+    if(lengthMeter == 0)
+      lengthMeter = static_cast<int>(currentNode.pos.distanceMeterTo(predecessor.pos));
+
+    float predecessorEdgeCosts = calculateEdgeCost(predecessor, currentNode, lengthMeter);
+
+    if(!currentNodeAirway.isEmpty() && !edge.airwayName.isEmpty() && currentNodeAirway != edge.airwayName)
+      predecessorEdgeCosts *= COST_FACTOR_AIRWAY_CHANGE;
+
+    float predecessorNodeCosts = backwardNodeCosts.value(currentNode.id) + predecessorEdgeCosts;
+
+    if(predecessorNodeCosts >= backwardNodeCosts.value(predecessor.id) &&
+       backwardOpenNodesHeap.contains(predecessor))
+      // New path is not cheaper
+      continue;
+
+    std::pair<int, int> predecessorNodeAltRange = backwardNodeAltRange.value(currentNode.id);
+
+    if(!combineRanges(predecessorNodeAltRange, edge.minAltFt, edge.maxAltFt))
+      continue;
+
+    backwardNodeAirwayId[predecessor.id] = edge.airwayId;
+    if(network->isAirwayRouting())
+      backwardNodeAirwayName[predecessor.id] = edge.airwayName;
+    backwardNodeSuccessor[predecessor.id] = currentNode.id;
+    backwardNodeCosts[predecessor.id] = predecessorNodeCosts;
+    backwardNodeEdgeCosts[predecessor.id] = predecessorEdgeCosts;
+    backwardNodeAltRange[predecessor.id] = predecessorNodeAltRange;
+
+    if(nodeCosts.contains(predecessor.id))
+      // Forward search was already here - remember connection
+      updateMeetingNode(predecessor.id);
+
+    float totalCost = predecessorNodeCosts + costEstimate(predecessor, startNode);
+
+    if(backwardOpenNodesHeap.contains(predecessor))
+      backwardOpenNodesHeap.change(predecessor, totalCost);
+    else
+      backwardOpenNodesHeap.push(predecessor, totalCost);
+  }
+}
+
+void RouteFinder::updateMeetingNode(int nodeId)
+{
+  float totalCosts = nodeCosts.value(nodeId) + backwardNodeCosts.value(nodeId);
+
+  if(network->isAirwayRouting())
+  {
+    // Airway change at the meeting node is not covered by any of the two searches - apply it to the first
+    // edge of the backward path like expandNode does for the edge leaving a node
+    QString forwardAirway = nodeAirwayName.value(nodeId);
+    QString backwardAirway = backwardNodeAirwayName.value(nodeId);
+    if(!forwardAirway.isEmpty() && !backwardAirway.isEmpty() && forwardAirway != backwardAirway)
+      totalCosts += backwardNodeEdgeCosts.value(nodeId) * (COST_FACTOR_AIRWAY_CHANGE - 1.f);
+  }
+
+  if(totalCosts < meetingCosts)
+  {
+    meetingCosts = totalCosts;
+    meetingNodeId = nodeId;
+  }
+}
+
 bool RouteFinder::combineRanges(std::pair<int, int>& range1, int min, int max)
 {
   // qDebug() << "[" << range1.first << "," << range1.second << "]" << "[" << min << "," << max << "]";
@@ -273,10 +486,74 @@ float RouteFinder::calculateEdgeCost(const nw::Node& currentNode, const nw::Node
   return costs;
 }
 
-/* GC distance in meter as costs between nodes */
+/* GC distance in meter as costs between nodes. Uses the larger landmark lower bound if available. */
 float RouteFinder::costEstimate(const nw::Node& currentNode, const nw::Node& destNode)
 {
-  return currentNode.pos.distanceMeterTo(destNode.pos);
+  float estimate = currentNode.pos.distanceMeterTo(destNode.pos);
+
+  if(landmarks != nullptr)
+  {
+    if(destNode.type == nw::DESTINATION)
+      estimate = std::max(estimate, landmarkEstimate(currentNode, destinationBounds));
+    else if(destNode.type == nw::DEPARTURE)
+      estimate = std::max(estimate, landmarkEstimate(currentNode, departureBounds));
+  }
+  return estimate;
+}
+
+/* Calculate bounds for a virtual node connected to the network by its edges.
+ * Network distance from a node n to the virtual node is at least min over all edges e (|d(L, e) - d(L, n)| + length(e))
+ * which is at least max(first - d(L, n), d(L, n) - second). */
+void RouteFinder::initLandmarkBounds(const nw::Node& node, QVector<std::pair<float, float> >& bounds)
+{
+  bounds.fill(std::make_pair(RouteLandmarks::INVALID_DISTANCE, RouteLandmarks::INVALID_DISTANCE), landmarks->size());
+
+  for(int landmark = 0; landmark < landmarks->size(); landmark++)
+  {
+    float minVal = std::numeric_limits<float>::max(), maxVal = std::numeric_limits<float>::lowest();
+    for(const Edge& edge : node.edges)
+    {
+      int index = network->getGraphIndex(edge.toNodeId);
+      if(index == -1)
+        continue;
+
+      float dist = landmarks->getDistance(landmark, index);
+      if(dist < 0.f)
+        // Not reachable from landmark
+        continue;
+
+      minVal = std::min(minVal, dist + edge.lengthMeter);
+      maxVal = std::max(maxVal, dist - edge.lengthMeter);
+    }
+
+    if(minVal < std::numeric_limits<float>::max())
+      bounds[landmark] = std::make_pair(minVal, maxVal);
+  }
+}
+
+/* Lower bound of the network distance from node to a virtual node using the triangle inequality */
+float RouteFinder::landmarkEstimate(const nw::Node& currentNode, const QVector<std::pair<float, float> >& bounds)
+{
+  int index = network->getGraphIndex(currentNode.id);
+  if(index == -1)
+    // Virtual node
+    return 0.f;
+
+  float estimate = 0.f;
+  for(int landmark = 0; landmark < bounds.size(); landmark++)
+  {
+    const std::pair<float, float>& bound = bounds.at(landmark);
+    if(bound.first < 0.f)
+      // No edges reachable from this landmark
+      continue;
+
+    float dist = landmarks->getDistance(landmark, index);
+    if(dist < 0.f)
+      continue;
+
+    estimate = std::max(estimate, std::max(bound.first - dist, dist - bound.second));
+  }
+  return estimate;
 }
 
 /* Convert internal network type to MapObjectTypes for extract route */
@@ -21,6 +21,8 @@
 #include "util/heap.h"
 #include "route/routenetwork.h"
 
+class RouteLandmarks;
+
 namespace rf {
 /* Used when fetching the route points after calculation. Adds airway id to node */
 struct RouteEntry
@@ -68,8 +70,34 @@ public:
     preferNdbToAirway = value;
   }
 
+  /* Search from departure and destination at the same time until both searches meet */
+  void setBidirectional(bool value)
+  {
+    bidirectional = value;
+  }
+
+  /* Number of nodes expanded in the last calculation by forward and backward search */
+  int getNumNodesExpanded() const
+  {
+    return closedNodes.size() + backwardClosedNodes.size();
+  }
+
+  /* Use landmark distances (ALT) in addition to the great circle distance for the cost estimate.
+   * Only used if the network has a preloaded graph with landmarks. */
+  void setUseLandmarks(bool value)
+  {
+    useLandmarks = value;
+  }
+
 private:
+  bool calculateRouteUnidirectional(const nw::Node& startNode, const nw::Node& destNode, int numNodesTotal);
+  bool calculateRouteBidirectional(const nw::Node& startNode, const nw::Node& destNode, int numNodesTotal);
+
   void expandNode(const nw::Node& node, const nw::Node& destNode);
+  void expandNodeBackward(const nw::Node& node, const nw::Node& startNode);
+  void updateMeetingNode(int nodeId);
+  void initLandmarkBounds(const nw::Node& node, QVector<std::pair<float, float> >& bounds);
+  float landmarkEstimate(const nw::Node& currentNode, const QVector<std::pair<float, float> >& bounds);
   float calculateEdgeCost(const nw::Node& node, const nw::Node& successorNode, int lengthMeter);
   float costEstimate(const nw::Node& currentNode, const nw::Node& destNode);
   map::MapObjectTypes toMapObjectType(nw::NodeType type);
@@ -132,7 +160,35 @@ private:
   QVector<nw::Node> successorNodes;
   QVector<nw::Edge> successorEdges;
 
-  bool preferVorToAirway = false, preferNdbToAirway = false;
+  bool preferVorToAirway = false, preferNdbToAirway = false, bidirectional = false, useLandmarks = false;
+
+  /* Same as above for the backward search from destination to departure if bidirectional is enabled.
+   * Successor is the next node towards the destination. Airway id and name are for the edge to the successor. */
+  atools::util::Heap<nw::Node> backwardOpenNodesHeap;
+  QSet<int> backwardClosedNodes;
+  QHash<int, float> backwardNodeCosts;
+  /* Costs of the edge to the successor */
+  QHash<int, float> backwardNodeEdgeCosts;
+  QHash<int, std::pair<int, int> > backwardNodeAltRange;
+  QHash<int, int> backwardNodeSuccessor;
+  QHash<int, int> backwardNodeAirwayId;
+  QHash<int, QString> backwardNodeAirwayName;
+
+  /* Maps node id to edge length for all edges of the virtual departure node. Used for the reverse edges in the
+   * backward search. */
+  QHash<int, int> departureEdgeLength;
+
+  /* Node where forward and backward search met with the lowest total costs */
+  int meetingNodeId = -1;
+  float meetingCosts = std::numeric_limits<float>::max();
+
+  /* Landmarks of the network or null if not used */
+  const RouteLandmarks *landmarks = nullptr;
+
+  /* Lower and upper bound per landmark for the virtual departure and destination nodes. The first value is
+   * the minimum of landmark distance plus edge length and the second the maximum of landmark distance
+   * minus edge length over all edges of the virtual node. */
+  QVector<std::pair<float, float> > departureBounds, destinationBounds;
 };
 
 #endif // LITTLENAVMAP_ROUTEFINDER_H
@@ -0,0 +1,220 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routelandmarks.h"
+
+#include "route/routenetworkgraph.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <queue>
+
+RouteLandmarks::RouteLandmarks()
+{
+
+}
+
+RouteLandmarks::~RouteLandmarks()
+{
+
+}
+
+void RouteLandmarks::clear()
+{
+  numNodes = numEdges = numRequested = 0;
+  landmarkIndexes.clear();
+  distances.clear();
+}
+
+void RouteLandmarks::calculate(const RouteNetworkGraph& graph, int numLandmarks)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  if(graph.size() == 0 || numLandmarks <= 0)
+    return;
+
+  numRequested = numLandmarks;
+  numNodes = graph.size();
+  numEdges = graph.getNumEdges();
+
+  QVector<float> temp(numNodes);
+
+  // Find a first landmark at the border of the network by using the node farthest away from an arbitrary one
+  dijkstra(graph, 0, temp.data());
+
+  int next = 0;
+  for(int i = 0; i < numNodes; i++)
+  {
+    if(temp.at(i) > temp.at(next))
+      next = i;
+  }
+
+  // Minimum distance from all landmarks so far for each node
+  QVector<float> minDistance(numNodes, std::numeric_limits<float>::max());
+
+  distances.resize(numLandmarks * numNodes);
+  for(int landmark = 0; landmark < numLandmarks; landmark++)
+  {
+    landmarkIndexes.append(next);
+    float *landmarkDistances = distances.data() + landmark * numNodes;
+    dijkstra(graph, next, landmarkDistances);
+
+    // Farthest point selection - next landmark is the node with the largest distance to all other landmarks
+    next = -1;
+    float maxDistance = 0.f;
+    for(int i = 0; i < numNodes; i++)
+    {
+      if(landmarkDistances[i] >= 0.f)
+        minDistance[i] = std::min(minDistance.at(i), landmarkDistances[i]);
+
+      if(minDistance.at(i) < std::numeric_limits<float>::max() && minDistance.at(i) > maxDistance)
+      {
+        maxDistance = minDistance.at(i);
+        next = i;
+      }
+    }
+
+    if(next == -1)
+      // Too few nodes
+      break;
+  }
+
+  // Remove unused rows if search stopped early
+  distances.resize(landmarkIndexes.size() * numNodes);
+  distances.squeeze();
+
+  qDebug() << Q_FUNC_INFO << "landmarks" << landmarkIndexes.size() << "nodes" << numNodes
+           << "took" << timer.elapsed() << "ms";
+}
+
+/* Simple Dijkstra on the undirected graph. Result contains INVALID_DISTANCE for unreachable nodes. */
+void RouteLandmarks::dijkstra(const RouteNetworkGraph& graph, int startIndex, float *result) const
+{
+  typedef std::pair<float, int> DistIndex;
+  std::priority_queue<DistIndex, std::vector<DistIndex>, std::greater<DistIndex> > queue;
+
+  for(int i = 0; i < numNodes; i++)
+    result[i] = INVALID_DISTANCE;
+
+  result[startIndex] = 0.f;
+  queue.push(std::make_pair(0.f, startIndex));
+
+  while(!queue.empty())
+  {
+    DistIndex current = queue.top();
+    queue.pop();
+
+    if(current.first > result[current.second])
+      // Outdated entry
+      continue;
+
+    atools::geo::Pos pos = graph.getPosition(current.second);
+    for(const nw::GraphEdge *edge = graph.getEdgesBegin(current.second); edge != graph.getEdgesEnd(current.second);
+        ++edge)
+    {
+      // Use the same length as RouteFinder to keep the lower bound valid
+      int lengthMeter = edge->lengthMeter;
+      if(lengthMeter == 0)
+        lengthMeter = static_cast<int>(pos.distanceMeterTo(graph.getPosition(edge->toIndex)));
+
+      float dist = current.first + lengthMeter;
+      float& otherDist = result[edge->toIndex];
+      if(otherDist < 0.f || dist < otherDist)
+      {
+        otherDist = dist;
+        queue.push(std::make_pair(dist, edge->toIndex));
+      }
+    }
+  }
+}
+
+bool RouteLandmarks::isForGraph(const RouteNetworkGraph& graph) const
+{
+  return numNodes == graph.size() && numEdges == graph.getNumEdges();
+}
+
+bool RouteLandmarks::load(const QString& filename, const RouteNetworkGraph& graph)
+{
+  clear();
+
+  QFile file(filename);
+  if(!file.exists())
+    return false;
+
+  bool retval = false;
+  if(file.open(QIODevice::ReadOnly))
+  {
+    quint32 magic;
+    quint16 version;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_5);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    in >> magic;
+
+    if(magic == FILE_MAGIC_NUMBER)
+    {
+      in >> version;
+      if(version == FILE_VERSION)
+      {
+        in >> numNodes >> numEdges >> numRequested >> landmarkIndexes >> distances;
+
+        if(in.status() == QDataStream::Ok && isForGraph(graph) &&
+           distances.size() == landmarkIndexes.size() * numNodes)
+          retval = true;
+        else
+          qWarning() << "Landmarks in" << file.fileName() << "do not match network";
+      }
+      else
+        qWarning() << "Cannot read landmarks" << file.fileName() << ". Invalid version number:" << version;
+    }
+    else
+      qWarning() << "Cannot read landmarks" << file.fileName() << ". Invalid magic number:" << magic;
+
+    file.close();
+  }
+  else
+    qWarning() << "Cannot read landmarks" << file.fileName() << ":" << file.errorString();
+
+  if(!retval)
+    clear();
+  return retval;
+}
+
+bool RouteLandmarks::save(const QString& filename) const
+{
+  QFile file(filename);
+
+  if(file.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    out << FILE_MAGIC_NUMBER << FILE_VERSION << numNodes << numEdges << numRequested << landmarkIndexes << distances;
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << "Cannot write landmarks" << file.fileName() << ":" << file.errorString();
+  return false;
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTELANDMARKS_H
+#define LITTLENAVMAP_ROUTELANDMARKS_H
+
+#include <QVector>
+
+class RouteNetworkGraph;
+
+/*
+ * Landmark distances for the ALT (A*, landmarks, triangle inequality) heuristic.
+ *
+ * Stores the shortest network distance in meter from a few landmark nodes to all nodes of a preloaded graph.
+ * Distances are calculated on the undirected graph with all edges regardless of airway type, direction or
+ * altitude restrictions. Therefore the triangle inequality gives a lower bound for the route costs in any
+ * network mode since all cost factors in RouteFinder are >= 1.
+ *
+ * Landmarks can be saved to a file next to the navigation database to avoid recalculation on each startup.
+ */
+class RouteLandmarks
+{
+public:
+  RouteLandmarks();
+  ~RouteLandmarks();
+
+  /* Select landmarks and calculate distances to all nodes using Dijkstra */
+  void calculate(const RouteNetworkGraph& graph, int numLandmarks);
+
+  /* Load from file. Returns false if the file does not exist or does not match the graph. */
+  bool load(const QString& filename, const RouteNetworkGraph& graph);
+
+  /* Save to file. Returns false on error. */
+  bool save(const QString& filename) const;
+
+  void clear();
+
+  bool isValid() const
+  {
+    return !distances.isEmpty();
+  }
+
+  /* Number of landmarks. Can be less than requested for small networks. */
+  int size() const
+  {
+    return landmarkIndexes.size();
+  }
+
+  /* Number of landmarks that were requested in calculate() */
+  int getNumRequested() const
+  {
+    return numRequested;
+  }
+
+  /* True if node and edge numbers match the graph */
+  bool isForGraph(const RouteNetworkGraph& graph) const;
+
+  /* Network distance in meter from landmark to the node at graph index. Is INVALID_DISTANCE if unreachable. */
+  float getDistance(int landmark, int nodeIndex) const
+  {
+    return distances.at(landmark * numNodes + nodeIndex);
+  }
+
+  /* Node is not reachable from landmark */
+  static Q_DECL_CONSTEXPR float INVALID_DISTANCE = -1.f;
+
+private:
+  void dijkstra(const RouteNetworkGraph& graph, int startIndex, float *result) const;
+
+  int numNodes = 0, numEdges = 0, numRequested = 0;
+
+  /* Graph indexes of the landmark nodes */
+  QVector<int> landmarkIndexes;
+
+  /* Distances for each landmark and node. Row major: landmark * numNodes + nodeIndex */
+  QVector<float> distances;
+
+  static Q_DECL_CONSTEXPR quint32 FILE_MAGIC_NUMBER = 0x4C4D4B31;
+  static Q_DECL_CONSTEXPR quint16 FILE_VERSION = 2;
+};
+
+#endif // LITTLENAVMAP_ROUTELANDMARKS_H
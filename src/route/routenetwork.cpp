@@ -16,6 +16,9 @@
 *****************************************************************************/
 
 #include "routenetwork.h"
+#include "route/routenetworkgraph.h"
+#include "route/routelandmarks.h"
+#include "route/routenodegrid.h"
 
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
@@ -26,6 +29,10 @@
 #include "geo/rect.h"
 
 #include <QElapsedTimer>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
 
 using atools::sql::SqlDatabase;
 using atools::sql::SqlQuery;
@@ -44,16 +51,153 @@ RouteNetwork::RouteNetwork(atools::sql::SqlDatabase *sqlDb, const QString& nodeT
   nodeCache.reserve(60000);
   destinationNodePredecessors.reserve(1000);
   airwayRouting = mode & nw::ROUTE_JET || mode & nw::ROUTE_VICTOR;
+  graph = new RouteNetworkGraph;
+  grid = new RouteNodeGrid;
   initQueries();
 }
 
 RouteNetwork::~RouteNetwork()
 {
   deInitQueries();
+  delete graph;
+  delete grid;
+}
+
+void RouteNetwork::setPreloadGraph(bool value)
+{
+  if(preloadGraph == value)
+    return;
+
+  preloadGraph = value;
+
+  if(preloadGraph)
+  {
+    if(nodeByIdQuery != nullptr)
+    {
+      // Queries are already initialized - load now and drop all nodes fetched from the database
+      clearStartAndDestinationNodes();
+      loadGraph();
+    }
+  }
+  else
+  {
+    clearStartAndDestinationNodes();
+    graph->clear();
+    clearLandmarks();
+    grid->clear();
+  }
+}
+
+void RouteNetwork::loadGraph()
+{
+  graph->load(db, nodeTable, edgeTable, nodeExtraCols, edgeExtraCols);
+
+  // Build spatial index from the graph nodes
+  QVector<nw::GridNode> gridNodes;
+  gridNodes.reserve(graph->size());
+  for(int i = 0; i < graph->size(); i++)
+  {
+    atools::geo::Pos pos = graph->getPosition(i);
+    gridNodes.append({graph->getNodeId(i), graph->getRawType(i), pos.getLonX(), pos.getLatY()});
+  }
+  grid->build(gridNodes);
+
+  // Landmarks are loaded on first use
+  clearLandmarks();
+}
+
+namespace {
+/* Landmarks for a landmark file and the modification time of the database they were calculated for */
+struct LandmarkCacheEntry
+{
+  QDateTime dbLastModified;
+  QSharedPointer<const RouteLandmarks> landmarks;
+};
+
+/* Process wide landmark cache keyed by landmark file name and number of landmarks. The mutex also serializes
+ * calculation and file access for networks in different threads. */
+QMutex landmarkCacheMutex;
+QHash<QString, LandmarkCacheEntry> landmarkCache;
+}
+
+void RouteNetwork::clearLandmarks()
+{
+  landmarks.reset();
+  landmarksLoaded = false;
+}
+
+/* Get landmarks from cache, load them from file next to the database or calculate and save them if file is
+ * missing or outdated */
+void RouteNetwork::loadLandmarks()
+{
+  QFileInfo dbFile(db->databaseName());
+  QFileInfo landmarkFile(dbFile.absolutePath() + QDir::separator() + dbFile.completeBaseName() + "_" + nodeTable +
+                         ".landmarks");
+  QString key = landmarkFile.absoluteFilePath() + "|" + QString::number(numLandmarks);
+
+  QMutexLocker locker(&landmarkCacheMutex);
+
+  auto it = landmarkCache.constFind(key);
+  if(it != landmarkCache.constEnd() && it->dbLastModified == dbFile.lastModified() &&
+     it->landmarks->isForGraph(*graph))
+  {
+    landmarks = it->landmarks;
+    return;
+  }
+
+  QSharedPointer<RouteLandmarks> newLandmarks(new RouteLandmarks);
+  if(!landmarkFile.exists() || landmarkFile.lastModified() < dbFile.lastModified() ||
+     !newLandmarks->load(landmarkFile.filePath(), *graph) || newLandmarks->getNumRequested() != numLandmarks)
+  {
+    newLandmarks->calculate(*graph, numLandmarks);
+    newLandmarks->save(landmarkFile.filePath());
+  }
+
+  // Replaces any outdated entry for the same file
+  landmarks = newLandmarks;
+  landmarkCache.insert(key, {dbFile.lastModified(), landmarks});
+}
+
+/* Load position and type of all nodes into the spatial index */
+void RouteNetwork::loadGrid()
+{
+  QVector<nw::GridNode> gridNodes;
+  gridNodes.reserve(getNumberOfNodesDatabase());
+
+  SqlQuery query(db);
+  query.exec("select node_id, type, lonx, laty from " + nodeTable);
+  while(query.next())
+    gridNodes.append({query.valueInt(0), query.valueInt(1), query.valueFloat(2), query.valueFloat(3)});
+  query.finish();
+
+  grid->build(gridNodes);
+}
+
+const RouteLandmarks *RouteNetwork::getLandmarks()
+{
+  if(!graph->isLoaded() || numLandmarks <= 0)
+    return nullptr;
+
+  if(!landmarksLoaded)
+  {
+    // Calculate lazily to avoid delaying startup if landmarks are not used
+    loadLandmarks();
+    landmarksLoaded = true;
+  }
+
+  return landmarks != nullptr && landmarks->isValid() ? landmarks.data() : nullptr;
+}
+
+int RouteNetwork::getGraphIndex(int nodeId) const
+{
+  return graph->isLoaded() ? graph->indexOf(nodeId) : -1;
 }
 
 int RouteNetwork::getNumberOfNodesDatabase()
 {
+  if(graph->isLoaded())
+    return graph->size();
+
   if(numNodesDb == -1)
     numNodesDb = atools::sql::SqlUtil(db).rowCount(nodeTable);
   return numNodesDb;
@@ -74,8 +218,10 @@ void RouteNetwork::clearStartAndDestinationNodes()
 {
   departurePos = atools::geo::EMPTY_POS;
   destinationPos = atools::geo::EMPTY_POS;
+  destinationEdgesLoaded = false;
   nodeCache.clear();
   destinationNodePredecessors.clear();
+  destinationNeighbours.clear();
   numNodesDb = -1;
   nodeIndexesCreated = false;
   edgeIndexesCreated = false;
@@ -109,29 +255,51 @@ void RouteNetwork::getNeighbours(const nw::Node& from, QVector<nw::Node>& neighb
   }
 }
 
-void RouteNetwork::addDepartureAndDestinationNodes(const atools::geo::Pos& from, const atools::geo::Pos& to)
+void RouteNetwork::addDepartureAndDestinationNodes(const atools::geo::Pos& from, const atools::geo::Pos& to,
+                                                   bool destinationEdges)
 {
   qDebug() << "adding start and  destination to network";
 
-  if(departurePos == from && destinationPos == to)
+  if(departurePos == from && destinationPos == to && destinationEdgesLoaded == destinationEdges)
     return;
 
-  if(destinationPos != to)
+  if(grid->isEmpty())
+    // Spatial index was not filled by preloading the graph
+    loadGrid();
+
+  if(destinationPos != to || destinationEdgesLoaded != destinationEdges)
   {
     // Remove all references to destination node
     cleanDestNodeEdges();
 
     // Add destination first so it can be added to start successors
     destinationPos = to;
+    destinationEdgesLoaded = destinationEdges;
 
     destinationNodeRect = Rect(to, NODE_SEARCH_RADIUS_METER);
 
+    // Collect all nodes near the destination and their distance
+    destinationNeighbours.clear();
+    QVector<nw::GridNode> gridNodes;
+    grid->getNodesInRect(destinationNodeRect, gridNodes);
+    for(const nw::GridNode& gridNode : gridNodes)
+      destinationNeighbours.insert(gridNode.id,
+                                   static_cast<int>(Pos(gridNode.lonx, gridNode.laty).distanceMeterTo(to)));
+
     // Will use the bounding rectangle to add any neighbor nodes to dest
-    fetchNode(to.getLonX(), to.getLatY(), false, DESTINATION_NODE_ID);
+    // Edges of the destination node are the reverse edges of the predecessors and are used for the backward search
+    fetchNode(to.getLonX(), to.getLatY(), destinationEdges, DESTINATION_NODE_ID);
 
-    for(int id : nodeCache.keys())
-      // Fill destination node predecessor index
-      addDestNodeEdges(nodeCache[id]);
+    // Fill destination node predecessor index for nodes already in the cache
+    for(auto it = destinationNeighbours.constBegin(); it != destinationNeighbours.constEnd(); ++it)
+    {
+      auto cacheIt = nodeCache.find(it.key());
+      if(cacheIt != nodeCache.end())
+        addDestNodeEdges(cacheIt.value());
+    }
+
+    if(nodeCache.contains(DEPARTURE_NODE_ID))
+      addDestNodeEdges(nodeCache[DEPARTURE_NODE_ID]);
   }
 
   if(departurePos != from)
@@ -160,6 +328,13 @@ nw::Node RouteNetwork::getNode(int id)
     return fetchNode(id);
 }
 
+void RouteNetwork::getNodes(const QVector<int>& ids, QVector<nw::Node>& nodes)
+{
+  nodes.reserve(nodes.size() + ids.size());
+  for(int id : ids)
+    nodes.append(getNode(id));
+}
+
 /* Remove all references to the destination node from the cache */
 void RouteNetwork::cleanDestNodeEdges()
 {
@@ -193,17 +368,33 @@ void RouteNetwork::cleanDestNodeEdges()
 /* Add a destination node virtual edge to the node if it is inside the destination bounding rectangle */
 void RouteNetwork::addDestNodeEdges(nw::Node& node)
 {
-  if(destinationNodeRect.contains(node.pos) && !destinationNodePredecessors.contains(node.id) &&
-     node.id != DESTINATION_NODE_ID)
+  if(node.id == DESTINATION_NODE_ID || destinationNodePredecessors.contains(node.id))
+    // Node is dest or already indexed
+    return;
+
+  int distance;
+  if(node.id == DEPARTURE_NODE_ID)
   {
-    // Node is not dest and not indexed yet - create virtual edge
-    nw::Edge edge(DESTINATION_NODE_ID, static_cast<int>(node.pos.distanceMeterTo(destinationPos)));
+    // Virtual departure node is not part of the spatial index
+    if(!destinationNodeRect.contains(node.pos))
+      return;
 
-    // Near destination - add as successor
-    node.edges.append(edge);
-    // Remember in cache for later cleanup
-    destinationNodePredecessors.insert(node.id);
+    distance = static_cast<int>(node.pos.distanceMeterTo(destinationPos));
+  }
+  else
+  {
+    auto it = destinationNeighbours.constFind(node.id);
+    if(it == destinationNeighbours.constEnd())
+      return;
+
+    distance = it.value();
   }
+
+  // Near destination - add virtual edge as successor
+  node.edges.append(nw::Edge(DESTINATION_NODE_ID, distance));
+
+  // Remember in cache for later cleanup
+  destinationNodePredecessors.insert(node.id);
 }
 
 /* Get a node by navaid id (waypoint_id, vor_id, ...) */
@@ -235,44 +426,6 @@ nw::Node RouteNetwork::fetchNodeByNavId(int id, nw::NodeType type)
   return node;
 }
 
-void RouteNetwork::getNavIdAndTypeForNode(int nodeId, int& navId, nw::NodeType& type)
-{
-  if(nodeId == DEPARTURE_NODE_ID)
-  {
-    type = DEPARTURE;
-    navId = -1; // No database id available
-  }
-  else if(nodeId == DESTINATION_NODE_ID)
-  {
-    type = DESTINATION;
-    navId = -1; // No database id available
-  }
-  else
-  {
-    nodeNavIdAndTypeQuery->bindValue(":id", nodeId);
-    nodeNavIdAndTypeQuery->exec();
-
-    if(nodeNavIdAndTypeQuery->next())
-    {
-      navId = nodeNavIdAndTypeQuery->value("nav_id").toInt();
-
-      int typeVal = nodeNavIdAndTypeQuery->value("type").toInt();
-
-      if(airwayRouting)
-        // This is an airway network which has the type in the upper four bits
-        type = static_cast<nw::NodeType>(typeVal >> 4);
-      else
-        type = static_cast<nw::NodeType>(typeVal);
-    }
-    else
-    {
-      navId = -1;
-      type = nw::NONE;
-    }
-    nodeNavIdAndTypeQuery->finish();
-  }
-}
-
 /* Create a virtual node at the given coordinates with the given id */
 nw::Node RouteNetwork::fetchNode(float lonx, float laty, bool loadSuccessors, int id)
 {
@@ -297,25 +450,17 @@ nw::Node RouteNetwork::fetchNode(float lonx, float laty, bool loadSuccessors, in
     // Load all successor nodes within the query rectangle
     Rect queryRect(Pos(lonx, laty), NODE_SEARCH_RADIUS_METER);
 
-    // Use a set for de-duplication
-    QSet<Edge> tempEdges;
-    tempEdges.reserve(1000);
+    // Spatial index handles rectangles crossing the anti-meridian and contains each node only once
+    QVector<nw::GridNode> gridNodes;
+    grid->getNodesInRect(queryRect, gridNodes);
 
-    for(const Rect& rect : queryRect.splitAtAntiMeridian())
+    node.edges.reserve(gridNodes.size() + 1);
+    for(const nw::GridNode& gridNode : gridNodes)
     {
-      bindCoordRect(rect, nearestNodesQuery);
-      nearestNodesQuery->exec();
-      while(nearestNodesQuery->next())
-      {
-        int nodeId = nearestNodesQuery->value("node_id").toInt();
-        if(testType(static_cast<nw::NodeType>(nearestNodesQuery->value("type").toInt())))
-        {
-          Pos otherPos(nearestNodesQuery->value("lonx").toFloat(), nearestNodesQuery->value("laty").toFloat());
-          tempEdges.insert(Edge(nodeId, static_cast<int>(node.pos.distanceMeterTo(otherPos))));
-        }
-      }
+      if(testType(static_cast<nw::NodeType>(gridNode.type)))
+        node.edges.append(Edge(gridNode.id,
+                               static_cast<int>(node.pos.distanceMeterTo(Pos(gridNode.lonx, gridNode.laty)))));
     }
-    node.edges = tempEdges.values().toVector();
 
     // Add edges to destination node if there are any
     addDestNodeEdges(node);
@@ -330,7 +475,24 @@ nw::Node RouteNetwork::fetchNode(float lonx, float laty, bool loadSuccessors, in
 nw::Node RouteNetwork::fetchNode(int id)
 {
   if(nodeCache.contains(id))
+  {
+    cacheHits++;
     return nodeCache.value(id);
+  }
+  cacheMisses++;
+
+  if(graph->isLoaded())
+  {
+    // Build node and edges from the preloaded graph without database access
+    int index = graph->indexOf(id);
+    if(index == -1)
+      return nw::Node();
+
+    nw::Node node = createNodeFromGraph(index);
+    addDestNodeEdges(node);
+    nodeCache.insert(node.id, node);
+    return node;
+  }
 
   nodeByIdQuery->bindValue(":id", id);
   nodeByIdQuery->exec();
@@ -388,17 +550,9 @@ void RouteNetwork::initQueries()
   nodeByNavIdQuery = new SqlQuery(db);
   nodeByNavIdQuery->prepare("select node_id from " + nodeTable + " where nav_id = :id and type = :type");
 
-  nodeNavIdAndTypeQuery = new SqlQuery(db);
-  nodeNavIdAndTypeQuery->prepare("select nav_id, type from " + nodeTable + " where node_id = :id");
-
-  nearestNodesQuery = new SqlQuery(db);
-  nearestNodesQuery->prepare(
-    "select node_id, type, lonx, laty from " + nodeTable +
-    " where lonx between :leftx and :rightx and laty between :bottomy and :topy");
-
   nodeByIdQuery = new SqlQuery(db);
   nodeByIdQuery->prepare(
-    "select " + nodeCols + " type, lonx, laty from " + nodeTable + " where node_id = :id");
+    "select " + nodeCols + " nav_id, type, lonx, laty from " + nodeTable + " where node_id = :id");
 
   edgeToQuery = new SqlQuery(db);
   edgeToQuery->prepare(
@@ -409,21 +563,21 @@ void RouteNetwork::initQueries()
   edgeFromQuery->prepare(
     "select " + edgeCols + " from_node_id, from_node_type from " + edgeTable +
     " where to_node_id = :id");
+
+  if(preloadGraph)
+    loadGraph();
 }
 
 void RouteNetwork::deInitQueries()
 {
   clearStartAndDestinationNodes();
+  graph->clear();
+  clearLandmarks();
+  grid->clear();
 
   delete nodeByNavIdQuery;
   nodeByNavIdQuery = nullptr;
 
-  delete nodeNavIdAndTypeQuery;
-  nodeNavIdAndTypeQuery = nullptr;
-
-  delete nearestNodesQuery;
-  nearestNodesQuery = nullptr;
-
   delete nodeByIdQuery;
   nodeByIdQuery = nullptr;
 
@@ -449,6 +603,8 @@ nw::Node RouteNetwork::createNode(const SqlRecord& rec)
   else
     node.type = static_cast<nw::NodeType>(rec.valueInt(nodeTypeIndex));
 
+  node.navId = rec.valueInt(nodeNavIdIndex);
+
   if(nodeRangeIndex != -1)
     // Add range if part of the extra columns
     node.range = rec.valueInt(nodeRangeIndex);
@@ -457,12 +613,56 @@ nw::Node RouteNetwork::createNode(const SqlRecord& rec)
   return node;
 }
 
+/* Create node including all edges from the preloaded graph */
+nw::Node RouteNetwork::createNodeFromGraph(int index)
+{
+  Node node;
+  node.id = graph->getNodeId(index);
+  node.navId = graph->getNavId(index);
+
+  int rawType = graph->getRawType(index);
+  if(airwayRouting)
+  {
+    node.type = static_cast<nw::NodeType>(rawType >> 4);
+    node.subtype = static_cast<nw::NodeType>(rawType & 0x0f);
+  }
+  else
+    node.type = static_cast<nw::NodeType>(rawType);
+
+  node.range = graph->getRange(index);
+  node.pos = graph->getPosition(index);
+
+  const nw::GraphEdge *begin = graph->getEdgesBegin(index), *end = graph->getEdgesEnd(index);
+  node.edges.reserve(static_cast<int>(end - begin));
+
+  for(const nw::GraphEdge *graphEdge = begin; graphEdge != end; ++graphEdge)
+  {
+    if(!testType(static_cast<nw::NodeType>(graph->getRawType(graphEdge->toIndex))))
+      continue;
+
+    Edge edge;
+    edge.toNodeId = graph->getNodeId(graphEdge->toIndex);
+    edge.lengthMeter = graphEdge->lengthMeter;
+    edge.minAltFt = graphEdge->minAltFt;
+    edge.maxAltFt = graphEdge->maxAltFt;
+    edge.airwayId = graphEdge->airwayId;
+    edge.type = static_cast<nw::EdgeType>(graphEdge->type);
+    edge.direction = static_cast<nw::EdgeDirection>(graphEdge->direction);
+
+    // Name data is shared with the interned string
+    edge.airwayName = graph->getAirwayName(graphEdge->airwayNameIndex);
+    node.edges.append(edge);
+  }
+  return node;
+}
+
 /* Update node index caches to avoid string lookups in SqlRecord */
 void RouteNetwork::updateNodeIndexes(const SqlRecord& rec)
 {
   if(!nodeIndexesCreated)
   {
     nodeTypeIndex = rec.indexOf("type");
+    nodeNavIdIndex = rec.indexOf("nav_id");
     if(rec.contains("range"))
       nodeRangeIndex = rec.indexOf("range");
     else
@@ -593,11 +793,3 @@ bool RouteNetwork::testType(nw::NodeType type)
 
   return false;
 }
-
-void RouteNetwork::bindCoordRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query)
-{
-  query->bindValue(":leftx", rect.getWest());
-  query->bindValue(":rightx", rect.getEast());
-  query->bindValue(":bottomy", rect.getSouth());
-  query->bindValue(":topy", rect.getNorth());
-}
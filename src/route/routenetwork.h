@@ -22,6 +22,7 @@
 #include "geo/calculations.h"
 
 #include <QHash>
+#include <QSharedPointer>
 #include <QVector>
 
 namespace  atools {
@@ -127,17 +128,18 @@ inline int qHash(const nw::Edge& edge)
 struct Node
 {
   Node()
-    : id(-1), range(0), type(nw::NONE), subtype(nw::NONE)
+    : id(-1), navId(-1), range(0), type(nw::NONE), subtype(nw::NONE)
   {
   }
 
   Node(int nodeId, nw::NodeType nodeType, nw::NodeType nodeType2,
        const atools::geo::Pos& position, int nodeRange = 0)
-    : id(nodeId), range(nodeRange), pos(position), type(nodeType), subtype(nodeType2)
+    : id(nodeId), navId(-1), range(nodeRange), pos(position), type(nodeType), subtype(nodeType2)
   {
   }
 
   int id = -1; /* Database id ("node_id") */
+  int navId; /* Navaid id ("nav_id" like "waypoint_id" or "vor_id") or -1 for virtual nodes */
   int range; /* Range for a radio navaid or 0 if not applicable */
   QVector<Edge> edges; /* Attached edges leading to adjacent nodes */
   atools::geo::Pos pos;
@@ -167,6 +169,10 @@ inline int qHash(const nw::Node& node)
 Q_DECLARE_TYPEINFO(nw::Node, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(nw::Edge, Q_MOVABLE_TYPE);
 
+class RouteNetworkGraph;
+class RouteLandmarks;
+class RouteNodeGrid;
+
 /*
  * Routing network that loads and caches nodes and edges from the database.
  * Allows to resolve relations between objects and walk through the network.
@@ -187,9 +193,6 @@ public:
                const QStringList& edgeExtraColumns);
   virtual ~RouteNetwork();
 
-  /* Get the navaid id and type for the given network node id. */
-  void getNavIdAndTypeForNode(int nodeId, int& navId, nw::NodeType& type);
-
   /* Set up and prepare all queries */
   void initQueries();
 
@@ -199,8 +202,11 @@ public:
   /* Get all adjacent nodes and attached edges for the given node */
   void getNeighbours(const nw::Node& from, QVector<nw::Node>& neighbours, QVector<nw::Edge>& edges);
 
-  /* Integrate departure and destination positions into the network as virtual nodes/edges */
-  void addDepartureAndDestinationNodes(const atools::geo::Pos& from, const atools::geo::Pos& to);
+  /* Integrate departure and destination positions into the network as virtual nodes/edges.
+   * destinationEdges adds the reverse edges to the destination node which are only needed for a backward search
+   * or landmark bounds. */
+  void addDepartureAndDestinationNodes(const atools::geo::Pos& from, const atools::geo::Pos& to,
+                                       bool destinationEdges);
 
   /* Get the virtual departure node that was added using addDepartureAndDestinationNodes */
   nw::Node getDepartureNode() const;
@@ -211,12 +217,32 @@ public:
   /* Get a node by routing network node id. If id is -1 an invalid node with id -1 is returned */
   nw::Node getNode(int id);
 
+  /* Get nodes for all ids in the given order. Nodes visited by the route finder are served from the cache
+   * without database access. Invalid nodes with id -1 are returned for unknown ids. */
+  void getNodes(const QVector<int>& ids, QVector<nw::Node>& nodes);
+
   /* Number of nodes in the database */
   int getNumberOfNodesDatabase();
 
   /* Number of nodes in the memory cache */
   int getNumberOfNodesCache() const;
 
+  /* Number of node fetches that were served by or missed the memory cache since last reset */
+  int getCacheHits() const
+  {
+    return cacheHits;
+  }
+
+  int getCacheMisses() const
+  {
+    return cacheMisses;
+  }
+
+  void resetCacheStatistics()
+  {
+    cacheHits = cacheMisses = 0;
+  }
+
   /* true if mode is either ROUTE_VICTOR, ROUTE_JET  or both flags */
   bool isAirwayRouting() const
   {
@@ -226,6 +252,30 @@ public:
   /* Sets the route mode. This will change some internal behavior like checking subtypes and more */
   void setMode(nw::Modes routeMode);
 
+  /* Load the whole network into memory when initializing queries instead of fetching nodes on demand.
+   * Loads the graph immediately if queries are already initialized. */
+  void setPreloadGraph(bool value);
+
+  bool isPreloadGraph() const
+  {
+    return preloadGraph;
+  }
+
+  /* Number of landmarks for the ALT heuristic that are loaded or calculated on first use for the preloaded graph.
+   * 0 disables landmarks. Has to be set before the graph is loaded. */
+  void setNumLandmarks(int value)
+  {
+    numLandmarks = value;
+  }
+
+  /* Get landmarks for the preloaded graph or null if not available. Landmarks are loaded from the process wide
+   * cache, the file or calculated on first call. */
+  const RouteLandmarks *getLandmarks();
+
+  /* Index of the node in the preloaded graph to be used with landmarks. -1 for virtual nodes or
+   * if graph is not loaded. */
+  int getGraphIndex(int nodeId) const;
+
 private:
   void clearStartAndDestinationNodes();
 
@@ -236,9 +286,13 @@ private:
   void addDestNodeEdges(nw::Node& node);
   void cleanDestNodeEdges();
 
-  void bindCoordRect(const atools::geo::Rect& rect, atools::sql::SqlQuery *query);
   bool testType(nw::NodeType type);
   nw::Node createNode(const atools::sql::SqlRecord& rec);
+  nw::Node createNodeFromGraph(int index);
+  void loadGraph();
+  void loadLandmarks();
+  void clearLandmarks();
+  void loadGrid();
   nw::Edge createEdge(const atools::sql::SqlRecord& rec, int toNodeId, bool reverseDirection);
 
   void updateNodeIndexes(const atools::sql::SqlRecord& rec);
@@ -255,17 +309,26 @@ private:
   /* Cache the number of nodes in the database */
   int numNodesDb = -1;
 
-  atools::sql::SqlQuery *nodeByNavIdQuery = nullptr, *nodeNavIdAndTypeQuery = nullptr,
-                        *nearestNodesQuery = nullptr, *nodeByIdQuery = nullptr, *edgeToQuery = nullptr,
+  /* Node cache statistics */
+  int cacheHits = 0, cacheMisses = 0;
+
+  atools::sql::SqlQuery *nodeByNavIdQuery = nullptr, *nodeByIdQuery = nullptr, *edgeToQuery = nullptr,
                         *edgeFromQuery = nullptr;
 
   /* Bounding rectangle around destination used to find virtual successor edges */
   atools::geo::Rect destinationNodeRect;
   atools::geo::Pos departurePos, destinationPos;
+  bool destinationEdgesLoaded = false;
 
   /* Collected destination predecessor node ids */
   QSet<int> destinationNodePredecessors;
 
+  /* All nodes within the destination bounding rectangle mapped to their distance to destination in meter */
+  QHash<int, int> destinationNeighbours;
+
+  /* Spatial index for all nodes used to attach departure and destination */
+  RouteNodeGrid *grid = nullptr;
+
   atools::sql::SqlDatabase *db;
   nw::Modes mode;
 
@@ -278,12 +341,22 @@ private:
 
   /* Index caches to avoid string lookups in SqlRecord */
   bool nodeIndexesCreated = false;
-  int nodeTypeIndex = -1, nodeRangeIndex = -1, nodeLonXIndex = -1, nodeLatYIndex = -1;
+  int nodeTypeIndex = -1, nodeNavIdIndex = -1, nodeRangeIndex = -1, nodeLonXIndex = -1, nodeLatYIndex = -1;
   bool edgeIndexesCreated = false;
   int edgeTypeIndex = -1, edgeAirwayNameIndex = -1, edgeDirectionIndex = -1, edgeMinAltIndex = -1, edgeMaxAltIndex = -1,
       edgeAirwayIdIndex = -1, edgeDistanceIndex = -1;
 
   bool airwayRouting;
+
+  /* Preloaded network. Used instead of the node and edge queries if loaded. */
+  RouteNetworkGraph *graph = nullptr;
+  bool preloadGraph = false;
+
+  /* Landmark distances for the preloaded graph. Saved next to the database file and shared between all
+   * networks using the same database and table. */
+  QSharedPointer<const RouteLandmarks> landmarks;
+  int numLandmarks = 0;
+  bool landmarksLoaded = false;
 };
 
 #endif // LITTLENAVMAP_ROUTENETWORK_H
@@ -0,0 +1,236 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routenetworkgraph.h"
+
+#include "route/routenetwork.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlRecord;
+using atools::geo::Pos;
+
+RouteNetworkGraph::RouteNetworkGraph()
+{
+
+}
+
+RouteNetworkGraph::~RouteNetworkGraph()
+{
+
+}
+
+void RouteNetworkGraph::load(atools::sql::SqlDatabase *db, const QString& nodeTable, const QString& edgeTable,
+                             const QStringList& nodeExtraColumns, const QStringList& edgeExtraColumns)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+
+  QString nodeCols = nodeExtraColumns.join(",");
+  if(!nodeExtraColumns.isEmpty())
+    nodeCols.append(", ");
+
+  QString edgeCols = edgeExtraColumns.join(",");
+  if(!edgeExtraColumns.isEmpty())
+    edgeCols.append(", ");
+
+  // Load nodes ==============================================================
+  SqlQuery nodeQuery(db);
+  nodeQuery.exec("select " + nodeCols + " node_id, nav_id, type, lonx, laty from " + nodeTable +
+                 " order by node_id");
+
+  SqlRecord nodeRec = nodeQuery.record();
+  int idIdx = nodeRec.indexOf("node_id"), navIdIdx = nodeRec.indexOf("nav_id"), typeIdx = nodeRec.indexOf("type"),
+      lonxIdx = nodeRec.indexOf("lonx"), latyIdx = nodeRec.indexOf("laty"),
+      rangeIdx = nodeRec.contains("range") ? nodeRec.indexOf("range") : -1;
+
+  int maxId = 0;
+  while(nodeQuery.next())
+  {
+    int id = nodeQuery.valueInt(idIdx);
+    maxId = std::max(maxId, id);
+
+    nodeIds.append(id);
+    navIds.append(nodeQuery.valueInt(navIdIdx));
+    types.append(nodeQuery.valueInt(typeIdx));
+    lonX.append(nodeQuery.valueFloat(lonxIdx));
+    latY.append(nodeQuery.valueFloat(latyIdx));
+
+    if(rangeIdx != -1)
+      ranges.append(nodeQuery.valueInt(rangeIdx));
+  }
+  nodeQuery.finish();
+
+  indexById.fill(-1, maxId + 1);
+  for(int i = 0; i < nodeIds.size(); i++)
+    indexById[nodeIds.at(i)] = i;
+
+  // Load edges ==============================================================
+  SqlQuery edgeQuery(db);
+  edgeQuery.exec("select " + edgeCols + " from_node_id, to_node_id from " + edgeTable);
+
+  SqlRecord edgeRec = edgeQuery.record();
+  int fromIdx = edgeRec.indexOf("from_node_id"), toIdx = edgeRec.indexOf("to_node_id"),
+      edgeTypeIdx = edgeRec.contains("type") ? edgeRec.indexOf("type") : -1,
+      directionIdx = edgeRec.contains("direction") ? edgeRec.indexOf("direction") : -1,
+      minAltIdx = edgeRec.contains("minimum_altitude") ? edgeRec.indexOf("minimum_altitude") : -1,
+      maxAltIdx = edgeRec.contains("maximum_altitude") ? edgeRec.indexOf("maximum_altitude") : -1,
+      airwayIdIdx = edgeRec.contains("airway_id") ? edgeRec.indexOf("airway_id") : -1,
+      airwayNameIdx = edgeRec.contains("airway_name") ? edgeRec.indexOf("airway_name") : -1,
+      distanceIdx = edgeRec.contains("distance") ? edgeRec.indexOf("distance") : -1;
+
+  // Collect outgoing edges first and ingoing edges second for each node to keep the order of RouteNetwork::fetchNode
+  QVector<QVector<nw::GraphEdge> > outEdges(nodeIds.size()), inEdges(nodeIds.size());
+  QHash<QString, int> airwayNameIndex;
+
+  while(edgeQuery.next())
+  {
+    int from = indexOf(edgeQuery.valueInt(fromIdx)), to = indexOf(edgeQuery.valueInt(toIdx));
+    if(from == -1 || to == -1 || from == to)
+      continue;
+
+    nw::GraphEdge edge;
+    edge.toIndex = to;
+    edge.type = static_cast<qint8>(edgeTypeIdx != -1 ? edgeQuery.valueInt(edgeTypeIdx) : nw::AIRWAY_NONE);
+    edge.direction = static_cast<qint8>(directionIdx != -1 ? edgeQuery.valueInt(directionIdx) : nw::BOTH);
+    edge.lengthMeter = distanceIdx != -1 ? edgeQuery.valueInt(distanceIdx) : 0;
+    edge.airwayId = airwayIdIdx != -1 ? edgeQuery.valueInt(airwayIdIdx) : -1;
+
+    edge.minAltFt = nw::Edge::MIN_ALTITUDE;
+    if(minAltIdx != -1 && edgeQuery.valueInt(minAltIdx) > 0)
+      edge.minAltFt = edgeQuery.valueInt(minAltIdx);
+
+    edge.maxAltFt = nw::Edge::MAX_ALTITUDE;
+    if(maxAltIdx != -1 && edgeQuery.valueInt(maxAltIdx) > 0)
+      edge.maxAltFt = edgeQuery.valueInt(maxAltIdx);
+
+    edge.airwayNameIndex = -1;
+    if(airwayNameIdx != -1)
+    {
+      QString name = edgeQuery.valueStr(airwayNameIdx);
+      if(!name.isEmpty())
+      {
+        // Intern name
+        auto it = airwayNameIndex.constFind(name);
+        if(it == airwayNameIndex.constEnd())
+        {
+          edge.airwayNameIndex = airwayNames.size();
+          airwayNameIndex.insert(name, edge.airwayNameIndex);
+          airwayNames.append(name);
+        }
+        else
+          edge.airwayNameIndex = it.value();
+      }
+    }
+
+    outEdges[from].append(edge);
+
+    // Add reverse edge to the other node
+    edge.toIndex = from;
+    if(edge.direction == nw::FORWARD)
+      edge.direction = nw::BACKWARD;
+    else if(edge.direction == nw::BACKWARD)
+      edge.direction = nw::FORWARD;
+    inEdges[to].append(edge);
+  }
+  edgeQuery.finish();
+
+  // Build compressed row arrays and remove duplicates like the QSet in RouteNetwork does
+  edgeOffsets.reserve(nodeIds.size() + 1);
+  int numEdges = 0;
+  for(int i = 0; i < nodeIds.size(); i++)
+    numEdges += outEdges.at(i).size() + inEdges.at(i).size();
+  edges.reserve(numEdges);
+
+  for(int i = 0; i < nodeIds.size(); i++)
+  {
+    int offset = edges.size();
+    edgeOffsets.append(offset);
+
+    for(const QVector<nw::GraphEdge> *list : {&outEdges.at(i), &inEdges.at(i)})
+    {
+      for(const nw::GraphEdge& edge : *list)
+      {
+        bool duplicate = false;
+        for(int j = offset; j < edges.size(); j++)
+        {
+          if(edges.at(j).toIndex == edge.toIndex && edges.at(j).type == edge.type)
+          {
+            duplicate = true;
+            break;
+          }
+        }
+
+        if(!duplicate)
+          edges.append(edge);
+      }
+    }
+
+    // Free temporary memory early
+    outEdges[i].clear();
+    inEdges[i].clear();
+  }
+  edgeOffsets.append(edges.size());
+  edges.squeeze();
+
+  loaded = true;
+
+  qDebug() << Q_FUNC_INFO << nodeTable << "nodes" << nodeIds.size() << "edges" << edges.size()
+           << "airway names" << airwayNames.size() << "memory" << getMemoryUsage() / 1024 << "kB"
+           << "took" << timer.elapsed() << "ms";
+}
+
+void RouteNetworkGraph::clear()
+{
+  loaded = false;
+  nodeIds.clear();
+  navIds.clear();
+  types.clear();
+  ranges.clear();
+  lonX.clear();
+  latY.clear();
+  indexById.clear();
+  edgeOffsets.clear();
+  edges.clear();
+  airwayNames.clear();
+}
+
+const QString& RouteNetworkGraph::getAirwayName(int nameIndex) const
+{
+  return nameIndex >= 0 && nameIndex < airwayNames.size() ? airwayNames.at(nameIndex) : emptyName;
+}
+
+qint64 RouteNetworkGraph::getMemoryUsage() const
+{
+  qint64 size = (nodeIds.capacity() + navIds.capacity() + types.capacity() + ranges.capacity() +
+                 indexById.capacity() + edgeOffsets.capacity()) * static_cast<qint64>(sizeof(int)) +
+                (lonX.capacity() + latY.capacity()) * static_cast<qint64>(sizeof(float)) +
+                edges.capacity() * static_cast<qint64>(sizeof(nw::GraphEdge));
+
+  for(const QString& name : airwayNames)
+    size += name.capacity() * static_cast<qint64>(sizeof(QChar)) + static_cast<qint64>(sizeof(QString));
+  return size;
+}
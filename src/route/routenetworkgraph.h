@@ -0,0 +1,160 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTENETWORKGRAPH_H
+#define LITTLENAVMAP_ROUTENETWORKGRAPH_H
+
+#include "geo/pos.h"
+
+#include <QVector>
+#include <QStringList>
+
+namespace  atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+namespace nw {
+
+/* Compact edge of the preloaded graph. The adjacent node is referenced by index into the graph node arrays. */
+struct GraphEdge
+{
+  int toIndex, lengthMeter, minAltFt, maxAltFt, airwayId,
+      airwayNameIndex /* Index into the interned airway names or -1 */;
+  qint8 type /* nw::EdgeType */, direction /* nw::EdgeDirection */;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(nw::GraphEdge, Q_PRIMITIVE_TYPE);
+
+/*
+ * Complete routing network loaded into memory in one go.
+ * Edges are stored in a compressed sparse row layout: all edges of the node at index i are found in
+ * edges[edgeOffsets[i]] to edges[edgeOffsets[i + 1] - 1]. Airway names are interned and referenced by index.
+ *
+ * Each edge from the database is added in both directions. Edges found from the other node have
+ * their direction reversed like RouteNetwork::createEdge does.
+ *
+ * Node types are stored unchanged as found in the database since the interpretation depends on the network mode.
+ */
+class RouteNetworkGraph
+{
+public:
+  RouteNetworkGraph();
+  ~RouteNetworkGraph();
+
+  /*
+   * Load all nodes and edges from the database. Replaces all currently loaded data.
+   * Table layout and column names are the same as used by RouteNetwork.
+   */
+  void load(atools::sql::SqlDatabase *db, const QString& nodeTable, const QString& edgeTable,
+            const QStringList& nodeExtraColumns, const QStringList& edgeExtraColumns);
+
+  /* Remove all nodes and edges and free memory */
+  void clear();
+
+  bool isLoaded() const
+  {
+    return loaded;
+  }
+
+  /* Number of nodes */
+  int size() const
+  {
+    return nodeIds.size();
+  }
+
+  /* Number of edges. Every database edge is counted twice. */
+  int getNumEdges() const
+  {
+    return edges.size();
+  }
+
+  /* Get index for database "node_id" or -1 if not found */
+  int indexOf(int nodeId) const
+  {
+    return nodeId >= 0 && nodeId < indexById.size() ? indexById.at(nodeId) : -1;
+  }
+
+  /* Database "node_id" for index */
+  int getNodeId(int index) const
+  {
+    return nodeIds.at(index);
+  }
+
+  /* Navaid id like "waypoint_id" or "vor_id" for index */
+  int getNavId(int index) const
+  {
+    return navIds.at(index);
+  }
+
+  /* Type as stored in the database. Contains type and subtype for the airway network. */
+  int getRawType(int index) const
+  {
+    return types.at(index);
+  }
+
+  /* Radio navaid range or 0 if not applicable */
+  int getRange(int index) const
+  {
+    return ranges.isEmpty() ? 0 : ranges.at(index);
+  }
+
+  atools::geo::Pos getPosition(int index) const
+  {
+    return atools::geo::Pos(lonX.at(index), latY.at(index));
+  }
+
+  /* First edge for the node at index. Use getEdgesEnd() to get the end. */
+  const nw::GraphEdge *getEdgesBegin(int index) const
+  {
+    return edges.constData() + edgeOffsets.at(index);
+  }
+
+  const nw::GraphEdge *getEdgesEnd(int index) const
+  {
+    return edges.constData() + edgeOffsets.at(index + 1);
+  }
+
+  /* Get interned airway name for the index from GraphEdge::airwayNameIndex. Returns an empty string for -1. */
+  const QString& getAirwayName(int nameIndex) const;
+
+  /* Approximate number of bytes allocated by this graph */
+  qint64 getMemoryUsage() const;
+
+private:
+  bool loaded = false;
+
+  /* Node arrays - all have the same size */
+  QVector<int> nodeIds, navIds, types, ranges /* empty if network has no ranges */;
+  QVector<float> lonX, latY;
+
+  /* Maps database "node_id" to node array index. -1 for unused ids. */
+  QVector<int> indexById;
+
+  /* Offsets into edges. Size is number of nodes + 1. */
+  QVector<int> edgeOffsets;
+  QVector<nw::GraphEdge> edges;
+
+  /* Interned airway names */
+  QVector<QString> airwayNames;
+  const QString emptyName;
+};
+
+#endif // LITTLENAVMAP_ROUTENETWORKGRAPH_H
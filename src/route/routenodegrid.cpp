@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routenodegrid.h"
+
+#include "geo/rect.h"
+
+#include <QDebug>
+
+RouteNodeGrid::RouteNodeGrid()
+{
+
+}
+
+RouteNodeGrid::~RouteNodeGrid()
+{
+
+}
+
+void RouteNodeGrid::clear()
+{
+  nodes.clear();
+  cellOffsets.clear();
+}
+
+int RouteNodeGrid::column(float lonx) const
+{
+  return std::min(std::max(static_cast<int>((lonx + 180.f) / CELL_SIZE_DEG), 0), NUM_COLUMNS - 1);
+}
+
+int RouteNodeGrid::row(float laty) const
+{
+  return std::min(std::max(static_cast<int>((laty + 90.f) / CELL_SIZE_DEG), 0), NUM_ROWS - 1);
+}
+
+void RouteNodeGrid::build(const QVector<nw::GridNode>& gridNodes)
+{
+  clear();
+
+  // Count nodes per cell
+  cellOffsets.fill(0, NUM_COLUMNS * NUM_ROWS + 1);
+  for(const nw::GridNode& node : gridNodes)
+    cellOffsets[row(node.laty) * NUM_COLUMNS + column(node.lonx) + 1]++;
+
+  // Convert counts to offsets
+  for(int i = 1; i < cellOffsets.size(); i++)
+    cellOffsets[i] += cellOffsets.at(i - 1);
+
+  // Sort nodes into cells
+  QVector<int> insertPos(cellOffsets);
+  nodes.resize(gridNodes.size());
+  for(const nw::GridNode& node : gridNodes)
+    nodes[insertPos[row(node.laty) * NUM_COLUMNS + column(node.lonx)]++] = node;
+
+  qDebug() << Q_FUNC_INFO << "nodes" << nodes.size();
+}
+
+void RouteNodeGrid::getNodesInRect(const atools::geo::Rect& rect, QVector<nw::GridNode>& result) const
+{
+  if(nodes.isEmpty() || !rect.isValid())
+    return;
+
+  float west = rect.getWest(), east = rect.getEast(), north = rect.getNorth(), south = rect.getSouth();
+  bool crossing = west > east;
+
+  int firstRow = row(south), lastRow = row(north);
+  int firstCol = column(west), lastCol = column(east);
+
+  // Number of columns to visit - wraps around at the anti-meridian
+  int numCols = crossing ? NUM_COLUMNS - firstCol + lastCol + 1 : lastCol - firstCol + 1;
+
+  for(int r = firstRow; r <= lastRow; r++)
+  {
+    for(int c = 0; c < numCols; c++)
+    {
+      int cell = r * NUM_COLUMNS + (firstCol + c) % NUM_COLUMNS;
+      for(int i = cellOffsets.at(cell); i < cellOffsets.at(cell + 1); i++)
+      {
+        const nw::GridNode& node = nodes.at(i);
+        if(node.laty < south || node.laty > north)
+          continue;
+
+        if(crossing ? (node.lonx >= west || node.lonx <= east) : (node.lonx >= west && node.lonx <= east))
+          result.append(node);
+      }
+    }
+  }
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTENODEGRID_H
+#define LITTLENAVMAP_ROUTENODEGRID_H
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class Rect;
+}
+}
+
+namespace nw {
+
+/* Minimal node information stored in the grid */
+struct GridNode
+{
+  int id /* Database "node_id" */, type /* Type as stored in the database */;
+  float lonx, laty;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(nw::GridNode, Q_PRIMITIVE_TYPE);
+
+/*
+ * Uniform latitude/longitude grid over all route network nodes.
+ * Nodes are sorted by cell and stored in one array. Cell offsets point to the first node of each cell.
+ * Rectangles crossing the anti-meridian are handled by wrapping the cell columns.
+ */
+class RouteNodeGrid
+{
+public:
+  RouteNodeGrid();
+  ~RouteNodeGrid();
+
+  /* Build grid from the given nodes. Replaces all current nodes. */
+  void build(const QVector<nw::GridNode>& gridNodes);
+
+  void clear();
+
+  bool isEmpty() const
+  {
+    return nodes.isEmpty();
+  }
+
+  int size() const
+  {
+    return nodes.size();
+  }
+
+  /* Get all nodes inside the rectangle. Rectangle can cross the anti-meridian. */
+  void getNodesInRect(const atools::geo::Rect& rect, QVector<nw::GridNode>& result) const;
+
+private:
+  int column(float lonx) const;
+  int row(float laty) const;
+
+  /* Cell size in degree */
+  static Q_DECL_CONSTEXPR int CELL_SIZE_DEG = 1;
+  static Q_DECL_CONSTEXPR int NUM_COLUMNS = 360 / CELL_SIZE_DEG;
+  static Q_DECL_CONSTEXPR int NUM_ROWS = 180 / CELL_SIZE_DEG;
+
+  /* Nodes sorted by cell index (row * NUM_COLUMNS + column) */
+  QVector<nw::GridNode> nodes;
+
+  /* First node index for each cell. Size is number of cells + 1. */
+  QVector<int> cellOffsets;
+};
+
+#endif // LITTLENAVMAP_ROUTENODEGRID_H
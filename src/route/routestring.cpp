@@ -24,10 +24,15 @@
 #include "query/mapquery.h"
 #include "query/airportquery.h"
 #include "route/flightplanentrybuilder.h"
+#include "route/routestringcache.h"
 #include "common/maptools.h"
 #include "common/unit.h"
+#include "fs/pln/flightplan.h"
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QRegularExpression>
+#include <QTextStream>
 
 using atools::fs::pln::Flightplan;
 using atools::fs::pln::FlightplanEntry;
@@ -52,9 +57,16 @@ const static QString SPANEND("</span>");
 RouteString::RouteString(FlightplanEntryBuilder *flightplanEntryBuilder)
   : entryBuilder(flightplanEntryBuilder)
 {
-  mapQuery = NavApp::getMapQuery();
   airportQuerySim = NavApp::getAirportQuerySim();
   procQuery = NavApp::getProcedureQuery();
+  cache = NavApp::getRouteStringCache();
+}
+
+RouteString::RouteString(FlightplanEntryBuilder *flightplanEntryBuilder, AirportQuery *airportQuerySimParam,
+                         ProcedureQuery *procQueryParam, RouteStringCache *cacheParam)
+  : airportQuerySim(airportQuerySimParam), procQuery(procQueryParam), cache(cacheParam),
+  entryBuilder(flightplanEntryBuilder)
+{
 }
 
 RouteString::~RouteString()
@@ -552,6 +564,57 @@ bool RouteString::createRouteFromString(const QString& routeString, atools::fs::
   return true;
 }
 
+QVector<rs::RouteStringResult> RouteString::createRoutesFromStrings(const QStringList& routeStrings)
+{
+  QVector<rs::RouteStringResult> results;
+  results.reserve(routeStrings.size());
+
+  for(const QString& routeString : routeStrings)
+    results.append(createRouteFromStringResult(routeString));
+  return results;
+}
+
+rs::RouteStringResult RouteString::createRouteFromStringResult(const QString& routeString)
+{
+  bool plaintext = plaintextMessages;
+  plaintextMessages = true;
+
+  rs::RouteStringResult result;
+  result.routeString = routeString;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  Flightplan flightplan;
+  result.valid = createRouteFromString(routeString, flightplan);
+  result.timeMicroseconds = timer.nsecsElapsed() / 1000;
+  result.numEntries = flightplan.getEntries().size();
+  result.messages = messages;
+
+  plaintextMessages = plaintext;
+  return result;
+}
+
+bool RouteString::readRouteStrings(const QString& filename, QStringList& routeStrings)
+{
+  QFile file(filename);
+  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    QTextStream stream(&file);
+    while(!stream.atEnd())
+    {
+      QString line = stream.readLine().trimmed();
+      if(!line.isEmpty() && !line.startsWith("#"))
+        routeStrings.append(line);
+    }
+    file.close();
+    return true;
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+  return false;
+}
+
 QStringList RouteString::cleanRouteString(const QString& string)
 {
   QString cleanstr = string.toUpper();
@@ -843,7 +906,6 @@ void RouteString::filterAirways(QList<ParseEntry>& resultList, int i)
 
   if(!result.airways.isEmpty())
   {
-    QList<map::MapWaypoint> waypoints;
     MapSearchResult& lastResult = resultList[i - 1].result;
     MapSearchResult& nextResult = resultList[i + 1].result;
     const QString& airwayName = resultList.at(i).item;
@@ -863,15 +925,13 @@ void RouteString::filterAirways(QList<ParseEntry>& resultList, int i)
       return;
     }
 
-    // Get all waypoints
-    mapQuery->getWaypointsForAirway(waypoints, airwayName, waypointStart);
-
-    if(!waypoints.isEmpty())
+    // Check if start waypoint is part of the airway
+    if(cache->hasAirwayWaypoint(airwayName, waypointStart))
     {
       QList<map::MapAirwayWaypoint> allAirwayWaypoints;
 
       // Get all waypoints for the airway sorted by fragment and sequence
-      mapQuery->getWaypointListForAirwayName(allAirwayWaypoints, airwayName);
+      cache->getWaypointListForAirwayName(allAirwayWaypoints, airwayName);
 
       if(!allAirwayWaypoints.isEmpty())
       {
@@ -936,7 +996,7 @@ void RouteString::findWaypoints(MapSearchResult& result, const QString& item)
   }
   else
   {
-    mapQuery->getMapObjectByIdent(result, ROUTE_TYPES, item);
+    cache->getMapObjectByIdent(result, item);
 
     if(item.length() == 5 && result.waypoints.isEmpty())
     {
@@ -32,11 +32,11 @@ class FlightplanEntry;
 }
 }
 
-class MapQuery;
 class AirportQuery;
 class ProcedureQuery;
 class FlightplanEntryBuilder;
 class Route;
+class RouteStringCache;
 
 namespace rs {
 
@@ -63,8 +63,29 @@ enum RouteStringOption
 
 Q_DECLARE_FLAGS(RouteStringOptions, RouteStringOption);
 Q_DECLARE_OPERATORS_FOR_FLAGS(rs::RouteStringOptions);
+
+/* Result of parsing one route string in bulk mode */
+struct RouteStringResult
+{
+  QString routeString;
+
+  /* False if departure or destination could not be resolved */
+  bool valid = false;
+
+  /* Number of flight plan entries including departure and destination */
+  int numEntries = 0;
+
+  /* Plain text errors, warnings and messages */
+  QStringList messages;
+
+  /* Time needed for parsing */
+  qint64 timeMicroseconds = 0;
+};
+
 }
 
+Q_DECLARE_TYPEINFO(rs::RouteStringResult, Q_MOVABLE_TYPE);
+
 /*
  * This class implementes the conversion from ATS route descriptions to flight plans and vice versa.
  * Additional functionality is available to generate route strings for various export formats.
@@ -76,6 +97,11 @@ class RouteString
 
 public:
   RouteString(FlightplanEntryBuilder *flightplanEntryBuilder = nullptr);
+
+  /* Use the given queries and cache instead of the global ones. Needed for instances used outside of the
+   * main thread. */
+  RouteString(FlightplanEntryBuilder *flightplanEntryBuilder, AirportQuery *airportQuerySimParam,
+              ProcedureQuery *procQueryParam, RouteStringCache *cacheParam);
   virtual ~RouteString();
 
   /*
@@ -98,6 +124,17 @@ public:
   bool createRouteFromString(const QString& routeString, atools::fs::pln::Flightplan& flightplan,
                              float& speedKts, bool& altIncluded);
 
+  /* Parse all route strings and return results in the same order. Messages are always plain text.
+   * Needs a flight plan entry builder. */
+  QVector<rs::RouteStringResult> createRoutesFromStrings(const QStringList& routeStrings);
+
+  /* Parse a single route string into a result. Messages are always plain text. */
+  rs::RouteStringResult createRouteFromStringResult(const QString& routeString);
+
+  /* Read route strings from a text file with one route per line. Empty lines and lines starting with "#"
+   * are skipped. Returns false if the file cannot be read. */
+  static bool readRouteStrings(const QString& filename, QStringList& routeStrings);
+
   const QStringList& getMessages() const
   {
     return messages;
@@ -147,9 +184,9 @@ private:
   bool extractSpeedAndAltitude(const QString& item, float& speedKnots, float& altFeet);
   QString createSpeedAndAltitude(float speedKnots, float altFeet);
 
-  MapQuery *mapQuery = nullptr;
   AirportQuery *airportQuerySim = nullptr;
   ProcedureQuery *procQuery = nullptr;
+  RouteStringCache *cache = nullptr;
   FlightplanEntryBuilder *entryBuilder = nullptr;
   QStringList messages;
   bool plaintextMessages = false;
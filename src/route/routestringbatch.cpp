@@ -0,0 +1,192 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routestringbatch.h"
+
+#include "route/flightplanentrybuilder.h"
+#include "route/routestringcache.h"
+#include "query/airportquery.h"
+#include "query/mapquery.h"
+#include "query/procedurequery.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+
+using atools::sql::SqlDatabase;
+
+/* Parses route strings until all are taken. Each worker has its own database connections and queries. */
+class RouteStringBatchWorker :
+  public QRunnable
+{
+public:
+  RouteStringBatchWorker(const RouteStringBatch *routeStringBatch, int workerIndex, const QStringList& strings,
+                         rs::RouteStringResult *routeResults, QAtomicInt& nextStringIndex, QMutex& queryMutex)
+    : batch(routeStringBatch), index(workerIndex), routeStrings(strings), results(routeResults),
+    nextIndex(nextStringIndex), initMutex(queryMutex)
+  {
+  }
+
+  virtual void run() override;
+
+private:
+  void parseRoutes(SqlDatabase *dbSim, SqlDatabase *dbNav);
+
+  /* Mark all route strings not taken yet as invalid with the given message */
+  void failRemaining(const QString& message);
+
+  const RouteStringBatch *batch;
+  int index;
+  const QStringList& routeStrings;
+  rs::RouteStringResult *results; /* Each worker writes only to the slots of its own route strings */
+  QAtomicInt& nextIndex;
+  QMutex& initMutex;
+};
+
+void RouteStringBatchWorker::run()
+{
+  QString simConnectionName = QString("LNMROUTESTRINGSIM%1").arg(index);
+  QString navConnectionName = QString("LNMROUTESTRINGNAV%1").arg(index);
+  SqlDatabase::addDatabase("QSQLITE", simConnectionName);
+  SqlDatabase::addDatabase("QSQLITE", navConnectionName);
+
+  {
+    SqlDatabase dbSim(simConnectionName), dbNav(navConnectionName);
+    try
+    {
+      dbSim.setDatabaseName(batch->simDatabaseFile);
+      dbSim.setReadonly();
+      dbSim.open();
+
+      dbNav.setDatabaseName(batch->navDatabaseFile);
+      dbNav.setReadonly();
+      dbNav.open();
+
+      parseRoutes(&dbSim, &dbNav);
+
+      dbNav.close();
+      dbSim.close();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "worker" << index << "caught exception" << e.what();
+      failRemaining(e.what());
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "worker" << index << "caught unknown exception";
+      failRemaining("Unknown error");
+    }
+  }
+
+  SqlDatabase::removeDatabase(navConnectionName);
+  SqlDatabase::removeDatabase(simConnectionName);
+}
+
+void RouteStringBatchWorker::failRemaining(const QString& message)
+{
+  int stringIndex;
+  while((stringIndex = nextIndex.fetchAndAddOrdered(1)) < routeStrings.size())
+  {
+    rs::RouteStringResult& result = results[stringIndex];
+    result.routeString = routeStrings.at(stringIndex);
+    result.valid = false;
+    result.messages.append(message);
+  }
+}
+
+void RouteStringBatchWorker::parseRoutes(SqlDatabase *dbSim, SqlDatabase *dbNav)
+{
+  // Deleted in reverse order when leaving or on exception
+  QScopedPointer<MapQuery> mapQuery;
+  QScopedPointer<AirportQuery> airportQuerySim, airportQueryNav;
+  QScopedPointer<ProcedureQuery> procQuery;
+  {
+    // Query constructors read and store the settings which is not thread safe
+    QMutexLocker locker(&initMutex);
+    mapQuery.reset(new MapQuery(nullptr, dbSim, dbNav));
+    airportQuerySim.reset(new AirportQuery(nullptr, dbSim, false /* nav */));
+    airportQueryNav.reset(new AirportQuery(nullptr, dbNav, true /* nav */));
+    mapQuery->setAirportQueries(airportQuerySim.data(), airportQueryNav.data());
+    procQuery.reset(new ProcedureQuery(dbNav, mapQuery.data(), airportQueryNav.data()));
+  }
+
+  mapQuery->initQueries();
+  airportQuerySim->initQueries();
+  airportQueryNav->initQueries();
+  procQuery->initQueries();
+
+  FlightplanEntryBuilder entryBuilder(mapQuery.data());
+  RouteStringCache cache(dbNav, mapQuery.data(), airportQuerySim.data());
+  RouteString routeString(&entryBuilder, airportQuerySim.data(), procQuery.data(), &cache);
+
+  int stringIndex;
+  while((stringIndex = nextIndex.fetchAndAddOrdered(1)) < routeStrings.size())
+  {
+    rs::RouteStringResult& result = results[stringIndex];
+    try
+    {
+      result = routeString.createRouteFromStringResult(routeStrings.at(stringIndex));
+    }
+    catch(atools::Exception& e)
+    {
+      result.routeString = routeStrings.at(stringIndex);
+      result.valid = false;
+      result.messages.append(e.what());
+    }
+    catch(...)
+    {
+      result.routeString = routeStrings.at(stringIndex);
+      result.valid = false;
+      result.messages.append("Unknown error");
+    }
+  }
+}
+
+RouteStringBatch::RouteStringBatch(const QString& simDatabaseFilename, const QString& navDatabaseFilename)
+  : simDatabaseFile(simDatabaseFilename), navDatabaseFile(navDatabaseFilename)
+{
+  numThreads = QThread::idealThreadCount();
+}
+
+RouteStringBatch::~RouteStringBatch()
+{
+
+}
+
+QVector<rs::RouteStringResult> RouteStringBatch::createRoutesFromStrings(const QStringList& routeStrings)
+{
+  QVector<rs::RouteStringResult> results(routeStrings.size());
+  QAtomicInt nextIndex(0);
+  QMutex initMutex;
+
+  int workers = std::max(1, std::min(numThreads, routeStrings.size()));
+  qDebug() << Q_FUNC_INFO << "route strings" << routeStrings.size() << "workers" << workers;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(workers);
+  for(int i = 0; i < workers; i++)
+    pool.start(new RouteStringBatchWorker(this, i, routeStrings, results.data(), nextIndex, initMutex));
+  pool.waitForDone();
+
+  return results;
+}
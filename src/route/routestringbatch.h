@@ -0,0 +1,56 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTESTRINGBATCH_H
+#define LITTLENAVMAP_ROUTESTRINGBATCH_H
+
+#include "route/routestring.h"
+
+/*
+ * Parses many route strings into flight plans without user interface.
+ *
+ * Route strings are distributed on a thread pool. Each worker thread opens its own read only connections to the
+ * simulator and navigation databases and uses its own set of map, airport and procedure queries as well as its own
+ * route string cache which are kept for all routes of the worker.
+ */
+class RouteStringBatch
+{
+public:
+  /*
+   * @param simDatabaseFilename Simulator database file
+   * @param navDatabaseFilename Navigation database file. Can be the same as the simulator database.
+   */
+  RouteStringBatch(const QString& simDatabaseFilename, const QString& navDatabaseFilename);
+  ~RouteStringBatch();
+
+  /* Parse all route strings and return results in the same order. Blocks until all are done. */
+  QVector<rs::RouteStringResult> createRoutesFromStrings(const QStringList& routeStrings);
+
+  /* Number of worker threads. Default is the ideal thread count. */
+  void setNumThreads(int value)
+  {
+    numThreads = value;
+  }
+
+private:
+  friend class RouteStringBatchWorker;
+
+  QString simDatabaseFile, navDatabaseFile;
+  int numThreads;
+};
+
+#endif // LITTLENAVMAP_ROUTESTRINGBATCH_H
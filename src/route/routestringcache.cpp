@@ -0,0 +1,174 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routestringcache.h"
+
+#include "common/maptypesfactory.h"
+#include "query/airportquery.h"
+#include "query/mapquery.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlRecord;
+
+/* Maximum number of idents in the cache */
+const static int MAX_IDENT_CACHE_SIZE = 20000;
+
+RouteStringCache::RouteStringCache(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam,
+                                   AirportQuery *airportQueryParam)
+  : dbNav(sqlDbNav), mapQuery(mapQueryParam), airportQuery(airportQueryParam)
+{
+  mapTypesFactory = new MapTypesFactory();
+  identCache.setMaxCost(MAX_IDENT_CACHE_SIZE);
+}
+
+RouteStringCache::~RouteStringCache()
+{
+  delete mapTypesFactory;
+}
+
+void RouteStringCache::clear()
+{
+  identCache.clear();
+  identCacheHits = identCacheMisses = 0;
+  airways.clear();
+  airwayWaypoints.clear();
+  airwaysLoaded = false;
+}
+
+void RouteStringCache::getMapObjectByIdent(map::MapSearchResult& result, const QString& ident)
+{
+  map::MapSearchResult *cached = identCache.object(ident);
+  if(cached == nullptr)
+  {
+    identCacheMisses++;
+    cached = new map::MapSearchResult;
+
+    // Airports from simulator database
+    map::MapAirport airport;
+    airportQuery->getAirportByIdent(airport, ident);
+    if(airport.isValid())
+      cached->airports.append(airport);
+
+    mapQuery->getMapObjectByIdent(*cached, map::WAYPOINT | map::VOR | map::NDB | map::AIRWAY, ident);
+    identCache.insert(ident, cached);
+  }
+  else
+    identCacheHits++;
+
+  result = *cached;
+}
+
+void RouteStringCache::getWaypointListForAirwayName(QList<map::MapAirwayWaypoint>& waypoints,
+                                                    const QString& airwayName)
+{
+  loadAirways();
+
+  for(const AirwayPoint& point : airways.value(airwayName))
+  {
+    map::MapAirwayWaypoint aw;
+    aw.waypoint = airwayWaypoints.value(point.waypointId);
+    aw.airwayId = point.airwayId;
+    aw.airwayFragmentId = point.fragment;
+    aw.seqNum = point.seqNum;
+    waypoints.append(aw);
+  }
+}
+
+bool RouteStringCache::hasAirwayWaypoint(const QString& airwayName, const QString& waypointIdent)
+{
+  loadAirways();
+
+  for(const AirwayPoint& point : airways.value(airwayName))
+  {
+    if(airwayWaypoints.value(point.waypointId).ident == waypointIdent)
+      return true;
+  }
+  return false;
+}
+
+void RouteStringCache::loadAirways()
+{
+  if(airwaysLoaded)
+    return;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  airwaysLoaded = true;
+  airways.clear();
+  airwayWaypoints.clear();
+
+  // Load all waypoints which are part of an airway
+  SqlQuery waypointQuery(dbNav);
+  waypointQuery.exec("select waypoint_id, ident, region, type, num_victor_airway, num_jet_airway, "
+                     "mag_var, lonx, laty from waypoint where waypoint_id in "
+                     "(select from_waypoint_id from airway union select to_waypoint_id from airway)");
+  while(waypointQuery.next())
+  {
+    map::MapWaypoint waypoint;
+    mapTypesFactory->fillWaypoint(waypointQuery.record(), waypoint);
+    airwayWaypoints.insert(waypoint.id, waypoint);
+  }
+
+  // Load segments in the same order as MapQuery::getWaypointListForAirwayName does for each airway
+  SqlQuery airwayQuery(dbNav);
+  airwayQuery.exec("select airway_name, airway_id, airway_fragment_no, sequence_no, "
+                   "from_waypoint_id, to_waypoint_id from airway "
+                   "order by airway_name, airway_fragment_no, sequence_no");
+
+  QString name;
+  int toWaypointId = -1;
+  AirwayPoint point = {-1, -1, -1, -1};
+  while(airwayQuery.next())
+  {
+    QString nextName = airwayQuery.valueStr("airway_name");
+    int nextFragment = airwayQuery.valueInt("airway_fragment_no");
+
+    if(point.waypointId != -1 && (nextName != name || nextFragment != point.fragment))
+    {
+      // Add to waypoint if this is the last one of the airway or if the fragment is about to change
+      point.waypointId = toWaypointId;
+      airways[name].append(point);
+    }
+
+    name = nextName;
+    point.fragment = nextFragment;
+    point.airwayId = airwayQuery.valueInt("airway_id");
+    point.seqNum = airwayQuery.valueInt("sequence_no");
+    point.waypointId = airwayQuery.valueInt("from_waypoint_id");
+    toWaypointId = airwayQuery.valueInt("to_waypoint_id");
+
+    // Add from waypoint
+    airways[name].append(point);
+  }
+
+  if(point.waypointId != -1)
+  {
+    // Add to waypoint of the last segment
+    point.waypointId = toWaypointId;
+    airways[name].append(point);
+  }
+
+  qDebug() << Q_FUNC_INFO << "airways" << airways.size() << "waypoints" << airwayWaypoints.size()
+           << "in" << timer.elapsed() << "ms";
+}
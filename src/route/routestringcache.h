@@ -0,0 +1,104 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_ROUTESTRINGCACHE_H
+#define LITTLENAVMAP_ROUTESTRINGCACHE_H
+
+#include "common/maptypes.h"
+
+#include <QCache>
+#include <QHash>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+class MapQuery;
+class AirportQuery;
+class MapTypesFactory;
+
+/*
+ * Caches used to resolve route strings without database queries.
+ *
+ * Results of ident lookups are kept in a least recently used cache. All airways are loaded at once on first
+ * access and kept as ordered arrays of waypoint ids per airway name together with all waypoints used by airways.
+ * Has to be cleared when the database changes.
+ */
+class RouteStringCache
+{
+public:
+  /*
+   * @param sqlDbNav navigation database containing airways and waypoints
+   * @param mapQueryParam used to look up navaids and airways by ident
+   * @param airportQueryParam used to look up airports by ident
+   */
+  RouteStringCache(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam, AirportQuery *airportQueryParam);
+  ~RouteStringCache();
+
+  /* Get airports, VOR, NDB, waypoints and airways for ident like MapQuery::getMapObjectByIdent.
+   * Result is not sorted by distance. */
+  void getMapObjectByIdent(map::MapSearchResult& result, const QString& ident);
+
+  /* Get all waypoints of an airway ordered by fragment and sequence number like
+   * MapQuery::getWaypointListForAirwayName */
+  void getWaypointListForAirwayName(QList<map::MapAirwayWaypoint>& waypoints, const QString& airwayName);
+
+  /* True if the airway contains a waypoint with the given ident */
+  bool hasAirwayWaypoint(const QString& airwayName, const QString& waypointIdent);
+
+  /* Load all airways and their waypoints. Done automatically on first airway access. */
+  void loadAirways();
+
+  /* Remove all cached objects */
+  void clear();
+
+  int getIdentCacheHits() const
+  {
+    return identCacheHits;
+  }
+
+  int getIdentCacheMisses() const
+  {
+    return identCacheMisses;
+  }
+
+private:
+  /* Airway point as loaded by MapQuery::getWaypointListForAirwayName but referring to the waypoint by id */
+  struct AirwayPoint
+  {
+    int waypointId, airwayId, fragment, seqNum;
+  };
+
+  atools::sql::SqlDatabase *dbNav;
+  MapQuery *mapQuery;
+  AirportQuery *airportQuery;
+  MapTypesFactory *mapTypesFactory;
+
+  QCache<QString, map::MapSearchResult> identCache;
+  int identCacheHits = 0, identCacheMisses = 0;
+
+  /* Airway name to points ordered by fragment and sequence number */
+  QHash<QString, QVector<AirwayPoint> > airways;
+
+  /* All waypoints which are part of airways by id */
+  QHash<int, map::MapWaypoint> airwayWaypoints;
+  bool airwaysLoaded = false;
+};
+
+#endif // LITTLENAVMAP_ROUTESTRINGCACHE_H
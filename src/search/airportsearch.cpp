@@ -236,6 +236,7 @@ AirportSearch::AirportSearch(QMainWindow *parent, QTableView *tableView, int tab
   view->setItemDelegateForColumn(columns->getColumn("ident")->getIndex(), iconDelegate);
 
   SearchBaseTable::initViewAndController(NavApp::getDatabaseSim());
+  SearchBaseTable::initTextIndex({"ident", "name", "city", "state", "country"});
 
   // Add model data handler and model format handler as callbacks
   setCallbacks();
@@ -164,6 +164,7 @@ NavSearch::NavSearch(QMainWindow *parent, QTableView *tableView, int tabWidgetIn
   view->setItemDelegateForColumn(columns->getColumn("ident")->getIndex(), iconDelegate);
 
   SearchBaseTable::initViewAndController(NavApp::getDatabaseNav());
+  SearchBaseTable::initTextIndex({"ident", "name", "region", "airport_ident"});
 
   // Add model data handler and model format handler as callbacks
   setCallbacks();
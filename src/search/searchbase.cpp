@@ -22,6 +22,8 @@
 #include "search/column.h"
 #include "ui_mainwindow.h"
 #include "search/columnlist.h"
+#include "search/searchtextindex.h"
+#include "search/searchspatialindex.h"
 #include "mapgui/mapwidget.h"
 #include "atools.h"
 #include "gui/actiontextsaver.h"
@@ -158,6 +160,8 @@ SearchBaseTable::~SearchBaseTable()
 {
   view->removeEventFilter(viewEventFilter);
   delete controller;
+  delete textIndex;
+  delete spatialIndex;
   delete csvExporter;
   delete updateTimer;
   delete zoomHandler;
@@ -171,6 +175,10 @@ void SearchBaseTable::tableCopyClipboard()
 {
   if(view->isVisible())
   {
+    // Avoid empty cells for rows not loaded yet
+    if(!controller->loadSelectedRows())
+      return;
+
     QString csv;
     SqlController *c = controller;
     int exported = CsvExporter::selectionAsCsv(view, true, csv, {"longitude", "latitude"},
@@ -197,9 +205,21 @@ void SearchBaseTable::initViewAndController(atools::sql::SqlDatabase *db)
   controller = new SqlController(db, columns, view);
   controller->prepareModel();
 
+  delete spatialIndex;
+  spatialIndex = new SearchSpatialIndex(db, columns->getTablename(), columns->getIdColumnName());
+  controller->setSpatialIndex(spatialIndex);
+
   csvExporter = new CsvExporter(mainWindow, controller);
 }
 
+void SearchBaseTable::initTextIndex(const QStringList& columnNames)
+{
+  delete textIndex;
+  textIndex = new SearchTextIndex(controller->getSqlDatabase(), columns->getTablename(),
+                                  columns->getIdColumnName(), columnNames);
+  controller->setTextIndex(textIndex);
+}
+
 void SearchBaseTable::filterByIdent(const QString& ident, const QString& region, const QString& airportIdent)
 {
   controller->filterByIdent(ident, region, airportIdent);
@@ -544,6 +564,12 @@ void SearchBaseTable::preDatabaseLoad()
 
 void SearchBaseTable::postDatabaseLoad()
 {
+  // Indexes are built again on next search if the database has changed
+  if(textIndex != nullptr)
+    textIndex->update();
+  if(spatialIndex != nullptr)
+    spatialIndex->update();
+
   controller->postDatabaseLoad();
   restoreViewState(controller->isDistanceSearch());
 }
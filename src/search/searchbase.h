@@ -37,6 +37,8 @@ class Column;
 class ViewEventFilter;
 class LineEditEventFilter;
 class QLineEdit;
+class SearchTextIndex;
+class SearchSpatialIndex;
 
 namespace atools {
 namespace sql {
@@ -138,6 +140,10 @@ protected:
   /* Derived have to call this in constructor. Initializes table view, header, controller and CSV export. */
   void initViewAndController(atools::sql::SqlDatabase *db);
 
+  /* Derived can call this after initViewAndController to resolve text searches for the given columns
+   * using an in-memory index */
+  void initTextIndex(const QStringList& columnNames);
+
   /* Connect widgets to the controller */
   void connectSearchWidgets();
 
@@ -148,6 +154,12 @@ protected:
   /* Table/view controller */
   SqlController *controller = nullptr;
 
+  /* Index for text columns. Null if not used. */
+  SearchTextIndex *textIndex = nullptr;
+
+  /* Index for distance search */
+  SearchSpatialIndex *spatialIndex = nullptr;
+
   /* Column definitions that will be used to create the SQL queries */
   ColumnList *columns;
   QTableView *view;
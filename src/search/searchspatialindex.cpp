@@ -0,0 +1,185 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "search/searchspatialindex.h"
+
+#include "geo/calculations.h"
+#include "geo/rect.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlDatabase;
+using atools::geo::Pos;
+using atools::geo::Rect;
+
+Q_DECL_CONSTEXPR int SearchSpatialIndex::MAX_IDS;
+
+SearchSpatialIndex::SearchSpatialIndex(SqlDatabase *sqlDb, const QString& tableName, const QString& idColumnName)
+  : db(sqlDb), table(tableName), idColumn(idColumnName)
+{
+}
+
+SearchSpatialIndex::~SearchSpatialIndex()
+{
+}
+
+void SearchSpatialIndex::update()
+{
+  if(built)
+  {
+    int numRows, maxId;
+    if(!tableStatistics(numRows, maxId) || numRows != tableRows || maxId != tableMaxId)
+      clear();
+  }
+}
+
+void SearchSpatialIndex::clear()
+{
+  built = false;
+  tableRows = tableMaxId = -1;
+  cellStart.clear();
+  ids.clear();
+  lonX.clear();
+  latY.clear();
+}
+
+bool SearchSpatialIndex::tableStatistics(int& numRows, int& maxId) const
+{
+  SqlQuery query(db);
+  query.exec("select count(1), max(" + idColumn + ") from " + table);
+  if(query.next())
+  {
+    numRows = query.value(0).toInt();
+    maxId = query.value(1).toInt();
+    return true;
+  }
+  return false;
+}
+
+int SearchSpatialIndex::cellColumn(float lonX)
+{
+  return std::max(0, std::min(static_cast<int>(std::floor(lonX + 180.f)), GRID_COLUMNS - 1));
+}
+
+int SearchSpatialIndex::cellRow(float latY)
+{
+  return std::max(0, std::min(static_cast<int>(std::floor(latY + 90.f)), GRID_ROWS - 1));
+}
+
+void SearchSpatialIndex::build()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+  tableStatistics(tableRows, tableMaxId);
+
+  QVector<int> rowIds, rowCells;
+  QVector<float> rowLonX, rowLatY;
+
+  SqlQuery query(db);
+  query.exec("select " + idColumn + ", lonx, laty from " + table);
+  while(query.next())
+  {
+    float lon = query.value(1).toFloat(), lat = query.value(2).toFloat();
+    rowIds.append(query.value(0).toInt());
+    rowLonX.append(lon);
+    rowLatY.append(lat);
+    rowCells.append(cellRow(lat) * GRID_COLUMNS + cellColumn(lon));
+  }
+
+  // Counting sort by cell
+  cellStart.fill(0, GRID_COLUMNS * GRID_ROWS + 1);
+  for(int cell : rowCells)
+    cellStart[cell + 1]++;
+  for(int i = 1; i < cellStart.size(); i++)
+    cellStart[i] += cellStart.at(i - 1);
+
+  ids.resize(rowIds.size());
+  lonX.resize(rowIds.size());
+  latY.resize(rowIds.size());
+  QVector<int> next(cellStart);
+  for(int i = 0; i < rowIds.size(); i++)
+  {
+    int idx = next[rowCells.at(i)]++;
+    ids[idx] = rowIds.at(i);
+    lonX[idx] = rowLonX.at(i);
+    latY[idx] = rowLatY.at(i);
+  }
+
+  built = true;
+  qDebug() << Q_FUNC_INFO << table << ids.size() << "rows" << timer.elapsed() << "ms";
+}
+
+bool SearchSpatialIndex::search(const Pos& center, float minDistMeter, float maxDistMeter,
+                                sqlproxymodel::SearchDirection dir, QVector<SearchSpatialResult>& result)
+{
+  result.clear();
+
+  if(!built)
+    build();
+
+  Rect boundingRect(center, maxDistMeter);
+  QList<Rect> rects;
+  if(boundingRect.crossesAntiMeridian())
+    rects = boundingRect.splitAtAntiMeridian();
+  else
+    rects.append(boundingRect);
+
+  for(const Rect& rect : rects)
+  {
+    int col1 = cellColumn(rect.getWest()), col2 = cellColumn(rect.getEast());
+    int row1 = cellRow(rect.getSouth()), row2 = cellRow(rect.getNorth());
+
+    for(int row = row1; row <= row2; row++)
+    {
+      // Cells of one grid row are consecutive
+      int start = cellStart.at(row * GRID_COLUMNS + col1), end = cellStart.at(row * GRID_COLUMNS + col2 + 1);
+      for(int i = start; i < end; i++)
+      {
+        Pos pos(lonX.at(i), latY.at(i));
+        float distMeter = pos.distanceMeterTo(center);
+        if(distMeter >= minDistMeter && distMeter <= maxDistMeter)
+        {
+          float heading = atools::geo::normalizeCourse(center.angleDegTo(pos));
+          if(sqlproxymodel::matchDirection(dir, heading))
+          {
+            result.append({ids.at(i), distMeter, heading});
+            if(result.size() > MAX_IDS)
+            {
+              result.clear();
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  std::sort(result.begin(), result.end(), [](const SearchSpatialResult& r1, const SearchSpatialResult& r2) -> bool
+  {
+    return r1.distanceMeter < r2.distanceMeter;
+  });
+  return true;
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_SEARCHSPATIALINDEX_H
+#define LITTLENAVMAP_SEARCHSPATIALINDEX_H
+
+#include "search/sqlproxymodel.h"
+
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/* Row found by a radius search */
+struct SearchSpatialResult
+{
+  int id;
+  float distanceMeter, headingDeg;
+};
+
+/*
+ * In-memory index over the positions of a search table for radius searches. Rows are bucketed into a grid of
+ * one degree cells. A search checks only the cells overlapping the bounding rectangle of the radius and computes
+ * distance and heading once for each row in these cells.
+ *
+ * The index is built on first search and dropped by update() if the table content has changed.
+ */
+class SearchSpatialIndex
+{
+public:
+  /* Table needs columns lonx and laty */
+  SearchSpatialIndex(atools::sql::SqlDatabase *sqlDb, const QString& tableName, const QString& idColumnName);
+  ~SearchSpatialIndex();
+
+  /* Drop index if number of rows or maximum id of the table have changed. Call after loading a database. */
+  void update();
+
+  /* Drop index */
+  void clear();
+
+  /*
+   * Get all rows within minimum and maximum distance and in the given direction from center ordered by distance.
+   * @return false if the result has more than MAX_IDS rows. The caller has to use a SQL condition in this case.
+   */
+  bool search(const atools::geo::Pos& center, float minDistMeter, float maxDistMeter,
+              sqlproxymodel::SearchDirection dir, QVector<SearchSpatialResult>& result);
+
+  /* Maximum number of rows returned by search */
+  static Q_DECL_CONSTEXPR int MAX_IDS = 20000;
+
+private:
+  void build();
+
+  /* Table row count and maximum id */
+  bool tableStatistics(int& numRows, int& maxId) const;
+
+  static int cellColumn(float lonX);
+  static int cellRow(float latY);
+
+  static Q_DECL_CONSTEXPR int GRID_COLUMNS = 360;
+  static Q_DECL_CONSTEXPR int GRID_ROWS = 180;
+
+  atools::sql::SqlDatabase *db;
+  QString table, idColumn;
+
+  bool built = false;
+  int tableRows = -1, tableMaxId = -1;
+
+  /* Index of first entry for each cell. Has one additional element for the end. */
+  QVector<int> cellStart;
+
+  /* Entries sorted by cell */
+  QVector<int> ids;
+  QVector<float> lonX, latY;
+};
+
+#endif // LITTLENAVMAP_SEARCHSPATIALINDEX_H
@@ -0,0 +1,259 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "search/searchtextindex.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+using atools::sql::SqlQuery;
+using atools::sql::SqlDatabase;
+
+Q_DECL_CONSTEXPR int SearchTextIndex::MAX_IDS;
+
+SearchTextIndex::SearchTextIndex(SqlDatabase *sqlDb, const QString& tableName, const QString& idColumnName,
+                                 const QStringList& columnNames)
+  : db(sqlDb), table(tableName), idColumn(idColumnName), columns(columnNames)
+{
+}
+
+SearchTextIndex::~SearchTextIndex()
+{
+}
+
+void SearchTextIndex::update()
+{
+  if(built)
+  {
+    int numRows, maxId;
+    if(!tableStatistics(numRows, maxId) || numRows != tableRows || maxId != tableMaxId)
+      clear();
+  }
+}
+
+void SearchTextIndex::clear()
+{
+  built = false;
+  tableRows = tableMaxId = -1;
+  ids.clear();
+  columnIndexes.clear();
+}
+
+bool SearchTextIndex::tableStatistics(int& numRows, int& maxId) const
+{
+  SqlQuery query(db);
+  query.exec("select count(1), max(" + idColumn + ") from " + table);
+  if(query.next())
+  {
+    numRows = query.value(0).toInt();
+    maxId = query.value(1).toInt();
+    return true;
+  }
+  return false;
+}
+
+void SearchTextIndex::build()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  clear();
+  tableStatistics(tableRows, tableMaxId);
+
+  for(const QString& column : columns)
+    columnIndexes.insert(column, ColumnIndex());
+
+  // Hash is not changed below - pointers stay valid
+  QVector<ColumnIndex *> indexes;
+  for(const QString& column : columns)
+    indexes.append(&columnIndexes[column]);
+
+  SqlQuery query(db);
+  query.exec("select " + idColumn + ", " + columns.join(", ") + " from " + table);
+
+  int row = 0;
+  while(query.next())
+  {
+    ids.append(query.value(0).toInt());
+
+    for(int c = 0; c < indexes.size(); c++)
+    {
+      ColumnIndex *index = indexes.at(c);
+      QString value = query.value(c + 1).toString().toLower();
+
+      for(int i = 0; i + 3 <= value.size(); i++)
+      {
+        QVector<int>& rows = index->trigrams[trigram(value, i)];
+        // Add row only once if trigram is repeated in value
+        if(rows.isEmpty() || rows.last() != row)
+          rows.append(row);
+      }
+      index->values.append(value);
+    }
+    row++;
+  }
+
+  for(ColumnIndex *index : indexes)
+  {
+    index->sorted.resize(row);
+    std::iota(index->sorted.begin(), index->sorted.end(), 0);
+    const QVector<QString>& values = index->values;
+    std::sort(index->sorted.begin(), index->sorted.end(), [&values](int r1, int r2) -> bool
+    {
+      return values.at(r1) < values.at(r2);
+    });
+  }
+
+  built = true;
+  qDebug() << Q_FUNC_INFO << table << row << "rows" << timer.elapsed() << "ms";
+}
+
+bool SearchTextIndex::lookup(const QString& column, const QString& pattern, QVector<int>& result)
+{
+  if(!columns.contains(column) || pattern.contains('_'))
+    // Single character wildcard is not supported
+    return false;
+
+  if(!built)
+    build();
+
+  auto it = columnIndexes.constFind(column);
+  if(it == columnIndexes.constEnd())
+    return false;
+  const ColumnIndex& index = it.value();
+
+  QStringList parts = pattern.toLower().split('%');
+
+  // Find candidate rows by prefix or by the longest text between wildcards
+  QVector<int> rows;
+  if(!parts.first().isEmpty())
+    prefixRows(index, parts.first(), rows);
+  else
+  {
+    QString longest;
+    for(const QString& part : parts)
+    {
+      if(part.size() > longest.size())
+        longest = part;
+    }
+
+    if(longest.size() < 3)
+      // Too short for trigrams - leave it to SQL
+      return false;
+
+    trigramRows(index, longest, rows);
+  }
+
+  // Check candidates against the full pattern
+  result.clear();
+  for(int row : rows)
+  {
+    if(matches(index.values.at(row), parts))
+    {
+      result.append(ids.at(row));
+      if(result.size() > MAX_IDS)
+        return false;
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return true;
+}
+
+void SearchTextIndex::prefixRows(const ColumnIndex& index, const QString& prefix, QVector<int>& rows) const
+{
+  const QVector<QString>& values = index.values;
+  auto it = std::lower_bound(index.sorted.constBegin(), index.sorted.constEnd(), prefix,
+                             [&values](int row, const QString& text) -> bool
+  {
+    return values.at(row) < text;
+  });
+
+  for(; it != index.sorted.constEnd() && values.at(*it).startsWith(prefix); ++it)
+    rows.append(*it);
+
+  // Keep row order to allow sequential access
+  std::sort(rows.begin(), rows.end());
+}
+
+void SearchTextIndex::trigramRows(const ColumnIndex& index, const QString& text, QVector<int>& rows) const
+{
+  // Collect posting lists for all trigrams of text
+  QVector<const QVector<int> *> postings;
+  for(int i = 0; i + 3 <= text.size(); i++)
+  {
+    auto it = index.trigrams.constFind(trigram(text, i));
+    if(it == index.trigrams.constEnd())
+      // Trigram does not exist - no match
+      return;
+    postings.append(&it.value());
+  }
+
+  // Intersect starting with the shortest list
+  std::sort(postings.begin(), postings.end(), [](const QVector<int> *p1, const QVector<int> *p2) -> bool
+  {
+    return p1->size() < p2->size();
+  });
+
+  rows = *postings.first();
+  for(int i = 1; i < postings.size() && !rows.isEmpty(); i++)
+  {
+    QVector<int> intersection;
+    std::set_intersection(rows.constBegin(), rows.constEnd(), postings.at(i)->constBegin(),
+                          postings.at(i)->constEnd(), std::back_inserter(intersection));
+    rows = intersection;
+  }
+}
+
+quint64 SearchTextIndex::trigram(const QString& text, int pos)
+{
+  return static_cast<quint64>(text.at(pos).unicode()) << 32 |
+         static_cast<quint64>(text.at(pos + 1).unicode()) << 16 |
+         static_cast<quint64>(text.at(pos + 2).unicode());
+}
+
+bool SearchTextIndex::matches(const QString& value, const QStringList& parts)
+{
+  if(parts.size() == 1)
+    // No wildcard
+    return value == parts.first();
+
+  // First part is anchored at the start and last part at the end
+  const QString& first = parts.first(), & last = parts.last();
+  if(!value.startsWith(first))
+    return false;
+
+  int pos = first.size();
+  for(int i = 1; i < parts.size() - 1; i++)
+  {
+    const QString& part = parts.at(i);
+    if(!part.isEmpty())
+    {
+      int idx = value.indexOf(part, pos);
+      if(idx == -1)
+        return false;
+      pos = idx + part.size();
+    }
+  }
+  return value.size() - last.size() >= pos && value.endsWith(last);
+}
@@ -0,0 +1,114 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_SEARCHTEXTINDEX_H
+#define LITTLENAVMAP_SEARCHTEXTINDEX_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/*
+ * In-memory prefix and trigram index over text columns of a search table. Resolves the SQL "like" patterns
+ * created by SqlModel to a list of row ids without scanning the table.
+ *
+ * The index is built on first lookup and dropped by update() if the table content has changed.
+ * Matching is case insensitive like the SQLite "like" operator.
+ */
+class SearchTextIndex
+{
+public:
+  /*
+   * @param sqlDb database to use
+   * @param tableName table to index
+   * @param idColumnName id column of the table
+   * @param columnNames text columns to index
+   */
+  SearchTextIndex(atools::sql::SqlDatabase *sqlDb, const QString& tableName, const QString& idColumnName,
+                  const QStringList& columnNames);
+  ~SearchTextIndex();
+
+  /* Drop index if number of rows or maximum id of the table have changed. Call after loading a database. */
+  void update();
+
+  /* Drop index */
+  void clear();
+
+  /* True if column is covered by the index */
+  bool hasColumn(const QString& column) const
+  {
+    return columns.contains(column);
+  }
+
+  /*
+   * Get sorted ids of all rows where the column matches the "like" pattern. "%" is the only supported wildcard.
+   * @return false if the pattern cannot be resolved by the index or the result is too large. The caller has to
+   * use a SQL condition in this case.
+   */
+  bool lookup(const QString& column, const QString& pattern, QVector<int>& ids);
+
+  /* Maximum number of ids returned by lookup */
+  static Q_DECL_CONSTEXPR int MAX_IDS = 20000;
+
+private:
+  struct ColumnIndex
+  {
+    /* Lower case values by row index */
+    QVector<QString> values;
+
+    /* Row indexes sorted by value for prefix search */
+    QVector<int> sorted;
+
+    /* Row indexes containing a trigram. Key is three packed UTF-16 code units. */
+    QHash<quint64, QVector<int> > trigrams;
+  };
+
+  void build();
+
+  /* Table row count and maximum id */
+  bool tableStatistics(int& numRows, int& maxId) const;
+
+  /* Row indexes of all values starting with prefix */
+  void prefixRows(const ColumnIndex& index, const QString& prefix, QVector<int>& rows) const;
+
+  /* Row indexes of all values containing text which must have at least three characters */
+  void trigramRows(const ColumnIndex& index, const QString& text, QVector<int>& rows) const;
+
+  static quint64 trigram(const QString& text, int pos);
+
+  /* Match value against pattern parts which were separated by "%" */
+  static bool matches(const QString& value, const QStringList& parts);
+
+  atools::sql::SqlDatabase *db;
+  QString table, idColumn;
+  QStringList columns;
+
+  bool built = false;
+  int tableRows = -1, tableMaxId = -1;
+
+  /* Row ids by row index */
+  QVector<int> ids;
+  QHash<QString, ColumnIndex> columnIndexes;
+};
+
+#endif // LITTLENAVMAP_SEARCHTEXTINDEX_H
@@ -20,6 +20,7 @@
 #include "geo/calculations.h"
 #include "search/column.h"
 #include "search/columnlist.h"
+#include "search/searchspatialindex.h"
 #include "sql/sqlrecord.h"
 
 #include <QTableView>
@@ -200,7 +201,8 @@ void SqlController::filterByDistance(const atools::geo::Pos& center, sqlproxymod
     // Update distances in proxy to get precise radius filtering (second filter stage)
     proxyModel->setDistanceFilter(center, dir, minDistance, maxDistance);
 
-    // Update rectangle filter in query model (first coarse filter stage)
+    // Update rectangle filter or precise id list in query model (first filter stage)
+    updateDistanceSearchIds(center, dir, minDistance, maxDistance);
     model->filterByBoundingRect(rect);
 
     if(proxyWasNull)
@@ -227,6 +229,7 @@ void SqlController::filterByDistance(const atools::geo::Pos& center, sqlproxymod
       proxyModel = nullptr;
     }
 
+    model->setBoundingRectIds(QVector<int>(), false);
     model->filterByBoundingRect(atools::geo::Rect());
     model->fillHeaderData();
     processViewColumns();
@@ -245,12 +248,37 @@ void SqlController::filterByDistanceUpdate(sqlproxymodel::SearchDirection dir, f
 
     // Update proxy second stage filter
     proxyModel->setDistanceFilter(currentDistanceCenter, dir, minDistance, maxDistance);
-    // Update SQL model coarse first stage filter
+    // Update SQL model first stage filter
+    updateDistanceSearchIds(currentDistanceCenter, dir, minDistance, maxDistance);
     model->filterByBoundingRect(rect);
     searchParamsChanged = true;
   }
 }
 
+void SqlController::updateDistanceSearchIds(const atools::geo::Pos& center, sqlproxymodel::SearchDirection dir,
+                                            float minDistance, float maxDistance)
+{
+  QVector<int> ids;
+  QVector<SearchSpatialResult> result;
+  bool valid = false;
+  if(spatialIndex != nullptr)
+  {
+    valid = spatialIndex->search(center, atools::geo::nmToMeter(minDistance), atools::geo::nmToMeter(maxDistance),
+                                 dir, result);
+    // Keep ids in distance order
+    ids.reserve(result.size());
+    for(const SearchSpatialResult& r : result)
+      ids.append(r.id);
+  }
+
+  // Pass distance and heading to the proxy to avoid calculating them again
+  if(proxyModel != nullptr)
+    proxyModel->setSpatialResults(valid ? result : QVector<SearchSpatialResult>(), columns->getIdColumnName());
+
+  // Falls back to the bounding rectangle if not valid
+  model->setBoundingRectIds(ids, valid);
+}
+
 /* Set new model into view and delete old selection model to avoid memory leak */
 void SqlController::viewSetModel(QAbstractItemModel *newModel)
 {
@@ -451,9 +479,17 @@ void SqlController::updateHeaderData()
   model->fillHeaderData();
 }
 
+void SqlController::setTextIndex(SearchTextIndex *value)
+{
+  textIndex = value;
+  if(model != nullptr)
+    model->setTextIndex(textIndex);
+}
+
 void SqlController::prepareModel()
 {
   model = new SqlModel(parentWidget, db, columns);
+  model->setTextIndex(textIndex);
 
   viewSetModel(model);
 
@@ -467,16 +503,12 @@ void SqlController::loadAllRowsForDistanceSearch()
   {
     QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-    // Run query again
+    // Run query again - rows are published when all pages are loaded in the background if paging is enabled
     model->resetSqlQuery();
 
-    // Let proxy know that filter parameters have changed
+    // Let proxy know that filter parameters have changed - this will read all rows for filtering
     proxyModel->invalidate();
 
-    while(model->canFetchMore())
-      // Fetch as long as we can
-      model->fetchMore(QModelIndex());
-
     QGuiApplication::restoreOverrideCursor();
     searchParamsChanged = false;
   }
@@ -490,21 +522,40 @@ void SqlController::setDataCallback(const SqlModel::DataFunctionType& value,
 
 void SqlController::loadAllRows()
 {
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-
+  // The model covers all rows of the result - pages are loaded when accessed
   if(proxyModel != nullptr)
   {
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+
     // Run query again
     model->resetSqlQuery();
 
     // Let proxy know that filter parameters have changed
     proxyModel->invalidate();
-  }
 
-  while(model->canFetchMore())
-    model->fetchMore(QModelIndex());
+    QGuiApplication::restoreOverrideCursor();
+  }
+}
 
-  QGuiApplication::restoreOverrideCursor();
+bool SqlController::loadSelectedRows()
+{
+  QVector<std::pair<int, int> > ranges;
+  const QItemSelection selection = getSelection();
+  for(const QItemSelectionRange& range : selection)
+  {
+    if(proxyModel != nullptr)
+    {
+      // Rows are not contiguous in the source model
+      for(int row = range.top(); row <= range.bottom(); row++)
+      {
+        int srow = toSource(proxyModel->index(row, 0)).row();
+        ranges.append(std::make_pair(srow, srow));
+      }
+    }
+    else
+      ranges.append(std::make_pair(range.top(), range.bottom()));
+  }
+  return model->loadRows(ranges);
 }
 
 QVector<const Column *> SqlController::getCurrentColumns() const
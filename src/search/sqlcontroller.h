@@ -33,6 +33,8 @@ class SqlDatabase;
 class QWidget;
 class QTableView;
 class ColumnList;
+class SearchTextIndex;
+class SearchSpatialIndex;
 
 /*
  * Combines all functionality around the table SQL model, view, view header and
@@ -50,6 +52,10 @@ public:
   /* Load all rows into the view */
   void loadAllRows();
 
+  /* Load the pages of all selected rows into the model cache in background while showing a progress dialog.
+   * Returns false if canceled by the user. */
+  bool loadSelectedRows();
+
   /* Restore columns ordering, sorting and column widths to default */
   void resetView();
 
@@ -174,9 +180,22 @@ public:
 
   void updateHeaderData();
 
+  /* Set index used by the model to resolve text search conditions. Can be null. */
+  void setTextIndex(SearchTextIndex *value);
+
+  /* Set index used to find rows for distance search instead of a bounding rectangle query. Can be null. */
+  void setSpatialIndex(SearchSpatialIndex *value)
+  {
+    spatialIndex = value;
+  }
+
 private:
   void viewSetModel(QAbstractItemModel *newModel);
 
+  /* Get ids for distance search from the spatial index and pass them to the model */
+  void updateDistanceSearchIds(const atools::geo::Pos& center, sqlproxymodel::SearchDirection dir,
+                               float minDistance, float maxDistance);
+
   /* Adapt columns to query change */
   void processViewColumns();
 
@@ -196,6 +215,8 @@ private:
   atools::sql::SqlDatabase *db = nullptr;
   QTableView *view = nullptr;
   ColumnList *columns = nullptr;
+  SearchTextIndex *textIndex = nullptr;
+  SearchSpatialIndex *spatialIndex = nullptr;
 
   /* The model query is executed immediately if distance search is not used. For distance search
    * use a delayed approach that checks if any query parameters are changed. Changed parameters
@@ -17,6 +17,7 @@
 
 #include "search/sqlmodel.h"
 
+#include "common/constants.h"
 #include "gui/application.h"
 #include "gui/errorhandler.h"
 #include "search/columnlist.h"
@@ -24,21 +25,39 @@
 #include "sql/sqlquery.h"
 #include "exception.h"
 #include "search/column.h"
+#include "search/searchtextindex.h"
+#include "settings/settings.h"
 #include "sql/sqlrecord.h"
 
 #include <QLineEdit>
 #include <QCheckBox>
-#include <QSqlError>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QProgressDialog>
+#include <QSqlField>
 #include <QRegularExpression>
 
+#include <algorithm>
+
 using atools::sql::SqlQuery;
 using atools::sql::SqlDatabase;
 using atools::gui::ErrorHandler;
 using atools::sql::SqlRecord;
+using atools::settings::Settings;
 
 SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *columnList)
-  : QSqlQueryModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
+  : QAbstractTableModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
 {
+  Settings& settings = Settings::instance();
+  maxCachedPages = std::max(settings.getAndStoreValue(lnm::SETTINGS_SEARCH + "MaxCachedPages", 256).toInt(), 4);
+  pageCache.setMaxCost(maxCachedPages);
+
+  if(settings.getAndStoreValue(lnm::SETTINGS_SEARCH + "BackgroundPaging", true).toBool())
+  {
+    pager = new SqlModelPager(this);
+    connect(pager, &SqlModelPager::pageLoaded, this, &SqlModel::pagerPageLoaded);
+  }
+
   // Set default handler
   setDataCallback(nullptr, QSet<Qt::ItemDataRole>());
 
@@ -47,6 +66,8 @@ SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *column
 
 SqlModel::~SqlModel()
 {
+  // Close open statement on the GUI connection
+  clearPages();
 }
 
 void SqlModel::filterIncluding(QModelIndex index)
@@ -67,6 +88,12 @@ void SqlModel::filterByBoundingRect(const atools::geo::Rect& boundingRectangle)
   buildQuery();
 }
 
+void SqlModel::setBoundingRectIds(const QVector<int>& ids, bool valid)
+{
+  boundingRectIds = ids;
+  boundingRectIdsValid = valid;
+}
+
 void SqlModel::filterByIdent(const QString& ident, const QString& region, const QString& airportIdent)
 {
   // Build filter conditions
@@ -86,7 +113,7 @@ void SqlModel::filterByIdent(const QString& ident, const QString& region, const
 void SqlModel::filterBy(QModelIndex index, bool exclude)
 {
   QString whereCol = getSqlRecord().fieldName(index.column());
-  filterBy(exclude, whereCol, QSqlQueryModel::data(index));
+  filterBy(exclude, whereCol, getRawData(index.row(), index.column()));
 }
 
 /* Simple include/exclude filter. Updates the attached search widgets */
@@ -300,6 +327,8 @@ void SqlModel::clearWhereConditions()
 {
   whereConditionMap.clear();
   boundingRect = atools::geo::Rect();
+  boundingRectIds.clear();
+  boundingRectIdsValid = false;
 }
 
 /* Set header captions */
@@ -479,6 +508,10 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols)
     if(numCond++ > 0)
       queryWhere += " " + WHERE_OPERATOR + " ";
 
+    if(buildWhereTextIndex(cond, queryWhere))
+      // Text condition replaced by id list
+      continue;
+
     if(cond.col->isIncludesName())
       // Condition includes column name
       queryWhere += " " + cond.oper + " ";
@@ -492,7 +525,15 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols)
   if(boundingRect.isValid())
   {
     QString rectCond;
-    if(boundingRect.crossesAntiMeridian())
+    if(boundingRectIdsValid)
+    {
+      // Use precise result of spatial search
+      QStringList idStrings;
+      for(int id : boundingRectIds)
+        idStrings.append(QString::number(id));
+      rectCond = columns->getIdColumnName() + " in (" + idStrings.join(",") + ")";
+    }
+    else if(boundingRect.crossesAntiMeridian())
     {
       QList<atools::geo::Rect> rect = boundingRect.splitAtAntiMeridian();
 
@@ -523,6 +564,25 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols)
   return queryWhere;
 }
 
+/* Resolve a "like" condition to an "id in" condition using the text index */
+bool SqlModel::buildWhereTextIndex(const WhereCondition& cond, QString& queryWhere)
+{
+  if(textIndex == nullptr || cond.oper.trimmed() != "like" || cond.value.type() != QVariant::String ||
+     !textIndex->hasColumn(cond.col->getColumnName()))
+    return false;
+
+  QVector<int> ids;
+  if(!textIndex->lookup(cond.col->getColumnName(), cond.value.toString(), ids))
+    return false;
+
+  QStringList idStrings;
+  for(int id : ids)
+    idStrings.append(QString::number(id));
+
+  queryWhere += columns->getIdColumnName() + " in (" + idStrings.join(",") + ")";
+  return true;
+}
+
 /* Convert a value to string for the where clause */
 QString SqlModel::buildWhereValue(const WhereCondition& cond)
 {
@@ -542,10 +602,264 @@ QString SqlModel::buildWhereValue(const WhereCondition& cond)
 
 void SqlModel::resetSqlQuery()
 {
-  QSqlQueryModel::setQuery(currentSqlQuery, db->getQSqlDatabase());
+  beginResetModel();
+  clearPages();
+  numRows = 0;
+
+  try
+  {
+    // Get field names and types without fetching rows
+    SqlQuery recordStmt(db);
+    recordStmt.exec(currentSqlQuery + " limit 0");
+    SqlRecord rec = recordStmt.record();
+
+    queryRecord.clear();
+    for(int i = 0; i < rec.count(); i++)
+      queryRecord.append(QSqlField(rec.fieldName(i), rec.fieldType(i)));
+
+    if(pager != nullptr && !pager->isOpen())
+    {
+      if(!pager->open("LNMSEARCH" + columns->getTablename().toUpper(), db->databaseName()))
+        qWarning() << Q_FUNC_INFO << "Cannot open pager - loading pages in GUI thread";
+    }
+
+    if(boundingRect.isValid() && pager != nullptr && pager->isOpen() && totalRowCount > 0)
+    {
+      // The proxy of the distance search needs all rows for filtering and sorting - load all pages in the
+      // background and publish the rows once complete instead of reading them in the GUI thread
+      int numPages = (totalRowCount + SqlModelPager::PAGE_ROWS - 1) / SqlModelPager::PAGE_ROWS;
+      pageCache.setMaxCost(std::max(maxCachedPages, numPages));
+      loadingAllRows = totalRowCount;
+
+      for(int page = 0; page < numPages; page++)
+      {
+        pendingPages.insert(page);
+        pager->requestPage(currentSqlQuery, page);
+      }
+    }
+    else
+    {
+      // Rows are loaded when accessed
+      pageCache.setMaxCost(maxCachedPages);
+      numRows = totalRowCount;
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    ATOOLS_HANDLE_EXCEPTION(e);
+  }
+  catch(...)
+  {
+    ATOOLS_HANDLE_UNKNOWN_EXCEPTION;
+  }
+
+  endResetModel();
+  emit fetchedMore();
+}
+
+void SqlModel::clear()
+{
+  beginResetModel();
+  clearPages();
+
+  if(pager != nullptr)
+    pager->close();
+
+  queryRecord.clear();
+  headers.clear();
+  numRows = 0;
+  endResetModel();
+}
+
+/* Drop all loaded pages and discard pages still being loaded in the background */
+void SqlModel::clearPages()
+{
+  pageReader.reset();
+  pageCache.clear();
+  pendingPages.clear();
+  loadingAllRows = -1;
 
-  if(lastError().isValid())
-    atools::gui::ErrorHandler(parentWidget).handleSqlError(lastError());
+  if(pager != nullptr)
+    pager->startRequest();
+}
+
+int SqlModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : numRows;
+}
+
+int SqlModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : queryRecord.count();
+}
+
+QVariant SqlModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if(orientation == Qt::Horizontal && (role == Qt::DisplayRole || role == Qt::EditRole))
+  {
+    QVariant header = headers.value(section);
+    if(header.isValid())
+      return header;
+    else if(section >= 0 && section < queryRecord.count())
+      // Fall back to field name if no caption was set
+      return queryRecord.fieldName(section);
+  }
+  return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool SqlModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant& value, int role)
+{
+  if(orientation != Qt::Horizontal || section < 0 || (role != Qt::DisplayRole && role != Qt::EditRole))
+    return QAbstractTableModel::setHeaderData(section, orientation, value, role);
+
+  if(section >= headers.size())
+    headers.resize(section + 1);
+  headers[section] = value;
+
+  emit headerDataChanged(orientation, section, section);
+  return true;
+}
+
+const SqlModelPage *SqlModel::getPage(int page, bool loadNow) const
+{
+  SqlModelPage *rows = pageCache.object(page);
+  if(rows == nullptr)
+  {
+    if(loadNow)
+    {
+      rows = new SqlModelPage;
+      try
+      {
+        pageReader.read(db, currentSqlQuery, page, *rows);
+      }
+      catch(atools::Exception& e)
+      {
+        // Called while painting - do not show a dialog
+        qWarning() << Q_FUNC_INFO << "Loading page failed" << e.what();
+        pageReader.reset();
+      }
+      // A background request for the same page is ignored when arriving
+      pageCache.insert(page, rows);
+    }
+    else if(!pendingPages.contains(page))
+    {
+      pendingPages.insert(page);
+      pager->requestPage(currentSqlQuery, page);
+    }
+  }
+  return rows;
+}
+
+QVariant SqlModel::pageValue(const SqlModelPage& rows, int row, int col) const
+{
+  return rows.value((row % SqlModelPager::PAGE_ROWS) * queryRecord.count() + col);
+}
+
+void SqlModel::pagerPageLoaded(int page, const SqlModelPage& values)
+{
+  pendingPages.remove(page);
+
+  bool alreadyLoaded = pageCache.contains(page);
+  if(!alreadyLoaded)
+    pageCache.insert(page, new SqlModelPage(values));
+
+  if(loadingAllRows >= 0)
+  {
+    // Distance search - rows are not visible before all pages are loaded
+    if(pendingPages.isEmpty())
+      finishLoadingAllRows();
+    return;
+  }
+
+  if(alreadyLoaded)
+    // Already loaded in the GUI thread
+    return;
+
+  int firstRow = page * SqlModelPager::PAGE_ROWS;
+  int lastRow = std::min(firstRow + SqlModelPager::PAGE_ROWS, numRows) - 1;
+  if(lastRow >= firstRow && queryRecord.count() > 0)
+    emit dataChanged(index(firstRow, 0), index(lastRow, queryRecord.count() - 1));
+}
+
+void SqlModel::finishLoadingAllRows()
+{
+  beginResetModel();
+  numRows = loadingAllRows;
+  loadingAllRows = -1;
+  endResetModel();
+  emit fetchedMore();
+}
+
+bool SqlModel::loadRows(const QVector<std::pair<int, int> >& rowRanges)
+{
+  // Collect missing pages in ascending order so the pager can continue reading with the same cursor
+  QVector<int> pages;
+  for(const std::pair<int, int>& range : rowRanges)
+  {
+    int firstRow = std::max(range.first, 0);
+    int lastRow = std::min(range.second, numRows - 1);
+    if(firstRow > lastRow)
+      continue;
+
+    for(int page = firstRow / SqlModelPager::PAGE_ROWS; page <= lastRow / SqlModelPager::PAGE_ROWS; page++)
+    {
+      if(!pageCache.contains(page))
+        pages.append(page);
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+  if(pages.isEmpty())
+    return true;
+
+  // Keep all requested pages in the cache until the next query
+  pageCache.setMaxCost(std::max(pageCache.maxCost(), pageCache.size() + pages.size()));
+
+  if(pager == nullptr || !pager->isOpen())
+  {
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    for(int page : pages)
+      getPage(page, true);
+    QGuiApplication::restoreOverrideCursor();
+    return true;
+  }
+
+  QProgressDialog progress(tr("Loading rows ..."), tr("&Cancel"), 0, pages.size(), parentWidget);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
+
+  QSet<int> missingPages;
+  for(int page : pages)
+    missingPages.insert(page);
+
+  QEventLoop loop;
+
+  // Called after pagerPageLoaded which was connected first and put the page into the cache
+  connect(pager, &SqlModelPager::pageLoaded, &loop, [&](int page, const SqlModelPage&)
+  {
+    if(missingPages.remove(page))
+    {
+      progress.setValue(pages.size() - missingPages.size());
+      if(missingPages.isEmpty())
+        loop.quit();
+    }
+  });
+  connect(&progress, &QProgressDialog::canceled, &loop, &QEventLoop::quit);
+  // Query changed in the meantime - pages will not arrive anymore
+  connect(this, &SqlModel::modelReset, &loop, &QEventLoop::quit);
+
+  for(int page : pages)
+  {
+    if(!pendingPages.contains(page))
+    {
+      pendingPages.insert(page);
+      pager->requestPage(currentSqlQuery, page);
+    }
+  }
+
+  loop.exec();
+  return missingPages.isEmpty();
 }
 
 Qt::SortOrder SqlModel::getSortOrder() const
@@ -569,21 +883,31 @@ QVariant SqlModel::defaultDataHandler(int colIndex, int rowIndex, const Column *
 
 QVariant SqlModel::data(const QModelIndex& index, int role) const
 {
-  if(!index.isValid())
+  // Let the view show empty rows until the page arrives if background loading is enabled.
+  // All pages of a distance search are already in the cache when the rows are published.
+  return dataInternal(index, role, pager == nullptr || !pager->isOpen());
+}
+
+QVariant SqlModel::dataInternal(const QModelIndex& index, int role, bool loadNow) const
+{
+  if(!index.isValid() || index.row() >= numRows)
+    return QVariant();
+
+  const SqlModelPage *rows = getPage(index.row() / SqlModelPager::PAGE_ROWS, loadNow);
+  if(rows == nullptr)
+    // dataChanged will be sent when loaded
     return QVariant();
 
   Qt::ItemDataRole dataRole = static_cast<Qt::ItemDataRole>(role);
 
-  // Get the default value for this role. Can be a font, color, etc.
-  QVariant roleValue = QSqlQueryModel::data(index, role);
+  // Get data to display - the value is the default for display and edit role only
+  QVariant dataValue = pageValue(*rows, index.row(), index.column());
+  QVariant roleValue = role == Qt::DisplayRole || role == Qt::EditRole ? dataValue : QVariant();
 
   if(handlerRoles.contains(dataRole))
   {
     // Callback wants to be called for this role
-
-    // Get data to display
-    QVariant dataValue = QSqlQueryModel::data(index, Qt::DisplayRole);
-    QString col = getSqlRecord().fieldName(index.column());
+    QString col = queryRecord.fieldName(index.column());
     const Column *column = columns->getColumn(col);
 
     int row = -1;
@@ -598,15 +922,9 @@ QVariant SqlModel::data(const QModelIndex& index, int role) const
   return roleValue;
 }
 
-void SqlModel::fetchMore(const QModelIndex& parent)
-{
-  QSqlQueryModel::fetchMore(parent);
-  emit fetchedMore();
-}
-
 QVariant SqlModel::getRawData(int row, const QString& colname) const
 {
-  return getRawData(row, getSqlRecord().indexOf(colname));
+  return getRawData(row, queryRecord.indexOf(colname));
 }
 
 void SqlModel::updateSqlQuery()
@@ -616,7 +934,11 @@ void SqlModel::updateSqlQuery()
 
 QVariant SqlModel::getRawData(int row, int col) const
 {
-  return QSqlQueryModel::data(createIndex(row, col));
+  if(row < 0 || row >= numRows || col < 0)
+    return QVariant();
+
+  const SqlModelPage *rows = getPage(row / SqlModelPager::PAGE_ROWS, true);
+  return rows != nullptr ? pageValue(*rows, row, col) : QVariant();
 }
 
 QString SqlModel::getColumnName(int col) const
@@ -626,15 +948,18 @@ QString SqlModel::getColumnName(int col) const
 
 QVariant SqlModel::getFormattedFieldData(const QModelIndex& index) const
 {
-  return data(index);
+  return dataInternal(index, Qt::DisplayRole, true);
 }
 
 atools::sql::SqlRecord SqlModel::getSqlRecord() const
 {
-  return atools::sql::SqlRecord(record(), currentSqlQuery);
+  return atools::sql::SqlRecord(queryRecord, currentSqlQuery);
 }
 
 atools::sql::SqlRecord SqlModel::getSqlRecord(int row) const
 {
-  return atools::sql::SqlRecord(record(row), currentSqlQuery);
+  QSqlRecord rec(queryRecord);
+  for(int i = 0; i < rec.count(); i++)
+    rec.setValue(i, getRawData(row, i));
+  return atools::sql::SqlRecord(rec, currentSqlQuery);
 }
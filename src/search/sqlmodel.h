@@ -19,10 +19,14 @@
 #define LITTLENAVMAP_SQLMODEL_H
 
 #include "geo/rect.h"
+#include "search/sqlmodelpager.h"
 
 #include <functional>
 
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QSet>
+#include <QSqlRecord>
 
 namespace atools {
 namespace sql {
@@ -34,12 +38,17 @@ class SqlRecord;
 
 class Column;
 class ColumnList;
+class SearchTextIndex;
 
 /*
- * Extends the QSqlQueryModel and adds query building based on filters and ordering.
+ * Table model for the search result which adds query building based on filters and ordering.
+ *
+ * The row count is known immediately after building the query. Rows are not fetched up front but loaded in pages
+ * of fixed size when accessed and kept in a least recently used cache. Pages needed by the view are loaded in a
+ * background thread using an own database connection. Rows accessed by getRawData are loaded directly.
  */
 class SqlModel :
-  public QSqlQueryModel
+  public QAbstractTableModel
 {
   Q_OBJECT
 
@@ -104,10 +113,21 @@ public:
     return currentSqlQuery;
   }
 
-  /* Fetch more data and emit signal fetchedMore */
-  virtual void fetchMore(const QModelIndex& parent) override;
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex()) const override;
 
-  /* Get unformatted data from the model */
+  virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+  virtual bool setHeaderData(int section, Qt::Orientation orientation, const QVariant& value,
+                             int role = Qt::EditRole) override;
+
+  /* Remove the query and all rows and close the background connection */
+  void clear();
+
+  /* Load all pages covering the row ranges (first and last row) into the cache if not already done.
+   * Pages are loaded by the background pager while a progress dialog is shown. Returns false if canceled. */
+  bool loadRows(const QVector<std::pair<int, int> >& rowRanges);
+
+  /* Get unformatted data from the model. Loads the page of the row if needed. */
   QVariant getRawData(int row, int col) const;
   QVariant getRawData(int row, const QString& colname) const;
 
@@ -118,6 +138,10 @@ public:
   /* Set a filter for objects within the given bounding rectangle */
   void filterByBoundingRect(const atools::geo::Rect& boundingRectangle);
 
+  /* Set ids found by a spatial search which are used instead of the rectangle condition while the bounding
+   * rectangle is valid. Pass an empty list and false to use the rectangle again. Does not update the query. */
+  void setBoundingRectIds(const QVector<int>& ids, bool valid);
+
   QString getColumnName(int col) const;
 
   /* Set sort order for the given column name. Does not update or restart the query */
@@ -155,14 +179,17 @@ public:
    */
   void setDataCallback(const DataFunctionType& func, const QSet<Qt::ItemDataRole>& roles);
 
+  /* Use index to resolve text conditions to a list of ids instead of using "like" in SQL. Can be null. */
+  void setTextIndex(SearchTextIndex *value)
+  {
+    textIndex = value;
+  }
+
 signals:
-  /* Emitted when more data was fetched */
+  /* Emitted when the query was reset and the row count changed */
   void fetchedMore();
 
 private:
-  // Hide the record method
-  using QSqlQueryModel::record;
-
   struct WhereCondition
   {
     QString oper; /* operator (like, not like) */
@@ -176,10 +203,23 @@ private:
   QString buildColumnList(const atools::sql::SqlRecord& tableCols);
   QString buildWhere(const atools::sql::SqlRecord& tableCols);
   QString buildWhereValue(const WhereCondition& cond);
+  bool buildWhereTextIndex(const WhereCondition& cond, QString& queryWhere);
   void buildQuery();
   void clearWhereConditions();
   void filterBy(QModelIndex index, bool exclude);
   QString  sortOrderToSql(Qt::SortOrder order);
+  QVariant dataInternal(const QModelIndex& index, int role, bool loadNow) const;
+
+  /* Get page from cache. Loads it if loadNow is true or requests it from the pager otherwise. Returns null if
+   * the page is not available yet. The pointer is valid until the next page is inserted into the cache. */
+  const SqlModelPage *getPage(int page, bool loadNow) const;
+  QVariant pageValue(const SqlModelPage& rows, int row, int col) const;
+  void pagerPageLoaded(int page, const SqlModelPage& values);
+  void clearPages();
+
+  /* Publish all rows of a distance search once the last page has arrived */
+  void finishLoadingAllRows();
+
   QVariant defaultDataHandler(int colIndex, int rowIndex, const Column *col, const QVariant& roleValue,
                               const QVariant& displayRoleValue, Qt::ItemDataRole role) const;
 
@@ -199,17 +239,50 @@ private:
   /* A bounding rectangle query is used if this is valid */
   atools::geo::Rect boundingRect;
 
+  /* Replaces the rectangle condition if valid */
+  QVector<int> boundingRectIds;
+  bool boundingRectIdsValid = false;
+
   /* Maps column name to where condition struct */
   QHash<QString, WhereCondition> whereConditionMap;
 
   atools::sql::SqlDatabase *db;
 
+  SearchTextIndex *textIndex = nullptr;
+
   /* List of column descriptors */
   const ColumnList *columns;
 
   QWidget *parentWidget;
   int totalRowCount = 0;
 
+  /* Field names and types of the current query */
+  QSqlRecord queryRecord;
+
+  /* Header captions by column index */
+  QVector<QVariant> headers;
+
+  /* Number of rows of the query set into the model */
+  int numRows = 0;
+
+  /* Least recently used pages of rows by page number */
+  mutable QCache<int, SqlModelPage> pageCache;
+
+  /* Pages requested from the pager but not delivered yet */
+  mutable QSet<int> pendingPages;
+
+  /* Reads pages in the GUI thread */
+  mutable SqlModelPageReader pageReader;
+
+  /* Null if background loading is disabled */
+  SqlModelPager *pager = nullptr;
+
+  /* Cache size from settings. Raised temporarily to hold all pages of a distance search. */
+  int maxCachedPages = 0;
+
+  /* Number of rows to publish when all pages of a distance search are loaded. -1 if not loading. */
+  int loadingAllRows = -1;
+
 };
 
 #endif // LITTLENAVMAP_SQLMODEL_H
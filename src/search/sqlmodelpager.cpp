@@ -0,0 +1,317 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "search/sqlmodelpager.h"
+
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "exception.h"
+
+#include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+
+Q_DECL_CONSTEXPR int SqlModelPager::PAGE_ROWS;
+Q_DECL_CONSTEXPR int SqlModelBulkReader::MAX_QUEUED_PAGES;
+
+// ---------------------------------------------------------------------------------
+SqlModelPageReader::SqlModelPageReader()
+{
+
+}
+
+SqlModelPageReader::~SqlModelPageReader()
+{
+  reset();
+}
+
+void SqlModelPageReader::reset()
+{
+  delete query;
+  query = nullptr;
+  querySql.clear();
+  nextRow = numColumns = 0;
+}
+
+int SqlModelPageReader::read(SqlDatabase *db, const QString& sql, int page, SqlModelPage& values)
+{
+  int firstRow = page * SqlModelPager::PAGE_ROWS;
+
+  if(query == nullptr || sql != querySql || firstRow != nextRow)
+  {
+    // Not a continuation of the last page - run query again starting at the first row of the page
+    reset();
+    query = new SqlQuery(db);
+    query->exec(sql + QString(" limit -1 offset %1").arg(firstRow));
+    querySql = sql;
+    nextRow = firstRow;
+    numColumns = query->record().count();
+  }
+
+  values.clear();
+  values.reserve(SqlModelPager::PAGE_ROWS * numColumns);
+
+  int rows = 0;
+  while(rows < SqlModelPager::PAGE_ROWS && query->next())
+  {
+    for(int col = 0; col < numColumns; col++)
+      values.append(query->value(col));
+    rows++;
+  }
+  nextRow += rows;
+
+  if(rows < SqlModelPager::PAGE_ROWS)
+    // End of result reached
+    reset();
+
+  return rows;
+}
+
+// ---------------------------------------------------------------------------------
+SqlModelPagerWorker::SqlModelPagerWorker(const QAtomicInt& latestRequestId)
+  : latestRequest(latestRequestId)
+{
+
+}
+
+SqlModelPagerWorker::~SqlModelPagerWorker()
+{
+  closeDatabase();
+}
+
+bool SqlModelPagerWorker::openDatabase(const QString& name, const QString& file)
+{
+  closeDatabase();
+
+  try
+  {
+    SqlDatabase::addDatabase("QSQLITE", name);
+    connectionName = name;
+    db = new SqlDatabase(name);
+    db->setDatabaseName(file);
+    db->setReadonly();
+    db->open({"PRAGMA cache_size=-10000", "PRAGMA synchronous=OFF"});
+    return true;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open pager database" << e.what();
+    closeDatabase();
+  }
+  return false;
+}
+
+void SqlModelPagerWorker::closeDatabase()
+{
+  reader.reset();
+
+  if(db != nullptr)
+  {
+    if(db->isOpen())
+      db->close();
+    delete db;
+    db = nullptr;
+  }
+
+  if(!connectionName.isEmpty())
+  {
+    // Remove after the database object is deleted to avoid warnings about connections still in use
+    SqlDatabase::removeDatabase(connectionName);
+    connectionName.clear();
+  }
+}
+
+void SqlModelPagerWorker::loadPage(int requestId, const QString& sql, int page)
+{
+  if(db == nullptr || latestRequest.load() != requestId)
+    // Not open or a newer request is waiting
+    return;
+
+  SqlModelPage values;
+  try
+  {
+    reader.read(db, sql, page, values);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Loading page failed" << e.what();
+    reader.reset();
+    values.clear();
+  }
+
+  emit pageLoaded(requestId, page, values);
+}
+
+// ---------------------------------------------------------------------------------
+SqlModelPager::SqlModelPager(QObject *parent)
+  : QObject(parent)
+{
+  qRegisterMetaType<SqlModelPage>("SqlModelPage");
+
+  worker = new SqlModelPagerWorker(latestRequestId);
+  worker->moveToThread(&thread);
+
+  // Both connections are queued since sender and receiver live in different threads
+  connect(this, &SqlModelPager::pageRequested, worker, &SqlModelPagerWorker::loadPage);
+  connect(worker, &SqlModelPagerWorker::pageLoaded, this, &SqlModelPager::workerPageLoaded);
+
+  thread.setObjectName("SqlModelPager");
+  thread.start(QThread::LowPriority);
+}
+
+SqlModelPager::~SqlModelPager()
+{
+  close();
+  thread.quit();
+  thread.wait();
+  delete worker;
+}
+
+bool SqlModelPager::open(const QString& name, const QString& file)
+{
+  close();
+
+  bool ok = false;
+  QMetaObject::invokeMethod(worker, "openDatabase", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, ok),
+                            Q_ARG(QString, name), Q_ARG(QString, file));
+  opened = ok;
+  return opened;
+}
+
+void SqlModelPager::close()
+{
+  if(!opened)
+    return;
+
+  // Cancel running request
+  startRequest();
+
+  QMetaObject::invokeMethod(worker, "closeDatabase", Qt::BlockingQueuedConnection);
+  opened = false;
+}
+
+void SqlModelPager::startRequest()
+{
+  latestRequestId.fetchAndAddOrdered(1);
+}
+
+void SqlModelPager::requestPage(const QString& sql, int page)
+{
+  if(opened)
+    emit pageRequested(latestRequestId.load(), sql, page);
+}
+
+void SqlModelPager::workerPageLoaded(int requestId, int page, const SqlModelPage& values)
+{
+  // Ignore pages of outdated requests which were already queued
+  if(requestId == latestRequestId.load())
+    emit pageLoaded(page, values);
+}
+
+// ---------------------------------------------------------------------------------
+SqlModelBulkReader::SqlModelBulkReader(QObject *parent)
+  : QObject(parent)
+{
+  qRegisterMetaType<SqlModelPage>("SqlModelPage");
+}
+
+SqlModelBulkReader::~SqlModelBulkReader()
+{
+  cancel();
+}
+
+void SqlModelBulkReader::start(const QString& name, const QString& file, const QString& sql)
+{
+  cancel();
+
+  canceled.store(0);
+  freePages.acquire(freePages.available());
+  freePages.release(MAX_QUEUED_PAGES);
+
+  future = QtConcurrent::run([ = ]()
+  {
+    run(name, file, sql);
+  });
+}
+
+void SqlModelBulkReader::pageProcessed()
+{
+  freePages.release();
+}
+
+void SqlModelBulkReader::cancel()
+{
+  canceled.store(1);
+
+  // Wake up the reader if it waits for the GUI thread
+  freePages.release(MAX_QUEUED_PAGES);
+  future.waitForFinished();
+}
+
+void SqlModelBulkReader::run(const QString& name, const QString& file, const QString& sql)
+{
+  bool success = false;
+  SqlDatabase::addDatabase("QSQLITE", name);
+
+  {
+    SqlDatabase db(name);
+    try
+    {
+      db.setDatabaseName(file);
+      db.setReadonly();
+      db.open({"PRAGMA cache_size=-10000", "PRAGMA synchronous=OFF"});
+
+      SqlModelPageReader reader;
+      SqlModelPage values;
+      for(int page = 0; canceled.load() == 0; page++)
+      {
+        int rows = reader.read(&db, sql, page, values);
+
+        if(rows > 0)
+        {
+          // Wait until the GUI thread has caught up
+          freePages.acquire();
+          if(canceled.load() != 0)
+            break;
+          emit pageRead(values);
+        }
+
+        if(rows < SqlModelPager::PAGE_ROWS)
+        {
+          // End of result reached
+          success = true;
+          break;
+        }
+      }
+
+      reader.reset();
+      db.close();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Reading rows failed" << e.what();
+    }
+  }
+
+  SqlDatabase::removeDatabase(name);
+
+  if(canceled.load() == 0)
+    emit finished(success);
+}
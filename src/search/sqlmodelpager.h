@@ -0,0 +1,184 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_SQLMODELPAGER_H
+#define LITTLENAVMAP_SQLMODELPAGER_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QSemaphore>
+#include <QThread>
+#include <QVariant>
+#include <QVector>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+class SqlQuery;
+}
+}
+
+/* Rows of one page. Values of all columns in row major order. */
+typedef QVector<QVariant> SqlModelPage;
+
+/*
+ * Reads pages of a fixed number of rows for a query. Keeps the statement open after reading a page so that
+ * reading the following page continues with the same cursor instead of running the query again with an offset.
+ */
+class SqlModelPageReader
+{
+public:
+  SqlModelPageReader();
+  ~SqlModelPageReader();
+
+  /* Read the page of the query into values and return the number of rows read. Throws an exception on error. */
+  int read(atools::sql::SqlDatabase *db, const QString& sql, int page, SqlModelPage& values);
+
+  /* Close the statement. Has to be called before closing the database. */
+  void reset();
+
+private:
+  atools::sql::SqlQuery *query = nullptr;
+  QString querySql;
+  int nextRow = 0, numColumns = 0;
+};
+
+/*
+ * Runs in the pager thread. Uses its own read only database connection.
+ */
+class SqlModelPagerWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SqlModelPagerWorker(const QAtomicInt& latestRequestId);
+  virtual ~SqlModelPagerWorker();
+
+  /* Open a database connection with the given name. Has to be called in the worker thread.
+   * Returns false if the database could not be opened. */
+  Q_INVOKABLE bool openDatabase(const QString& name, const QString& file);
+
+  /* Close and remove the database connection. Has to be called in the worker thread. */
+  Q_INVOKABLE void closeDatabase();
+
+  /* Load the page of the query and emit pageLoaded. Does nothing if a newer request was started.
+   * Emits an empty page if loading fails so that waiting receivers do not hang. */
+  void loadPage(int requestId, const QString& sql, int page);
+
+signals:
+  void pageLoaded(int requestId, int page, const SqlModelPage& values);
+
+private:
+  atools::sql::SqlDatabase *db = nullptr;
+  QString connectionName;
+  SqlModelPageReader reader;
+  const QAtomicInt& latestRequest;
+};
+
+/*
+ * Loads pages of rows for a search table model in a background thread. The model starts a new request for each
+ * query change which cancels all page loads pending for older requests.
+ */
+class SqlModelPager :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SqlModelPager(QObject *parent);
+  virtual ~SqlModelPager();
+
+  /* Open a connection with the given name on the database file. Blocks until done.
+   * Returns false and leaves the pager closed if the database could not be opened. */
+  bool open(const QString& name, const QString& file);
+
+  /* Cancel all requests and close the connection. Blocks until done. */
+  void close();
+
+  bool isOpen() const
+  {
+    return opened;
+  }
+
+  /* Start a new request which discards all pages of previous requests */
+  void startRequest();
+
+  /* Load page of the query in the background. pageLoaded is emitted when done. */
+  void requestPage(const QString& sql, int page);
+
+  /* Number of rows in a page */
+  static Q_DECL_CONSTEXPR int PAGE_ROWS = 256;
+
+signals:
+  /* Page of the current request loaded. Sent in the GUI thread. */
+  void pageLoaded(int page, const SqlModelPage& values);
+
+  /* Internal - passes a request to the worker thread */
+  void pageRequested(int requestId, const QString& sql, int page);
+
+private:
+  void workerPageLoaded(int requestId, int page, const SqlModelPage& values);
+
+  QThread thread;
+  SqlModelPagerWorker *worker = nullptr;
+  QAtomicInt latestRequestId;
+  bool opened = false;
+};
+
+/*
+ * Reads the rows of a query page by page on its own connection in a background thread and delivers the pages
+ * to the GUI thread. Used for exports which need the whole result without blocking the window.
+ */
+class SqlModelBulkReader :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SqlModelBulkReader(QObject *parent = nullptr);
+  virtual ~SqlModelBulkReader();
+
+  /* Open a connection with the given name on the database file and start reading all rows of the query */
+  void start(const QString& name, const QString& file, const QString& sql);
+
+  /* Has to be called after each page delivered by pageRead was processed. Reading pauses if too many pages
+   * are waiting in the event queue. */
+  void pageProcessed();
+
+  /* Stop reading and wait for the thread. finished is not sent if not already queued. */
+  void cancel();
+
+signals:
+  /* Rows of one page. Values of all columns in row major order. Sent in the GUI thread. */
+  void pageRead(const SqlModelPage& values);
+
+  /* All rows read or reading failed. Sent in the GUI thread. */
+  void finished(bool success);
+
+private:
+  void run(const QString& name, const QString& file, const QString& sql);
+
+  /* Maximum number of pages read ahead of the GUI thread */
+  static Q_DECL_CONSTEXPR int MAX_QUEUED_PAGES = 16;
+
+  QFuture<void> future;
+  QAtomicInt canceled;
+  QSemaphore freePages;
+};
+
+#endif // LITTLENAVMAP_SQLMODELPAGER_H
@@ -19,6 +19,7 @@
 
 #include "geo/calculations.h"
 #include "search/sqlmodel.h"
+#include "search/searchspatialindex.h"
 #include "common/unit.h"
 #include "common/mapflags.h"
 
@@ -26,9 +27,47 @@
 
 using namespace atools::geo;
 
+namespace sqlproxymodel {
+
+/* Direction filter ranges are decreased by this value on each side */
+static Q_DECL_CONSTEXPR float DIR_RANGE_DEG = 22.5f;
+
+/* Direction filter parameters */
+static Q_DECL_CONSTEXPR float MIN_NORTH_DEG = 270.f + DIR_RANGE_DEG, MAX_NORTH_DEG = 90.f - DIR_RANGE_DEG;
+static Q_DECL_CONSTEXPR float MIN_EAST_DEG = 0.f + DIR_RANGE_DEG, MAX_EAST_DEG = 180.f - DIR_RANGE_DEG;
+static Q_DECL_CONSTEXPR float MIN_SOUTH_DEG = 90.f + DIR_RANGE_DEG, MAX_SOUTH_DEG = 270.f - DIR_RANGE_DEG;
+static Q_DECL_CONSTEXPR float MIN_WEST_DEG = 180.f + DIR_RANGE_DEG, MAX_WEST_DEG = 360.f - DIR_RANGE_DEG;
+
+bool matchDirection(SearchDirection dir, float heading)
+{
+  switch(dir)
+  {
+    case sqlproxymodel::ALL:
+      // All directions
+      return true;
+
+    case sqlproxymodel::NORTH:
+      return MIN_NORTH_DEG <= heading || heading <= MAX_NORTH_DEG;
+
+    case sqlproxymodel::EAST:
+      return MIN_EAST_DEG <= heading && heading <= MAX_EAST_DEG;
+
+    case sqlproxymodel::SOUTH:
+      return MIN_SOUTH_DEG <= heading && heading <= MAX_SOUTH_DEG;
+
+    case sqlproxymodel::WEST:
+      return MIN_WEST_DEG <= heading && heading <= MAX_WEST_DEG;
+  }
+  return true;
+}
+
+}
+
 SqlProxyModel::SqlProxyModel(QObject *parent, SqlModel *sqlModel)
   : QSortFilterProxyModel(parent), sourceSqlModel(sqlModel)
 {
+  // Connect before the proxy connects to the model to have the cache cleared before filtering again
+  connect(sqlModel, &SqlModel::modelReset, this, &SqlProxyModel::clearRowCache);
 }
 
 SqlProxyModel::~SqlProxyModel()
@@ -43,72 +82,86 @@ void SqlProxyModel::setDistanceFilter(const Pos& center, sqlproxymodel::SearchDi
   maxDistMeter = nmToMeter(maxDistance);
   centerPos = center;
   direction = dir;
+  spatialDistHeading.clear();
+  clearRowCache();
 }
 
 void SqlProxyModel::clearDistanceFilter()
 {
   centerPos = Pos();
+  spatialDistHeading.clear();
+  clearRowCache();
 }
 
-/* Does the filtering by minimum and maximum distance and direction */
-bool SqlProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
+void SqlProxyModel::setSpatialResults(const QVector<SearchSpatialResult>& results, const QString& idColumnName)
 {
-  Q_UNUSED(sourceParent);
+  idColumn = idColumnName;
+  spatialDistHeading.clear();
+  spatialDistHeading.reserve(results.size());
+  for(const SearchSpatialResult& result : results)
+    spatialDistHeading.insert(result.id, std::make_pair(result.distanceMeter, result.headingDeg));
+  clearRowCache();
+}
 
-  Pos pos = buildPos(sourceRow);
-  float heading = normalizeCourse(centerPos.angleDegTo(pos));
+void SqlProxyModel::clearRowCache()
+{
+  rowDistMeter.clear();
+  rowHeading.clear();
+}
 
-  switch(direction)
+void SqlProxyModel::rowDistance(int row, float& distMeter, float& heading) const
+{
+  if(row >= rowDistMeter.size())
   {
-    case sqlproxymodel::ALL:
-      // All directions
-      return matchDistance(pos);
-
-    case sqlproxymodel::NORTH:
-      if(MIN_NORTH_DEG <= heading || heading <= MAX_NORTH_DEG)
-        return matchDistance(pos);
-      else
-        return false;
-
-    case sqlproxymodel::EAST:
-      if(MIN_EAST_DEG <= heading && heading <= MAX_EAST_DEG)
-        return matchDistance(pos);
-      else
-        return false;
+    // Rows were fetched - add uncalculated entries
+    rowDistMeter.resize(std::max(row + 1, sourceSqlModel->rowCount()));
+    std::fill(rowDistMeter.begin() + rowHeading.size(), rowDistMeter.end(), -1.f);
+    rowHeading.resize(rowDistMeter.size());
+  }
 
-    case sqlproxymodel::SOUTH:
-      if(MIN_SOUTH_DEG <= heading && heading <= MAX_SOUTH_DEG)
-        return matchDistance(pos);
-      else
-        return false;
+  if(rowDistMeter.at(row) < 0.f)
+  {
+    auto it = spatialDistHeading.constEnd();
+    if(!spatialDistHeading.isEmpty())
+      it = spatialDistHeading.constFind(sourceSqlModel->getRawData(row, idColumn).toInt());
 
-    case sqlproxymodel::WEST:
-      if(MIN_WEST_DEG <= heading && heading <= MAX_WEST_DEG)
-        return matchDistance(pos);
-      else
-        return false;
+    if(it != spatialDistHeading.constEnd())
+    {
+      // Already calculated by spatial index
+      rowDistMeter[row] = it->first;
+      rowHeading[row] = it->second;
+    }
+    else
+    {
+      Pos pos = buildPos(row);
+      rowDistMeter[row] = pos.distanceMeterTo(centerPos);
+      rowHeading[row] = normalizeCourse(centerPos.angleDegTo(pos));
+    }
   }
-  return true;
+  distMeter = rowDistMeter.at(row);
+  heading = rowHeading.at(row);
 }
 
-bool SqlProxyModel::matchDistance(const Pos& pos) const
+/* Does the filtering by minimum and maximum distance and direction */
+bool SqlProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
-  float distMeter = pos.distanceMeterTo(centerPos);
-  return distMeter >= minDistMeter && distMeter <= maxDistMeter;
+  Q_UNUSED(sourceParent);
+
+  float distMeter, heading;
+  rowDistance(sourceRow, distMeter, heading);
+
+  return sqlproxymodel::matchDirection(direction, heading) && distMeter >= minDistMeter && distMeter <= maxDistMeter;
 }
 
 void SqlProxyModel::sort(int column, Qt::SortOrder order)
 {
+  // Sorting reads all rows of the source model - set wait cursor
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
   QSortFilterProxyModel::sort(column, order);
+  QGuiApplication::restoreOverrideCursor();
 
   // Update query in underlying SQL model
   sourceSqlModel->setSort(sourceSqlModel->getColumnName(column), order);
-
-  // Fetch all data and set wait cursor
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-  while(canFetchMore(QModelIndex()))
-    fetchMore(QModelIndex());
-  QGuiApplication::restoreOverrideCursor();
 }
 
 QVariant SqlProxyModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -125,15 +178,17 @@ bool SqlProxyModel::lessThan(const QModelIndex& sourceLeft, const QModelIndex& s
   if(leftCol == "distance" && rightCol == "distance")
   {
     // Sort by distance
-    float distLeft = buildPos(sourceLeft.row()).distanceMeterTo(centerPos);
-    float distRight = buildPos(sourceRight.row()).distanceMeterTo(centerPos);
+    float distLeft, distRight, headingLeft, headingRight;
+    rowDistance(sourceLeft.row(), distLeft, headingLeft);
+    rowDistance(sourceRight.row(), distRight, headingRight);
     return distLeft < distRight;
   }
   else if(leftCol == "heading" && rightCol == "heading")
   {
     // Sort by heading
-    float headingLeft = normalizeCourse(centerPos.angleDegTo(buildPos(sourceLeft.row())));
-    float headingRight = normalizeCourse(centerPos.angleDegTo(buildPos(sourceRight.row())));
+    float distLeft, distRight, headingLeft, headingRight;
+    rowDistance(sourceLeft.row(), distLeft, headingLeft);
+    rowDistance(sourceRight.row(), distRight, headingRight);
     return headingLeft < headingRight;
   }
   else
@@ -147,7 +202,11 @@ QVariant SqlProxyModel::data(const QModelIndex& index, int role) const
   if(sourceSqlModel->getColumnName(index.column()) == "distance")
   {
     if(role == Qt::DisplayRole)
-      return Unit::distMeter(buildPos(mapToSource(index).row()).distanceMeterTo(centerPos), false);
+    {
+      float distMeter, heading;
+      rowDistance(mapToSource(index).row(), distMeter, heading);
+      return Unit::distMeter(distMeter, false);
+    }
     else if(role == Qt::TextAlignmentRole)
       return Qt::AlignRight;
   }
@@ -155,7 +214,8 @@ QVariant SqlProxyModel::data(const QModelIndex& index, int role) const
   {
     if(role == Qt::DisplayRole)
     {
-      float heading = normalizeCourse(centerPos.angleDegTo(buildPos(mapToSource(index).row())));
+      float distMeter, heading;
+      rowDistance(mapToSource(index).row(), distMeter, heading);
       if(heading < map::INVALID_COURSE_VALUE)
         return QLocale().toString(heading, 'f', 0);
       else
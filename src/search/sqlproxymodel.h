@@ -20,9 +20,11 @@
 
 #include "geo/pos.h"
 
+#include <QHash>
 #include <QSortFilterProxyModel>
 
 class SqlModel;
+struct SearchSpatialResult;
 
 namespace sqlproxymodel {
 
@@ -38,6 +40,9 @@ enum SearchDirection
   WEST = 4
 };
 
+/* True if heading from center to object matches the search direction */
+bool matchDirection(SearchDirection dir, float heading);
+
 }
 
 /*
@@ -46,6 +51,9 @@ enum SearchDirection
  * and direction.
  * Dynamic loading on demand (like the SQL model does) does not work with this model. Therefore all results
  * have to be fetched.
+ *
+ * Distance and heading are taken from the spatial index results if available. Otherwise they are calculated
+ * only once for each source row. Values are cached until the filter or the source model changes.
  */
 class SqlProxyModel :
   public QSortFilterProxyModel
@@ -69,6 +77,10 @@ public:
   /* Clear distance search and stop all filtering */
   void clearDistanceFilter();
 
+  /* Use distance and heading of the spatial index search instead of calculating them again. Rows are
+   * identified by the given id column. Call after setDistanceFilter. Empty results fall back to calculation. */
+  void setSpatialResults(const QVector<SearchSpatialResult>& results, const QString& idColumnName);
+
   /* Sorts the model by column in the given order and fetches all data from the underlying model. */
   virtual void sort(int column, Qt::SortOrder order) override;
 
@@ -78,23 +90,24 @@ private:
   virtual bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
   virtual bool lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const override;
 
-  bool matchDistance(const atools::geo::Pos& pos) const;
   atools::geo::Pos buildPos(int row) const;
 
-  /* Direction filter ranges are decreased by this value on each side */
-  static float Q_DECL_CONSTEXPR DIR_RANGE_DEG = 22.5f;
-
-  /* Direction filter parameters */
-  static float Q_DECL_CONSTEXPR MIN_NORTH_DEG = 270.f + DIR_RANGE_DEG, MAX_NORTH_DEG = 90.f - DIR_RANGE_DEG;
-  static float Q_DECL_CONSTEXPR MIN_EAST_DEG = 0.f + DIR_RANGE_DEG, MAX_EAST_DEG = 180.f - DIR_RANGE_DEG;
-  static float Q_DECL_CONSTEXPR MIN_SOUTH_DEG = 90.f + DIR_RANGE_DEG, MAX_SOUTH_DEG = 270.f - DIR_RANGE_DEG;
-  static float Q_DECL_CONSTEXPR MIN_WEST_DEG = 180.f + DIR_RANGE_DEG, MAX_WEST_DEG = 360.f - DIR_RANGE_DEG;
+  /* Get cached distance and heading for source row. Calculates values if not already done. */
+  void rowDistance(int row, float& distMeter, float& heading) const;
+  void clearRowCache();
 
   SqlModel *sourceSqlModel = nullptr;
   atools::geo::Pos centerPos;
   sqlproxymodel::SearchDirection direction;
   float minDistMeter = 0.f, maxDistMeter = 0.f;
 
+  /* Distance and heading by source row. Distance is negative if not calculated yet. */
+  mutable QVector<float> rowDistMeter, rowHeading;
+
+  /* Distance and heading from spatial index by row id */
+  QHash<int, std::pair<float, float> > spatialDistHeading;
+  QString idColumn;
+
 };
 
 #endif // LITTLENAVMAP_SQLPROXYMODEL_H